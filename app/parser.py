@@ -1,10 +1,19 @@
 import csv
 import io
 import os
+import struct
 
 from loguru import logger
+import numpy as np
 import pandas as pd
 
+# The magic bytes at the start of every block of a columnar log. See
+# gpu/cldrive/columnar_log.h for the format.
+COLUMNAR_LOG_MAGIC = b"CLDCOL01"
+
+# Column encodings of the columnar log format.
+_INT32, _INT64, _DELTA_INT64, _DICTIONARY, _FLOAT64 = range(5)
+
 def ParseCLDriveStdoutToDataframe(
     stdout: str
 ) -> pd.DataFrame:
@@ -19,6 +28,88 @@ def ParseCLDriveStdoutToDataframe(
 
     return df
 
+def _ReadColumnarLogBlock(data: bytes, pos: int):
+    """Read a columnar log block at an offset into data. Returns a dict of
+    column arrays and the offset of the next block."""
+    if data[pos:pos + 8] != COLUMNAR_LOG_MAGIC:
+        raise ValueError(f"Bad columnar log magic at offset {pos}")
+    num_rows, num_columns = struct.unpack_from("<II", data, pos + 8)
+    pos += 16
+
+    columns = {}
+    for _ in range(num_columns):
+        (name_length,) = struct.unpack_from("<H", data, pos)
+        name = data[pos + 2:pos + 2 + name_length].decode()
+        encoding = data[pos + 2 + name_length]
+        pos += 3 + name_length
+
+        if encoding in (_INT32, _INT64, _FLOAT64):
+            dtype = {_INT32: "<i4", _INT64: "<i8", _FLOAT64: "<f8"}[encoding]
+            values = np.frombuffer(data, dtype=dtype, count=num_rows, offset=pos)
+            pos += values.nbytes
+        elif encoding == _DELTA_INT64:
+            (first,) = struct.unpack_from("<q", data, pos)
+            width = data[pos + 8]
+            pos += 9
+            deltas = np.frombuffer(
+                data, dtype=f"<i{width}", count=num_rows - 1, offset=pos
+            )
+            pos += deltas.nbytes
+            values = np.empty(num_rows, dtype=np.int64)
+            values[0] = first
+            np.cumsum(deltas, dtype=np.int64, out=values[1:])
+            values[1:] += first
+        elif encoding == _DICTIONARY:
+            (num_strings,) = struct.unpack_from("<I", data, pos)
+            pos += 4
+            strings = []
+            for _ in range(num_strings):
+                (length,) = struct.unpack_from("<I", data, pos)
+                strings.append(data[pos + 4:pos + 4 + length].decode())
+                pos += 4 + length
+            width = data[pos]
+            pos += 1
+            codes = np.frombuffer(
+                data, dtype=f"<u{width}", count=num_rows, offset=pos
+            )
+            pos += codes.nbytes
+            values = pd.Categorical.from_codes(
+                codes.astype(np.int32), categories=pd.Index(strings, dtype=object)
+            )
+        else:
+            raise ValueError(f"Unknown encoding {encoding} of column {name}")
+        columns[name] = values
+    return columns, pos
+
+
+def ParseCLDriveColumnarToDataframe(data: bytes) -> pd.DataFrame:
+    """
+    Parse the output of `cldrive --output_format=columnar`, or a file of
+    concatenated outputs, into a pandas dataframe. Nulls are -1 in numeric
+    columns.
+    """
+    frames = []
+    pos = 0
+    while pos < len(data):
+        columns, pos = _ReadColumnarLogBlock(data, pos)
+        frames.append(pd.DataFrame(columns))
+    if not frames:
+        return pd.DataFrame()
+    # Categories differ between blocks, so concatenated string columns are
+    # converted back to categoricals over the union of them.
+    df = pd.concat(frames, ignore_index=True)
+    for name in frames[0].columns:
+        if isinstance(frames[0][name].dtype, pd.CategoricalDtype):
+            df[name] = df[name].astype("category")
+    return df
+
+
+def LoadCLDriveColumnarFile(path: str) -> pd.DataFrame:
+    """Load a columnar log file into a pandas dataframe."""
+    with open(path, "rb") as f:
+        return ParseCLDriveColumnarToDataframe(f.read())
+
+
 def get_file_id_from_config(config):
     kernel_id = os.path.splitext(os.path.basename(config["kernel_path"]))[0]
     return f"{kernel_id}_{config['gsize']}_{config['lsize']}"
@@ -3,6 +3,8 @@ import pathlib
 import random
 import subprocess
 import typing
+import io
+import json
 import pandas as pd
 from loguru import logger
 import tempfile
@@ -11,6 +13,7 @@ from app.parser import ParseCLDriveStdoutToDataframe
 from app.utils import getOpenCLPlatforms
 
 CLDRIVE = "bazel-bin/gpu/cldrive/cldrive"
+CLMEM = "bazel-bin/gpu/clmem/clmem"
 TIMEOUT = 10
 MAX_GSIZE = int(1e7) - 1
 
@@ -27,6 +30,7 @@ def RunCLDrive(
     cl_platform: str = None,
     output_format: str = "csv",
     verbose_cldrive: bool = False,
+    sweep: str = None,
 ) -> str:
     """
     If CLDrive executable exists, run it over provided source code.
@@ -67,6 +71,8 @@ def RunCLDrive(
                     cl_platform,
                     output_format
                 )
+                if sweep:
+                    cmd += " --sweep={}".format(sweep)
                 if verbose_cldrive:
                     print(cmd)
                     # print(src)
@@ -74,7 +80,8 @@ def RunCLDrive(
                     cmd.split(),
                     stdout=subprocess.PIPE,
                     stderr=subprocess.PIPE,
-                    universal_newlines=True,
+                    # Columnar output is binary.
+                    universal_newlines=output_format != "columnar",
                 )
                 stdout, stderr = proc.communicate()
         else:
@@ -94,6 +101,8 @@ def RunCLDrive(
                 cl_platform,
                 output_format
             )
+            if sweep:
+                cmd += " --sweep={}".format(sweep)
             if verbose_cldrive:
                 print(cmd)
                 # print(src)
@@ -101,7 +110,8 @@ def RunCLDrive(
                 cmd.split(),
                 stdout=subprocess.PIPE,
                 stderr=subprocess.PIPE,
-                universal_newlines=True,
+                # Columnar output is binary.
+                universal_newlines=output_format != "columnar",
             )
             try:
                 stdout, stderr = proc.communicate()
@@ -111,6 +121,115 @@ def RunCLDrive(
             stderr = "TIMEOUT"
     return stdout, stderr
 
+def RunClmemAccessBounds(
+    clmem_exe: str,
+    src: str,
+    gsize: int,
+    lsize: int,
+    args_values: typing.List[int],
+    cl_platform: str,
+    timeout: int = 0,
+):
+    """
+    Run a hook-instrumented kernel once with clmem, which records the minimum
+    and maximum index passed to hook() for each argument on the device.
+    Returns a dataframe with columns instance, kernel, global_size, local_size,
+    arg_id, min_index, max_index, and stderr.
+    """
+    with tempfile.NamedTemporaryFile("w", suffix=".cl") as f:
+        f.write(src)
+        f.flush()
+        cmd = ["timeout", "-s9", str(timeout)] if timeout > 0 else []
+        cmd += [
+            clmem_exe,
+            f"--srcs={f.name}",
+            "--num_runs=1",
+            f"--gsize={gsize}",
+            f"--lsize_x={lsize}",
+            f"--envs={cl_platform}",
+            "--hook_mode=atomic",
+            "--output_format=bounds",
+        ]
+        if args_values:
+            cmd.append("--args_values=" + ",".join(map(str, args_values)))
+        proc = subprocess.Popen(
+            cmd,
+            stdout=subprocess.PIPE,
+            stderr=subprocess.PIPE,
+            universal_newlines=True,
+        )
+        stdout, stderr = proc.communicate()
+    if proc.returncode == 9:
+        stderr = "TIMEOUT"
+    if not stdout:
+        return pd.DataFrame(), stderr
+    return pd.read_csv(io.StringIO(stdout)), stderr
+
+def RunClmemInferBounds(
+    clmem_exe: str,
+    src: str,
+    gsize: int,
+    lsize: int,
+    cl_platform: str,
+    timeout: int = 0,
+):
+    """
+    Infer the array bounds of the first kernel of a hook-instrumented source
+    with `clmem --infer_bounds`, which runs every probe in one process.
+    Returns the value of each kernel argument at the launch config, as for
+    --args_values, and stderr. The values are None if no scalar setting keeps
+    the kernel in bounds.
+    """
+    with tempfile.NamedTemporaryFile("w", suffix=".cl") as f:
+        f.write(src)
+        f.flush()
+        cmd = ["timeout", "-s9", str(timeout)] if timeout > 0 else []
+        cmd += [
+            clmem_exe,
+            f"--srcs={f.name}",
+            f"--gsize={gsize}",
+            f"--lsize_x={lsize}",
+            f"--envs={cl_platform}",
+            "--infer_bounds",
+        ]
+        proc = subprocess.Popen(
+            cmd,
+            stdout=subprocess.PIPE,
+            stderr=subprocess.PIPE,
+            universal_newlines=True,
+        )
+        stdout, stderr = proc.communicate()
+    if proc.returncode == 9:
+        stderr = "TIMEOUT"
+    if not stdout.strip():
+        return None, stderr
+    # Each argument's bound is round(a * gsize + b * lsize + c) + 1, which
+    # for a scalar is its value.
+    models = sorted(json.loads(stdout).values(), key=lambda x: x["arg_id"])
+    args_values = [
+        int(round(m["coef"][0] * gsize + m["coef"][1] * lsize + m["coef"][2])) + 1
+        for m in models
+    ]
+    return args_values, stderr
+
+def WriteSweepFile(path, launch_configs, args_values_list=()):
+    """Write a --sweep file which runs every (gsize, lsize) launch config with
+    every list of argument values."""
+    sweep = {
+        "kernel": [{
+            "dynamic_params": [
+                {"global_size_x": int(gsize), "local_size_x": int(lsize)}
+                for gsize, lsize in launch_configs
+            ],
+            "args_values": [
+                {"value": [int(v) for v in args_values]}
+                for args_values in args_values_list
+            ],
+        }]
+    }
+    with open(path, "w") as f:
+        json.dump(sweep, f)
+
 class KernelRunInstance:
     def __init__(self, kernel_code, gsize, lsize, args_values=None,
                  cldrive_exe=CLDRIVE, device=getOpenCLPlatforms(CLDRIVE)[0],
@@ -137,6 +256,31 @@ class KernelRunInstance:
         )
 
         return stdout, stderr
+
+    def run_mem_bounds(self, clmem_exe=CLMEM):
+        """Run a hook-instrumented kernel and return the access bounds of each
+        argument, as recorded on the device by clmem."""
+        return RunClmemAccessBounds(
+            clmem_exe=clmem_exe,
+            src=self.kernel_code,
+            gsize=self.gsize,
+            lsize=self.lsize,
+            args_values=self.args_info,
+            cl_platform=self.device,
+            timeout=self.timeout,
+        )
+    
+    def infer_args_values(self, clmem_exe=CLMEM):
+        """Infer argument values at which a hook-instrumented kernel stays in
+        bounds at this launch config, with `clmem --infer_bounds`."""
+        return RunClmemInferBounds(
+            clmem_exe=clmem_exe,
+            src=self.kernel_code,
+            gsize=self.gsize,
+            lsize=self.lsize,
+            cl_platform=self.device,
+            timeout=self.timeout,
+        )
     
     def run_check(self):
         stdout, stderr = RunCLDrive(
@@ -170,6 +314,29 @@ class KernelRunInstance:
         df = ParseCLDriveStdoutToDataframe(stdout)
 
 
+        return df, stderr
+
+    def run_sweep(self, args_values_list, nrun=10):
+        """Run the kernel once per list of argument values, in a single cldrive
+        process. The rows of each list have its position in args_values_list
+        in their sweep_index column."""
+        with tempfile.NamedTemporaryFile("w", suffix=".json") as f:
+            WriteSweepFile(f.name, [(self.gsize, self.lsize)], args_values_list)
+            stdout, stderr = RunCLDrive(
+                cldrive_exe=self.cldrive_exe,
+                src=self.kernel_code,
+                num_runs=nrun,
+                lsize=self.lsize,
+                gsize=self.gsize,
+                args_values=None,
+                cl_platform=self.device,
+                timeout=self.timeout * max(len(args_values_list), 1),
+                output_format="csv",
+                sweep=f.name,
+            )
+
+        df = ParseCLDriveStdoutToDataframe(stdout)
+
         return df, stderr
 
 def gen_launch_configs(device_num_sm):
@@ -43,6 +43,26 @@ def get_kernel_info(cldrive_exe, kernel_path):
                         - error: {stderr}
                         - exception: {e}""")
 
+def get_kernel_signatures(cldrive_exe, path, envs=None):
+    """
+    Get the kernel signatures of every OpenCL source in a directory or
+    manifest, as a list of ProgramSignatures dicts.
+    """
+    cmd = [cldrive_exe, f"--signatures={path}"]
+    if envs:
+        cmd.append(f"--envs={envs}")
+    proc = subprocess.Popen(
+        cmd,
+        stdout=subprocess.PIPE,
+        stderr=subprocess.PIPE,
+        universal_newlines=True,
+    )
+    stdout, stderr = proc.communicate()
+    if proc.returncode:
+        raise Exception(f"""ERROR: Get kernel signatures failed with:\n
+                        - error: {stderr}""")
+    return [json.loads(line) for line in stdout.splitlines() if line]
+
 def setup_logging(logger_name: str = "gpu-code-gen") -> logging.Logger:
     """
     Set up logging for the project."""
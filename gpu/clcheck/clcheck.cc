@@ -22,10 +22,12 @@
 // You should have received a copy of the GNU General Public License
 // along with clcheck.  If not, see <https://www.gnu.org/licenses/>.
 #include "gpu/clcheck/libclcheck.h"
+#include "gpu/clcheck/mem_analysis_store.h"
 #include "gpu/clcheck/mem_analysis_util.h"
 
 #include "gpu/clcheck/logger.h"
 #include "gpu/clcheck/proto/clcheck.pb.h"
+#include "gpu/cldrive/program_cache.h"
 #include "gpu/clinfo/libclinfo.h"
 
 #include "labm8/cpp/app.h"
@@ -81,11 +83,22 @@ static bool ValidateSrcs(const char* flagname, const string& value) {
 }
 DEFINE_validator(srcs, &ValidateSrcs);
 
+DEFINE_string(mem_analysis_store, "",
+              "If set, look up memory analysis models in this store file, "
+              "as written by --pack_mem_analysis_store, before "
+              "--mem_analysis_dir. Store lookups are keyed by the stem of the "
+              "source file name, and do not read or parse JSON.");
+DEFINE_bool(pack_mem_analysis_store, false,
+            "Pack every '<stem>.json' file of --mem_analysis_dir into the "
+            "store file --mem_analysis_store, then exit.");
 DEFINE_string(mem_analysis_dir, "mem_analysis_info", "The directory to store the memory analysis information, "
                                                       "each source file corresponds to a json file with same name in this directory. "
                                                       "Example: if the source file is /path/to/file.cl, "
                                                       "then the memory analysis file is /path/to/mem_analysis_info/file.json");
 static bool ValidateMemAnalysis(const char* flagname, const string& value) {
+  if (!FLAGS_mem_analysis_store.empty()) {
+    return true;
+  }
   for (auto str_path : SplitCommaSeparated(FLAGS_srcs)) {
     if (!gpu::clcheck::mem_analysis::isMemAnalysisFileExists(str_path, value)) {
       LOG(WARNING) << "Memory analysis file not found for source file: " << str_path << ". Using default memory analysis setting."
@@ -135,6 +148,10 @@ DEFINE_int32(gsize, 1024,
              "work items are instantiated.");
 DEFINE_int32(lsize, 128, "The local (work group) size. Must be <= gsize.");
 DEFINE_string(cl_build_opt, "", "Build options passed to clBuildProgram().");
+DEFINE_string(cl_program_cache_dir, "",
+              "If set, cache compiled program binaries in this directory and "
+              "reuse them for later builds of the same source, build options, "
+              "and device.");
 DEFINE_int32(num_runs, 30, "The number of runs per kernel.");
 DEFINE_bool(clinfo, false, "List the available devices and exit.");
 
@@ -200,6 +217,27 @@ int main(int argc, char** argv) {
     return 0;
   }
 
+  if (!FLAGS_cl_program_cache_dir.empty()) {
+    gpu::cldrive::EnableProgramBinaryCache(FLAGS_cl_program_cache_dir);
+  }
+
+  if (FLAGS_pack_mem_analysis_store) {
+    CHECK(!FLAGS_mem_analysis_store.empty())
+        << "--pack_mem_analysis_store requires --mem_analysis_store";
+    gpu::clcheck::MemAnalysisStoreBuilder builder;
+    auto num_added_or = builder.AddDirectory(FLAGS_mem_analysis_dir);
+    CHECK(num_added_or.ok()) << num_added_or.status().ToString();
+    labm8::Status status = builder.Write(FLAGS_mem_analysis_store);
+    CHECK(status.ok()) << status.ToString();
+    LOG(INFO) << "Packed " << num_added_or.ValueOrDie()
+              << " memory analysis files into " << FLAGS_mem_analysis_store;
+    return 0;
+  }
+
+  if (!FLAGS_mem_analysis_store.empty()) {
+    gpu::clcheck::EnableMemAnalysisStore(FLAGS_mem_analysis_store);
+  }
+
   // Check that required flags are set. We can't check this in the flag
   // validator functions as they are only required if the early-exit flags
   // above are not set.
@@ -224,8 +262,6 @@ int main(int argc, char** argv) {
 
   int instance_num = 0;
   for (auto path : SplitCommaSeparated(FLAGS_srcs)) {
-    std::map<int,int> memAnalysis = gpu::clcheck::mem_analysis::getMemAnalysisInfo(path, FLAGS_mem_analysis_dir, FLAGS_gsize, FLAGS_lsize);
-    
     logger->StartNewInstance();
     instance->set_opencl_src(ReadFileOrDie(path));
     instance->set_mem_filepath(gpu::clcheck::mem_analysis::getMemAnalysisFilePath(path, FLAGS_mem_analysis_dir).string());
@@ -243,5 +279,9 @@ int main(int argc, char** argv) {
     ++instance_num;
   }
 
+  if (gpu::cldrive::GetProgramBinaryCache()) {
+    LOG(INFO) << gpu::cldrive::GetProgramBinaryCache()->StatsString();
+  }
+
   return 0;
 }
@@ -126,16 +126,10 @@ labm8::Status KernelDriver::RunDynamicParams(
   std::map<int,int> memAnalysisInfo = gpu::clcheck::mem_analysis::getMemAnalysisInfo(instance_.mem_filepath(), 
                                                                                       dynamic_params.global_size_x(), 
                                                                                       dynamic_params.local_size_x());
-  std::vector<long long> arrayBoundArgs;
-  int nArgs = kernel_.getInfo<CL_KERNEL_NUM_ARGS>();
-  for (int i = 0; i < nArgs; ++i) {
-    // if mem analysis info is not found, then use global size as array bound
-    if (memAnalysisInfo.find(i) != memAnalysisInfo.end()) {
-      kernel_instance_->add_arg_array_bounds(dynamic_params.global_size_x());
-    }
-    else {
-      kernel_instance_->add_arg_array_bounds(memAnalysisInfo[i]);
-    }
+  const int nArgs = kernel_.getInfo<CL_KERNEL_NUM_ARGS>();
+  for (long long bound : gpu::clcheck::mem_analysis::getArgArrayBounds(
+           memAnalysisInfo, nArgs, dynamic_params.global_size_x())) {
+    kernel_instance_->add_arg_array_bounds(bound);
   }
 
   // 2 warmup run
@@ -17,6 +17,7 @@
 
 #include "gpu/clcheck/kernel_arg_value.h"
 #include "gpu/clcheck/kernel_driver.h"
+#include "gpu/cldrive/program_cache.h"
 #include "gpu/clinfo/libclinfo.h"
 
 #include "labm8/cpp/logging.h"
@@ -36,37 +37,6 @@
 namespace gpu {
 namespace clcheck {
 
-namespace {
-
-// Attempt to build OpenCL program.
-labm8::StatusOr<cl::Program> BuildOpenClProgram(
-    const std::string& opencl_kernel, const cl::Context& context,
-    const string& cl_build_opts) {
-  auto start_time = absl::Now();
-  try {
-    // Assemble the build options. We need -cl-kernel-arg-info so that we can
-    // read the kernel signatures.
-    string all_build_opts = "-cl-kernel-arg-info ";
-    absl::StrAppend(&all_build_opts, cl_build_opts);
-    labm8::TrimRight(all_build_opts);
-
-    cl::Program program(context, opencl_kernel);
-    program.build(context.getInfo<CL_CONTEXT_DEVICES>(),
-                  all_build_opts.c_str());
-    auto end_time = absl::Now();
-    auto duration = (end_time - start_time) / absl::Milliseconds(1);
-    LOG(INFO) << "clBuildProgram() with options '" << all_build_opts
-              << "' completed in " << duration << " ms";
-    return program;
-  } catch (cl::Error e) {
-    LOG_CL_ERROR(WARNING, e);
-    return labm8::Status(labm8::error::Code::INVALID_ARGUMENT,
-                         "clBuildProgram failed");
-  }
-}
-
-}  // namespace
-
 Cldrive::Cldrive(CldriveInstance* instance, int instance_num)
     : instance_(instance),
       instance_num_(instance_num),
@@ -92,8 +62,9 @@ void Cldrive::DoRunOrDie(Logger& logger) {
                          /*properties=*/CL_QUEUE_PROFILING_ENABLE);
 
   // Compile program or fail.
-  labm8::StatusOr<cl::Program> program_or = BuildOpenClProgram(
-      string(instance_->opencl_src()), context, instance_->build_opts());
+  labm8::StatusOr<cl::Program> program_or =
+      ::gpu::cldrive::BuildOpenClProgram(string(instance_->opencl_src()),
+                                         context, instance_->build_opts());
   if (!program_or.ok()) {
     LOG(ERROR) << "OpenCL program compilation failed!";
     instance_->set_outcome(CldriveInstance::PROGRAM_COMPILATION_FAILURE);
@@ -0,0 +1,351 @@
+// Copyright (c) 2016-2020 Chris Cummins.
+// This file is part of clcheck.
+//
+// clcheck is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// clcheck is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with clcheck.  If not, see <https://www.gnu.org/licenses/>.
+#include "gpu/clcheck/mem_analysis_store.h"
+
+#include "labm8/cpp/logging.h"
+
+#include "absl/strings/str_format.h"
+
+#include "boost/filesystem.hpp"
+#include "boost/filesystem/fstream.hpp"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <json/json.h>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+
+namespace fs = boost::filesystem;
+
+namespace gpu {
+namespace clcheck {
+
+namespace {
+
+// The file is a header, then a power-of-two table of buckets, then the
+// argument records of every kernel, then the keys of every kernel. A bucket
+// with a zero key hash is empty.
+const char kMagic[8] = {'C', 'L', 'M', 'E', 'M', 'S', 'T', 'R'};
+const uint32_t kVersion = 2;
+// Written in native byte order, so that a store written on a machine of the
+// other endianness is rejected.
+const uint32_t kByteOrderMark = 0x01020304;
+
+// The records are mapped as written, so their layout must match that of the
+// machine which wrote the store. The header records the byte order and the
+// record sizes, and stores which differ are rejected.
+struct Header {
+  char magic[8];
+  uint32_t version;
+  uint32_t byte_order_mark;
+  uint32_t num_buckets;
+  uint16_t bucket_size;
+  uint16_t arg_size;
+  uint64_t num_kernels;
+  uint64_t num_args;
+  uint64_t keys_size;
+};
+
+struct Bucket {
+  uint64_t key_hash;
+  // The key is compared on a hash match, so that colliding keys are not
+  // confused.
+  uint64_t key_offset;
+  uint32_t key_size;
+  uint32_t first_arg;
+  uint32_t num_args;
+  uint32_t padding;
+};
+
+static_assert(sizeof(Header) == 48, "Unexpected store header layout");
+static_assert(sizeof(Bucket) == 32, "Unexpected store bucket layout");
+static_assert(sizeof(ArgBoundCoefficients) == 32,
+              "Unexpected store argument layout");
+
+std::unique_ptr<MemAnalysisStore> global_store;
+
+// Return the 64-bit FNV-1a hash of a key. Zero marks an empty bucket, so it
+// is never returned.
+uint64_t HashKey(const string& key) {
+  uint64_t hash = 14695981039346656037ull;
+  for (unsigned char c : key) {
+    hash ^= c;
+    hash *= 1099511628211ull;
+  }
+  return hash ? hash : 1;
+}
+
+const Header* GetHeader(const void* data) {
+  return static_cast<const Header*>(data);
+}
+
+const Bucket* GetBuckets(const void* data) {
+  return reinterpret_cast<const Bucket*>(static_cast<const char*>(data) +
+                                         sizeof(Header));
+}
+
+const ArgBoundCoefficients* GetArgs(const void* data) {
+  return reinterpret_cast<const ArgBoundCoefficients*>(
+      GetBuckets(data) + GetHeader(data)->num_buckets);
+}
+
+const char* GetKeys(const void* data) {
+  return reinterpret_cast<const char*>(GetArgs(data) +
+                                       GetHeader(data)->num_args);
+}
+
+}  // anonymous namespace
+
+int EvaluateArgBound(const ArgBoundCoefficients& arg, int global_size,
+                     int local_size) {
+  return std::round(arg.coef[0] * global_size + arg.coef[1] * local_size +
+                    arg.coef[2]) +
+         1;
+}
+
+labm8::StatusOr<std::vector<ArgBoundCoefficients>> ParseMemAnalysisJson(
+    const string& json) {
+  Json::Value root;
+  Json::CharReaderBuilder builder;
+  std::istringstream stream(json);
+  string errors;
+  if (!Json::parseFromStream(builder, stream, &root, &errors) ||
+      !root.isObject()) {
+    return labm8::Status(labm8::error::Code::INVALID_ARGUMENT,
+                         "Failed to parse memory analysis JSON: {}", errors);
+  }
+
+  std::vector<ArgBoundCoefficients> args;
+  for (const auto& name : root.getMemberNames()) {
+    const Json::Value& arg = root[name];
+    if (!arg.isObject() || !arg["arg_id"].isInt() || !arg["coef"].isArray() ||
+        arg["coef"].size() != 3) {
+      return labm8::Status(labm8::error::Code::INVALID_ARGUMENT,
+                           "Invalid memory analysis of argument '{}'", name);
+    }
+    ArgBoundCoefficients coefficients = {arg["arg_id"].asInt(), 0, {}};
+    for (int i = 0; i < 3; ++i) {
+      coefficients.coef[i] = arg["coef"][i].asDouble();
+    }
+    args.push_back(coefficients);
+  }
+  return args;
+}
+
+labm8::Status MemAnalysisStore::Open(const string& path,
+                                     std::unique_ptr<MemAnalysisStore>* store) {
+  const int fd = open(path.c_str(), O_RDONLY);
+  if (fd < 0) {
+    return labm8::Status(labm8::error::Code::NOT_FOUND,
+                         "Memory analysis store not found: '{}'", path);
+  }
+  struct stat st;
+  if (fstat(fd, &st) || static_cast<size_t>(st.st_size) < sizeof(Header)) {
+    close(fd);
+    return labm8::Status(labm8::error::Code::INVALID_ARGUMENT,
+                         "Not a memory analysis store: '{}'", path);
+  }
+  const size_t size = st.st_size;
+  void* data = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+  close(fd);
+  if (data == MAP_FAILED) {
+    return labm8::Status(labm8::error::Code::INTERNAL,
+                         "Failed to map memory analysis store: '{}'", path);
+  }
+
+  // Take ownership before validating, so that the mapping is released on
+  // error.
+  store->reset(new MemAnalysisStore(data, size));
+  const Header* header = GetHeader(data);
+  if (memcmp(header->magic, kMagic, sizeof(kMagic))) {
+    store->reset();
+    return labm8::Status(labm8::error::Code::INVALID_ARGUMENT,
+                         "Not a memory analysis store: '{}'", path);
+  }
+  if (header->version != kVersion ||
+      header->byte_order_mark != kByteOrderMark ||
+      header->bucket_size != sizeof(Bucket) ||
+      header->arg_size != sizeof(ArgBoundCoefficients)) {
+    store->reset();
+    return labm8::Status(labm8::error::Code::INVALID_ARGUMENT,
+                         "Memory analysis store '{}' was written by an "
+                         "incompatible version or machine, and must be "
+                         "repacked",
+                         path);
+  }
+  const uint32_t num_buckets = header->num_buckets;
+  if (!num_buckets || (num_buckets & (num_buckets - 1)) ||
+      size != sizeof(Header) + num_buckets * sizeof(Bucket) +
+                  header->num_args * sizeof(ArgBoundCoefficients) +
+                  header->keys_size) {
+    store->reset();
+    return labm8::Status(labm8::error::Code::INVALID_ARGUMENT,
+                         "Corrupt memory analysis store: '{}'", path);
+  }
+  return labm8::Status::OK;
+}
+
+MemAnalysisStore::MemAnalysisStore(const void* data, size_t size)
+    : data_(data), size_(size) {}
+
+MemAnalysisStore::~MemAnalysisStore() {
+  munmap(const_cast<void*>(data_), size_);
+}
+
+bool MemAnalysisStore::Lookup(const string& key, int global_size,
+                              int local_size,
+                              std::map<int, int>* bounds) const {
+  const Header* header = GetHeader(data_);
+  const Bucket* buckets = GetBuckets(data_);
+  const uint64_t hash = HashKey(key);
+  const uint32_t mask = header->num_buckets - 1;
+
+  // The table is at most half full, so probing always reaches an empty
+  // bucket.
+  for (uint32_t i = hash & mask; buckets[i].key_hash; i = (i + 1) & mask) {
+    if (buckets[i].key_hash != hash || buckets[i].key_size != key.size()) {
+      continue;
+    }
+    CHECK(buckets[i].key_offset + buckets[i].key_size <= header->keys_size &&
+          static_cast<uint64_t>(buckets[i].first_arg) + buckets[i].num_args <=
+              header->num_args)
+        << "Corrupt memory analysis store";
+    if (memcmp(GetKeys(data_) + buckets[i].key_offset, key.data(),
+               key.size())) {
+      continue;
+    }
+    const ArgBoundCoefficients* args = GetArgs(data_) + buckets[i].first_arg;
+    for (uint32_t j = 0; j < buckets[i].num_args; ++j) {
+      (*bounds)[args[j].arg_id] =
+          EvaluateArgBound(args[j], global_size, local_size);
+    }
+    return true;
+  }
+  return false;
+}
+
+size_t MemAnalysisStore::size() const { return GetHeader(data_)->num_kernels; }
+
+void MemAnalysisStoreBuilder::Add(
+    const string& key, const std::vector<ArgBoundCoefficients>& args) {
+  kernels_[key] = args;
+}
+
+labm8::StatusOr<size_t> MemAnalysisStoreBuilder::AddDirectory(
+    const string& dir) {
+  if (!fs::is_directory(dir)) {
+    return labm8::Status(labm8::error::Code::NOT_FOUND,
+                         "Directory not found: '{}'", dir);
+  }
+
+  size_t num_added = 0;
+  for (fs::directory_iterator it(dir), end; it != end; ++it) {
+    const fs::path& path = it->path();
+    if (!fs::is_regular_file(path) || path.extension() != ".json") {
+      continue;
+    }
+    fs::ifstream file(path);
+    std::stringstream buffer;
+    buffer << file.rdbuf();
+    auto args_or = ParseMemAnalysisJson(buffer.str());
+    if (!args_or.ok()) {
+      LOG(WARNING) << "Skipping '" << path.string()
+                   << "': " << args_or.status().ToString();
+      continue;
+    }
+    Add(path.stem().string(), args_or.ValueOrDie());
+    ++num_added;
+  }
+  return num_added;
+}
+
+labm8::Status MemAnalysisStoreBuilder::Write(const string& path) const {
+  Header header;
+  memcpy(header.magic, kMagic, sizeof(kMagic));
+  header.version = kVersion;
+  header.byte_order_mark = kByteOrderMark;
+  header.bucket_size = sizeof(Bucket);
+  header.arg_size = sizeof(ArgBoundCoefficients);
+  header.num_buckets = 1;
+  while (header.num_buckets < 2 * kernels_.size()) {
+    header.num_buckets *= 2;
+  }
+  header.num_kernels = kernels_.size();
+  header.num_args = 0;
+
+  std::vector<Bucket> buckets(header.num_buckets, Bucket{0, 0, 0, 0, 0, 0});
+  std::vector<ArgBoundCoefficients> args;
+  string keys;
+  const uint32_t mask = header.num_buckets - 1;
+  for (const auto& kernel : kernels_) {
+    const uint64_t hash = HashKey(kernel.first);
+    uint32_t i = hash & mask;
+    while (buckets[i].key_hash) {
+      i = (i + 1) & mask;
+    }
+    buckets[i] = {hash,
+                  keys.size(),
+                  static_cast<uint32_t>(kernel.first.size()),
+                  static_cast<uint32_t>(args.size()),
+                  static_cast<uint32_t>(kernel.second.size()),
+                  0};
+    args.insert(args.end(), kernel.second.begin(), kernel.second.end());
+    keys += kernel.first;
+  }
+  header.num_args = args.size();
+  header.keys_size = keys.size();
+
+  const string tmp_path = absl::StrFormat("%s.%d.tmp", path, getpid());
+  {
+    std::ofstream file(tmp_path, std::ios::binary);
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file.write(reinterpret_cast<const char*>(buckets.data()),
+               buckets.size() * sizeof(Bucket));
+    file.write(reinterpret_cast<const char*>(args.data()),
+               args.size() * sizeof(ArgBoundCoefficients));
+    file.write(keys.data(), keys.size());
+    if (!file) {
+      std::remove(tmp_path.c_str());
+      return labm8::Status(labm8::error::Code::INTERNAL,
+                           "Failed to write memory analysis store: '{}'",
+                           path);
+    }
+  }
+  if (std::rename(tmp_path.c_str(), path.c_str())) {
+    std::remove(tmp_path.c_str());
+    return labm8::Status(labm8::error::Code::INTERNAL,
+                         "Failed to write memory analysis store: '{}'", path);
+  }
+  return labm8::Status::OK;
+}
+
+void EnableMemAnalysisStore(const string& path) {
+  labm8::Status status = MemAnalysisStore::Open(path, &global_store);
+  if (!status.ok()) {
+    LOG(FATAL) << status.ToString();
+  }
+}
+
+const MemAnalysisStore* GetMemAnalysisStore() { return global_store.get(); }
+
+}  // namespace clcheck
+}  // namespace gpu
@@ -0,0 +1,119 @@
+// A memory-mapped store of memory analysis array bound models.
+//
+// Copyright (c) 2016-2020 Chris Cummins.
+// This file is part of clcheck.
+//
+// clcheck is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// clcheck is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with clcheck.  If not, see <https://www.gnu.org/licenses/>.
+#pragma once
+
+#include "labm8/cpp/macros.h"
+#include "labm8/cpp/status.h"
+#include "labm8/cpp/statusor.h"
+#include "labm8/cpp/string.h"
+
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <vector>
+
+namespace gpu {
+namespace clcheck {
+
+// The model of the array bound of a kernel argument at a launch:
+//     round(coef[0] * global_size + coef[1] * local_size + coef[2]) + 1
+// This is the layout of an argument record in the store.
+struct ArgBoundCoefficients {
+  int32_t arg_id;
+  uint32_t padding;
+  double coef[3];
+};
+
+// Return the array bound of an argument at a launch.
+int EvaluateArgBound(const ArgBoundCoefficients& arg, int global_size,
+                     int local_size);
+
+// Parse a memory analysis JSON file: an object of
+// {"arg_id": <int>, "coef": [<double>, <double>, <double>]} values, as
+// written by clmem --infer_bounds.
+labm8::StatusOr<std::vector<ArgBoundCoefficients>> ParseMemAnalysisJson(
+    const string& json);
+
+// A read-only store of the argument models of many kernels, in a single
+// memory-mapped file. Kernels are keyed by the stem of their memory analysis
+// JSON file name. Lookups are an open-addressed hash table probe into the
+// mapped file on the 64-bit FNV-1a hash of the key, and the stored key is
+// compared on a hash match. Opening a store does not read it, and lookups are
+// thread safe. A store must be read on a machine with the byte order and
+// record layout of the one which wrote it.
+class MemAnalysisStore {
+ public:
+  // Map a store file. Returns INVALID_ARGUMENT if the file is not a store, or
+  // was written by another version of the store or on an incompatible
+  // machine.
+  static labm8::Status Open(const string& path,
+                            std::unique_ptr<MemAnalysisStore>* store);
+
+  ~MemAnalysisStore();
+
+  // Set the array bound of each argument of the kernel at a launch. Returns
+  // false if the kernel is not in the store.
+  bool Lookup(const string& key, int global_size, int local_size,
+              std::map<int, int>* bounds) const;
+
+  // The number of kernels in the store.
+  size_t size() const;
+
+ private:
+  MemAnalysisStore(const void* data, size_t size);
+
+  const void* data_;
+  size_t size_;
+
+  DISALLOW_EVIL_CONSTRUCTORS(MemAnalysisStore);
+};
+
+// Builds a store file.
+class MemAnalysisStoreBuilder {
+ public:
+  MemAnalysisStoreBuilder() = default;
+
+  // Add the argument models of a kernel. A later model of the same key
+  // replaces an earlier one.
+  void Add(const string& key, const std::vector<ArgBoundCoefficients>& args);
+
+  // Add every '<key>.json' memory analysis file in a directory. Files which
+  // cannot be parsed are skipped with a warning. Returns the number of files
+  // added.
+  labm8::StatusOr<size_t> AddDirectory(const string& dir);
+
+  // Write the store. The file is written to a temporary path and renamed
+  // into place, so that concurrent readers never map a partial store.
+  labm8::Status Write(const string& path) const;
+
+ private:
+  std::map<string, std::vector<ArgBoundCoefficients>> kernels_;
+
+  DISALLOW_EVIL_CONSTRUCTORS(MemAnalysisStoreBuilder);
+};
+
+// Open the process-wide memory analysis store, or abort if it cannot be
+// opened.
+void EnableMemAnalysisStore(const string& path);
+
+// Return the process-wide memory analysis store, or nullptr if it has not been
+// enabled.
+const MemAnalysisStore* GetMemAnalysisStore();
+
+}  // namespace clcheck
+}  // namespace gpu
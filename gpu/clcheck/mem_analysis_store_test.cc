@@ -0,0 +1,203 @@
+// Copyright (c) 2016-2020 Chris Cummins.
+// This file is part of clcheck.
+//
+// clcheck is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// clcheck is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with clcheck.  If not, see <https://www.gnu.org/licenses/>.
+#include "gpu/clcheck/mem_analysis_store.h"
+
+#include "labm8/cpp/logging.h"
+#include "labm8/cpp/test.h"
+
+#include <stdlib.h>
+#include <fstream>
+
+namespace gpu {
+namespace clcheck {
+namespace {
+
+string MakeTemporaryDirectory() {
+  char path[] = "/tmp/mem_analysis_store_test_XXXXXX";
+  CHECK(mkdtemp(path));
+  return path;
+}
+
+void WriteFile(const string& path, const string& contents) {
+  std::ofstream file(path);
+  file << contents;
+}
+
+TEST(ParseMemAnalysisJson, ArgumentModels) {
+  auto args_or = ParseMemAnalysisJson(
+      "{\"a\": {\"arg_id\": 0, \"coef\": [1, 0, -1]},"
+      " \"n\": {\"arg_id\": 1, \"coef\": [0, 0, 3]}}");
+  ASSERT_TRUE(args_or.ok());
+  const auto& args = args_or.ValueOrDie();
+  ASSERT_EQ(args.size(), 2);
+  EXPECT_EQ(args[0].arg_id, 0);
+  EXPECT_EQ(EvaluateArgBound(args[0], 1024, 128), 1024);
+  EXPECT_EQ(args[1].arg_id, 1);
+  EXPECT_EQ(EvaluateArgBound(args[1], 1024, 128), 4);
+}
+
+TEST(ParseMemAnalysisJson, InvalidJson) {
+  EXPECT_FALSE(ParseMemAnalysisJson("{").ok());
+  EXPECT_FALSE(ParseMemAnalysisJson("[]").ok());
+  EXPECT_FALSE(ParseMemAnalysisJson("{\"a\": {\"arg_id\": 0}}").ok());
+  EXPECT_FALSE(
+      ParseMemAnalysisJson("{\"a\": {\"arg_id\": 0, \"coef\": [1, 0]}}").ok());
+}
+
+TEST(EvaluateArgBound, LocalSizeTerm) {
+  const ArgBoundCoefficients arg = {0, 0, {2, 1, 0.4}};
+  EXPECT_EQ(EvaluateArgBound(arg, 100, 10), 211);
+}
+
+TEST(MemAnalysisStore, LookupAfterWrite) {
+  const string path = MakeTemporaryDirectory() + "/store";
+  MemAnalysisStoreBuilder builder;
+  builder.Add("kernel_a", {{0, 0, {1, 0, -1}}, {2, 0, {0, 1, -1}}});
+  builder.Add("kernel_b", {{1, 0, {2, 0, 0}}});
+  builder.Add("kernel_c", {});
+  ASSERT_TRUE(builder.Write(path).ok());
+
+  std::unique_ptr<MemAnalysisStore> store;
+  ASSERT_TRUE(MemAnalysisStore::Open(path, &store).ok());
+  EXPECT_EQ(store->size(), 3);
+
+  std::map<int, int> bounds;
+  ASSERT_TRUE(store->Lookup("kernel_a", 512, 64, &bounds));
+  EXPECT_EQ(bounds.size(), 2);
+  EXPECT_EQ(bounds[0], 512);
+  EXPECT_EQ(bounds[2], 64);
+
+  bounds.clear();
+  ASSERT_TRUE(store->Lookup("kernel_b", 512, 64, &bounds));
+  EXPECT_EQ(bounds.size(), 1);
+  EXPECT_EQ(bounds[1], 1025);
+
+  bounds.clear();
+  EXPECT_TRUE(store->Lookup("kernel_c", 512, 64, &bounds));
+  EXPECT_TRUE(bounds.empty());
+
+  EXPECT_FALSE(store->Lookup("kernel_d", 512, 64, &bounds));
+}
+
+TEST(MemAnalysisStore, ManyKernels) {
+  const string path = MakeTemporaryDirectory() + "/store";
+  MemAnalysisStoreBuilder builder;
+  for (int i = 0; i < 1000; ++i) {
+    builder.Add("kernel_" + std::to_string(i), {{i, 0, {0, 0, double(i)}}});
+  }
+  ASSERT_TRUE(builder.Write(path).ok());
+
+  std::unique_ptr<MemAnalysisStore> store;
+  ASSERT_TRUE(MemAnalysisStore::Open(path, &store).ok());
+  EXPECT_EQ(store->size(), 1000);
+  for (int i = 0; i < 1000; ++i) {
+    std::map<int, int> bounds;
+    ASSERT_TRUE(
+        store->Lookup("kernel_" + std::to_string(i), 1024, 128, &bounds));
+    EXPECT_EQ(bounds[i], i + 1);
+  }
+}
+
+TEST(MemAnalysisStore, EmptyStore) {
+  const string path = MakeTemporaryDirectory() + "/store";
+  ASSERT_TRUE(MemAnalysisStoreBuilder().Write(path).ok());
+
+  std::unique_ptr<MemAnalysisStore> store;
+  ASSERT_TRUE(MemAnalysisStore::Open(path, &store).ok());
+  EXPECT_EQ(store->size(), 0);
+  std::map<int, int> bounds;
+  EXPECT_FALSE(store->Lookup("kernel", 1024, 128, &bounds));
+}
+
+TEST(MemAnalysisStore, OpenInvalidFile) {
+  const string root = MakeTemporaryDirectory();
+  WriteFile(root + "/store", "not a memory analysis store, but long enough");
+
+  std::unique_ptr<MemAnalysisStore> store;
+  EXPECT_EQ(MemAnalysisStore::Open(root + "/store", &store).error_code(),
+            labm8::error::Code::INVALID_ARGUMENT);
+  EXPECT_FALSE(store);
+  EXPECT_EQ(MemAnalysisStore::Open(root + "/missing", &store).error_code(),
+            labm8::error::Code::NOT_FOUND);
+}
+
+TEST(MemAnalysisStore, OpenIncompatibleStore) {
+  const string path = MakeTemporaryDirectory() + "/store";
+  MemAnalysisStoreBuilder builder;
+  builder.Add("kernel", {{0, 0, {1, 0, 0}}});
+
+  // The version, then the byte order mark, follow the 8 byte magic.
+  for (int offset : {8, 12}) {
+    ASSERT_TRUE(builder.Write(path).ok());
+    {
+      std::fstream file(path, std::ios::in | std::ios::out | std::ios::binary);
+      file.seekp(offset);
+      file.put(0x7f);
+    }
+    std::unique_ptr<MemAnalysisStore> store;
+    EXPECT_EQ(MemAnalysisStore::Open(path, &store).error_code(),
+              labm8::error::Code::INVALID_ARGUMENT);
+    EXPECT_FALSE(store);
+  }
+}
+
+TEST(MemAnalysisStore, LookupComparesKeys) {
+  const string path = MakeTemporaryDirectory() + "/store";
+  MemAnalysisStoreBuilder builder;
+  builder.Add("kernel", {{0, 0, {1, 0, 0}}});
+  ASSERT_TRUE(builder.Write(path).ok());
+
+  std::unique_ptr<MemAnalysisStore> store;
+  ASSERT_TRUE(MemAnalysisStore::Open(path, &store).ok());
+  std::map<int, int> bounds;
+  EXPECT_FALSE(store->Lookup("kerne", 1024, 128, &bounds));
+  EXPECT_FALSE(store->Lookup("kernel_", 1024, 128, &bounds));
+  EXPECT_FALSE(store->Lookup(string("kernel\0", 7), 1024, 128, &bounds));
+  EXPECT_TRUE(store->Lookup("kernel", 1024, 128, &bounds));
+}
+
+TEST(MemAnalysisStoreBuilder, AddDirectory) {
+  const string root = MakeTemporaryDirectory();
+  WriteFile(root + "/kernel_a.json",
+            "{\"a\": {\"arg_id\": 0, \"coef\": [1, 0, -1]}}");
+  WriteFile(root + "/kernel_b.json", "not json");
+  WriteFile(root + "/kernel_c.txt", "{}");
+
+  MemAnalysisStoreBuilder builder;
+  auto num_added_or = builder.AddDirectory(root);
+  ASSERT_TRUE(num_added_or.ok());
+  EXPECT_EQ(num_added_or.ValueOrDie(), 1);
+  ASSERT_TRUE(builder.Write(root + "/store").ok());
+
+  std::unique_ptr<MemAnalysisStore> store;
+  ASSERT_TRUE(MemAnalysisStore::Open(root + "/store", &store).ok());
+  std::map<int, int> bounds;
+  ASSERT_TRUE(store->Lookup("kernel_a", 256, 32, &bounds));
+  EXPECT_EQ(bounds[0], 256);
+  EXPECT_FALSE(store->Lookup("kernel_b", 256, 32, &bounds));
+}
+
+TEST(MemAnalysisStoreBuilder, AddDirectoryNotFound) {
+  MemAnalysisStoreBuilder builder;
+  EXPECT_EQ(builder.AddDirectory("/not/a/directory").status().error_code(),
+            labm8::error::Code::NOT_FOUND);
+}
+
+}  // anonymous namespace
+}  // namespace clcheck
+}  // namespace gpu
+
+TEST_MAIN();
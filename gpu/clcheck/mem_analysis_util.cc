@@ -25,34 +25,36 @@ namespace mem_analysis {
   std::map<int,int> getMemAnalysisInfo(boost::filesystem::path memFilePath, int gsize, int lsize) {
     std::map<int, int> memAnalysisInfo;
 
-    // If the file not exists, then use default memory analysis setting (empty)
-    if (boost::filesystem::exists(memFilePath) == false) {
+    // Look up the memory analysis store first, if enabled, by the file stem
+    const MemAnalysisStore* store = GetMemAnalysisStore();
+    if (store && store->Lookup(memFilePath.stem().string(), gsize, lsize, &memAnalysisInfo)) {
       return memAnalysisInfo;
     }
 
-    std::ifstream jsonFile(memFilePath.string());
-
-    // Read the JSON content into a string
-    std::string jsonData((std::istreambuf_iterator<char>(jsonFile)),
-                         std::istreambuf_iterator<char>());
-
-    // Close the file
-    jsonFile.close();
-
-    // Parse the JSON data
-    Json::Value root;
-    Json::Reader reader;
-
-    CHECK(reader.parse(jsonData, root)) << "Failed to parse JSON data: " << reader.getFormattedErrorMessages() << "\n";
+    // Each file is parsed once per process, then evaluated from the cache
+    static std::mutex cacheMutex;
+    static std::map<std::string, std::vector<ArgBoundCoefficients>> cache;
+    std::lock_guard<std::mutex> lock(cacheMutex);
+
+    auto it = cache.find(memFilePath.string());
+    if (it == cache.end()) {
+      std::vector<ArgBoundCoefficients> args;
+
+      // If the file not exists, then use default memory analysis setting (empty)
+      if (boost::filesystem::exists(memFilePath)) {
+        boost::filesystem::ifstream jsonFile(memFilePath);
+        std::stringstream jsonData;
+        jsonData << jsonFile.rdbuf();
+
+        auto argsOr = ParseMemAnalysisJson(jsonData.str());
+        CHECK(argsOr.ok()) << "Failed to parse " << memFilePath.string() << ": " << argsOr.status().ToString();
+        args = argsOr.ValueOrDie();
+      }
+      it = cache.emplace(memFilePath.string(), std::move(args)).first;
+    }
 
-    // Iterate through children of root and get the memory analysis information
-    for (const auto& child : root.getMemberNames()) {
-        const Json::Value& currentChild = root[child];
-        int argId = currentChild["arg_id"].asInt();
-        int arraySize = std::round(currentChild["coef"][0].asDouble() * gsize 
-                              + currentChild["coef"][1].asDouble() * lsize 
-                              + currentChild["coef"][2].asDouble()) + 1;
-        memAnalysisInfo[argId] = arraySize;
+    for (const auto& arg : it->second) {
+      memAnalysisInfo[arg.arg_id] = EvaluateArgBound(arg, gsize, lsize);
     }
 
     return memAnalysisInfo;
@@ -69,6 +71,16 @@ namespace mem_analysis {
     boost::filesystem::path memFilePath = getMemAnalysisFilePath(sourceFile_, memAnalysisDir_);
     return getMemAnalysisInfo(memFilePath, gsize, lsize);
   }
+
+  std::vector<long long> getArgArrayBounds(const std::map<int, int>& memAnalysisInfo, int nArgs, int gsize) {
+    std::vector<long long> arrayBounds;
+    for (int i = 0; i < nArgs; ++i) {
+      // if mem analysis info is not found, then use global size as array bound
+      auto bound = memAnalysisInfo.find(i);
+      arrayBounds.push_back(bound == memAnalysisInfo.end() ? gsize : bound->second);
+    }
+    return arrayBounds;
+  }
 }
 }
 }
@@ -1,11 +1,16 @@
+#include "gpu/clcheck/mem_analysis_store.h"
+
 #include "boost/filesystem.hpp"
 #include "boost/filesystem/fstream.hpp"
 #include "labm8/cpp/logging.h"
 
 #include <json/json.h>
+#include <mutex>
 #include <sstream>
 #include <iostream>
 #include <cmath>
+#include <map>
+#include <vector>
 
 namespace gpu {
 namespace clcheck {
@@ -16,10 +21,17 @@ namespace mem_analysis {
   // check if the memory analysis file exists
   bool isMemAnalysisFileExists(std::string filePathToCheck_, std::string memAnalysisDir_);
 
-  // get the memory analysis information from the memory analysis file
+  // get the memory analysis information from the memory analysis store, if
+  // enabled, else from the memory analysis file. Each file is parsed once per
+  // process.
   std::map<int,int> getMemAnalysisInfo(boost::filesystem::path memFilePath, int gsize, int lsize);
   std::map<int,int> getMemAnalysisInfo(std::string memFilePathStr, int gsize, int lsize);
   std::map<int, int> getMemAnalysisInfo(std::string sourceFile_, std::string memAnalysisDir_, int gsize, int lsize);
+
+  // get the array bound of each of nArgs arguments from the memory analysis
+  // information. Arguments without memory analysis information are bound by
+  // the global size.
+  std::vector<long long> getArgArrayBounds(const std::map<int, int>& memAnalysisInfo, int nArgs, int gsize);
 }
 }
 }
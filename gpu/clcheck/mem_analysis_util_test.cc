@@ -0,0 +1,41 @@
+// Copyright (c) 2016-2020 Chris Cummins.
+// This file is part of clcheck.
+//
+// clcheck is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// clcheck is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with clcheck.  If not, see <https://www.gnu.org/licenses/>.
+#include "gpu/clcheck/mem_analysis_util.h"
+
+#include "labm8/cpp/test.h"
+
+namespace gpu {
+namespace clcheck {
+namespace mem_analysis {
+namespace {
+
+TEST(GetArgArrayBounds, ArgumentsWithInfoUseTheirBound) {
+  const std::map<int, int> memAnalysisInfo = {{0, 2048}, {2, 7}};
+  EXPECT_EQ(getArgArrayBounds(memAnalysisInfo, /*nArgs=*/3, /*gsize=*/1024),
+            std::vector<long long>({2048, 1024, 7}));
+}
+
+TEST(GetArgArrayBounds, NoInfoUsesTheGlobalSize) {
+  EXPECT_EQ(getArgArrayBounds({}, /*nArgs=*/2, /*gsize=*/1024),
+            std::vector<long long>({1024, 1024}));
+}
+
+}  // anonymous namespace
+}  // namespace mem_analysis
+}  // namespace clcheck
+}  // namespace gpu
+
+TEST_MAIN();
@@ -17,9 +17,12 @@
 import csv
 import io
 import subprocess
+import typing
 
 import numpy as np
 import pandas as pd
+from google.protobuf.internal import decoder as _decoder
+from google.protobuf.internal import encoder as _encoder
 
 from gpu.cldrive.legacy import env as _env
 from gpu.cldrive.proto import cldrive_pb2
@@ -32,6 +35,7 @@ FLAGS = app.FLAGS
 
 _NATIVE_DRIVER = bazelutil.DataPath("phd/gpu/cldrive/native_driver")
 _NATIVE_CSV_DRIVER = bazelutil.DataPath("phd/gpu/cldrive/native_csv_driver")
+_CLDRIVE = bazelutil.DataPath("phd/gpu/cldrive/cldrive")
 
 
 class CldriveCrash(OSError):
@@ -88,11 +92,23 @@ def DriveToDataFrame(
         "work_item_local_mem_size": "Int64",
         "work_item_private_mem_size": "Int64",
         "global_size": "Int32",
+        "global_size_y": "Int32",
+        "global_size_z": "Int32",
         "local_size": "Int32",
         "outcome": str,
         "transferred_bytes": "Int64",
         "transfer_time_ns": "Int64",
         "kernel_time_ns": "Int64",
+        "host_to_device_bytes": "Int64",
+        "host_to_device_time_ns": "Int64",
+        "host_to_device_gbps": np.float64,
+        "device_to_host_bytes": "Int64",
+        "device_to_host_time_ns": "Int64",
+        "device_to_host_gbps": np.float64,
+        "arg_transfers": str,
+        "tuning_rounds": "Int32",
+        "best_local_size": "Int32",
+        "sweep_index": "Int32",
       },
     )
   except subprocess.CalledProcessError as e:
@@ -114,3 +130,83 @@ def DriveToDataFrame(
   assert not pd.isna(df["outcome"]).any()
 
   return df
+
+
+def ParseDelimitedResults(data: bytes) -> typing.Iterator[cldrive_pb2.CldriveResult]:
+  """Parse the output of `cldrive --output_format=pbdelim`.
+
+  Results are streamed as they complete, so the output of a killed process
+  may end with a truncated result. A truncated result is ignored.
+  """
+  pos = 0
+  while pos < len(data):
+    try:
+      size, start = _decoder._DecodeVarint32(data, pos)
+    except IndexError:
+      return
+    if start + size > len(data):
+      return
+    result = cldrive_pb2.CldriveResult()
+    result.ParseFromString(data[start : start + size])
+    yield result
+    pos = start + size
+
+
+class CldriveServer(object):
+  """A persistent `cldrive --serve` process.
+
+  The server keeps one OpenCL context and command queue per device, and a table
+  of compiled programs, alive between calls to Drive(). Only the first instance
+  for a given device and program pays the start-up and compilation cost.
+
+  Usage:
+
+    with api.CldriveServer() as server:
+      for instance in instances:
+        result = server.Drive(instance)
+  """
+
+  def __init__(self, cldrive_path=_CLDRIVE):
+    self._process = subprocess.Popen(
+      [str(cldrive_path), "--serve"],
+      stdin=subprocess.PIPE,
+      stdout=subprocess.PIPE,
+    )
+
+  def Drive(
+    self, instance: cldrive_pb2.CldriveInstance
+  ) -> cldrive_pb2.CldriveInstance:
+    """Drive an instance and return it with its output fields set."""
+    serialized = instance.SerializeToString()
+    self._process.stdin.write(_encoder._VarintBytes(len(serialized)))
+    self._process.stdin.write(serialized)
+    self._process.stdin.flush()
+
+    # Read the varint length prefix one byte at a time.
+    prefix = b""
+    while True:
+      byte = self._process.stdout.read(1)
+      if not byte:
+        raise CldriveCrash(
+          f"cldrive server exited with returncode {self._process.poll()}"
+        )
+      prefix += byte
+      if not ord(byte) & 0x80:
+        break
+    size, _ = _decoder._DecodeVarint32(prefix, 0)
+
+    result = cldrive_pb2.CldriveInstance()
+    result.ParseFromString(self._process.stdout.read(size))
+    return result
+
+  def Close(self) -> None:
+    """Shut down the server."""
+    if self._process.poll() is None:
+      self._process.stdin.close()
+      self._process.wait()
+
+  def __enter__(self) -> "CldriveServer":
+    return self
+
+  def __exit__(self, *args) -> None:
+    self.Close()
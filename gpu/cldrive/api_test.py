@@ -16,6 +16,7 @@
 """Unit tests for //gpu/cldrive:api."""
 import numpy as np
 import pytest
+from google.protobuf.internal import encoder
 
 from gpu.cldrive import api
 from gpu.cldrive.legacy import env
@@ -168,5 +169,16 @@ def test_DriveToDataFrame_device_not_found(device: env.OpenCLEnvironment):
     )
 
 
+def test_ParseDelimitedResults_ignores_truncated_result():
+  data = b""
+  for instance_num in range(3):
+    serialized = cldrive_pb2.CldriveResult(
+      instance_num=instance_num, build_opts="-O3"
+    ).SerializeToString()
+    data += encoder._VarintBytes(len(serialized)) + serialized
+  results = list(api.ParseDelimitedResults(data[:-1]))
+  assert [r.instance_num for r in results] == [0, 1]
+
+
 if __name__ == "__main__":
   test.Main()
@@ -0,0 +1,227 @@
+// Copyright (c) 2016-2020 Chris Cummins.
+// This file is part of cldrive.
+//
+// cldrive is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// cldrive is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with cldrive.  If not, see <https://www.gnu.org/licenses/>.
+#include "gpu/cldrive/buffer_compare.h"
+
+#include "absl/strings/str_format.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace gpu {
+namespace cldrive {
+
+namespace {
+
+// The size of the blocks which are compared with memcmp() before comparing
+// their elements.
+const size_t kBlockSize = 4096;
+
+// The scalar type of each vector type family, in the order of OpenClType.
+const ElementFormat kVectorFamilies[] = {
+    {ElementFormat::SIGNED, 1, 1, 1},   {ElementFormat::UNSIGNED, 1, 1, 1},
+    {ElementFormat::SIGNED, 2, 1, 1},   {ElementFormat::UNSIGNED, 2, 1, 1},
+    {ElementFormat::SIGNED, 4, 1, 1},   {ElementFormat::UNSIGNED, 4, 1, 1},
+    {ElementFormat::SIGNED, 8, 1, 1},   {ElementFormat::UNSIGNED, 8, 1, 1},
+    {ElementFormat::FLOAT, 4, 1, 1},    {ElementFormat::DOUBLE, 8, 1, 1},
+    {ElementFormat::HALF, 2, 1, 1},
+};
+
+// The widths of the vector types of a family, in the order of OpenClType.
+const int kVectorWidths[] = {2, 3, 4, 8, 16};
+
+static_assert(OpenClType::HALF - OpenClType::CHAR + 1 ==
+                  sizeof(kVectorFamilies) / sizeof(kVectorFamilies[0]),
+              "Scalar types out of sync with OpenClType");
+static_assert(OpenClType::HALF16 - OpenClType::CHAR2 + 1 ==
+                  sizeof(kVectorFamilies) / sizeof(kVectorFamilies[0]) *
+                      sizeof(kVectorWidths) / sizeof(kVectorWidths[0]),
+              "Vector types out of sync with OpenClType");
+
+uint64_t LoadLane(const ElementFormat& format, const unsigned char* lane) {
+  switch (format.lane_size) {
+    case 1:
+      return *lane;
+    case 2: {
+      uint16_t value;
+      memcpy(&value, lane, sizeof(value));
+      return value;
+    }
+    case 4: {
+      uint32_t value;
+      memcpy(&value, lane, sizeof(value));
+      return value;
+    }
+    default: {
+      uint64_t value;
+      memcpy(&value, lane, sizeof(value));
+      return value;
+    }
+  }
+}
+
+bool IsNan(const ElementFormat& format, uint64_t bits) {
+  switch (format.kind) {
+    case ElementFormat::HALF:
+      return (bits & 0x7c00u) == 0x7c00u && (bits & 0x03ffu);
+    case ElementFormat::FLOAT:
+      return (bits & 0x7f800000u) == 0x7f800000u && (bits & 0x007fffffu);
+    case ElementFormat::DOUBLE:
+      return (bits & 0x7ff0000000000000ull) == 0x7ff0000000000000ull &&
+             (bits & 0x000fffffffffffffull);
+    default:
+      return false;
+  }
+}
+
+// Map the bits of a sign-magnitude floating point value to an unsigned
+// integer of the same order, so that adjacent values differ by one. Positive
+// and negative zero map to the same integer.
+uint64_t OrderedBits(const ElementFormat& format, uint64_t bits) {
+  const uint64_t sign = 1ull << (8 * format.lane_size - 1);
+  const uint64_t magnitude = bits & (sign - 1);
+  return (bits & sign) ? sign - magnitude : sign + magnitude;
+}
+
+float HalfToFloat(uint16_t bits) {
+  const int exponent = (bits >> 10) & 0x1f;
+  const int mantissa = bits & 0x3ff;
+  float value;
+  if (exponent == 0) {
+    value = std::ldexp(static_cast<float>(mantissa), -24);
+  } else if (exponent == 0x1f) {
+    value = mantissa ? NAN : INFINITY;
+  } else {
+    value = std::ldexp(static_cast<float>(mantissa | 0x400), exponent - 25);
+  }
+  return (bits & 0x8000) ? -value : value;
+}
+
+}  // anonymous namespace
+
+labm8::StatusOr<ElementFormat> GetElementFormat(const OpenClType& type) {
+  if (type == OpenClType::BOOL) {
+    return ElementFormat{ElementFormat::UNSIGNED, sizeof(cl_bool), 1, 1};
+  }
+  if (type >= OpenClType::CHAR && type <= OpenClType::HALF) {
+    return kVectorFamilies[type - OpenClType::CHAR];
+  }
+  if (type >= OpenClType::CHAR2 && type <= OpenClType::HALF16) {
+    const int num_widths = sizeof(kVectorWidths) / sizeof(kVectorWidths[0]);
+    ElementFormat format = kVectorFamilies[(type - OpenClType::CHAR2) /
+                                           num_widths];
+    format.num_lanes = kVectorWidths[(type - OpenClType::CHAR2) % num_widths];
+    format.lane_stride = format.num_lanes == 3 ? 4 : format.num_lanes;
+    return format;
+  }
+  return labm8::Status(labm8::error::Code::INVALID_ARGUMENT,
+                       "Unknown OpenCL type");
+}
+
+BufferDiff CompareBuffers(const ElementFormat& format, const void* a,
+                          const void* b, size_t num_elements,
+                          uint64_t max_ulps) {
+  const unsigned char* a_bytes = static_cast<const unsigned char*>(a);
+  const unsigned char* b_bytes = static_cast<const unsigned char*>(b);
+  const size_t element_size = format.element_size();
+  const size_t block_elements = std::max<size_t>(kBlockSize / element_size, 1);
+  const bool is_float = format.kind == ElementFormat::HALF ||
+                        format.kind == ElementFormat::FLOAT ||
+                        format.kind == ElementFormat::DOUBLE;
+
+  BufferDiff diff;
+  for (size_t block = 0; block < num_elements; block += block_elements) {
+    const size_t block_end = std::min(block + block_elements, num_elements);
+    if (!memcmp(a_bytes + block * element_size, b_bytes + block * element_size,
+                (block_end - block) * element_size)) {
+      continue;
+    }
+
+    for (size_t i = block; i < block_end; ++i) {
+      bool mismatch = false;
+      for (int lane = 0; lane < format.num_lanes; ++lane) {
+        const size_t offset = i * element_size + lane * format.lane_size;
+        const uint64_t a_bits = LoadLane(format, a_bytes + offset);
+        const uint64_t b_bits = LoadLane(format, b_bytes + offset);
+        if (a_bits == b_bits) {
+          continue;
+        }
+
+        bool lane_mismatch = true;
+        if (is_float) {
+          const bool a_nan = IsNan(format, a_bits);
+          const bool b_nan = IsNan(format, b_bits);
+          if (a_nan || b_nan) {
+            lane_mismatch = a_nan != b_nan;
+          } else {
+            const uint64_t a_ordered = OrderedBits(format, a_bits);
+            const uint64_t b_ordered = OrderedBits(format, b_bits);
+            const uint64_t distance = a_ordered > b_ordered
+                                          ? a_ordered - b_ordered
+                                          : b_ordered - a_ordered;
+            diff.max_ulp_distance = std::max(diff.max_ulp_distance, distance);
+            lane_mismatch = distance > max_ulps;
+          }
+        }
+
+        if (lane_mismatch && !mismatch) {
+          mismatch = true;
+          if (diff.first_mismatch_index < 0) {
+            diff.first_mismatch_index = i;
+            diff.first_mismatch_lane = lane;
+          }
+        }
+      }
+      diff.num_mismatches += mismatch;
+    }
+  }
+  return diff;
+}
+
+string LaneToString(const ElementFormat& format, const void* data,
+                    size_t element_index, int lane) {
+  const uint64_t bits = LoadLane(
+      format, static_cast<const unsigned char*>(data) +
+                  element_index * format.element_size() +
+                  lane * format.lane_size);
+  switch (format.kind) {
+    case ElementFormat::SIGNED: {
+      // Sign-extend the lane.
+      const int shift = 64 - 8 * format.lane_size;
+      return absl::StrFormat("%d",
+                             static_cast<int64_t>(bits << shift) >> shift);
+    }
+    case ElementFormat::UNSIGNED:
+      return absl::StrFormat("%d", bits);
+    case ElementFormat::HALF:
+      return absl::StrFormat("%.5g", HalfToFloat(bits));
+    case ElementFormat::FLOAT: {
+      float value;
+      const uint32_t float_bits = bits;
+      memcpy(&value, &float_bits, sizeof(value));
+      return absl::StrFormat("%.9g", value);
+    }
+    case ElementFormat::DOUBLE: {
+      double value;
+      memcpy(&value, &bits, sizeof(value));
+      return absl::StrFormat("%.17g", value);
+    }
+  }
+  return "";
+}
+
+}  // namespace cldrive
+}  // namespace gpu
@@ -0,0 +1,80 @@
+// Type-aware comparison of host buffers of OpenCL values.
+//
+// Copyright (c) 2016-2020 Chris Cummins.
+// This file is part of cldrive.
+//
+// cldrive is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// cldrive is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with cldrive.  If not, see <https://www.gnu.org/licenses/>.
+#pragma once
+
+#include "gpu/cldrive/opencl_type.h"
+
+#include "labm8/cpp/statusor.h"
+#include "labm8/cpp/string.h"
+
+#include <cstddef>
+#include <cstdint>
+
+namespace gpu {
+namespace cldrive {
+
+// The memory layout of the elements of an OpenCL type. Vector types are
+// compared lane by lane.
+struct ElementFormat {
+  enum Kind { SIGNED, UNSIGNED, HALF, FLOAT, DOUBLE };
+  Kind kind;
+  // The size of a lane, in bytes.
+  size_t lane_size;
+  // The number of lanes which hold values.
+  int num_lanes;
+  // The number of lanes which an element occupies. 3-component vectors are
+  // stored as 4-component vectors, and the padding lane is not compared.
+  int lane_stride;
+
+  size_t element_size() const { return lane_size * lane_stride; }
+};
+
+// Return the element format of an OpenCL type. Returns INVALID_ARGUMENT for
+// DEFAULT_UNKNOWN.
+labm8::StatusOr<ElementFormat> GetElementFormat(const OpenClType& type);
+
+// The differences between two buffers.
+struct BufferDiff {
+  // The number of elements with at least one mismatching lane.
+  size_t num_mismatches = 0;
+  // The index of the first mismatching element and lane, or -1 if the buffers
+  // match.
+  int64_t first_mismatch_index = -1;
+  int first_mismatch_lane = -1;
+  // The largest distance in units in the last place between two lanes, for
+  // half, float and double elements.
+  uint64_t max_ulp_distance = 0;
+};
+
+// Compare two buffers of num_elements elements. Integer lanes must be equal.
+// Floating point lanes must be within max_ulps units in the last place of
+// each other, and NaNs are equal to NaNs. Buffers are first compared a block
+// at a time with memcmp(), and only the elements of blocks which differ are
+// compared lane by lane, so matching buffers are compared at memory
+// bandwidth.
+BufferDiff CompareBuffers(const ElementFormat& format, const void* a,
+                          const void* b, size_t num_elements,
+                          uint64_t max_ulps);
+
+// Return the value of a lane of an element, e.g. for reporting the first
+// mismatch of a BufferDiff.
+string LaneToString(const ElementFormat& format, const void* data,
+                    size_t element_index, int lane);
+
+}  // namespace cldrive
+}  // namespace gpu
@@ -0,0 +1,180 @@
+// Copyright (c) 2016-2020 Chris Cummins.
+// This file is part of cldrive.
+//
+// cldrive is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// cldrive is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with cldrive.  If not, see <https://www.gnu.org/licenses/>.
+#include "gpu/cldrive/buffer_compare.h"
+
+#include "labm8/cpp/logging.h"
+#include "labm8/cpp/test.h"
+
+#include <cmath>
+#include <limits>
+#include <vector>
+
+namespace gpu {
+namespace cldrive {
+namespace {
+
+ElementFormat GetFormat(const OpenClType& type) {
+  auto format_or = GetElementFormat(type);
+  CHECK(format_or.ok());
+  return format_or.ValueOrDie();
+}
+
+TEST(GetElementFormat, ScalarTypes) {
+  EXPECT_EQ(GetFormat(OpenClType::BOOL).lane_size, sizeof(cl_bool));
+  EXPECT_EQ(GetFormat(OpenClType::CHAR).kind, ElementFormat::SIGNED);
+  EXPECT_EQ(GetFormat(OpenClType::ULONG).kind, ElementFormat::UNSIGNED);
+  EXPECT_EQ(GetFormat(OpenClType::ULONG).lane_size, 8);
+  EXPECT_EQ(GetFormat(OpenClType::HALF).kind, ElementFormat::HALF);
+  EXPECT_EQ(GetFormat(OpenClType::DOUBLE).element_size(), sizeof(cl_double));
+  EXPECT_FALSE(GetElementFormat(OpenClType::DEFAULT_UNKNOWN).ok());
+}
+
+TEST(GetElementFormat, VectorTypes) {
+  const ElementFormat char2 = GetFormat(OpenClType::CHAR2);
+  EXPECT_EQ(char2.kind, ElementFormat::SIGNED);
+  EXPECT_EQ(char2.element_size(), sizeof(cl_char2));
+
+  const ElementFormat float3 = GetFormat(OpenClType::FLOAT3);
+  EXPECT_EQ(float3.kind, ElementFormat::FLOAT);
+  EXPECT_EQ(float3.num_lanes, 3);
+  EXPECT_EQ(float3.element_size(), sizeof(cl_float3));
+
+  const ElementFormat half16 = GetFormat(OpenClType::HALF16);
+  EXPECT_EQ(half16.kind, ElementFormat::HALF);
+  EXPECT_EQ(half16.element_size(), sizeof(cl_half16));
+
+  EXPECT_EQ(GetFormat(OpenClType::UINT8).element_size(), sizeof(cl_uint8));
+}
+
+TEST(CompareBuffers, IntegersMustBeEqual) {
+  std::vector<int> a(10000, 5);
+  std::vector<int> b = a;
+  BufferDiff diff =
+      CompareBuffers(GetFormat(OpenClType::INT), a.data(), b.data(), a.size(),
+                     /*max_ulps=*/4);
+  EXPECT_EQ(diff.num_mismatches, 0);
+  EXPECT_EQ(diff.first_mismatch_index, -1);
+
+  b[5000] = 6;
+  b[9999] = 4;
+  diff = CompareBuffers(GetFormat(OpenClType::INT), a.data(), b.data(),
+                        a.size(), /*max_ulps=*/4);
+  EXPECT_EQ(diff.num_mismatches, 2);
+  EXPECT_EQ(diff.first_mismatch_index, 5000);
+  EXPECT_EQ(diff.max_ulp_distance, 0);
+}
+
+TEST(CompareBuffers, FloatUlpTolerance) {
+  std::vector<float> a(100, 1.0f);
+  std::vector<float> b = a;
+  b[10] = std::nextafter(std::nextafter(1.0f, 2.0f), 2.0f);
+  b[20] = 1.5f;
+
+  BufferDiff diff = CompareBuffers(GetFormat(OpenClType::FLOAT), a.data(),
+                                   b.data(), a.size(), /*max_ulps=*/2);
+  EXPECT_EQ(diff.num_mismatches, 1);
+  EXPECT_EQ(diff.first_mismatch_index, 20);
+  EXPECT_GT(diff.max_ulp_distance, 2);
+
+  diff = CompareBuffers(GetFormat(OpenClType::FLOAT), a.data(), b.data(),
+                        a.size(), /*max_ulps=*/1);
+  EXPECT_EQ(diff.num_mismatches, 2);
+  EXPECT_EQ(diff.first_mismatch_index, 10);
+}
+
+TEST(CompareBuffers, FloatSignedZerosAndNans) {
+  const float a[] = {0.0f, NAN, 1.0f};
+  const float b[] = {-0.0f, -NAN, NAN};
+  BufferDiff diff = CompareBuffers(GetFormat(OpenClType::FLOAT), a, b, 3,
+                                   /*max_ulps=*/0);
+  EXPECT_EQ(diff.num_mismatches, 1);
+  EXPECT_EQ(diff.first_mismatch_index, 2);
+}
+
+TEST(CompareBuffers, FloatAcrossZero) {
+  const float a[] = {std::numeric_limits<float>::denorm_min()};
+  const float b[] = {-std::numeric_limits<float>::denorm_min()};
+  BufferDiff diff = CompareBuffers(GetFormat(OpenClType::FLOAT), a, b, 1,
+                                   /*max_ulps=*/2);
+  EXPECT_EQ(diff.num_mismatches, 0);
+  EXPECT_EQ(diff.max_ulp_distance, 2);
+}
+
+TEST(CompareBuffers, DoubleUlpTolerance) {
+  const double a[] = {1.0, -1.0};
+  const double b[] = {std::nextafter(1.0, 2.0), -2.0};
+  BufferDiff diff = CompareBuffers(GetFormat(OpenClType::DOUBLE), a, b, 2,
+                                   /*max_ulps=*/1);
+  EXPECT_EQ(diff.num_mismatches, 1);
+  EXPECT_EQ(diff.first_mismatch_index, 1);
+  EXPECT_EQ(diff.first_mismatch_lane, 0);
+}
+
+TEST(CompareBuffers, HalfUlpTolerance) {
+  // 1.0, and the next two halfs.
+  const cl_half a[] = {0x3c00, 0x3c00};
+  const cl_half b[] = {0x3c01, 0x3c02};
+  BufferDiff diff = CompareBuffers(GetFormat(OpenClType::HALF), a, b, 2,
+                                   /*max_ulps=*/1);
+  EXPECT_EQ(diff.num_mismatches, 1);
+  EXPECT_EQ(diff.first_mismatch_index, 1);
+  EXPECT_EQ(LaneToString(GetFormat(OpenClType::HALF), a, 0, 0), "1");
+}
+
+TEST(CompareBuffers, VectorLanes) {
+  std::vector<cl_int4> a(4);
+  for (auto& value : a) {
+    value.s[0] = value.s[1] = value.s[2] = value.s[3] = 1;
+  }
+  std::vector<cl_int4> b = a;
+  b[2].s[1] = 7;
+  b[2].s[3] = 7;
+
+  BufferDiff diff = CompareBuffers(GetFormat(OpenClType::INT4), a.data(),
+                                   b.data(), a.size(), /*max_ulps=*/0);
+  EXPECT_EQ(diff.num_mismatches, 1);
+  EXPECT_EQ(diff.first_mismatch_index, 2);
+  EXPECT_EQ(diff.first_mismatch_lane, 1);
+  EXPECT_EQ(LaneToString(GetFormat(OpenClType::INT4), b.data(), 2, 1), "7");
+}
+
+TEST(CompareBuffers, Vector3PaddingIsIgnored) {
+  std::vector<cl_float3> a(2);
+  for (auto& value : a) {
+    value.s[0] = value.s[1] = value.s[2] = value.s[3] = 1.0f;
+  }
+  std::vector<cl_float3> b = a;
+  b[1].s[3] = 2.0f;
+
+  BufferDiff diff = CompareBuffers(GetFormat(OpenClType::FLOAT3), a.data(),
+                                   b.data(), a.size(), /*max_ulps=*/0);
+  EXPECT_EQ(diff.num_mismatches, 0);
+}
+
+TEST(LaneToString, SignedAndUnsigned) {
+  const cl_char a[] = {-3};
+  EXPECT_EQ(LaneToString(GetFormat(OpenClType::CHAR), a, 0, 0), "-3");
+  const cl_uchar b[] = {253};
+  EXPECT_EQ(LaneToString(GetFormat(OpenClType::UCHAR), b, 0, 0), "253");
+  const cl_long c[] = {-5000000000ll};
+  EXPECT_EQ(LaneToString(GetFormat(OpenClType::LONG), c, 0, 0), "-5000000000");
+}
+
+}  // anonymous namespace
+}  // namespace cldrive
+}  // namespace gpu
+
+TEST_MAIN();
@@ -2,7 +2,12 @@
 //
 // Usage summary:
 //   cldrive --srcs=<opencl_sources> --envs=<opencl_devices>
-//       --gsize=<gsize> --lsize=<lsize> --output_format=(txt|pb|pbtxt)
+//       --gsize=<gsize> [--gsize_y=<y> --gsize_z=<z>] --lsize_x=<lsize>
+//       --output_format=(csv|columnar|pb|pbdelim|pbtxt)
+//   cldrive --srcs=<opencl_sources> --envs=<opencl_devices> --sweep=<file>
+//   cldrive --srcs=<opencl_sources> --diff_envs=<device_a>,<device_b>
+//   cldrive --serve [--serve_socket=<path>]
+//   cldrive --signatures=<dir|manifest> [--envs=<opencl_devices>]
 //
 // Run with `--help` argument to see full usage options.
 //
@@ -21,23 +26,37 @@
 //
 // You should have received a copy of the GNU General Public License
 // along with cldrive.  If not, see <https://www.gnu.org/licenses/>.
+#include "gpu/cldrive/env_diff.h"
 #include "gpu/cldrive/libcldrive.h"
 #include "gpu/cldrive/kernel_info_util.h"
+#include "gpu/cldrive/kernel_signature.h"
 
 #include "gpu/cldrive/logger.h"
+#include "gpu/cldrive/program_cache.h"
 #include "gpu/cldrive/proto/cldrive.pb.h"
+#include "gpu/cldrive/server.h"
+#include "gpu/cldrive/session.h"
+#include "gpu/cldrive/sweep.h"
+#include "gpu/cldrive/worker_pool.h"
 #include "gpu/clinfo/libclinfo.h"
 
 #include "labm8/cpp/app.h"
 #include "labm8/cpp/logging.h"
 
 #include "absl/strings/str_split.h"
+#include "absl/strings/ascii.h"
 #include "absl/strings/numbers.h"
 #include "boost/filesystem.hpp"
 #include "boost/filesystem/fstream.hpp"
 #include "gflags/gflags.h"
+#include "google/protobuf/util/json_util.h"
 
+#include <unistd.h>
+#include <algorithm>
+#include <deque>
+#include <set>
 #include <sstream>
+#include <thread>
 #include <json/json.h>
 
 namespace {
@@ -96,9 +115,15 @@ DEFINE_validator(srcs, &ValidateSrcs);
 DEFINE_string(envs, "",
               "A comma separated list of OpenCL devices to use. Use "
               "'--clinfo' argument to print a list of available devices. If "
-              "not provided, all available OpenCL devices will be used.");
+              "not provided, all available OpenCL devices will be used. A "
+              "device may be named only once.");
 static bool ValidateEnvs(const char* flagname, const string& value) {
+  std::set<string> seen;
   for (auto env : SplitCommaSeparated(value)) {
+    if (!seen.insert(env).second) {
+      LOG(FATAL) << "OpenCL environment '" << env << "' is repeated in --"
+                 << flagname;
+    }
     try {
       labm8::gpu::clinfo::GetOpenClDevice(env);
     } catch (std::invalid_argument e) {
@@ -114,32 +139,223 @@ static bool ValidateEnvs(const char* flagname, const string& value) {
 }
 DEFINE_validator(envs, &ValidateEnvs);
 
+DEFINE_string(diff_envs, "",
+              "A comma separated pair of different OpenCL devices. If set, "
+              "each kernel is run once on both devices with the same inputs, "
+              "and the outputs of its global buffer arguments are compared. A "
+              "CldriveKernelDiff message is printed as JSON for each kernel "
+              "and launch config, in place of timings.");
+static bool ValidateDiffEnvs(const char* flagname, const string& value) {
+  if (value.empty()) {
+    return true;
+  }
+  const std::vector<string> envs = SplitCommaSeparated(value);
+  if (envs.size() != 2) {
+    LOG(FATAL) << "--" << flagname << " must name two OpenCL devices";
+  }
+  return ValidateEnvs(flagname, value);
+}
+DEFINE_validator(diff_envs, &ValidateDiffEnvs);
+DEFINE_uint64(diff_max_ulps, 4,
+              "With --diff_envs, the largest difference between half, float "
+              "and double values of the two devices, in units in the last "
+              "place, which is not a mismatch. Integers must be equal.");
+
 DEFINE_string(output_format, "csv",
-              "The output format. One of: {csv,pb,pbtxt,null}.");
+              "The output format. One of: "
+              "{csv,columnar,pb,pbdelim,pbtxt,null}. columnar is a compact "
+              "binary format with the same columns as csv, see "
+              "gpu/cldrive/columnar_log.h. pbdelim streams a length-delimited "
+              "CldriveResult proto for each run as soon as it completes, "
+              "rather than writing every result at exit.");
 static bool ValidateOutputFormat(const char* flagname, const string& value) {
-  if (value.compare("csv") && value.compare("pb") && value.compare("pbtxt") && value.compare("null")) {
+  if (value.compare("csv") && value.compare("columnar") && value.compare("pb") && value.compare("pbdelim") && value.compare("pbtxt") && value.compare("null")) {
     LOG(FATAL) << "Illegal value for --" << flagname << ". Must be one of: "
-               << "{csv,pb,pbtxt,null}";
+               << "{csv,columnar,pb,pbdelim,pbtxt,null}";
   }
   return true;
 }
 DEFINE_validator(output_format, &ValidateOutputFormat);
 
 DEFINE_int64(gsize, 1024,
-             "The global size to drive each kernel with. Buffers of this size "
-             "are allocated and transferred for array arguments, and this many "
-             "work items are instantiated.");
-DEFINE_int64(lsize_x, 128, "The local (work group) size in first dimension. lsize_x*lsize_y*lsize_z must be <= gsize.");
-DEFINE_int64(lsize_y, 1, "The local (work group) size in second dimension. lsize_x*lsize_y*lsize_z must be <= gsize.");
-DEFINE_int64(lsize_z, 1, "The local (work group) size in third dimension. lsize_x*lsize_y*lsize_z must be <= gsize.");
+             "The global size to drive each kernel with, in the first "
+             "dimension. Buffers with an element per work item are allocated "
+             "and transferred for array arguments, and scalar arguments are "
+             "set to this value.");
+DEFINE_int64(gsize_y, 1,
+             "The global size in the second dimension. If greater than 1, "
+             "kernels are launched with a 2D or 3D NDRange.");
+DEFINE_int64(gsize_z, 1,
+             "The global size in the third dimension. If greater than 1, "
+             "kernels are launched with a 3D NDRange.");
+DEFINE_int64(lsize_x, 128, "The local (work group) size in first dimension. lsize_x must be <= gsize.");
+DEFINE_int64(lsize_y, 1, "The local (work group) size in second dimension. lsize_y must be <= gsize_y, so it must be 1 for a 1D NDRange.");
+DEFINE_int64(lsize_z, 1, "The local (work group) size in third dimension. lsize_z must be <= gsize_z, so it must be 1 for a 1D or 2D NDRange.");
+DEFINE_bool(tune_lsize, false,
+            "Ignore --lsize_* and search for the fastest local size of each "
+            "kernel and global size. Candidate local sizes are derived from "
+            "CL_KERNEL_WORK_GROUP_SIZE and "
+            "CL_KERNEL_PREFERRED_WORK_GROUP_SIZE_MULTIPLE, and timed with "
+            "successive halving. Every candidate's runs are logged.");
+DEFINE_int64(tune_lsize_budget, 0,
+             "With --tune_lsize, the total number of timed runs per kernel "
+             "and global size. If 0, --num_runs runs per candidate.");
+DEFINE_bool(check_outputs, false,
+            "Before timing each launch config, hash the kernel's global "
+            "buffers on the device after two runs of the same inputs and one "
+            "of different inputs, and reject kernels which produce no output, "
+            "are nondeterministic, or are input insensitive. Copy buffers are "
+            "used regardless of --buffer_strategy. With --tune_lsize, the "
+            "check is made once per global size.");
+DEFINE_bool(copy_outputs, false,
+            "Copy every buffer argument back to the host after each timed "
+            "run, and include the copies in the run's device to host "
+            "transfer timings. Not supported with --pipelined.");
 
 DEFINE_string(args_values, "",
               "A comma separated list of values to use for each kernel "
               "argument. Must be the same length as the number of arguments");
+DEFINE_string(sweep, "",
+              "A file listing launch configs and argument values to run each "
+              "kernel with, as a CldriveSweep proto. Files ending in .json are "
+              "parsed as JSON, .pb as a binary proto, and all others as a text "
+              "format proto. Kernels without a sweep are run with --gsize, "
+              "--lsize_* and --args_values.");
 DEFINE_string(cl_build_opt, "", "Build options passed to clBuildProgram().");
+DEFINE_string(cl_program_cache_dir, "",
+              "If set, cache compiled program binaries in this directory and "
+              "reuse them for later builds of the same source, build options, "
+              "and device.");
+DEFINE_int32(compile_lookahead, 0,
+             "The number of --srcs to compile ahead of the one being run. "
+             "Programs are compiled on background threads while kernels run "
+             "on the device. If 0, each program is compiled just before it "
+             "is run.");
+static bool ValidateCompileLookahead(const char* flagname, int32_t value) {
+  if (value < 0) {
+    LOG(FATAL) << "--" << flagname << " must be non-negative";
+  }
+  return true;
+}
+DEFINE_validator(compile_lookahead, &ValidateCompileLookahead);
 DEFINE_int32(num_runs, 5, "The number of runs per kernel.");
+DEFINE_int32(max_runs, 0,
+             "If greater than --num_runs, run each launch config adaptively: "
+             "at least --num_runs and at most --max_runs times, stopping once "
+             "--target_ci_width or --max_time_per_config_ms is reached.");
+DEFINE_double(target_ci_width, 0.02,
+              "With --max_runs, stop once the 95% confidence interval of the "
+              "median kernel time is narrower than this fraction of the "
+              "median. If 0, runs do not stop on confidence.");
+DEFINE_int64(max_time_per_config_ms, 0,
+             "With --max_runs, stop once the timed runs of a launch config "
+             "have taken this many milliseconds. If 0, there is no limit.");
+DEFINE_int64(compile_timeout_ms, 0,
+             "Give up on a program which takes longer than this many "
+             "milliseconds to build, with the COMPILE_TIMEOUT outcome. If 0, "
+             "there is no limit.");
+DEFINE_int64(run_timeout_ms, 0,
+             "Abandon a launch config if a single run (input transfers and "
+             "kernel) takes longer than this many milliseconds. The config's "
+             "completed runs are kept, and it gets the TIMEOUT outcome. If 0, "
+             "there is no limit.");
+DEFINE_int64(config_timeout_ms, 0,
+             "Abandon a launch config if its runs, including warmup runs, take "
+             "longer than this many milliseconds in total. Unlike "
+             "--max_time_per_config_ms, this also ends runs which never "
+             "complete. If 0, there is no limit.");
+DEFINE_string(input_residency, "per_run",
+              "When to copy kernel inputs to the device. One of: "
+              "{per_run,per_config,once}. per_run copies before every run, "
+              "and includes the transfer in each run's timings. per_config "
+              "copies once per launch config, before the warmup runs. once "
+              "copies each input buffer only once, reusing it between launch "
+              "configs where possible.");
+static bool ValidateInputResidency(const char* flagname, const string& value) {
+  gpu::cldrive::CldriveInstance::InputResidency residency;
+  if (!gpu::cldrive::CldriveInstance::InputResidency_Parse(
+          absl::AsciiStrToUpper(value), &residency)) {
+    LOG(FATAL) << "Illegal value for --" << flagname << ". Must be one of: "
+               << "{per_run,per_config,once}";
+  }
+  return true;
+}
+DEFINE_validator(input_residency, &ValidateInputResidency);
+DEFINE_int64(seed, 0,
+             "The seed for random kernel inputs. The same seed produces the "
+             "same inputs across runs, processes, and host thread counts.");
+DEFINE_string(buffer_strategy, "copy",
+              "How buffer arguments are transferred to the device. One of: "
+              "{auto,copy,zero_copy}. copy uses separate host and device "
+              "buffers. zero_copy creates device buffers over the host memory "
+              "and maps them in place of copies, which avoids copying on CPU "
+              "and integrated devices. With zero_copy, kernel outputs "
+              "overwrite the inputs of later runs. auto uses zero_copy if the "
+              "device shares memory with the host.");
+static bool ValidateBufferStrategy(const char* flagname, const string& value) {
+  gpu::cldrive::CldriveInstance::BufferStrategy strategy;
+  if (!gpu::cldrive::CldriveInstance::BufferStrategy_Parse(
+          absl::AsciiStrToUpper(value), &strategy)) {
+    LOG(FATAL) << "Illegal value for --" << flagname << ". Must be one of: "
+               << "{auto,copy,zero_copy}";
+  }
+  return true;
+}
+DEFINE_validator(buffer_strategy, &ValidateBufferStrategy);
+DEFINE_bool(pipelined, false,
+            "Enqueue all --num_runs runs of a launch config back to back and "
+            "collect their profiling data after a single clFinish(), rather "
+            "than waiting for each run to complete before enqueuing the next. "
+            "Not supported with --max_runs or --copy_outputs.");
+DEFINE_bool(summary_only, false,
+            "Record summary statistics of the kernel times of each launch "
+            "config in place of the individual runs. With csv output, one "
+            "row is printed per launch config. Not supported with columnar "
+            "output.");
+DEFINE_bool(parallel_envs, false,
+            "Run each device in --envs on its own thread, rather than one "
+            "after another. Logs from different devices may be interleaved.");
+DEFINE_int32(workers, 0,
+             "If greater than 0, run instances on this many worker processes, "
+             "each a long-lived 'cldrive --serve'. A kernel which crashes its "
+             "worker gets the CRASH outcome, and the worker is replaced. If 0, "
+             "instances are run in this process.");
+static bool ValidateWorkers(const char* flagname, int32_t value) {
+  if (value < 0) {
+    LOG(FATAL) << "--" << flagname << " must be non-negative";
+  }
+  return true;
+}
+DEFINE_validator(workers, &ValidateWorkers);
+DEFINE_int64(worker_timeout_ms, 0,
+             "With --workers, kill a worker which takes longer than this many "
+             "milliseconds to run an instance. The instance gets the "
+             "WORKER_TIMEOUT outcome. If 0, there is no limit.");
 DEFINE_bool(clinfo, false, "List the available devices and exit.");
 DEFINE_bool(kernelinfo, false, "List the kernel arguments and exit.");
+DEFINE_string(signatures, "",
+              "Print the kernel signatures of every OpenCL source in a "
+              "directory, or listed in a manifest file, one per line, and "
+              "exit. A JSON ProgramSignatures record is printed per source "
+              "and device in --envs, or the first device if --envs is unset.");
+static bool ValidateSignatureThreads(const char* flagname, int32_t value) {
+  if (value < 0) {
+    LOG(FATAL) << "Flag --" << flagname << " must be >= 0";
+  }
+  return true;
+}
+DEFINE_int32(signature_threads, 0,
+             "The number of threads used to build programs with --signatures. "
+             "If 0, one per hardware thread.");
+DEFINE_validator(signature_threads, &ValidateSignatureThreads);
+DEFINE_bool(serve, false,
+            "Run as a long-lived server. Read length-delimited CldriveInstance "
+            "protos from stdin (or --serve_socket) and write each back with "
+            "its results. OpenCL contexts, queues, and compiled programs are "
+            "kept alive between requests.");
+DEFINE_string(serve_socket, "",
+              "If set with --serve, listen for connections on a Unix domain "
+              "socket at this path rather than reading stdin.");
 
 // End flag definitions ------------------------------------
 
@@ -151,11 +367,18 @@ std::unique_ptr<Logger> MakeLoggerFromFlags(
   if (!FLAGS_output_format.compare("pb")) {
     return std::make_unique<ProtocolBufferLogger>(std::cout, instances,
                                                   /*text_format=*/false);
+  } else if (!FLAGS_output_format.compare("pbdelim")) {
+    return std::make_unique<DelimitedProtocolBufferLogger>(std::cout,
+                                                           instances);
   } else if (!FLAGS_output_format.compare("pbtxt")) {
     return std::make_unique<ProtocolBufferLogger>(std::cout, instances,
                                                   /*text_format=*/true);
+  } else if (!FLAGS_output_format.compare("csv") && FLAGS_summary_only) {
+    return std::make_unique<CsvSummaryLogger>(std::cout, instances);
   } else if (!FLAGS_output_format.compare("csv")) {
     return std::make_unique<CsvLogger>(std::cout, instances);
+  } else if (!FLAGS_output_format.compare("columnar")) {
+    return std::make_unique<ColumnarLogger>(std::cout, instances);
   } else if (!FLAGS_output_format.compare("null")) {
     return std::make_unique<NULLLogger>(std::cout, instances);
   } else {
@@ -190,6 +413,62 @@ std::vector<::gpu::clinfo::OpenClDevice> GetDevicesFromCommaSeparatedString(
   return devices;
 }
 
+// Run an instance on every device at once, with one thread per device. Each
+// device is driven with its own copy of the instance, and logs are merged
+// through a thread-safe logger.
+//
+// The outcomes of every device are recorded through the logger as they run.
+// A CldriveInstance holds the results of a single device, so on return
+// instance holds those of the last device only, and the others are
+// discarded. This is the same as when the devices are run one after another,
+// where each device overwrites the results of the one before.
+void RunOnDevicesInParallel(
+    gpu::cldrive::CldriveInstance* instance,
+    const std::vector<::gpu::clinfo::OpenClDevice>& devices,
+    gpu::cldrive::CldriveSession* session, int instance_num,
+    gpu::cldrive::Logger* logger) {
+  gpu::cldrive::ThreadSafeLogger thread_safe_logger(logger);
+
+  std::vector<gpu::cldrive::CldriveInstance> device_instances(devices.size(),
+                                                              *instance);
+  std::vector<std::thread> threads;
+  for (size_t i = 0; i < devices.size(); ++i) {
+    device_instances[i].clear_outcome();
+    device_instances[i].clear_kernel();
+    *device_instances[i].mutable_device() = devices[i];
+
+    threads.emplace_back([&, i]() {
+      gpu::cldrive::Cldrive(&device_instances[i], session, instance_num)
+          .RunOrDie(thread_safe_logger);
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+
+  *instance = device_instances.back();
+}
+
+// Log the results of the instances of the oldest source which was submitted to
+// the worker pool.
+void LogNextSourceFromWorkers(gpu::cldrive::WorkerPool* pool,
+                              size_t num_devices,
+                              gpu::cldrive::CldriveInstance* instance,
+                              gpu::cldrive::Logger* logger) {
+  logger->StartNewInstance();
+  for (size_t i = 0; i < num_devices; ++i) {
+    *instance = pool->NextResult();
+    gpu::cldrive::RecordInstance(*instance, logger);
+    if (FLAGS_summary_only) {
+      for (auto& kernel : *instance->mutable_kernel()) {
+        for (auto& run : *kernel.mutable_run()) {
+          run.clear_log();
+        }
+      }
+    }
+  }
+}
+
 }  // namespace
 
 int main(int argc, char** argv) {
@@ -205,12 +484,89 @@ int main(int argc, char** argv) {
     return 0;
   }
 
+  if (!FLAGS_cl_program_cache_dir.empty()) {
+    gpu::cldrive::EnableProgramBinaryCache(FLAGS_cl_program_cache_dir);
+  }
+
+  if (FLAGS_serve) {
+    gpu::cldrive::CldriveSession session;
+    labm8::Status status =
+        FLAGS_serve_socket.empty()
+            ? gpu::cldrive::ServeFileDescriptors(STDIN_FILENO, STDOUT_FILENO,
+                                                 &session)
+            : gpu::cldrive::ServeUnixSocket(FLAGS_serve_socket, &session);
+    if (!status.ok()) {
+      LOG(FATAL) << status.ToString();
+    }
+    return 0;
+  }
+
+  if (!FLAGS_signatures.empty()) {
+    auto paths_or = gpu::cldrive::ListKernelSources(FLAGS_signatures);
+    if (!paths_or.ok()) {
+      LOG(FATAL) << paths_or.status().ToString();
+    }
+    std::vector<::gpu::clinfo::OpenClDevice> devices;
+    if (FLAGS_envs.empty()) {
+      devices.push_back(labm8::gpu::clinfo::GetOpenClDevices().device(0));
+    } else {
+      devices = GetDevicesFromCommaSeparatedString(FLAGS_envs);
+    }
+    const int num_threads =
+        FLAGS_signature_threads
+            ? FLAGS_signature_threads
+            : static_cast<int>(
+                  std::max(std::thread::hardware_concurrency(), 1u));
+
+    google::protobuf::util::JsonPrintOptions options;
+    options.always_print_primitive_fields = true;
+    for (const auto& device : devices) {
+      gpu::cldrive::ExtractKernelSignatures(
+          device, paths_or.ValueOrDie(), FLAGS_cl_build_opt, num_threads,
+          [&](const gpu::cldrive::ProgramSignatures& signatures) {
+            string json;
+            google::protobuf::util::MessageToJsonString(signatures, &json,
+                                                        options);
+            std::cout << json << std::endl;
+          });
+    }
+    return 0;
+  }
+
   // Check that required flags are set. We can't check this in the flag
   // validator functions as they are only required if the early-exit flags
   // above are not set.
   if (FLAGS_srcs.empty()) {
     LOG(FATAL) << "Flag --srcs must be set";
   }
+  // The columnar format has the columns of the per-run CSV, and no columns
+  // for the summaries.
+  if (FLAGS_summary_only && !FLAGS_output_format.compare("columnar")) {
+    LOG(FATAL) << "Flag --summary_only is not supported with "
+               << "--output_format=columnar";
+  }
+  // Pipelined runs are enqueued together, so their number cannot depend on
+  // the times of earlier runs, and outputs cannot be copied between them.
+  if (FLAGS_pipelined && FLAGS_max_runs > FLAGS_num_runs) {
+    LOG(FATAL) << "Flag --pipelined is not supported with --max_runs, as "
+               << "pipelined runs are not adaptive";
+  }
+  if (FLAGS_pipelined && FLAGS_copy_outputs) {
+    LOG(FATAL) << "Flag --pipelined is not supported with --copy_outputs";
+  }
+  // The pb and pbtxt formats write all instances when cldrive exits, so the
+  // watchdog has nothing to flush when a time budget runs out, and a hung
+  // run would lose every result. Worker processes flush their own output,
+  // and their results are written by this process.
+  if ((FLAGS_run_timeout_ms > 0 || FLAGS_config_timeout_ms > 0) &&
+      FLAGS_workers <= 0 &&
+      (!FLAGS_output_format.compare("pb") ||
+       !FLAGS_output_format.compare("pbtxt"))) {
+    LOG(FATAL) << "Flags --run_timeout_ms and --config_timeout_ms are not "
+               << "supported with --output_format=" << FLAGS_output_format
+               << " unless --workers is set. Use --output_format=pbdelim to "
+               << "stream results";
+  }
 
   if (FLAGS_kernelinfo) {
     cl::Device device = labm8::gpu::clinfo::GetOpenClDeviceOrDie(labm8::gpu::clinfo::GetOpenClDevices().device(0));
@@ -232,43 +588,163 @@ int main(int argc, char** argv) {
   gpu::cldrive::CldriveInstance* instance = instances.add_instance();
   instance->set_build_opts(FLAGS_cl_build_opt);
   auto dp = instance->add_dynamic_params();
-  if ((int64_t)FLAGS_gsize < (int64_t) FLAGS_lsize_x * FLAGS_lsize_y * FLAGS_lsize_z) {
-    LOG(FATAL) << "Global size must be greater than or equal to local size. Got: "
-                << "gsize: " << FLAGS_gsize << ", lsize_x*lsize_y*lsize_z: " 
-                <<  (int64_t) FLAGS_lsize_x * FLAGS_lsize_y * FLAGS_lsize_z;
-  }
   dp->set_global_size_x(FLAGS_gsize);
+  dp->set_global_size_y(FLAGS_gsize_y);
+  dp->set_global_size_z(FLAGS_gsize_z);
   dp->set_local_size_x(FLAGS_lsize_x);
   dp->set_local_size_y(FLAGS_lsize_y);
   dp->set_local_size_z(FLAGS_lsize_z);
   instance->set_min_runs_per_kernel(FLAGS_num_runs);
+  instance->set_max_runs_per_kernel(FLAGS_max_runs);
+  instance->set_target_relative_ci_width(FLAGS_target_ci_width);
+  instance->set_max_time_per_config_ms(FLAGS_max_time_per_config_ms);
+  instance->set_compile_timeout_ms(FLAGS_compile_timeout_ms);
+  instance->set_run_timeout_ms(FLAGS_run_timeout_ms);
+  instance->set_config_timeout_ms(FLAGS_config_timeout_ms);
+  instance->set_pipelined(FLAGS_pipelined);
+  instance->set_tune_lsize(FLAGS_tune_lsize);
+  instance->set_tune_lsize_budget(FLAGS_tune_lsize_budget);
+  instance->set_check_outputs(FLAGS_check_outputs);
+  instance->set_copy_outputs(FLAGS_copy_outputs);
+  instance->set_seed(FLAGS_seed);
+  instance->set_summary_only(FLAGS_summary_only);
+  instance->set_stream_runs(!FLAGS_output_format.compare("pbdelim"));
+  gpu::cldrive::CldriveInstance::InputResidency input_residency;
+  CHECK(gpu::cldrive::CldriveInstance::InputResidency_Parse(
+      absl::AsciiStrToUpper(FLAGS_input_residency), &input_residency));
+  instance->set_input_residency(input_residency);
+  gpu::cldrive::CldriveInstance::BufferStrategy buffer_strategy;
+  CHECK(gpu::cldrive::CldriveInstance::BufferStrategy_Parse(
+      absl::AsciiStrToUpper(FLAGS_buffer_strategy), &buffer_strategy));
+  instance->set_buffer_strategy(buffer_strategy);
+
+  if (!FLAGS_sweep.empty()) {
+    auto sweep_or =
+        gpu::cldrive::ParseSweep(FLAGS_sweep, ReadFileOrDie(FLAGS_sweep));
+    if (!sweep_or.ok()) {
+      LOG(FATAL) << sweep_or.status().ToString();
+    }
+    *instance->mutable_sweep() = sweep_or.ValueOrDie().kernel();
+  }
 
-  // Parse logger flag.
-  std::unique_ptr<gpu::cldrive::Logger> logger =
-      gpu::cldrive::MakeLoggerFromFlags(std::cout, &instances);
-
-  int instance_num = 0;
   std::vector<long long> args_values;
   SplitCommaSeparatedInt(FLAGS_args_values, args_values);
   for (auto arg_value : args_values) {
     instance->add_args_values(arg_value);
   }
-  for (auto path : SplitCommaSeparated(FLAGS_srcs)) {
-    logger->StartNewInstance();
-    instance->set_opencl_src(ReadFileOrDie(path));
 
-    for (size_t i = 0; i < devices.size(); ++i) {
-      // Reset fields from previous loop iterations.
-      instance->clear_outcome();
-      instance->clear_kernel();
+  if (!FLAGS_diff_envs.empty()) {
+    const std::vector<string> envs = SplitCommaSeparated(FLAGS_diff_envs);
+    const auto device_a =
+        labm8::gpu::clinfo::GetOpenClDeviceProto(envs[0]).ValueOrDie();
+    const auto device_b =
+        labm8::gpu::clinfo::GetOpenClDeviceProto(envs[1]).ValueOrDie();
+    gpu::cldrive::CldriveSession session;
+
+    google::protobuf::util::JsonPrintOptions options;
+    options.always_print_primitive_fields = true;
+    for (const auto& path : SplitCommaSeparated(FLAGS_srcs)) {
+      instance->set_opencl_src(ReadFileOrDie(path));
+      for (auto& diff : gpu::cldrive::DiffEnvs(*instance, device_a, device_b,
+                                               FLAGS_diff_max_ulps,
+                                               &session)) {
+        diff.set_path(path);
+        string json;
+        google::protobuf::util::MessageToJsonString(diff, &json, options);
+        std::cout << json << std::endl;
+      }
+    }
+    return 0;
+  }
+
+  // Parse logger flag.
+  std::unique_ptr<gpu::cldrive::Logger> logger =
+      gpu::cldrive::MakeLoggerFromFlags(std::cout, &instances);
+
+  // Share contexts, queues, and programs between all sources and devices.
+  gpu::cldrive::CldriveSession session;
+
+  // Workers are cldrive servers. They return every run of an instance, and
+  // the runs are logged by this process.
+  std::unique_ptr<gpu::cldrive::WorkerPool> pool;
+  gpu::cldrive::CldriveInstance worker_instance;
+  if (FLAGS_workers > 0) {
+    std::vector<string> command = {argv[0], "--serve"};
+    if (!FLAGS_cl_program_cache_dir.empty()) {
+      command.push_back("--cl_program_cache_dir=" +
+                        FLAGS_cl_program_cache_dir);
+    }
+    pool = std::make_unique<gpu::cldrive::WorkerPool>(
+        command, FLAGS_workers, FLAGS_worker_timeout_ms);
+  }
+
+  int instance_num = 0;
+  // Sources are read ahead of the one being run. With --compile_lookahead,
+  // they are also compiled ahead on background threads.
+  const std::vector<string> paths = SplitCommaSeparated(FLAGS_srcs);
+  std::deque<string> read_ahead_srcs;
+  size_t num_read = 0;
+  for (size_t path_num = 0; path_num < paths.size(); ++path_num) {
+    while (num_read < paths.size() &&
+           num_read <= path_num + FLAGS_compile_lookahead) {
+      read_ahead_srcs.push_back(ReadFileOrDie(paths[num_read++]));
+      if (FLAGS_compile_lookahead > 0 && !pool) {
+        for (const auto& device : devices) {
+          session.PrefetchProgram(session.GetDeviceStateOrDie(device),
+                                  read_ahead_srcs.back(), FLAGS_cl_build_opt);
+        }
+      }
+    }
 
-      *instance->mutable_device() = devices[i];
+    if (pool) {
+      // Keep up to two instances per worker in flight, and log the results
+      // in the order that sources were given.
+      worker_instance = *instance;
+      worker_instance.set_opencl_src(read_ahead_srcs.front());
+      worker_instance.set_summary_only(false);
+      worker_instance.set_stream_runs(false);
+      read_ahead_srcs.pop_front();
+      for (const auto& device : devices) {
+        *worker_instance.mutable_device() = device;
+        pool->Submit(worker_instance);
+      }
+      while (pool->pending() > 2 * static_cast<size_t>(FLAGS_workers)) {
+        LogNextSourceFromWorkers(pool.get(), devices.size(), instance,
+                                 logger.get());
+      }
+      continue;
+    }
 
-      gpu::cldrive::Cldrive(instance, instance_num).RunOrDie(*logger);
+    logger->StartNewInstance();
+    instance->set_opencl_src(read_ahead_srcs.front());
+    read_ahead_srcs.pop_front();
+
+    if (FLAGS_parallel_envs && devices.size() > 1) {
+      RunOnDevicesInParallel(instance, devices, &session, instance_num,
+                             logger.get());
+    } else {
+      for (size_t i = 0; i < devices.size(); ++i) {
+        // Reset fields from previous loop iterations.
+        instance->clear_outcome();
+        instance->clear_kernel();
+
+        *instance->mutable_device() = devices[i];
+
+        gpu::cldrive::Cldrive(instance, &session, instance_num)
+            .RunOrDie(*logger);
+      }
     }
 
     ++instance_num;
   }
+  while (pool && pool->pending()) {
+    LogNextSourceFromWorkers(pool.get(), devices.size(), instance,
+                             logger.get());
+  }
+
+  if (gpu::cldrive::GetProgramBinaryCache()) {
+    LOG(INFO) << gpu::cldrive::GetProgramBinaryCache()->StatsString();
+  }
 
   return 0;
 }
@@ -0,0 +1,468 @@
+// Copyright (c) 2016-2020 Chris Cummins.
+// This file is part of cldrive.
+//
+// cldrive is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// cldrive is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with cldrive.  If not, see <https://www.gnu.org/licenses/>.
+#include "gpu/cldrive/columnar_log.h"
+
+#include "gpu/cldrive/csv_log.h"
+
+#include "labm8/cpp/logging.h"
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <type_traits>
+
+namespace gpu {
+namespace cldrive {
+
+namespace {
+
+// Append an integer to a string, little-endian.
+template <typename T>
+void PutInt(string* out, T value, size_t width = sizeof(T)) {
+  auto bits = static_cast<typename std::make_unsigned<T>::type>(value);
+  for (size_t i = 0; i < width; ++i) {
+    out->push_back(static_cast<char>(bits & 0xff));
+    bits >>= 8;
+  }
+}
+
+void PutDouble(string* out, double value) {
+  uint64_t bits;
+  std::memcpy(&bits, &value, sizeof(bits));
+  PutInt(out, bits);
+}
+
+void PutString(string* out, const string& value) {
+  PutInt<uint32_t>(out, value.size());
+  out->append(value);
+}
+
+// Read a little-endian integer at an offset into a string, and advance the
+// offset past it.
+template <typename T>
+bool GetInt(const string& in, size_t* pos, T* value) {
+  if (in.size() - *pos < sizeof(T)) {
+    return false;
+  }
+  typename std::make_unsigned<T>::type bits = 0;
+  for (size_t i = 0; i < sizeof(T); ++i) {
+    bits |= static_cast<decltype(bits)>(
+                static_cast<unsigned char>(in[*pos + i]))
+            << (8 * i);
+  }
+  *value = static_cast<T>(bits);
+  *pos += sizeof(T);
+  return true;
+}
+
+bool GetDouble(const string& in, size_t* pos, double* value) {
+  uint64_t bits;
+  if (!GetInt(in, pos, &bits)) {
+    return false;
+  }
+  std::memcpy(value, &bits, sizeof(bits));
+  return true;
+}
+
+bool GetString(const string& in, size_t* pos, string* value) {
+  uint32_t size;
+  if (!GetInt(in, pos, &size) || in.size() - *pos < size) {
+    return false;
+  }
+  value->assign(in, *pos, size);
+  *pos += size;
+  return true;
+}
+
+void PutColumnHeader(string* out, const string& name,
+                     ColumnEncoding encoding) {
+  PutInt<uint16_t>(out, name.size());
+  out->append(name);
+  PutInt<uint8_t>(out, static_cast<uint8_t>(encoding));
+}
+
+template <typename T>
+void PutColumn(string* out, const string& name, const std::vector<T>& values) {
+  static_assert(sizeof(T) == 4 || sizeof(T) == 8, "Unsupported column type");
+  PutColumnHeader(out, name,
+                  sizeof(T) == 4 ? ColumnEncoding::INT32
+                                 : ColumnEncoding::INT64);
+  for (const auto& value : values) {
+    PutInt(out, value);
+  }
+}
+
+void PutColumn(string* out, const string& name,
+               const std::vector<double>& values) {
+  PutColumnHeader(out, name, ColumnEncoding::FLOAT64);
+  for (const auto& value : values) {
+    PutDouble(out, value);
+  }
+}
+
+// Return the smallest width in bytes of a signed integer which holds every
+// value.
+size_t SignedWidth(const std::vector<labm8::int64>& values) {
+  size_t width = 1;
+  for (const auto& value : values) {
+    while (width < 8 && (value < -(labm8::int64(1) << (8 * width - 1)) ||
+                         value >= (labm8::int64(1) << (8 * width - 1)))) {
+      width *= 2;
+    }
+  }
+  return width;
+}
+
+void PutDeltaColumn(string* out, const string& name,
+                    const std::vector<labm8::int64>& values) {
+  PutColumnHeader(out, name, ColumnEncoding::DELTA_INT64);
+  PutInt(out, values[0]);
+
+  std::vector<labm8::int64> deltas;
+  deltas.reserve(values.size() - 1);
+  for (size_t i = 1; i < values.size(); ++i) {
+    deltas.push_back(values[i] - values[i - 1]);
+  }
+
+  const size_t width = SignedWidth(deltas);
+  PutInt<uint8_t>(out, width);
+  for (const auto& delta : deltas) {
+    PutInt(out, delta, width);
+  }
+}
+
+void PutDictionaryColumn(string* out, const string& name,
+                         const std::vector<string>& strings,
+                         const std::vector<uint32_t>& values) {
+  PutColumnHeader(out, name, ColumnEncoding::DICTIONARY);
+  PutInt<uint32_t>(out, strings.size());
+  for (const auto& value : strings) {
+    PutString(out, value);
+  }
+
+  size_t width = 1;
+  while (width < 4 && strings.size() > (size_t(1) << (8 * width))) {
+    width *= 2;
+  }
+  PutInt<uint8_t>(out, width);
+  for (const auto& value : values) {
+    PutInt(out, value, width);
+  }
+}
+
+}  // anonymous namespace
+
+ColumnarLogRow::ColumnarLogRow(int instance_id)
+    : instance_id_(instance_id),
+      work_item_local_mem_size_(-1),
+      work_item_private_mem_size_(-1),
+      global_size_x_(-1),
+      global_size_y_(-1),
+      global_size_z_(-1),
+      local_size_x_(-1),
+      local_size_y_(-1),
+      local_size_z_(-1),
+      transferred_bytes_(-1),
+      transfer_time_ns_(-1),
+      kernel_time_ns_(-1),
+      host_to_device_bytes_(-1),
+      host_to_device_time_ns_(-1),
+      host_to_device_gbps_(-1),
+      device_to_host_bytes_(-1),
+      device_to_host_time_ns_(-1),
+      device_to_host_gbps_(-1),
+      tuning_rounds_(-1),
+      best_local_size_(-1),
+      sweep_index_(-1) {
+  CHECK(instance_id >= 0) << "Negative instance ID not allowed";
+}
+
+/*static*/ ColumnarLogRow ColumnarLogRow::FromProtos(
+    int instance_id, const CldriveInstance* const instance,
+    const CldriveKernelInstance* const kernel_instance,
+    const CldriveKernelRun* const run,
+    const gpu::libcecl::OpenClKernelInvocation* const log) {
+  ColumnarLogRow row(instance_id);
+
+  CHECK(instance) << "CldriveInstance pointer cannot be null";
+  row.device_ = instance->device().name();
+  row.build_opts_ = instance->build_opts();
+
+  row.outcome_ = CldriveInstance::InstanceOutcome_Name(instance->outcome());
+  if (log) {
+    row.args_ = log->args_info();
+  }
+  if (kernel_instance) {
+    row.kernel_ = kernel_instance->name();
+    row.work_item_local_mem_size_ =
+        kernel_instance->work_item_local_mem_size_in_bytes();
+    row.work_item_private_mem_size_ =
+        kernel_instance->work_item_private_mem_size_in_bytes();
+
+    row.outcome_ = CldriveKernelInstance::KernelInstanceOutcome_Name(
+        kernel_instance->outcome());
+    if (run) {
+      row.outcome_ = KernelRunOutcomeName(*run);
+      if (instance->tune_lsize()) {
+        row.tuning_rounds_ = run->tuning_rounds();
+        row.best_local_size_ = run->best_local_size();
+      }
+      if (run->has_sweep_index()) {
+        row.sweep_index_ = run->sweep_index();
+      }
+      if (log) {
+        row.global_size_x_ = log->global_size_x();
+        row.global_size_y_ =
+            std::max<labm8::int64>(log->global_size_y(), 1);
+        row.global_size_z_ =
+            std::max<labm8::int64>(log->global_size_z(), 1);
+        row.local_size_x_ = log->local_size_x();
+        row.local_size_y_ = log->local_size_y();
+        row.local_size_z_ = log->local_size_z();
+        if (log->transferred_bytes() >= 0) {
+          row.outcome_ = "PASS";
+          row.kernel_time_ns_ = log->kernel_time_ns();
+          row.transfer_time_ns_ = log->transfer_time_ns();
+          row.transferred_bytes_ = log->transferred_bytes();
+          row.host_to_device_bytes_ = log->host_to_device_bytes();
+          row.host_to_device_time_ns_ = log->host_to_device_time_ns();
+          row.host_to_device_gbps_ = log->host_to_device_gbps();
+          row.device_to_host_bytes_ = log->device_to_host_bytes();
+          row.device_to_host_time_ns_ = log->device_to_host_time_ns();
+          row.device_to_host_gbps_ = log->device_to_host_gbps();
+          row.arg_transfers_ = FormatArgTransfers(*log);
+        }
+      }
+    }
+  }
+
+  return row;
+}
+
+void ColumnarLogRow::AppendTo(string* out) const {
+  PutInt<int32_t>(out, instance_id_);
+  PutString(out, device_);
+  PutString(out, build_opts_);
+  PutString(out, kernel_);
+  PutInt<int32_t>(out, work_item_local_mem_size_);
+  PutInt<int32_t>(out, work_item_private_mem_size_);
+  PutInt<int32_t>(out, global_size_x_);
+  PutInt<int32_t>(out, global_size_y_);
+  PutInt<int32_t>(out, global_size_z_);
+  PutInt<int32_t>(out, local_size_x_);
+  PutInt<int32_t>(out, local_size_y_);
+  PutInt<int32_t>(out, local_size_z_);
+  PutString(out, outcome_);
+  PutString(out, args_);
+  PutInt<labm8::int64>(out, transferred_bytes_);
+  PutInt<labm8::int64>(out, transfer_time_ns_);
+  PutInt<labm8::int64>(out, kernel_time_ns_);
+  PutInt<labm8::int64>(out, host_to_device_bytes_);
+  PutInt<labm8::int64>(out, host_to_device_time_ns_);
+  PutDouble(out, host_to_device_gbps_);
+  PutInt<labm8::int64>(out, device_to_host_bytes_);
+  PutInt<labm8::int64>(out, device_to_host_time_ns_);
+  PutDouble(out, device_to_host_gbps_);
+  PutString(out, arg_transfers_);
+  PutInt<int32_t>(out, tuning_rounds_);
+  PutInt<int32_t>(out, best_local_size_);
+  PutInt<int32_t>(out, sweep_index_);
+}
+
+/*static*/ bool ColumnarLogRow::ReadFrom(const string& in, size_t* pos,
+                                         ColumnarLogRow* row) {
+  int32_t instance_id;
+  int32_t work_item_local_mem_size;
+  int32_t work_item_private_mem_size;
+  int32_t global_size_x;
+  int32_t global_size_y;
+  int32_t global_size_z;
+  int32_t local_size_x;
+  int32_t local_size_y;
+  int32_t local_size_z;
+  int32_t tuning_rounds;
+  int32_t best_local_size;
+  int32_t sweep_index;
+  if (!(GetInt(in, pos, &instance_id) &&
+        GetString(in, pos, &row->device_) &&
+        GetString(in, pos, &row->build_opts_) &&
+        GetString(in, pos, &row->kernel_) &&
+        GetInt(in, pos, &work_item_local_mem_size) &&
+        GetInt(in, pos, &work_item_private_mem_size) &&
+        GetInt(in, pos, &global_size_x) && GetInt(in, pos, &global_size_y) &&
+        GetInt(in, pos, &global_size_z) && GetInt(in, pos, &local_size_x) &&
+        GetInt(in, pos, &local_size_y) && GetInt(in, pos, &local_size_z) &&
+        GetString(in, pos, &row->outcome_) &&
+        GetString(in, pos, &row->args_) &&
+        GetInt(in, pos, &row->transferred_bytes_) &&
+        GetInt(in, pos, &row->transfer_time_ns_) &&
+        GetInt(in, pos, &row->kernel_time_ns_) &&
+        GetInt(in, pos, &row->host_to_device_bytes_) &&
+        GetInt(in, pos, &row->host_to_device_time_ns_) &&
+        GetDouble(in, pos, &row->host_to_device_gbps_) &&
+        GetInt(in, pos, &row->device_to_host_bytes_) &&
+        GetInt(in, pos, &row->device_to_host_time_ns_) &&
+        GetDouble(in, pos, &row->device_to_host_gbps_) &&
+        GetString(in, pos, &row->arg_transfers_) &&
+        GetInt(in, pos, &tuning_rounds) &&
+        GetInt(in, pos, &best_local_size) &&
+        GetInt(in, pos, &sweep_index))) {
+    return false;
+  }
+  row->instance_id_ = instance_id;
+  row->work_item_local_mem_size_ = work_item_local_mem_size;
+  row->work_item_private_mem_size_ = work_item_private_mem_size;
+  row->global_size_x_ = global_size_x;
+  row->global_size_y_ = global_size_y;
+  row->global_size_z_ = global_size_z;
+  row->local_size_x_ = local_size_x;
+  row->local_size_y_ = local_size_y;
+  row->local_size_z_ = local_size_z;
+  row->tuning_rounds_ = tuning_rounds;
+  row->best_local_size_ = best_local_size;
+  row->sweep_index_ = sweep_index;
+  return true;
+}
+
+void ColumnarLogBlock::StringColumn::Add(const string& value) {
+  auto it = codes.find(value);
+  if (it == codes.end()) {
+    it = codes.emplace(value, strings.size()).first;
+    strings.push_back(value);
+  }
+  values.push_back(it->second);
+}
+
+void ColumnarLogBlock::StringColumn::Clear() {
+  codes.clear();
+  strings.clear();
+  values.clear();
+}
+
+void ColumnarLogBlock::AddRow(const ColumnarLogRow& row) {
+  instance_id_.push_back(row.instance_id_);
+  device_.Add(row.device_);
+  build_opts_.Add(row.build_opts_);
+  kernel_.Add(row.kernel_);
+  work_item_local_mem_size_.push_back(row.work_item_local_mem_size_);
+  work_item_private_mem_size_.push_back(row.work_item_private_mem_size_);
+  global_size_x_.push_back(row.global_size_x_);
+  global_size_y_.push_back(row.global_size_y_);
+  global_size_z_.push_back(row.global_size_z_);
+  local_size_x_.push_back(row.local_size_x_);
+  local_size_y_.push_back(row.local_size_y_);
+  local_size_z_.push_back(row.local_size_z_);
+  outcome_.Add(row.outcome_);
+  transferred_bytes_.push_back(row.transferred_bytes_);
+  transfer_time_ns_.push_back(row.transfer_time_ns_);
+  kernel_time_ns_.push_back(row.kernel_time_ns_);
+  host_to_device_bytes_.push_back(row.host_to_device_bytes_);
+  host_to_device_time_ns_.push_back(row.host_to_device_time_ns_);
+  host_to_device_gbps_.push_back(row.host_to_device_gbps_);
+  device_to_host_bytes_.push_back(row.device_to_host_bytes_);
+  device_to_host_time_ns_.push_back(row.device_to_host_time_ns_);
+  device_to_host_gbps_.push_back(row.device_to_host_gbps_);
+  arg_transfers_.Add(row.arg_transfers_);
+  tuning_rounds_.push_back(row.tuning_rounds_);
+  best_local_size_.push_back(row.best_local_size_);
+  sweep_index_.push_back(row.sweep_index_);
+  args_.Add(row.args_);
+}
+
+void ColumnarLogBlock::Clear() {
+  instance_id_.clear();
+  device_.Clear();
+  build_opts_.Clear();
+  kernel_.Clear();
+  work_item_local_mem_size_.clear();
+  work_item_private_mem_size_.clear();
+  global_size_x_.clear();
+  global_size_y_.clear();
+  global_size_z_.clear();
+  local_size_x_.clear();
+  local_size_y_.clear();
+  local_size_z_.clear();
+  outcome_.Clear();
+  transferred_bytes_.clear();
+  transfer_time_ns_.clear();
+  kernel_time_ns_.clear();
+  host_to_device_bytes_.clear();
+  host_to_device_time_ns_.clear();
+  host_to_device_gbps_.clear();
+  device_to_host_bytes_.clear();
+  device_to_host_time_ns_.clear();
+  device_to_host_gbps_.clear();
+  arg_transfers_.Clear();
+  tuning_rounds_.clear();
+  best_local_size_.clear();
+  sweep_index_.clear();
+  args_.Clear();
+}
+
+std::ostream& operator<<(std::ostream& stream, const ColumnarLogBlock& block) {
+  if (!block.size()) {
+    return stream;
+  }
+  CHECK(block.size() <= std::numeric_limits<uint32_t>::max());
+
+  string out(kColumnarLogMagic, sizeof(kColumnarLogMagic) - 1);
+  PutInt<uint32_t>(&out, block.size());
+  PutInt<uint32_t>(&out, /*number of columns=*/27);
+
+  PutColumn(&out, "instance", block.instance_id_);
+  PutDictionaryColumn(&out, "device", block.device_.strings,
+                      block.device_.values);
+  PutDictionaryColumn(&out, "build_opts", block.build_opts_.strings,
+                      block.build_opts_.values);
+  PutDictionaryColumn(&out, "kernel", block.kernel_.strings,
+                      block.kernel_.values);
+  PutColumn(&out, "work_item_local_mem_size",
+            block.work_item_local_mem_size_);
+  PutColumn(&out, "work_item_private_mem_size",
+            block.work_item_private_mem_size_);
+  PutColumn(&out, "global_size", block.global_size_x_);
+  PutColumn(&out, "global_size_y", block.global_size_y_);
+  PutColumn(&out, "global_size_z", block.global_size_z_);
+  PutColumn(&out, "local_size_x", block.local_size_x_);
+  PutColumn(&out, "local_size_y", block.local_size_y_);
+  PutColumn(&out, "local_size_z", block.local_size_z_);
+  PutDictionaryColumn(&out, "outcome", block.outcome_.strings,
+                      block.outcome_.values);
+  PutColumn(&out, "transferred_bytes", block.transferred_bytes_);
+  PutDeltaColumn(&out, "transfer_time_ns", block.transfer_time_ns_);
+  PutDeltaColumn(&out, "kernel_time_ns", block.kernel_time_ns_);
+  PutColumn(&out, "host_to_device_bytes", block.host_to_device_bytes_);
+  PutDeltaColumn(&out, "host_to_device_time_ns",
+                 block.host_to_device_time_ns_);
+  PutColumn(&out, "host_to_device_gbps", block.host_to_device_gbps_);
+  PutColumn(&out, "device_to_host_bytes", block.device_to_host_bytes_);
+  PutDeltaColumn(&out, "device_to_host_time_ns",
+                 block.device_to_host_time_ns_);
+  PutColumn(&out, "device_to_host_gbps", block.device_to_host_gbps_);
+  PutDictionaryColumn(&out, "arg_transfers", block.arg_transfers_.strings,
+                      block.arg_transfers_.values);
+  PutColumn(&out, "tuning_rounds", block.tuning_rounds_);
+  PutColumn(&out, "best_local_size", block.best_local_size_);
+  PutColumn(&out, "sweep_index", block.sweep_index_);
+  PutDictionaryColumn(&out, "args_info", block.args_.strings,
+                      block.args_.values);
+
+  stream.write(out.data(), out.size());
+  return stream;
+}
+
+}  // namespace cldrive
+}  // namespace gpu
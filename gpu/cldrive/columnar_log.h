@@ -0,0 +1,190 @@
+// A compact, columnar binary log format.
+//
+// Copyright (c) 2016-2020 Chris Cummins.
+// This file is part of cldrive.
+//
+// cldrive is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// cldrive is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with cldrive.  If not, see <https://www.gnu.org/licenses/>.
+//
+// A columnar log is a sequence of blocks. Blocks are self-contained, so the
+// logs of several shards can be concatenated into a single log. Each block
+// holds the same columns as the CSV log (see csv_log.h), with nulls encoded
+// as -1. All integers are little-endian. A block is:
+//
+//   char[8]   magic: "CLDCOL01"
+//   uint32    number of rows (at least 1)
+//   uint32    number of columns
+//   column[]  the columns
+//
+// A column is:
+//
+//   uint16    length of name
+//   char[]    name
+//   uint8     encoding: a ColumnEncoding
+//   ...       the encoded values
+//
+// The values of each encoding are:
+//
+//   INT32:       int32[rows]
+//   INT64:       int64[rows]
+//   FLOAT64:     IEEE 754 double[rows]
+//   DELTA_INT64: int64 first value, uint8 width w (1, 2, 4 or 8), then
+//                int{8w}[rows - 1] differences between consecutive values.
+//   DICTIONARY:  uint32 number of strings, then the strings, each as a uint32
+//                length and the string bytes, then uint8 width w (1, 2 or
+//                4), then uint{8w}[rows] indices into the strings.
+#pragma once
+
+#include "gpu/cldrive/proto/cldrive.pb.h"
+#include "labm8/cpp/port.h"
+#include "labm8/cpp/string.h"
+
+#include <iostream>
+#include <unordered_map>
+#include <vector>
+
+namespace gpu {
+namespace cldrive {
+
+// The magic bytes at the start of every block.
+constexpr char kColumnarLogMagic[] = "CLDCOL01";
+
+// The maximum number of rows in a block.
+constexpr size_t kColumnarLogBlockRows = 1 << 16;
+
+enum class ColumnEncoding : uint8_t {
+  INT32 = 0,
+  INT64 = 1,
+  DELTA_INT64 = 2,
+  DICTIONARY = 3,
+  FLOAT64 = 4,
+};
+
+// A single row of a columnar log.
+//
+// Usage:
+//    ColumnarLogBlock block;
+//    block.AddRow(ColumnarLogRow::FromProtos(...));
+class ColumnarLogRow {
+ public:
+  ColumnarLogRow(int instance_id);
+
+  // Create a row from proto messages. The column values are the same as
+  // those of CsvLog::FromProtos().
+  static ColumnarLogRow FromProtos(
+      int instance_id, const CldriveInstance* const instance,
+      const CldriveKernelInstance* const kernel_instance,
+      const CldriveKernelRun* const run,
+      const gpu::libcecl::OpenClKernelInvocation* const log);
+
+  // Append a binary encoding of the row to a string.
+  void AppendTo(string* out) const;
+
+  // Read a row encoded by AppendTo() at an offset into a string, and advance
+  // the offset past it. Returns false if the string is too short.
+  static bool ReadFrom(const string& in, size_t* pos, ColumnarLogRow* row);
+
+ private:
+  friend class ColumnarLogBlock;
+
+  int instance_id_;
+  string device_;
+  string build_opts_;
+  string kernel_;
+  int work_item_local_mem_size_;
+  int work_item_private_mem_size_;
+  int global_size_x_;
+  int global_size_y_;
+  int global_size_z_;
+  int local_size_x_;
+  int local_size_y_;
+  int local_size_z_;
+  string outcome_;
+  string args_;
+  labm8::int64 transferred_bytes_;
+  labm8::int64 transfer_time_ns_;
+  labm8::int64 kernel_time_ns_;
+  labm8::int64 host_to_device_bytes_;
+  labm8::int64 host_to_device_time_ns_;
+  double host_to_device_gbps_;
+  labm8::int64 device_to_host_bytes_;
+  labm8::int64 device_to_host_time_ns_;
+  double device_to_host_gbps_;
+  string arg_transfers_;
+  int tuning_rounds_;
+  int best_local_size_;
+  int sweep_index_;
+};
+
+// A block of rows of a columnar log, stored by column.
+//
+// Usage:
+//    ColumnarLogBlock block;
+//    block.AddRow(row);
+//    std::cout << block;
+class ColumnarLogBlock {
+ public:
+  void AddRow(const ColumnarLogRow& row);
+
+  size_t size() const { return instance_id_.size(); }
+
+  void Clear();
+
+  // Format the block to output stream. An empty block is not printed.
+  friend std::ostream& operator<<(std::ostream& stream,
+                                  const ColumnarLogBlock& block);
+
+ private:
+  // A dictionary-encoded string column.
+  struct StringColumn {
+    void Add(const string& value);
+    void Clear();
+
+    std::unordered_map<string, uint32_t> codes;
+    std::vector<string> strings;
+    std::vector<uint32_t> values;
+  };
+
+  std::vector<int32_t> instance_id_;
+  StringColumn device_;
+  StringColumn build_opts_;
+  StringColumn kernel_;
+  std::vector<int32_t> work_item_local_mem_size_;
+  std::vector<int32_t> work_item_private_mem_size_;
+  std::vector<labm8::int64> global_size_x_;
+  std::vector<int32_t> global_size_y_;
+  std::vector<int32_t> global_size_z_;
+  std::vector<int32_t> local_size_x_;
+  std::vector<int32_t> local_size_y_;
+  std::vector<int32_t> local_size_z_;
+  StringColumn outcome_;
+  std::vector<labm8::int64> transferred_bytes_;
+  std::vector<labm8::int64> transfer_time_ns_;
+  std::vector<labm8::int64> kernel_time_ns_;
+  std::vector<labm8::int64> host_to_device_bytes_;
+  std::vector<labm8::int64> host_to_device_time_ns_;
+  std::vector<double> host_to_device_gbps_;
+  std::vector<labm8::int64> device_to_host_bytes_;
+  std::vector<labm8::int64> device_to_host_time_ns_;
+  std::vector<double> device_to_host_gbps_;
+  StringColumn arg_transfers_;
+  std::vector<int32_t> tuning_rounds_;
+  std::vector<int32_t> best_local_size_;
+  std::vector<int32_t> sweep_index_;
+  StringColumn args_;
+};
+
+std::ostream& operator<<(std::ostream& stream, const ColumnarLogBlock& block);
+
+}  // namespace cldrive
+}  // namespace gpu
@@ -0,0 +1,163 @@
+// Copyright (c) 2016-2020 Chris Cummins.
+// This file is part of cldrive.
+//
+// cldrive is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// cldrive is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with cldrive.  If not, see <https://www.gnu.org/licenses/>.
+#include "gpu/cldrive/columnar_log.h"
+
+#include "gpu/cldrive/csv_log.h"
+
+#include "labm8/cpp/test.h"
+
+#include <sstream>
+
+namespace gpu {
+namespace cldrive {
+namespace {
+
+ColumnarLogRow MakeRow(int instance_id, labm8::int64 kernel_time_ns) {
+  CldriveInstance instance;
+  instance.mutable_device()->set_name("device");
+  CldriveKernelInstance kernel_instance;
+  kernel_instance.set_name("kernel");
+  CldriveKernelRun run;
+  gpu::libcecl::OpenClKernelInvocation log;
+  log.set_global_size_x(1024);
+  log.set_local_size_x(64);
+  log.set_local_size_y(1);
+  log.set_local_size_z(1);
+  log.set_transferred_bytes(4096);
+  log.set_transfer_time_ns(100);
+  log.set_kernel_time_ns(kernel_time_ns);
+  log.set_args_info("a: 1024");
+  return ColumnarLogRow::FromProtos(instance_id, &instance, &kernel_instance,
+                                    &run, &log);
+}
+
+string Print(const ColumnarLogBlock& block) {
+  std::stringstream stream;
+  stream << block;
+  return stream.str();
+}
+
+TEST(ColumnarLogBlock, EmptyBlockIsNotPrinted) {
+  ColumnarLogBlock block;
+  EXPECT_EQ(Print(block), "");
+}
+
+TEST(ColumnarLogBlock, BlockStartsWithMagicAndRowCount) {
+  ColumnarLogBlock block;
+  block.AddRow(MakeRow(0, 1000));
+  block.AddRow(MakeRow(0, 1001));
+  const string printed = Print(block);
+  ASSERT_GE(printed.size(), 12);
+  EXPECT_EQ(printed.substr(0, 8), "CLDCOL01");
+  EXPECT_EQ(printed.substr(8, 4), string("\x02\x00\x00\x00", 4));
+}
+
+TEST(ColumnarLogBlock, BlockHasTheColumnsOfTheCsvLog) {
+  ColumnarLogBlock block;
+  block.AddRow(MakeRow(0, 1000));
+  const string printed = Print(block);
+
+  std::stringstream header;
+  header << CsvLogHeader();
+  string names = header.str();
+  names.pop_back();
+
+  // Read the name of each column, skipping over its values.
+  string columnar_names;
+  size_t pos = 16;
+  for (int i = 0; i < printed[12]; ++i) {
+    const size_t length = static_cast<unsigned char>(printed[pos]);
+    if (i) {
+      columnar_names += ",";
+    }
+    columnar_names += printed.substr(pos + 2, length);
+    pos += 2 + length;
+    switch (static_cast<ColumnEncoding>(printed[pos++])) {
+      case ColumnEncoding::INT32:
+        pos += 4;
+        break;
+      case ColumnEncoding::INT64:
+      case ColumnEncoding::FLOAT64:
+        pos += 8;
+        break;
+      case ColumnEncoding::DELTA_INT64:
+        pos += 9;
+        break;
+      case ColumnEncoding::DICTIONARY:
+        pos += 4 + 4 + static_cast<unsigned char>(printed[pos + 4]) + 1 + 1;
+        break;
+    }
+  }
+  EXPECT_EQ(columnar_names, names);
+}
+
+TEST(ColumnarLogBlock, RowsAreCompact) {
+  ColumnarLogBlock block;
+  for (int i = 0; i < 100; ++i) {
+    block.AddRow(MakeRow(0, 1000 + i % 3));
+  }
+  const size_t size = Print(block).size();
+  for (int i = 0; i < 100; ++i) {
+    block.AddRow(MakeRow(0, 1000 + i % 3));
+  }
+
+  // Each row adds single byte dictionary codes for the six string columns,
+  // single byte deltas for the four timing columns, and 92 bytes of the other
+  // columns.
+  EXPECT_EQ(Print(block).size() - size, 100 * (6 + 4 + 92));
+}
+
+TEST(ColumnarLogBlock, ClearRemovesRows) {
+  ColumnarLogBlock block;
+  block.AddRow(MakeRow(0, 1000));
+  block.Clear();
+  EXPECT_EQ(block.size(), 0);
+  EXPECT_EQ(Print(block), "");
+}
+
+TEST(ColumnarLogRow, EncodedRowsRoundTrip) {
+  string encoded;
+  MakeRow(3, 1000).AppendTo(&encoded);
+  MakeRow(4, 2000).AppendTo(&encoded);
+
+  ColumnarLogBlock expected;
+  expected.AddRow(MakeRow(3, 1000));
+  expected.AddRow(MakeRow(4, 2000));
+
+  ColumnarLogBlock actual;
+  size_t pos = 0;
+  while (pos < encoded.size()) {
+    ColumnarLogRow row(0);
+    ASSERT_TRUE(ColumnarLogRow::ReadFrom(encoded, &pos, &row));
+    actual.AddRow(row);
+  }
+  EXPECT_EQ(Print(actual), Print(expected));
+}
+
+TEST(ColumnarLogRow, TruncatedRowIsRejected) {
+  string encoded;
+  MakeRow(0, 1000).AppendTo(&encoded);
+  encoded.pop_back();
+  size_t pos = 0;
+  ColumnarLogRow row(0);
+  EXPECT_FALSE(ColumnarLogRow::ReadFrom(encoded, &pos, &row));
+}
+
+}  // anonymous namespace
+}  // namespace cldrive
+}  // namespace gpu
+
+TEST_MAIN();
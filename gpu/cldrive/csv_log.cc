@@ -17,6 +17,9 @@
 
 #include "labm8/cpp/logging.h"
 
+#include "absl/strings/str_cat.h"
+
+#include <algorithm>
 #include <iostream>
 
 namespace gpu {
@@ -51,8 +54,12 @@ std::ostream& NullIfNegative(std::ostream& stream, const T& value) {
 
 std::ostream& operator<<(std::ostream& stream, const CsvLogHeader& header) {
   stream << "instance,device,build_opts,kernel,work_item_local_mem_size,"
-         << "work_item_private_mem_size,global_size,local_size_x,local_size_y,local_size_z,outcome,"
-         << "transferred_bytes,transfer_time_ns,kernel_time_ns,args_info\n";
+         << "work_item_private_mem_size,global_size,global_size_y,global_size_z,local_size_x,local_size_y,local_size_z,outcome,"
+         << "transferred_bytes,transfer_time_ns,kernel_time_ns,"
+         << "host_to_device_bytes,host_to_device_time_ns,host_to_device_gbps,"
+         << "device_to_host_bytes,device_to_host_time_ns,device_to_host_gbps,"
+         << "arg_transfers,tuning_rounds,best_local_size,sweep_index,"
+         << "args_info\n";
   return stream;
 }
 
@@ -61,12 +68,23 @@ CsvLog::CsvLog(int instance_id)
       work_item_local_mem_size_(-1),
       work_item_private_mem_size_(-1),
       global_size_x_(-1),
+      global_size_y_(-1),
+      global_size_z_(-1),
       local_size_x_(-1),
       local_size_y_(-1),
       local_size_z_(-1),
       transferred_bytes_(-1),
       transfer_time_ns_(-1),
-      kernel_time_ns_(-1) {
+      kernel_time_ns_(-1),
+      host_to_device_bytes_(-1),
+      host_to_device_time_ns_(-1),
+      host_to_device_gbps_(-1),
+      device_to_host_bytes_(-1),
+      device_to_host_time_ns_(-1),
+      device_to_host_gbps_(-1),
+      tuning_rounds_(-1),
+      best_local_size_(-1),
+      sweep_index_(-1) {
   CHECK(instance_id >= 0) << "Negative instance ID not allowed";
 }
 
@@ -89,16 +107,48 @@ std::ostream& operator<<(std::ostream& stream, const CsvLog& log) {
   NullIfNegative(stream, log.work_item_local_mem_size_) << ",";
   NullIfNegative(stream, log.work_item_private_mem_size_) << ",";
   NullIfNegative(stream, log.global_size_x_) << ",";
+  NullIfNegative(stream, log.global_size_y_) << ",";
+  NullIfNegative(stream, log.global_size_z_) << ",";
   NullIfNegative(stream, log.local_size_x_) << ",";
   NullIfNegative(stream, log.local_size_y_) << ",";
   NullIfNegative(stream, log.local_size_z_) << "," << log.outcome_ << ",";
   NullIfNegative(stream, log.transferred_bytes_) << ",";
   NullIfNegative(stream, log.transfer_time_ns_) << ",";
   NullIfNegative(stream, log.kernel_time_ns_) << ",";
+  NullIfNegative(stream, log.host_to_device_bytes_) << ",";
+  NullIfNegative(stream, log.host_to_device_time_ns_) << ",";
+  NullIfNegative(stream, log.host_to_device_gbps_) << ",";
+  NullIfNegative(stream, log.device_to_host_bytes_) << ",";
+  NullIfNegative(stream, log.device_to_host_time_ns_) << ",";
+  NullIfNegative(stream, log.device_to_host_gbps_) << ",";
+  NullIfEmpty(stream, log.arg_transfers_) << ",";
+  NullIfNegative(stream, log.tuning_rounds_) << ",";
+  NullIfNegative(stream, log.best_local_size_) << ",";
+  NullIfNegative(stream, log.sweep_index_) << ",";
   NullIfEmpty(stream, addQuotes(log.args_)) << std::endl;
   return stream;
 }
 
+string KernelRunOutcomeName(const CldriveKernelRun& run) {
+  string name = CldriveKernelRun::KernelRunOutcome_Name(run.outcome());
+  if (run.outcome() == CldriveKernelRun::TIMEOUT) {
+    name += "_" + CldriveKernelRun::TimeoutPhase_Name(run.timeout_phase());
+  }
+  return name;
+}
+
+string FormatArgTransfers(const gpu::libcecl::OpenClKernelInvocation& log) {
+  string formatted;
+  for (const auto& transfer : log.arg_transfer()) {
+    absl::StrAppend(&formatted, formatted.empty() ? "" : " ",
+                    transfer.arg_index(), ":", transfer.host_to_device_bytes(),
+                    ":", transfer.host_to_device_time_ns(), ":",
+                    transfer.device_to_host_bytes(), ":",
+                    transfer.device_to_host_time_ns());
+  }
+  return formatted;
+}
+
 /*static*/ CsvLog CsvLog::FromProtos(
     int instance_id, const CldriveInstance* const instance,
     const CldriveKernelInstance* const kernel_instance,
@@ -111,7 +161,9 @@ std::ostream& operator<<(std::ostream& stream, const CsvLog& log) {
   csv.build_opts_ = instance->build_opts();
 
   csv.outcome_ = CldriveInstance::InstanceOutcome_Name(instance->outcome());
-  csv.args_ = log->args_info();
+  if (log) {
+    csv.args_ = log->args_info();
+  }
   if (kernel_instance) {
     csv.kernel_ = kernel_instance->name();
     csv.work_item_local_mem_size_ =
@@ -122,9 +174,20 @@ std::ostream& operator<<(std::ostream& stream, const CsvLog& log) {
     csv.outcome_ = CldriveKernelInstance::KernelInstanceOutcome_Name(
         kernel_instance->outcome());
     if (run) {
-      csv.outcome_ = CldriveKernelRun::KernelRunOutcome_Name(run->outcome());
+      csv.outcome_ = KernelRunOutcomeName(*run);
+      if (instance->tune_lsize()) {
+        csv.tuning_rounds_ = run->tuning_rounds();
+        csv.best_local_size_ = run->best_local_size();
+      }
+      if (run->has_sweep_index()) {
+        csv.sweep_index_ = run->sweep_index();
+      }
       if (log) {
         csv.global_size_x_ = log->global_size_x();
+        csv.global_size_y_ =
+            std::max<labm8::int64>(log->global_size_y(), 1);
+        csv.global_size_z_ =
+            std::max<labm8::int64>(log->global_size_z(), 1);
         csv.local_size_x_ = log->local_size_x();
         csv.local_size_y_ = log->local_size_y();
         csv.local_size_z_ = log->local_size_z();
@@ -133,6 +196,13 @@ std::ostream& operator<<(std::ostream& stream, const CsvLog& log) {
           csv.kernel_time_ns_ = log->kernel_time_ns();
           csv.transfer_time_ns_ = log->transfer_time_ns();
           csv.transferred_bytes_ = log->transferred_bytes();
+          csv.host_to_device_bytes_ = log->host_to_device_bytes();
+          csv.host_to_device_time_ns_ = log->host_to_device_time_ns();
+          csv.host_to_device_gbps_ = log->host_to_device_gbps();
+          csv.device_to_host_bytes_ = log->device_to_host_bytes();
+          csv.device_to_host_time_ns_ = log->device_to_host_time_ns();
+          csv.device_to_host_gbps_ = log->device_to_host_gbps();
+          csv.arg_transfers_ = FormatArgTransfers(*log);
         }
       }
     }
@@ -141,5 +211,111 @@ std::ostream& operator<<(std::ostream& stream, const CsvLog& log) {
   return csv;
 }
 
+std::ostream& operator<<(std::ostream& stream,
+                         const CsvSummaryLogHeader& header) {
+  stream << "instance,device,build_opts,kernel,global_size,global_size_y,"
+         << "global_size_z,local_size_x,local_size_y,local_size_z,outcome,"
+         << "stopping_reason,num_runs,"
+         << "kernel_time_ns_min,kernel_time_ns_max,kernel_time_ns_mean,"
+         << "kernel_time_ns_std,kernel_time_ns_p25,kernel_time_ns_p50,"
+         << "kernel_time_ns_p75,kernel_time_ns_p99,kernel_time_ns_mad,"
+         << "num_outliers,tuning_rounds,best_local_size,sweep_index,"
+         << "args_info\n";
+  return stream;
+}
+
+CsvSummaryLog::CsvSummaryLog(int instance_id)
+    : instance_id_(instance_id),
+      global_size_x_(-1),
+      global_size_y_(-1),
+      global_size_z_(-1),
+      local_size_x_(-1),
+      local_size_y_(-1),
+      local_size_z_(-1),
+      has_summary_(false),
+      tuning_rounds_(-1),
+      best_local_size_(-1),
+      sweep_index_(-1) {
+  CHECK(instance_id >= 0) << "Negative instance ID not allowed";
+}
+
+std::ostream& operator<<(std::ostream& stream, const CsvSummaryLog& log) {
+  stream << log.instance_id_ << "," << log.device_ << "," << log.build_opts_
+         << ",";
+  NullIfEmpty(stream, log.kernel_) << ",";
+  NullIfNegative(stream, log.global_size_x_) << ",";
+  NullIfNegative(stream, log.global_size_y_) << ",";
+  NullIfNegative(stream, log.global_size_z_) << ",";
+  NullIfNegative(stream, log.local_size_x_) << ",";
+  NullIfNegative(stream, log.local_size_y_) << ",";
+  NullIfNegative(stream, log.local_size_z_) << "," << log.outcome_ << ",";
+  NullIfEmpty(stream, log.stopping_reason_) << ",";
+  if (log.has_summary_) {
+    const KernelTimeSummary& summary = log.summary_;
+    stream << summary.num_runs() << "," << summary.min() << ","
+           << summary.max() << "," << summary.mean() << ","
+           << summary.stddev() << "," << summary.p25() << ","
+           << summary.p50() << "," << summary.p75() << "," << summary.p99()
+           << "," << summary.mad() << "," << summary.num_outliers() << ",";
+  } else {
+    stream << ",,,,,,,,,,,";
+  }
+  NullIfNegative(stream, log.tuning_rounds_) << ",";
+  NullIfNegative(stream, log.best_local_size_) << ",";
+  NullIfNegative(stream, log.sweep_index_) << ",";
+  NullIfEmpty(stream, addQuotes(log.args_)) << std::endl;
+  return stream;
+}
+
+/*static*/ CsvSummaryLog CsvSummaryLog::FromProtos(
+    int instance_id, const CldriveInstance* const instance,
+    const CldriveKernelInstance* const kernel_instance,
+    const CldriveKernelRun* const run,
+    const gpu::libcecl::OpenClKernelInvocation* const log) {
+  CsvSummaryLog csv(instance_id);
+
+  CHECK(instance) << "CldriveInstance pointer cannot be null";
+  csv.device_ = instance->device().name();
+  csv.build_opts_ = instance->build_opts();
+
+  csv.outcome_ = CldriveInstance::InstanceOutcome_Name(instance->outcome());
+  if (log) {
+    csv.args_ = log->args_info();
+  }
+  if (kernel_instance) {
+    csv.kernel_ = kernel_instance->name();
+    csv.outcome_ = CldriveKernelInstance::KernelInstanceOutcome_Name(
+        kernel_instance->outcome());
+    if (run) {
+      csv.outcome_ = KernelRunOutcomeName(*run);
+      if (instance->tune_lsize()) {
+        csv.tuning_rounds_ = run->tuning_rounds();
+        csv.best_local_size_ = run->best_local_size();
+      }
+      if (run->has_sweep_index()) {
+        csv.sweep_index_ = run->sweep_index();
+      }
+      if (log) {
+        csv.global_size_x_ = log->global_size_x();
+        csv.global_size_y_ =
+            std::max<labm8::int64>(log->global_size_y(), 1);
+        csv.global_size_z_ =
+            std::max<labm8::int64>(log->global_size_z(), 1);
+        csv.local_size_x_ = log->local_size_x();
+        csv.local_size_y_ = log->local_size_y();
+        csv.local_size_z_ = log->local_size_z();
+      }
+      if (run->has_kernel_time_summary()) {
+        csv.stopping_reason_ =
+            CldriveKernelRun::StoppingReason_Name(run->stopping_reason());
+        csv.summary_ = run->kernel_time_summary();
+        csv.has_summary_ = true;
+      }
+    }
+  }
+
+  return csv;
+}
+
 }  // namespace cldrive
 }  // namespace gpu
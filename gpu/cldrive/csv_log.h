@@ -24,6 +24,14 @@
 namespace gpu {
 namespace cldrive {
 
+// Return the name of the outcome of a run. The outcome of a run which timed
+// out is qualified with the phase which overran, e.g. "TIMEOUT_KERNEL".
+string KernelRunOutcomeName(const CldriveKernelRun& run);
+
+// Return the transfers of each argument of a run, as a space separated list
+// of "<arg_index>:<h2d_bytes>:<h2d_time_ns>:<d2h_bytes>:<d2h_time_ns>".
+string FormatArgTransfers(const gpu::libcecl::OpenClKernelInvocation& log);
+
 // A class which prints the header values for a CSV row.
 //
 // Usage:
@@ -81,6 +89,12 @@ class CsvLog {
   // CldriveInstance.outcome != PASS, this will be empty.
   int global_size_x_;
 
+  // From CldriveInstance.dynamic_params.global_size_y and global_size_z
+  // fields, or one if unset. If CldriveInstance.outcome != PASS, these will
+  // be empty.
+  int global_size_y_;
+  int global_size_z_;
+
   // From CldriveInstance.dynamic_params.local_size_x field. If
   // CldriveInstance.outcome != PASS, this will be empty.
   int local_size_x_;
@@ -106,12 +120,104 @@ class CsvLog {
   labm8::int64 transfer_time_ns_;
   labm8::int64 kernel_time_ns_;
 
+  // The transfers of transferred_bytes and transfer_time_ns by direction,
+  // from CldriveKernelRun.log. If outcome != PASS, these will be empty.
+  labm8::int64 host_to_device_bytes_;
+  labm8::int64 host_to_device_time_ns_;
+  double host_to_device_gbps_;
+  labm8::int64 device_to_host_bytes_;
+  labm8::int64 device_to_host_time_ns_;
+  double device_to_host_gbps_;
+
+  // The transfers of each argument, from OpenClKernelInvocation.arg_transfer,
+  // as formatted by FormatArgTransfers().
+  string arg_transfers_;
+
+  // From CldriveKernelRun.tuning_rounds and best_local_size, as 0 or 1. If
+  // CldriveInstance.tune_lsize is false or there is no run, these will be
+  // empty.
+  int tuning_rounds_;
+  int best_local_size_;
+
+  // From CldriveKernelRun.sweep_index. If there is no run, this will be empty.
+  int sweep_index_;
+
+  // End CSV columns (in order) -----------------------------------
+};
+
+// A class which prints the header values for a summary CSV row.
+//
+// Usage:
+//    std::cout << CsvSummaryLogHeader();
+class CsvSummaryLogHeader {
+  // Format CSV header to output stream.
+  friend std::ostream& operator<<(std::ostream& stream,
+                                  const CsvSummaryLogHeader& log);
+};
+
+// A class which formats a summary CSV row: one row per kernel and launch
+// config, rather than one row per run.
+//
+// Usage:
+//    CsvSummaryLog::FromProtos log(...);
+//    std::cout << log;
+class CsvSummaryLog {
+ public:
+  CsvSummaryLog(int instance_id);
+
+  // Create a log from proto messages. The kernel time columns are set from
+  // CldriveKernelRun.kernel_time_summary. The log is only used for the launch
+  // config and arguments of runs which failed before their summary was made.
+  static CsvSummaryLog FromProtos(
+      int instance_id, const CldriveInstance* const instance,
+      const CldriveKernelInstance* const kernel_instance,
+      const CldriveKernelRun* const run,
+      const gpu::libcecl::OpenClKernelInvocation* const log);
+
+  // Format CSV to output stream.
+  friend std::ostream& operator<<(std::ostream& stream,
+                                  const CsvSummaryLog& log);
+
+ private:
+  // Begin CSV columns (in order) -----------------------------------
+
+  // As for CsvLog.
+  int instance_id_;
+  string device_;
+  string build_opts_;
+  string kernel_;
+  int global_size_x_;
+  int global_size_y_;
+  int global_size_z_;
+  int local_size_x_;
+  int local_size_y_;
+  int local_size_z_;
+  string outcome_;
+
+  // From CldriveKernelRun.stopping_reason. If outcome != PASS, this will be
+  // empty.
+  string stopping_reason_;
+
+  // From CldriveKernelRun.kernel_time_summary. If outcome != PASS, these will
+  // be empty.
+  KernelTimeSummary summary_;
+  bool has_summary_;
+
+  // As for CsvLog.
+  int tuning_rounds_;
+  int best_local_size_;
+  int sweep_index_;
+  string args_;
+
   // End CSV columns (in order) -----------------------------------
 };
 
 //
 std::ostream& operator<<(std::ostream& stream, const CsvLogHeader& log);
 std::ostream& operator<<(std::ostream& stream, const CsvLog& log);
+std::ostream& operator<<(std::ostream& stream,
+                         const CsvSummaryLogHeader& log);
+std::ostream& operator<<(std::ostream& stream, const CsvSummaryLog& log);
 
 }  // namespace cldrive
 }  // namespace gpu
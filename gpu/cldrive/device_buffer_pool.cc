@@ -0,0 +1,82 @@
+// Copyright (c) 2016-2020 Chris Cummins.
+// This file is part of cldrive.
+//
+// cldrive is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// cldrive is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with cldrive.  If not, see <https://www.gnu.org/licenses/>.
+#include "gpu/cldrive/device_buffer_pool.h"
+
+#include "labm8/cpp/logging.h"
+
+namespace gpu {
+namespace cldrive {
+
+namespace {
+
+// The smallest size class. Smaller requests are rounded up to this.
+constexpr size_t kMinSizeClass = 256;
+
+}  // anonymous namespace
+
+DeviceBufferPool::DeviceBufferPool(const cl::Context& context,
+                                   size_t max_idle_bytes)
+    : context_(context), max_idle_bytes_(max_idle_bytes) {}
+
+size_t DeviceBufferPool::SizeClass(size_t size) {
+  if (size <= kMinSizeClass) {
+    return kMinSizeClass;
+  }
+
+  // Find the largest power of two strictly less than size, then round up to
+  // a multiple of a quarter of it.
+  size_t power = kMinSizeClass;
+  while (power * 2 < size) {
+    power *= 2;
+  }
+  const size_t step = power / 4;
+  return ((size + step - 1) / step) * step;
+}
+
+cl::Buffer DeviceBufferPool::Acquire(size_t size) {
+  const size_t size_class = SizeClass(size);
+
+  {
+    labm8::MutexLock lock(&mutex_);
+    auto it = idle_.find(size_class);
+    if (it != idle_.end() && !it->second.empty()) {
+      cl::Buffer buffer = it->second.back();
+      it->second.pop_back();
+      idle_bytes_ -= size_class;
+      ++reuses_;
+      return buffer;
+    }
+    ++allocations_;
+  }
+
+  return cl::Buffer(context_, /*flags=*/CL_MEM_READ_WRITE,
+                    /*size=*/size_class);
+}
+
+void DeviceBufferPool::Release(cl::Buffer buffer, size_t size) {
+  const size_t size_class = SizeClass(size);
+
+  labm8::MutexLock lock(&mutex_);
+  if (idle_bytes_ + size_class > max_idle_bytes_) {
+    // The pool is full. The buffer is freed when it goes out of scope.
+    return;
+  }
+  idle_[size_class].push_back(buffer);
+  idle_bytes_ += size_class;
+}
+
+}  // namespace cldrive
+}  // namespace gpu
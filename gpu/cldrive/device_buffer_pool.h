@@ -0,0 +1,77 @@
+// A pool of reusable OpenCL device buffers.
+//
+// Copyright (c) 2016-2020 Chris Cummins.
+// This file is part of cldrive.
+//
+// cldrive is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// cldrive is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with cldrive.  If not, see <https://www.gnu.org/licenses/>.
+#pragma once
+
+#include "labm8/cpp/macros.h"
+#include "labm8/cpp/mutex.h"
+
+#include "third_party/opencl/cl.hpp"
+
+#include <map>
+#include <vector>
+
+namespace gpu {
+namespace cldrive {
+
+// A pool of CL_MEM_READ_WRITE buffers for a single context.
+//
+// Requested sizes are rounded up to a size class, so that a released buffer
+// can satisfy later requests of a similar size. Size classes are spaced at a
+// quarter of each power of two, which bounds the wasted space to 25%.
+// Released buffers are kept until the total size of the idle buffers would
+// exceed max_idle_bytes.
+//
+// Acquire() and Release() are thread safe.
+class DeviceBufferPool {
+ public:
+  // The default limit on the total size of idle buffers (256 MiB).
+  static constexpr size_t kDefaultMaxIdleBytes = 256 << 20;
+
+  explicit DeviceBufferPool(const cl::Context& context,
+                            size_t max_idle_bytes = kDefaultMaxIdleBytes);
+
+  // Return a buffer of at least size bytes. The buffer's actual size is
+  // SizeClass(size). Its contents are undefined.
+  cl::Buffer Acquire(size_t size);
+
+  // Return a buffer to the pool. The size must be that passed to Acquire().
+  void Release(cl::Buffer buffer, size_t size);
+
+  // Return the size class of a request for the given number of bytes.
+  static size_t SizeClass(size_t size);
+
+  size_t allocations() const { return allocations_; }
+  size_t reuses() const { return reuses_; }
+  size_t idle_bytes() const { return idle_bytes_; }
+
+ private:
+  cl::Context context_;
+  const size_t max_idle_bytes_;
+
+  mutable labm8::Mutex mutex_;
+  // Idle buffers, keyed by size class.
+  std::map<size_t, std::vector<cl::Buffer>> idle_;
+  size_t idle_bytes_ = 0;
+  size_t allocations_ = 0;
+  size_t reuses_ = 0;
+
+  DISALLOW_EVIL_CONSTRUCTORS(DeviceBufferPool);
+};
+
+}  // namespace cldrive
+}  // namespace gpu
@@ -0,0 +1,87 @@
+// Copyright (c) 2016-2020 Chris Cummins.
+// This file is part of cldrive.
+//
+// cldrive is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// cldrive is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with cldrive.  If not, see <https://www.gnu.org/licenses/>.
+#include "gpu/cldrive/device_buffer_pool.h"
+
+#include "gpu/cldrive/testutil.h"
+
+#include "labm8/cpp/test.h"
+
+namespace gpu {
+namespace cldrive {
+namespace {
+
+cl::Context MakeTestContext() {
+  return test::CreateClKernel("kernel void A(global int* a) {}")
+      .getInfo<CL_KERNEL_CONTEXT>();
+}
+
+TEST(DeviceBufferPool, SmallSizesShareMinimumClass) {
+  EXPECT_EQ(DeviceBufferPool::SizeClass(0), 256);
+  EXPECT_EQ(DeviceBufferPool::SizeClass(1), 256);
+  EXPECT_EQ(DeviceBufferPool::SizeClass(256), 256);
+}
+
+TEST(DeviceBufferPool, PowersOfTwoAreExact) {
+  EXPECT_EQ(DeviceBufferPool::SizeClass(512), 512);
+  EXPECT_EQ(DeviceBufferPool::SizeClass(4096), 4096);
+  EXPECT_EQ(DeviceBufferPool::SizeClass(1 << 20), 1 << 20);
+}
+
+TEST(DeviceBufferPool, SizesAreRoundedToQuarterSteps) {
+  EXPECT_EQ(DeviceBufferPool::SizeClass(257), 320);
+  EXPECT_EQ(DeviceBufferPool::SizeClass(513), 640);
+  EXPECT_EQ(DeviceBufferPool::SizeClass(4000), 4096);
+  EXPECT_EQ(DeviceBufferPool::SizeClass(4097), 5120);
+}
+
+TEST(DeviceBufferPool, ReleasedBufferIsReused) {
+  DeviceBufferPool pool(MakeTestContext());
+
+  cl::Buffer a = pool.Acquire(1000);
+  pool.Release(a, 1000);
+  cl::Buffer b = pool.Acquire(1020);
+
+  EXPECT_EQ(a(), b());
+  EXPECT_EQ(pool.allocations(), 1);
+  EXPECT_EQ(pool.reuses(), 1);
+}
+
+TEST(DeviceBufferPool, DifferentSizeClassIsNotReused) {
+  DeviceBufferPool pool(MakeTestContext());
+
+  pool.Release(pool.Acquire(1000), 1000);
+  pool.Acquire(4000);
+
+  EXPECT_EQ(pool.allocations(), 2);
+  EXPECT_EQ(pool.reuses(), 0);
+}
+
+TEST(DeviceBufferPool, IdleBytesAreBounded) {
+  DeviceBufferPool pool(MakeTestContext(), /*max_idle_bytes=*/1024);
+
+  cl::Buffer a = pool.Acquire(1024);
+  cl::Buffer b = pool.Acquire(1024);
+  pool.Release(a, 1024);
+  pool.Release(b, 1024);
+
+  EXPECT_EQ(pool.idle_bytes(), 1024);
+}
+
+}  // anonymous namespace
+}  // namespace cldrive
+}  // namespace gpu
+
+TEST_MAIN();
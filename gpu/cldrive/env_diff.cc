@@ -0,0 +1,235 @@
+// Copyright (c) 2016-2020 Chris Cummins.
+// This file is part of cldrive.
+//
+// cldrive is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// cldrive is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with cldrive.  If not, see <https://www.gnu.org/licenses/>.
+#include "gpu/cldrive/env_diff.h"
+
+#include "gpu/cldrive/buffer_compare.h"
+#include "gpu/cldrive/kernel_arg_set.h"
+#include "gpu/cldrive/opencl_util.h"
+#include "gpu/clinfo/libclinfo.h"
+
+#include "labm8/cpp/logging.h"
+#include "labm8/cpp/status.h"
+
+#include "absl/strings/str_cat.h"
+
+#include <thread>
+
+namespace gpu {
+namespace cldrive {
+
+namespace {
+
+// The outputs of a kernel on a device.
+struct DeviceOutputs {
+  labm8::Status status;
+  std::vector<KernelArg> args;
+  // The values of global buffer arguments after the run. Other arguments are
+  // nullptr.
+  KernelArgValuesSet values;
+};
+
+// Run a kernel once with the random inputs of the instance, and copy its
+// global buffers back to the host.
+void RunOnDevice(DeviceState* device_state, cl::Kernel kernel,
+                 const DynamicParams& dynamic_params,
+                 const CldriveInstance& instance, DeviceOutputs* outputs) {
+  // Outputs are copied back to the host, so zero-copy buffers would save
+  // nothing.
+  KernelArgSet args_set(&kernel, device_state->buffer_pool.get(),
+                        instance.seed(), /*zero_copy=*/false);
+  if (args_set.Init() != CldriveKernelInstance::PASS) {
+    outputs->status = labm8::Status(labm8::error::Code::INVALID_ARGUMENT,
+                                    "Unsupported kernel arguments");
+    return;
+  }
+
+  try {
+    KernelArgValuesSet inputs;
+    labm8::Status status =
+        instance.args_values_size()
+            ? args_set.SetRandom(
+                  device_state->context,
+                  std::vector<long long>(instance.args_values().begin(),
+                                         instance.args_values().end()),
+                  &inputs)
+            : args_set.SetRandom(device_state->context, dynamic_params,
+                                 &inputs);
+    if (!status.ok()) {
+      outputs->status = status;
+      return;
+    }
+
+    ProfilingData profiling;
+    inputs.CopyToDevice(device_state->queue, &profiling);
+    inputs.SetAsArgs(&kernel);
+    device_state->queue.enqueueNDRangeKernel(
+        kernel, /*offset=*/cl::NullRange,
+        /*global=*/util::GetGlobalRange(dynamic_params),
+        /*local=*/util::GetLocalRange(dynamic_params));
+    for (size_t i = 0; i < args_set.args().size(); ++i) {
+      const KernelArg& arg = args_set.args()[i];
+      outputs->values.AddKernelArgValue(
+          arg.IsPointer() && arg.IsGlobal()
+              ? inputs.values()[i]->CopyFromDevice(device_state->queue,
+                                                   &profiling)
+              : nullptr);
+    }
+    outputs->args = args_set.args();
+  } catch (cl::Error error) {
+    outputs->status = labm8::Status(
+        labm8::error::Code::INTERNAL, "Error code {} ({}) raised by {}()",
+        error.err(), labm8::gpu::clinfo::OpenClErrorString(error.err()),
+        error.what());
+  }
+}
+
+// Set the outcome and argument comparisons of diff from the outputs of the
+// two devices.
+void CompareOutputs(const DeviceOutputs& a, const DeviceOutputs& b,
+                    uint64_t max_ulps, CldriveKernelDiff* diff) {
+  for (const DeviceOutputs* outputs : {&a, &b}) {
+    if (!outputs->status.ok()) {
+      diff->set_outcome(outputs->status.code() ==
+                                labm8::error::Code::INVALID_ARGUMENT
+                            ? CldriveKernelDiff::UNSUPPORTED_ARGUMENTS
+                            : CldriveKernelDiff::CL_ERROR);
+      diff->set_error(absl::StrCat(
+          outputs == &a ? diff->device_a() : diff->device_b(), ": ",
+          outputs->status.error_message().ToString()));
+      return;
+    }
+  }
+
+  diff->set_outcome(CldriveKernelDiff::MATCH);
+  for (size_t i = 0; i < a.args.size(); ++i) {
+    const KernelArgValue* a_value = a.values.values()[i].get();
+    const KernelArgValue* b_value = b.values.values()[i].get();
+    if (!a_value || !b_value) {
+      continue;
+    }
+    // The argument set was initialized, so its types are known.
+    const ElementFormat format =
+        GetElementFormat(a.args[i].type()).ValueOrDie();
+    CHECK(a_value->Size() == b_value->Size());
+
+    CldriveArgDiff* arg_diff = diff->add_arg();
+    arg_diff->set_arg_index(i);
+    arg_diff->set_name(a.args[i].name());
+    arg_diff->set_type_name(a.args[i].type_name());
+    arg_diff->set_num_elements(a_value->Size());
+
+    const BufferDiff buffer_diff =
+        CompareBuffers(format, a_value->HostData(), b_value->HostData(),
+                       a_value->Size(), max_ulps);
+    arg_diff->set_num_mismatches(buffer_diff.num_mismatches);
+    arg_diff->set_first_mismatch_index(buffer_diff.first_mismatch_index);
+    arg_diff->set_max_ulp_distance(buffer_diff.max_ulp_distance);
+    if (buffer_diff.num_mismatches) {
+      arg_diff->set_value_a(LaneToString(format, a_value->HostData(),
+                                         buffer_diff.first_mismatch_index,
+                                         buffer_diff.first_mismatch_lane));
+      arg_diff->set_value_b(LaneToString(format, b_value->HostData(),
+                                         buffer_diff.first_mismatch_index,
+                                         buffer_diff.first_mismatch_lane));
+      diff->set_outcome(CldriveKernelDiff::MISMATCH);
+    }
+  }
+}
+
+}  // anonymous namespace
+
+std::vector<CldriveKernelDiff> DiffEnvs(
+    const CldriveInstance& instance,
+    const ::gpu::clinfo::OpenClDevice& device_a,
+    const ::gpu::clinfo::OpenClDevice& device_b, uint64_t max_ulps,
+    CldriveSession* session) {
+  DeviceState* device_states[2] = {session->GetDeviceStateOrDie(device_a),
+                                   session->GetDeviceStateOrDie(device_b)};
+  // A device has one state in the session, whose queue and programs would be
+  // shared by both threads.
+  CHECK(device_states[0] != device_states[1])
+      << "Cannot diff OpenCL device '" << device_states[0]->name
+      << "' against itself";
+  std::vector<cl::Kernel> kernels[2];
+  for (int i = 0; i < 2; ++i) {
+    labm8::StatusOr<cl::Program> program_or = session->GetProgram(
+        device_states[i], instance.opencl_src(), instance.build_opts(),
+        instance.compile_timeout_ms());
+    if (!program_or.ok()) {
+      CldriveKernelDiff diff;
+      diff.set_device_a(device_states[0]->name);
+      diff.set_device_b(device_states[1]->name);
+      diff.set_outcome(CldriveKernelDiff::PROGRAM_COMPILATION_FAILURE);
+      diff.set_error(
+          absl::StrCat(device_states[i]->name, ": ",
+                       program_or.status().error_message().ToString()));
+      return {diff};
+    }
+    cl::Program program = program_or.ValueOrDie();
+    program.createKernels(&kernels[i]);
+  }
+
+  std::vector<CldriveKernelDiff> diffs;
+  for (const auto& kernel_a : kernels[0]) {
+    const string name = util::GetOpenClKernelName(kernel_a);
+    const cl::Kernel* kernel_b = nullptr;
+    for (const auto& kernel : kernels[1]) {
+      if (util::GetOpenClKernelName(kernel) == name) {
+        kernel_b = &kernel;
+        break;
+      }
+    }
+
+    for (const auto& dynamic_params : instance.dynamic_params()) {
+      CldriveKernelDiff diff;
+      diff.set_kernel_name(name);
+      *diff.mutable_dynamic_params() = dynamic_params;
+      diff.set_device_a(device_states[0]->name);
+      diff.set_device_b(device_states[1]->name);
+      if (!kernel_b) {
+        diff.set_outcome(CldriveKernelDiff::UNSUPPORTED_ARGUMENTS);
+        diff.set_error(absl::StrCat(device_states[1]->name,
+                                    ": Kernel not found in program"));
+        diffs.push_back(diff);
+        continue;
+      }
+
+      // The devices are run concurrently. Each has its own queue and kernel
+      // object, and the buffer pools are thread safe.
+      DeviceOutputs outputs_a, outputs_b;
+      std::thread thread_b([&]() {
+        RunOnDevice(device_states[1], *kernel_b, dynamic_params, instance,
+                    &outputs_b);
+      });
+      RunOnDevice(device_states[0], kernel_a, dynamic_params, instance,
+                  &outputs_a);
+      thread_b.join();
+
+      CompareOutputs(outputs_a, outputs_b, max_ulps, &diff);
+      if (diff.outcome() != CldriveKernelDiff::MATCH) {
+        LOG(WARNING) << "Kernel '" << name << "' differs between '"
+                     << diff.device_a() << "' and '" << diff.device_b()
+                     << "': "
+                     << CldriveKernelDiff::Outcome_Name(diff.outcome());
+      }
+      diffs.push_back(diff);
+    }
+  }
+  return diffs;
+}
+
+}  // namespace cldrive
+}  // namespace gpu
@@ -0,0 +1,45 @@
+// Compare the outputs of kernels on two OpenCL devices.
+//
+// Copyright (c) 2016-2020 Chris Cummins.
+// This file is part of cldrive.
+//
+// cldrive is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// cldrive is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with cldrive.  If not, see <https://www.gnu.org/licenses/>.
+#pragma once
+
+#include "gpu/cldrive/proto/cldrive.pb.h"
+#include "gpu/cldrive/session.h"
+#include "gpu/clinfo/proto/clinfo.pb.h"
+
+#include <cstdint>
+#include <vector>
+
+namespace gpu {
+namespace cldrive {
+
+// Run each kernel of the instance's opencl_src once on device_a and once on
+// device_b, for each of the instance's dynamic params, and compare the
+// outputs of their global buffer arguments with CompareBuffers(). Inputs are
+// the random values of the instance's seed, and of its args_values if set,
+// so both devices see the same inputs. The two devices must differ, and are
+// run on a thread each. Returns one comparison per kernel and launch config,
+// or a single PROGRAM_COMPILATION_FAILURE if the program cannot be built on
+// either device.
+std::vector<CldriveKernelDiff> DiffEnvs(
+    const CldriveInstance& instance,
+    const ::gpu::clinfo::OpenClDevice& device_a,
+    const ::gpu::clinfo::OpenClDevice& device_b, uint64_t max_ulps,
+    CldriveSession* session);
+
+}  // namespace cldrive
+}  // namespace gpu
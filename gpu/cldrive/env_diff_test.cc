@@ -0,0 +1,72 @@
+// Copyright (c) 2016-2020 Chris Cummins.
+// This file is part of cldrive.
+//
+// cldrive is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// cldrive is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with cldrive.  If not, see <https://www.gnu.org/licenses/>.
+#include "gpu/cldrive/env_diff.h"
+
+#include "gpu/clinfo/libclinfo.h"
+
+#include "labm8/cpp/test.h"
+
+namespace gpu {
+namespace cldrive {
+namespace {
+
+CldriveInstance MakeInstance(const string& opencl_src) {
+  CldriveInstance instance;
+  instance.set_opencl_src(opencl_src);
+  auto dynamic_params = instance.add_dynamic_params();
+  dynamic_params->set_global_size_x(256);
+  dynamic_params->set_local_size_x(64);
+  return instance;
+}
+
+// A device compared with itself matches, since both runs see the same inputs.
+TEST(DiffEnvs, SameDeviceMatches) {
+  const auto device = labm8::gpu::clinfo::GetOpenClDevices().device(0);
+  CldriveSession session;
+  const auto diffs = DiffEnvs(
+      MakeInstance("kernel void A(global float* a, local int* b, const int n) {"
+                   "  a[get_global_id(0)] *= n;"
+                   "}"),
+      device, device, /*max_ulps=*/0, &session);
+
+  ASSERT_EQ(diffs.size(), 1);
+  EXPECT_EQ(diffs[0].kernel_name(), "A");
+  EXPECT_EQ(diffs[0].outcome(), CldriveKernelDiff::MATCH);
+  // Only the global buffer is compared.
+  ASSERT_EQ(diffs[0].arg_size(), 1);
+  EXPECT_EQ(diffs[0].arg(0).arg_index(), 0);
+  EXPECT_EQ(diffs[0].arg(0).name(), "a");
+  EXPECT_EQ(diffs[0].arg(0).num_elements(), 256);
+  EXPECT_EQ(diffs[0].arg(0).num_mismatches(), 0);
+  EXPECT_EQ(diffs[0].arg(0).first_mismatch_index(), -1);
+}
+
+TEST(DiffEnvs, ProgramCompilationFailure) {
+  const auto device = labm8::gpu::clinfo::GetOpenClDevices().device(0);
+  CldriveSession session;
+  const auto diffs = DiffEnvs(MakeInstance("invalid kernel"), device, device,
+                              /*max_ulps=*/0, &session);
+
+  ASSERT_EQ(diffs.size(), 1);
+  EXPECT_EQ(diffs[0].outcome(),
+            CldriveKernelDiff::PROGRAM_COMPILATION_FAILURE);
+}
+
+}  // anonymous namespace
+}  // namespace cldrive
+}  // namespace gpu
+
+TEST_MAIN();
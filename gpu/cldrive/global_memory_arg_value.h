@@ -15,6 +15,7 @@
 // along with cldrive.  If not, see <https://www.gnu.org/licenses/>.
 #pragma once
 
+#include "gpu/cldrive/device_buffer_pool.h"
 #include "gpu/cldrive/kernel_arg_value.h"
 #include "gpu/cldrive/opencl_type.h"
 
@@ -23,9 +24,53 @@
 #include "labm8/cpp/logging.h"
 #include "labm8/cpp/string.h"
 
+#include <cstdlib>
+#include <new>
+#include <vector>
+
 namespace gpu {
 namespace cldrive {
 
+// An allocator which aligns memory to a page. OpenCL implementations can
+// then use the memory in place for CL_MEM_USE_HOST_PTR buffers.
+template <typename T>
+class PageAlignedAllocator {
+ public:
+  using value_type = T;
+
+  static constexpr size_t kAlignment = 4096;
+
+  PageAlignedAllocator() = default;
+  template <typename U>
+  PageAlignedAllocator(const PageAlignedAllocator<U> &) {}
+
+  T *allocate(size_t n) {
+    void *ptr = nullptr;
+    if (posix_memalign(&ptr, kAlignment, n ? n * sizeof(T) : 1)) {
+      throw std::bad_alloc();
+    }
+    return static_cast<T *>(ptr);
+  }
+
+  void deallocate(T *ptr, size_t) { free(ptr); }
+};
+
+template <typename T, typename U>
+bool operator==(const PageAlignedAllocator<T> &,
+                const PageAlignedAllocator<U> &) {
+  return true;
+}
+
+template <typename T, typename U>
+bool operator!=(const PageAlignedAllocator<T> &,
+                const PageAlignedAllocator<U> &) {
+  return false;
+}
+
+// The host storage of array values.
+template <typename T>
+using HostVector = std::vector<T, PageAlignedAllocator<T>>;
+
 // An array argument.
 template <typename T>
 class GlobalMemoryArgValue : public KernelArgValue {
@@ -56,9 +101,11 @@ class GlobalMemoryArgValue : public KernelArgValue {
     return !(*this == rhs);
   }
 
-  std::vector<T> &vector() { return vector_; }
+  HostVector<T> &vector() { return vector_; }
+
+  const HostVector<T> &vector() const { return vector_; }
 
-  const std::vector<T> &vector() const { return vector_; }
+  virtual const void *HostData() const override { return vector_.data(); }
 
   virtual size_t Size() const override { return vector_.size(); }
 
@@ -91,7 +138,7 @@ class GlobalMemoryArgValue : public KernelArgValue {
   }
 
  protected:
-  std::vector<T> vector_;
+  HostVector<T> vector_;
 };
 
 // An array value with a device-side buffer.
@@ -102,33 +149,112 @@ class GlobalMemoryArgValueWithBuffer : public GlobalMemoryArgValue<T> {
   GlobalMemoryArgValueWithBuffer(const cl::Context &context, size_t size,
                                  Args &&... args)
       : GlobalMemoryArgValue<T>(size, args...),
+        pool_(nullptr),
         buffer_(context, /*flags=*/CL_MEM_READ_WRITE,
                 /*size=*/sizeof(T) * size) {}
 
+  // Construct a value whose buffer is acquired from, and returned to, a
+  // pool. If pool is nullptr, a new buffer is allocated.
+  //
+  // If zero_copy is true, the buffer is instead created with
+  // CL_MEM_USE_HOST_PTR over the host vector, and the pool is not used.
+  // Copies to and from the device become a map and unmap, which do not copy
+  // on devices that share memory with the host. Kernels then write to the
+  // host vector, so values do not survive a run unchanged.
+  template <typename... Args>
+  GlobalMemoryArgValueWithBuffer(DeviceBufferPool *pool, bool zero_copy,
+                                 const cl::Context &context, size_t size,
+                                 Args &&... args)
+      : GlobalMemoryArgValue<T>(size, args...),
+        pool_(zero_copy ? nullptr : pool),
+        zero_copy_(zero_copy),
+        buffer_(zero_copy
+                    ? cl::Buffer(context,
+                                 /*flags=*/CL_MEM_READ_WRITE |
+                                     CL_MEM_USE_HOST_PTR,
+                                 /*size=*/sizeof(T) * size,
+                                 /*host_ptr=*/this->vector_.data())
+                    : pool ? pool->Acquire(sizeof(T) * size)
+                           : cl::Buffer(context, /*flags=*/CL_MEM_READ_WRITE,
+                                        /*size=*/sizeof(T) * size)) {}
+
+  // A copy would return the same buffer to the pool twice.
+  GlobalMemoryArgValueWithBuffer(const GlobalMemoryArgValueWithBuffer &) =
+      delete;
+  GlobalMemoryArgValueWithBuffer &operator=(
+      const GlobalMemoryArgValueWithBuffer &) = delete;
+
+  virtual ~GlobalMemoryArgValueWithBuffer() {
+    if (pool_) {
+      pool_->Release(buffer_, sizeof(T) * this->Size());
+    }
+  }
+
   cl::Buffer &buffer() { return buffer_; }
 
+  bool zero_copy() const { return zero_copy_; }
+
   virtual void SetAsArg(cl::Kernel *kernel, size_t arg_index) override {
     kernel->setArg(arg_index, buffer());
   }
 
+  virtual const cl::Buffer *DeviceBuffer() const override { return &buffer_; }
+
+  // The buffer is released rather than returned to the pool. OpenCL keeps it
+  // until the commands which use it complete. A zero-copy buffer is backed by
+  // the host vector, which is leaked, as a command may still write to it.
+  virtual void Abandon() override {
+    pool_ = nullptr;
+    if (zero_copy_) {
+      new std::vector<T>(std::move(this->vector_));
+    }
+  }
+
   virtual void CopyToDevice(const cl::CommandQueue &queue,
                             ProfilingData *profiling) override {
     size_t buffer_size = this->vector().size() * sizeof(T);
-    util::CopyHostToDevice(queue, this->vector().data(), buffer(), buffer_size,
-                           profiling);
+    if (zero_copy_) {
+      util::MapHostToDevice(queue, buffer(), buffer_size, profiling);
+    } else {
+      util::CopyHostToDevice(queue, this->vector().data(), buffer(),
+                             buffer_size, profiling);
+    }
+    resident_ = true;
   }
 
+  virtual void EnqueueCopyToDevice(const cl::CommandQueue &queue,
+                                   ProfilingData *profiling) override {
+    size_t buffer_size = this->vector().size() * sizeof(T);
+    if (zero_copy_) {
+      util::EnqueueMapHostToDevice(queue, buffer(), buffer_size, profiling);
+    } else {
+      util::EnqueueCopyHostToDevice(queue, this->vector().data(), buffer(),
+                                    buffer_size, profiling);
+    }
+    resident_ = true;
+  }
+
+  virtual bool IsResident() const override { return resident_; }
+
   virtual std::unique_ptr<KernelArgValue> CopyFromDevice(
       const cl::CommandQueue &queue, ProfilingData *profiling) override {
     size_t buffer_size = this->vector().size() * sizeof(T);
     auto new_arg = std::make_unique<GlobalMemoryArgValue<T>>(this->Size());
-    util::CopyDeviceToHost(queue, buffer(), new_arg->vector().data(),
-                           buffer_size, profiling);
+    if (zero_copy_) {
+      util::MapDeviceToHost(queue, buffer(), new_arg->vector().data(),
+                            buffer_size, profiling);
+    } else {
+      util::CopyDeviceToHost(queue, buffer(), new_arg->vector().data(),
+                             buffer_size, profiling);
+    }
     return std::move(new_arg);
   }
 
  private:
+  DeviceBufferPool *pool_;
+  bool zero_copy_ = false;
   cl::Buffer buffer_;
+  bool resident_ = false;
 };
 
 }  // namespace cldrive
@@ -62,6 +62,13 @@ TEST(GlobalMemoryArgValue, FloatValuesAreNotEqual) {
   EXPECT_NE(a, &b);
 }
 
+TEST(GlobalMemoryArgValue, HostMemoryIsPageAligned) {
+  GlobalMemoryArgValue<labm8::int32> a(3, 0);
+  EXPECT_EQ(reinterpret_cast<uintptr_t>(a.vector().data()) %
+                PageAlignedAllocator<labm8::int32>::kAlignment,
+            0);
+}
+
 }  // anonymous namespace
 }  // namespace cldrive
 }  // namespace gpu
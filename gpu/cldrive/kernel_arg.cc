@@ -19,6 +19,7 @@
 #include "gpu/cldrive/opencl_type.h"
 #include "gpu/cldrive/opencl_type_util.h"
 #include "gpu/cldrive/opencl_util.h"
+#include "gpu/cldrive/random_fill.h"
 #include "gpu/cldrive/scalar_kernel_arg_value.h"
 
 #include "labm8/cpp/status_macros.h"
@@ -84,13 +85,15 @@ const string& KernelArg::name() const { return name_; }
 const string& KernelArg::type_name() const { return type_name_; }
 
 std::unique_ptr<KernelArgValue> KernelArg::TryToCreateRandomValue(
-    const cl::Context& context, const int& size) const {
-  return TryToCreateKernelArgValueRandom(context, size);
+    const cl::Context& context, const int& size, DeviceBufferPool* pool,
+    uint64_t seed, bool zero_copy) const {
+  return TryToCreateKernelArgValueRandom(context, size, pool, seed, zero_copy);
 }
 
 std::unique_ptr<KernelArgValue> KernelArg::TryToCreateConstValue(
-    const cl::Context& context, const int& size, const int& value) const {
-  return TryToCreateKernelArgValueConst(context, size, value);
+    const cl::Context& context, const int& size, const int& value,
+    DeviceBufferPool* pool, bool zero_copy) const {
+  return TryToCreateKernelArgValueConst(context, size, value, pool, zero_copy);
 }
 
 bool KernelArg::IsGlobal() const {
@@ -112,35 +115,37 @@ bool KernelArg::IsPrivate() const {
 bool KernelArg::IsPointer() const { return is_pointer_; }
 
 std::unique_ptr<KernelArgValue> KernelArg::TryToCreateKernelArgValueRandom(
-    const cl::Context& context, const int& size) const {
+    const cl::Context& context, const int& size, DeviceBufferPool* pool,
+    uint64_t seed, bool zero_copy) const {
   CHECK(type() != OpenClType::DEFAULT_UNKNOWN);
 
   if (IsPointer() && IsGlobal()) {
     return util::CreateGlobalMemoryArgValue(
         type(), context,
         /*size=*/size,
-        /*value=*/1, /*rand_values*/true);
+        /*value=*/1, /*rand_values*/true, pool, seed, zero_copy);
   } else if (IsPointer() && IsLocal()) {
     return util::CreateLocalMemoryArgValue(
         type(),
         /*size=*/size);
   } else if (!IsPointer()) {
-    return util::CreateScalarArgValue(type(),
-                                      /*value=*/rand());
+    return util::CreateScalarArgValue(
+        type(), /*value=*/util::CounterRandom(seed, /*counter=*/0));
   } else {
     return std::unique_ptr<KernelArgValue>(nullptr);
   }
 }
 
 std::unique_ptr<KernelArgValue> KernelArg::TryToCreateKernelArgValueConst(
-    const cl::Context& context, const int& size, const int& value) const {
+    const cl::Context& context, const int& size, const int& value,
+    DeviceBufferPool* pool, bool zero_copy) const {
   CHECK(type() != OpenClType::DEFAULT_UNKNOWN);
 
   if (IsPointer() && IsGlobal()) {
     return util::CreateGlobalMemoryArgValue(
         type(), context,
         /*size=*/size,
-        /*value=*/value, /*rand_values*/false);
+        /*value=*/value, /*rand_values*/false, pool, /*seed=*/0, zero_copy);
   } else if (IsPointer() && IsLocal()) {
     return util::CreateLocalMemoryArgValue(
         type(),
@@ -15,6 +15,7 @@
 // along with cldrive.  If not, see <https://www.gnu.org/licenses/>.
 #pragma once
 
+#include "gpu/cldrive/device_buffer_pool.h"
 #include "gpu/cldrive/kernel_arg_value.h"
 #include "gpu/cldrive/opencl_type.h"
 #include "gpu/cldrive/proto/cldrive.pb.h"
@@ -33,14 +34,20 @@ class KernelArg {
   labm8::Status Init(cl::Kernel *kernel, size_t arg_index);
 
   // Create a random value for this argument. If the argument is not supported,
-  // returns nullptr.
+  // returns nullptr. Device buffers are acquired from pool, if provided, or
+  // use host memory if zero_copy is true. Values are a deterministic function
+  // of seed.
   std::unique_ptr<KernelArgValue> TryToCreateRandomValue(
-      const cl::Context &context, const int& size) const;
+      const cl::Context &context, const int& size,
+      DeviceBufferPool *pool = nullptr, uint64_t seed = 0,
+      bool zero_copy = false) const;
 
   // Create a "ones" value for this argument. If the argument is not supported,
-  // returns nullptr.
+  // returns nullptr. Device buffers are acquired from pool, if provided, or
+  // use host memory if zero_copy is true.
   std::unique_ptr<KernelArgValue> TryToCreateConstValue(
-      const cl::Context &context, const int& size, const int& value) const;
+      const cl::Context &context, const int& size, const int& value,
+      DeviceBufferPool *pool = nullptr, bool zero_copy = false) const;
 
   // Address qualifier accessors.
 
@@ -60,9 +67,11 @@ class KernelArg {
 
  private:
   std::unique_ptr<KernelArgValue> TryToCreateKernelArgValueRandom(
-      const cl::Context &context, const int& size) const;
+      const cl::Context &context, const int& size,
+      DeviceBufferPool *pool, uint64_t seed, bool zero_copy) const;
   std::unique_ptr<KernelArgValue> TryToCreateKernelArgValueConst(
-      const cl::Context &context, const int& size, const int& value) const;
+      const cl::Context &context, const int& size, const int& value,
+      DeviceBufferPool *pool, bool zero_copy) const;
 
   OpenClType type_;
   cl_kernel_arg_address_qualifier address_;
@@ -16,6 +16,7 @@
 #include "gpu/cldrive/kernel_arg_set.h"
 
 #include "gpu/cldrive/opencl_util.h"
+#include "gpu/cldrive/random_fill.h"
 
 #include "labm8/cpp/logging.h"
 #include "labm8/cpp/status_macros.h"
@@ -23,7 +24,12 @@
 namespace gpu {
 namespace cldrive {
 
-KernelArgSet::KernelArgSet(cl::Kernel* kernel) : kernel_(kernel) {}
+KernelArgSet::KernelArgSet(cl::Kernel* kernel, DeviceBufferPool* buffer_pool,
+                           uint64_t seed, bool zero_copy)
+    : kernel_(kernel),
+      buffer_pool_(buffer_pool),
+      seed_(seed),
+      zero_copy_(zero_copy) {}
 
 CldriveKernelInstance::KernelInstanceOutcome KernelArgSet::Init() {
   size_t num_args = kernel_->getInfo<CL_KERNEL_NUM_ARGS>();
@@ -60,39 +66,119 @@ CldriveKernelInstance::KernelInstanceOutcome KernelArgSet::Init() {
 labm8::Status KernelArgSet::SetRandom(const cl::Context& context,
                                       const DynamicParams& dynamic_params,
                                       KernelArgValuesSet* values) {
-  values->Clear();
-  for (auto& arg : args_) {
-    auto value = (arg.IsPointer()) ? arg.TryToCreateRandomValue(context, /*size=*/dynamic_params.global_size_x())
-                                   : arg.TryToCreateConstValue(context, /*size=*/1, /*value=*/dynamic_params.global_size_x());
-    if (value) {
-      values->AddKernelArgValue(std::move(value));
-    } else {
+  // Buffers have an element per work item, and scalars the global size value
+  // of the first dimension. For a 2D or 3D launch config, that is the row
+  // width which kernels commonly take as an argument.
+  std::vector<long long> args_values;
+  for (const auto& arg : args_) {
+    args_values.push_back(arg.IsPointer()
+                              ? util::GetNumWorkItems(dynamic_params)
+                              : dynamic_params.global_size_x());
+  }
+  return SetRandom(context, args_values, values);
+}
+
+labm8::Status KernelArgSet::SetRandom(const cl::Context& context,
+                                      const std::vector<long long>& args_values,
+                                      KernelArgValuesSet* values) {
+  if (args_values.size() != args_.size()) {
+    values->Clear();
+    return labm8::Status(labm8::error::Code::INVALID_ARGUMENT,
+                         "Expected {} argument values, got {}", args_.size(),
+                         args_values.size());
+  }
+
+  // If the values were set by a previous call, buffers which are already the
+  // requested size are kept rather than re-allocated and re-filled.
+  const bool reuse = values->values().size() == args_.size();
+  if (!reuse) {
+    values->Clear();
+  }
+
+  for (size_t i = 0; i < args_.size(); ++i) {
+    if (reuse && args_[i].IsPointer() &&
+        values->values()[i]->Size() == static_cast<size_t>(args_values[i])) {
+      continue;
+    }
+    if (reuse) {
+      // Free the old value first so that its buffer may be reused.
+      values->values()[i].reset();
+    }
+
+    auto value = (args_[i].IsPointer()) ? args_[i].TryToCreateRandomValue(context, /*size=*/args_values[i], buffer_pool_, util::StreamSeed(seed_, i), zero_copy_)
+                                        : args_[i].TryToCreateConstValue(context, /*size=*/1, /*value=*/args_values[i]);
+    if (!value) {
       // TryToCreateRandomValue() returns nullptr if the argument is not
       // supported.
+      values->Clear();
       return labm8::Status(labm8::error::Code::INVALID_ARGUMENT,
                            "Unsupported argument type.");
     }
+    if (reuse) {
+      values->values()[i] = std::move(value);
+    } else {
+      values->AddKernelArgValue(std::move(value));
+    }
   }
   return labm8::Status::OK;
 }
 
-labm8::Status KernelArgSet::SetRandom(const cl::Context& context,
-                                      const std::vector<long long>& args_values,
-                                      KernelArgValuesSet* values) {
-  values->Clear();
-  int i = 0;
-  for (auto& arg : args_) {
-    auto value = (arg.IsPointer()) ? arg.TryToCreateRandomValue(context, /*size=*/args_values[i])
-                                   : arg.TryToCreateConstValue(context, /*size=*/1, /*value=*/args_values[i]);
-    if (value) {
-      values->AddKernelArgValue(std::move(value));
-    } else {
-      // TryToCreateRandomValue() returns nullptr if the argument is not
-      // supported.
+labm8::Status KernelArgSet::SetAlternateRandom(
+    const cl::Context& context, const KernelArgValuesSet& values,
+    KernelArgValuesSet* alternates) {
+  alternates->Clear();
+  if (values.values().size() != args_.size()) {
+    return labm8::Status(labm8::error::Code::INVALID_ARGUMENT,
+                         "Expected {} argument values, got {}", args_.size(),
+                         values.values().size());
+  }
+
+  for (size_t i = 0; i < args_.size(); ++i) {
+    if (!args_[i].IsPointer() || !args_[i].IsGlobal()) {
+      alternates->AddKernelArgValue(nullptr);
+      continue;
+    }
+    // The streams after those of the arguments are unused by SetRandom().
+    auto value = args_[i].TryToCreateRandomValue(
+        context, /*size=*/values.values()[i]->Size(), buffer_pool_,
+        util::StreamSeed(seed_, args_.size() + i), zero_copy_);
+    if (!value) {
+      alternates->Clear();
+      return labm8::Status(labm8::error::Code::INVALID_ARGUMENT,
+                           "Unsupported argument type.");
+    }
+    alternates->AddKernelArgValue(std::move(value));
+  }
+  return labm8::Status::OK;
+}
+
+labm8::Status KernelArgSet::ReplaceBuffers(const cl::Context& context,
+                                          KernelArgValuesSet* values) {
+  if (values->values().size() != args_.size()) {
+    return labm8::Status(labm8::error::Code::INVALID_ARGUMENT,
+                         "Expected {} argument values, got {}", args_.size(),
+                         values->values().size());
+  }
+
+  for (size_t i = 0; i < args_.size(); ++i) {
+    auto& old_value = values->values()[i];
+    if (!args_[i].IsPointer() || !old_value || !old_value->DeviceBuffer()) {
+      continue;
+    }
+    // The old value is abandoned before the new one is created, so that the
+    // pool cannot hand its buffer out again.
+    const size_t size = old_value->Size();
+    old_value->Abandon();
+    old_value.reset();
+    // The same stream of the seed as SetRandom(), so the values are equal.
+    auto value = args_[i].TryToCreateRandomValue(
+        context, size, buffer_pool_, util::StreamSeed(seed_, i), zero_copy_);
+    if (!value) {
+      values->Abandon();
       return labm8::Status(labm8::error::Code::INVALID_ARGUMENT,
                            "Unsupported argument type.");
     }
-    ++i;
+    old_value = std::move(value);
   }
   return labm8::Status::OK;
 }
@@ -102,7 +188,7 @@ labm8::Status KernelArgSet::SetOnes(const cl::Context& context,
                                     KernelArgValuesSet* values) {
   values->Clear();
   for (auto& arg : args_) {
-    auto value = (arg.IsPointer()) ? arg.TryToCreateConstValue(context, /*size=*/dynamic_params.global_size_x(),/*value=*/ 1)
+    auto value = (arg.IsPointer()) ? arg.TryToCreateConstValue(context, /*size=*/util::GetNumWorkItems(dynamic_params),/*value=*/ 1, buffer_pool_, zero_copy_)
                                    : arg.TryToCreateConstValue(context, /*size=*/1, /*value=*/1);
     if (value) {
       values->AddKernelArgValue(std::move(value));
@@ -15,6 +15,7 @@
 // along with cldrive.  If not, see <https://www.gnu.org/licenses/>.
 #pragma once
 
+#include "gpu/cldrive/device_buffer_pool.h"
 #include "gpu/cldrive/kernel_arg_set.h"
 #include "gpu/cldrive/kernel_arg.h"
 #include "gpu/cldrive/kernel_arg_values_set.h"
@@ -27,7 +28,12 @@ namespace cldrive {
 
 class KernelArgSet {
  public:
-  KernelArgSet(cl::Kernel* kernel);
+  // If buffer_pool is not nullptr, device buffers for argument values are
+  // acquired from it. Random values are generated from seed, with an
+  // independent stream for each argument. If zero_copy is true, device
+  // buffers use the host memory of the argument values.
+  KernelArgSet(cl::Kernel* kernel, DeviceBufferPool* buffer_pool = nullptr,
+               uint64_t seed = 0, bool zero_copy = false);
 
   CldriveKernelInstance::KernelInstanceOutcome LogErrorOutcome(
       const CldriveKernelInstance::KernelInstanceOutcome& outcome);
@@ -37,14 +43,32 @@ class KernelArgSet {
   labm8::Status SetRandom(const cl::Context& context,
                           const DynamicParams& dynamic_params,
                           KernelArgValuesSet* values);
+  // Set argument values from a list of one value per argument. See
+  // ArgsValues in cldrive.proto. If values were set by a previous call,
+  // buffers of the requested size are reused.
   labm8::Status SetRandom(const cl::Context& context,
-                                      const std::vector<long long>& args_values,
-                                      KernelArgValuesSet* values);
+                          const std::vector<long long>& args_values,
+                          KernelArgValuesSet* values);
+
+  // Set alternate values of the global buffer arguments of values: new random
+  // values of the same sizes, from a different stream of the seed. Other
+  // arguments are set to nullptr.
+  labm8::Status SetAlternateRandom(const cl::Context& context,
+                                   const KernelArgValuesSet& values,
+                                   KernelArgValuesSet* alternates);
+
+  // Replace the buffers of the pointer arguments of values set by
+  // SetRandom(), abandoning the old ones, e.g. after a run which may still be
+  // using them has exceeded its time budget. The new buffers hold the same
+  // values, and are not resident on the device.
+  labm8::Status ReplaceBuffers(const cl::Context& context,
+                               KernelArgValuesSet* values);
 
   labm8::Status SetOnes(const cl::Context& context,
                         const DynamicParams& dynamic_params,
                         KernelArgValuesSet* values);
   const std::vector<KernelArg>& args() const;
+  bool zero_copy() const { return zero_copy_; }
   // Return a JSON string representation of the kernel arguments.
   string ToStringWithValue(const KernelArgValuesSet& values) const;
   string ToString() const;
@@ -52,6 +76,9 @@ class KernelArgSet {
 
  private:
   cl::Kernel* kernel_;
+  DeviceBufferPool* buffer_pool_;
+  uint64_t seed_;
+  bool zero_copy_;
   std::vector<KernelArg> args_;
 };
 
@@ -15,6 +15,8 @@
 // along with cldrive.  If not, see <https://www.gnu.org/licenses/>.
 #include "gpu/cldrive/kernel_arg_set.h"
 
+#include "gpu/cldrive/testutil.h"
+
 #include "labm8/cpp/test.h"
 
 namespace gpu {
@@ -23,6 +25,102 @@ namespace {
 
 TEST(TODO, TODO) { EXPECT_EQ(1, 1); }
 
+TEST(KernelArgSet, SetRandomWithArgsValues) {
+  cl::Kernel kernel =
+      test::CreateClKernel("kernel void A(global int* a, const int b) {}");
+  cl::Context context = kernel.getInfo<CL_KERNEL_CONTEXT>();
+  KernelArgSet args_set(&kernel);
+  ASSERT_EQ(args_set.Init(), CldriveKernelInstance::PASS);
+
+  KernelArgValuesSet values;
+  ASSERT_TRUE(
+      args_set.SetRandom(context, std::vector<long long>{16, 5}, &values).ok());
+  ASSERT_EQ(values.values().size(), 2);
+  EXPECT_EQ(values.values()[0]->Size(), 16);
+  EXPECT_EQ(values.values()[1]->Size(), 1);
+}
+
+TEST(KernelArgSet, SetRandomWithWrongNumberOfArgsValues) {
+  cl::Kernel kernel =
+      test::CreateClKernel("kernel void A(global int* a, const int b) {}");
+  cl::Context context = kernel.getInfo<CL_KERNEL_CONTEXT>();
+  KernelArgSet args_set(&kernel);
+  ASSERT_EQ(args_set.Init(), CldriveKernelInstance::PASS);
+
+  KernelArgValuesSet values;
+  EXPECT_FALSE(
+      args_set.SetRandom(context, std::vector<long long>{16}, &values).ok());
+}
+
+TEST(KernelArgSet, SetRandomReusesBuffersOfSameSize) {
+  cl::Kernel kernel =
+      test::CreateClKernel("kernel void A(global int* a, const int b) {}");
+  cl::Context context = kernel.getInfo<CL_KERNEL_CONTEXT>();
+  KernelArgSet args_set(&kernel);
+  ASSERT_EQ(args_set.Init(), CldriveKernelInstance::PASS);
+
+  KernelArgValuesSet values;
+  ASSERT_TRUE(
+      args_set.SetRandom(context, std::vector<long long>{16, 5}, &values).ok());
+  const KernelArgValue* buffer = values.values()[0].get();
+
+  ASSERT_TRUE(
+      args_set.SetRandom(context, std::vector<long long>{16, 7}, &values).ok());
+  EXPECT_EQ(values.values()[0].get(), buffer);
+
+  ASSERT_TRUE(
+      args_set.SetRandom(context, std::vector<long long>{32, 7}, &values).ok());
+  EXPECT_EQ(values.values()[0]->Size(), 32);
+}
+
+TEST(KernelArgSet, SetRandomIsDeterministicForSeed) {
+  cl::Kernel kernel = test::CreateClKernel(
+      "kernel void A(global int* a, global int* b, const int c) {}");
+  cl::Context context = kernel.getInfo<CL_KERNEL_CONTEXT>();
+  KernelArgSet args_set_a(&kernel, /*buffer_pool=*/nullptr, /*seed=*/42);
+  KernelArgSet args_set_b(&kernel, /*buffer_pool=*/nullptr, /*seed=*/42);
+  KernelArgSet args_set_c(&kernel, /*buffer_pool=*/nullptr, /*seed=*/43);
+  ASSERT_EQ(args_set_a.Init(), CldriveKernelInstance::PASS);
+  ASSERT_EQ(args_set_b.Init(), CldriveKernelInstance::PASS);
+  ASSERT_EQ(args_set_c.Init(), CldriveKernelInstance::PASS);
+
+  KernelArgValuesSet a, b, c;
+  const std::vector<long long> args_values{1000, 1000, 5};
+  ASSERT_TRUE(args_set_a.SetRandom(context, args_values, &a).ok());
+  ASSERT_TRUE(args_set_b.SetRandom(context, args_values, &b).ok());
+  ASSERT_TRUE(args_set_c.SetRandom(context, args_values, &c).ok());
+
+  EXPECT_EQ(a, b);
+  EXPECT_NE(a, c);
+  // Each argument has its own stream of values.
+  EXPECT_TRUE(*a.values()[0] != a.values()[1].get());
+}
+
+TEST(KernelArgSet, ReplaceBuffersGivesFreshBuffersWithTheSameValues) {
+  cl::Kernel kernel =
+      test::CreateClKernel("kernel void A(global int* a, const int b) {}");
+  cl::Context context = kernel.getInfo<CL_KERNEL_CONTEXT>();
+  DeviceBufferPool pool(context);
+  KernelArgSet args_set(&kernel, &pool, /*seed=*/42);
+  KernelArgSet expected_args_set(&kernel, /*buffer_pool=*/nullptr, /*seed=*/42);
+  ASSERT_EQ(args_set.Init(), CldriveKernelInstance::PASS);
+  ASSERT_EQ(expected_args_set.Init(), CldriveKernelInstance::PASS);
+
+  KernelArgValuesSet values, expected;
+  const std::vector<long long> args_values{16, 5};
+  ASSERT_TRUE(args_set.SetRandom(context, args_values, &values).ok());
+  ASSERT_TRUE(
+      expected_args_set.SetRandom(context, args_values, &expected).ok());
+  const cl_mem buffer = (*values.values()[0]->DeviceBuffer())();
+
+  ASSERT_TRUE(args_set.ReplaceBuffers(context, &values).ok());
+  EXPECT_NE((*values.values()[0]->DeviceBuffer())(), buffer);
+  EXPECT_EQ(values, expected);
+  // The old buffer is not returned to the pool for reuse.
+  EXPECT_EQ(pool.idle_bytes(), 0);
+  EXPECT_EQ(pool.allocations(), 2);
+}
+
 }  // anonymous namespace
 }  // namespace cldrive
 }  // namespace gpu
@@ -37,11 +37,36 @@ class KernelArgValue {
   virtual void CopyToDevice(const cl::CommandQueue &queue,
                             ProfilingData *profiling) = 0;
 
+  // Enqueue the copy to device without waiting for it to complete. The
+  // default implementation is blocking.
+  virtual void EnqueueCopyToDevice(const cl::CommandQueue &queue,
+                                   ProfilingData *profiling) {
+    CopyToDevice(queue, profiling);
+  }
+
+  // Return true if the device holds a copy of the value, i.e. it has been
+  // copied to the device since it was created. Values with no device-side
+  // storage are always resident.
+  virtual bool IsResident() const { return true; }
+
   virtual std::unique_ptr<KernelArgValue> CopyFromDevice(
       const cl::CommandQueue &queue, ProfilingData *profiling) = 0;
 
   virtual void SetAsArg(cl::Kernel *kernel, size_t arg_index) = 0;
 
+  // Return the device-side buffer of the value, or nullptr if it has none.
+  virtual const cl::Buffer *DeviceBuffer() const { return nullptr; }
+
+  // Return the host-side storage of the value, of SizeInBytes() bytes, or
+  // nullptr if it has none.
+  virtual const void *HostData() const { return nullptr; }
+
+  // Give up the storage of the value, which may still be in use by a command
+  // that will never be waited for, e.g. a run which exceeded its time budget.
+  // The storage is then neither returned to a pool nor reused. The value must
+  // not be used again, other than to destroy it.
+  virtual void Abandon() {}
+
   virtual bool operator==(const KernelArgValue *const rhs) const = 0;
 
   virtual bool operator!=(const KernelArgValue *const rhs) const = 0;
@@ -38,9 +38,31 @@ bool KernelArgValuesSet::operator!=(const KernelArgValuesSet &rhs) const {
 
 void KernelArgValuesSet::CopyToDevice(const cl::CommandQueue &queue,
                                       ProfilingData *profiling) const {
-  for (auto &value : values()) {
-    value->CopyToDevice(queue, profiling);
+  for (size_t i = 0; i < values().size(); ++i) {
+    profiling->current_arg = i;
+    values()[i]->CopyToDevice(queue, profiling);
+  }
+  profiling->current_arg = -1;
+}
+
+void KernelArgValuesSet::CopyNonResidentToDevice(
+    const cl::CommandQueue &queue, ProfilingData *profiling) const {
+  for (size_t i = 0; i < values().size(); ++i) {
+    if (!values()[i]->IsResident()) {
+      profiling->current_arg = i;
+      values()[i]->CopyToDevice(queue, profiling);
+    }
   }
+  profiling->current_arg = -1;
+}
+
+void KernelArgValuesSet::EnqueueCopyToDevice(const cl::CommandQueue &queue,
+                                             ProfilingData *profiling) const {
+  for (size_t i = 0; i < values().size(); ++i) {
+    profiling->current_arg = i;
+    values()[i]->EnqueueCopyToDevice(queue, profiling);
+  }
+  profiling->current_arg = -1;
 }
 
 void KernelArgValuesSet::CopyFromDeviceToNewValueSet(
@@ -48,9 +70,12 @@ void KernelArgValuesSet::CopyFromDeviceToNewValueSet(
     ProfilingData *profiling) const {
   // TODO(cec): Refactor so this isn't causing mallocs() for every run.
   new_values->Clear();
-  for (auto &value : values()) {
-    new_values->AddKernelArgValue(value->CopyFromDevice(queue, profiling));
+  for (size_t i = 0; i < values().size(); ++i) {
+    profiling->current_arg = i;
+    new_values->AddKernelArgValue(
+        values()[i]->CopyFromDevice(queue, profiling));
   }
+  profiling->current_arg = -1;
 }
 
 void KernelArgValuesSet::AddKernelArgValue(
@@ -66,6 +91,15 @@ void KernelArgValuesSet::SetAsArgs(cl::Kernel *kernel) {
 
 void KernelArgValuesSet::Clear() { values().clear(); }
 
+void KernelArgValuesSet::Abandon() {
+  for (auto& value : values()) {
+    if (value) {
+      value->Abandon();
+    }
+  }
+  Clear();
+}
+
 string KernelArgValuesSet::ToString() const {
   string s = "";
   for (size_t i = 0; i < values().size(); ++i) {
@@ -28,9 +28,18 @@ class KernelArgValuesSet {
 
   bool operator!=(const KernelArgValuesSet &rhs) const;
 
+  // Transfers are recorded in profiling->args under the index of the value.
   void CopyToDevice(const cl::CommandQueue &queue,
                     ProfilingData *profiling) const;
 
+  // Copy only the values which are not already resident on the device.
+  void CopyNonResidentToDevice(const cl::CommandQueue &queue,
+                               ProfilingData *profiling) const;
+
+  // Enqueue the copies to device without waiting for them to complete.
+  void EnqueueCopyToDevice(const cl::CommandQueue &queue,
+                           ProfilingData *profiling) const;
+
   void CopyFromDeviceToNewValueSet(const cl::CommandQueue &queue,
                                    KernelArgValuesSet *new_values,
                                    ProfilingData *profiling) const;
@@ -41,6 +50,10 @@ class KernelArgValuesSet {
 
   void Clear();
 
+  // Abandon the storage of every value, see KernelArgValue::Abandon(), and
+  // clear the set.
+  void Abandon();
+
   string ToString() const;
 
   std::vector<std::unique_ptr<KernelArgValue>> &values();
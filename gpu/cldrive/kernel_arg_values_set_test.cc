@@ -15,6 +15,8 @@
 // along with cldrive.  If not, see <https://www.gnu.org/licenses/>.
 #include "gpu/cldrive/kernel_arg_values_set.h"
 
+#include "gpu/cldrive/global_memory_arg_value.h"
+
 #include "labm8/cpp/test.h"
 
 namespace gpu {
@@ -23,6 +25,54 @@ namespace {
 
 TEST(TODO, TODO) { EXPECT_EQ(1, 1); }
 
+TEST(KernelArgValuesSet, CopyNonResidentToDeviceCopiesOnce) {
+  cl::Context context = cl::Context::getDefault();
+  cl::CommandQueue queue(context, context.getInfo<CL_CONTEXT_DEVICES>()[0],
+                         CL_QUEUE_PROFILING_ENABLE);
+
+  KernelArgValuesSet values;
+  values.AddKernelArgValue(
+      std::make_unique<GlobalMemoryArgValueWithBuffer<cl_int>>(context, 16,
+                                                               0));
+  EXPECT_FALSE(values.values()[0]->IsResident());
+
+  ProfilingData first;
+  values.CopyNonResidentToDevice(queue, &first);
+  EXPECT_EQ(first.transferred_bytes, 16 * sizeof(cl_int));
+  EXPECT_TRUE(values.values()[0]->IsResident());
+
+  ProfilingData second;
+  values.CopyNonResidentToDevice(queue, &second);
+  EXPECT_EQ(second.transferred_bytes, 0);
+}
+
+TEST(KernelArgValuesSet, ZeroCopyValuesRoundTrip) {
+  cl::Context context = cl::Context::getDefault();
+  cl::CommandQueue queue(context, context.getInfo<CL_CONTEXT_DEVICES>()[0],
+                         CL_QUEUE_PROFILING_ENABLE);
+
+  KernelArgValuesSet values;
+  values.AddKernelArgValue(
+      std::make_unique<GlobalMemoryArgValueWithBuffer<cl_int>>(
+          /*pool=*/nullptr, /*zero_copy=*/true, context, 1024, 7));
+
+  ProfilingData profiling;
+  values.CopyToDevice(queue, &profiling);
+  // Maps do not copy.
+  EXPECT_EQ(profiling.transferred_bytes, 0);
+
+  KernelArgValuesSet outputs;
+  values.CopyFromDeviceToNewValueSet(queue, &outputs, &profiling);
+  ASSERT_EQ(outputs.values().size(), 1);
+  EXPECT_TRUE(*outputs.values()[0] == values.values()[0].get());
+
+  // Each direction is recorded against the argument.
+  ASSERT_EQ(profiling.args.size(), 1);
+  EXPECT_EQ(profiling.args[0].host_to_device_bytes, 0);
+  EXPECT_EQ(profiling.args[0].device_to_host_bytes, 0);
+  EXPECT_EQ(profiling.current_arg, -1);
+}
+
 }  // anonymous namespace
 }  // namespace cldrive
 }  // namespace gpu
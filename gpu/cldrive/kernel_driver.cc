@@ -16,19 +16,86 @@
 #include "gpu/cldrive/kernel_driver.h"
 
 #include "gpu/cldrive/logger.h"
+#include "gpu/cldrive/lsize_tuner.h"
 #include "gpu/cldrive/opencl_util.h"
+#include "gpu/cldrive/run_statistics.h"
+#include "gpu/cldrive/sweep.h"
 #include "gpu/clinfo/libclinfo.h"
 
 #include "labm8/cpp/logging.h"
 #include "labm8/cpp/status_macros.h"
 
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
+
+#include <algorithm>
+#include <chrono>
+#include <thread>
+
 namespace gpu {
 namespace cldrive {
 
+namespace {
+
+// Return true if argument values should share host memory with the device.
+bool UseZeroCopyBuffers(const cl::Device& device,
+                        const CldriveInstance& instance) {
+  // Output checks need inputs which survive a run.
+  if (instance.check_outputs()) {
+    return false;
+  }
+  switch (instance.buffer_strategy()) {
+    case CldriveInstance::COPY:
+      return false;
+    case CldriveInstance::ZERO_COPY:
+      return true;
+    default:
+      return device.getInfo<CL_DEVICE_HOST_UNIFIED_MEMORY>();
+  }
+}
+
+// Wait for an event of a command on queue to complete. If there is a watchdog,
+// the status of the event is polled rather than blocking on it, and
+// WatchdogTimeout is thrown if a time budget runs out first.
+void WaitForEvent(const cl::CommandQueue& queue, const cl::Event& event,
+                  const Watchdog* watchdog) {
+  if (watchdog) {
+    // A command which has not been flushed need never leave the queue, so the
+    // status of its event would never change.
+    queue.flush();
+    auto poll_interval = std::chrono::microseconds(10);
+    while (event.getInfo<CL_EVENT_COMMAND_EXECUTION_STATUS>() > CL_COMPLETE) {
+      watchdog->CheckOrThrow();
+      std::this_thread::sleep_for(poll_interval);
+      poll_interval =
+          std::min(2 * poll_interval, std::chrono::microseconds(1000));
+    }
+  }
+  // Raises an OpenCL error if the command failed.
+  event.wait();
+}
+
+// Append the digest of the device buffer of each value which has one. Null
+// values are skipped.
+void HashDeviceBuffers(DeviceBufferHasher* hasher,
+                       const cl::CommandQueue& queue,
+                       const KernelArgValuesSet& values,
+                       std::vector<uint64_t>* digests) {
+  for (const auto& value : values.values()) {
+    const cl::Buffer* buffer = value ? value->DeviceBuffer() : nullptr;
+    if (buffer) {
+      digests->push_back(hasher->Hash(queue, *buffer, value->SizeInBytes()));
+    }
+  }
+}
+
+}  // anonymous namespace
+
 KernelDriver::KernelDriver(const cl::Context& context,
                            const cl::CommandQueue& queue,
                            const cl::Kernel& kernel, CldriveInstance* instance,
-                           int instance_num)
+                           int instance_num, DeviceBufferPool* buffer_pool,
+                           Watchdog* watchdog, DeviceBufferHasher* hasher)
     : context_(context),
       queue_(queue),
       device_(context.getInfo<CL_CONTEXT_DEVICES>()[0]),
@@ -37,7 +104,10 @@ KernelDriver::KernelDriver(const cl::Context& context,
       instance_num_(instance_num),
       kernel_instance_(instance->add_kernel()),
       name_(util::GetOpenClKernelName(kernel)),
-      args_set_(&kernel_) {}
+      args_set_(&kernel_, buffer_pool, instance->seed(),
+                UseZeroCopyBuffers(device_, *instance)),
+      watchdog_(watchdog),
+      hasher_(hasher) {}
 
 void KernelDriver::RunOrDie(Logger& logger) {
   kernel_instance_->set_name(name_);
@@ -56,51 +126,73 @@ void KernelDriver::RunOrDie(Logger& logger) {
     return;
   }
   
-  for (int i = 0; i < instance_.dynamic_params_size(); ++i) {
-    auto args_values_proto = instance_.args_values();
-    labm8::Status args_status;
-    if (args_values_proto.begin() != args_values_proto.end()) {
-      std::vector<long long> args_values(args_values_proto.begin(), args_values_proto.end());
-      args_status = args_set_.SetRandom(context_, args_values, &inputs);
-    }
-    else {
-      args_status = args_set_.SetRandom(context_, instance_.dynamic_params(i), &inputs);
-    }
-    if (!args_status.ok()) {
-      LOG(WARNING) << "Unsupported params for kernel: '" << name_ << "'";
-      logger.RecordLog(&instance_, kernel_instance_, /*run=*/nullptr, 
-                      /*log=*/nullptr);
-      return;
+  // Run every combination of launch config and argument values from the
+  // kernel's sweep, falling back to those of the instance. The kernel is
+  // compiled once, and buffers are reused between runs where sizes allow.
+  const CldriveKernelSweep* sweep = FindKernelSweep(instance_, name_);
+  const auto& all_dynamic_params =
+      (sweep && sweep->dynamic_params_size()) ? sweep->dynamic_params()
+                                              : instance_.dynamic_params();
+
+  std::vector<std::vector<long long>> args_values_sets;
+  if (sweep) {
+    for (const auto& args_values : sweep->args_values()) {
+      args_values_sets.emplace_back(args_values.value().begin(),
+                                    args_values.value().end());
     }
+  } else if (instance_.args_values_size()) {
+    args_values_sets.emplace_back(instance_.args_values().begin(),
+                                  instance_.args_values().end());
+  }
 
-    auto run = RunDynamicParams(instance_.dynamic_params(i), logger, inputs);
-    
-    if (run.ok()) {
-      *kernel_instance_->add_run() = run.ValueOrDie();
-    } else {
-      kernel_instance_->clear_run();
-      kernel_instance_->set_outcome(
-          CldriveKernelInstance::UNSUPPORTED_ARGUMENTS);
+  int sweep_index = 0;
+  for (const auto& dynamic_params : all_dynamic_params) {
+    if (args_values_sets.empty()) {
+      if (!SetArgsAndRun(dynamic_params, /*args_values=*/nullptr,
+                         sweep_index++, logger, &inputs)) {
+        return;
+      }
+    }
+    for (const auto& args_values : args_values_sets) {
+      if (!SetArgsAndRun(dynamic_params, &args_values, sweep_index++, logger,
+                         &inputs)) {
+        return;
+      }
     }
   }
 }
 
-labm8::StatusOr<CldriveKernelRun> KernelDriver::RunDynamicParams(
-    const DynamicParams& dynamic_params, Logger& logger, KernelArgValuesSet& inputs) {
-  CldriveKernelRun run;
-
-  try {
-    RunDynamicParams(dynamic_params, logger, &run, inputs);
-  } catch (cl::Error error) {
-    LOG(WARNING) << "Error code " << error.err() << " ("
-                 << labm8::gpu::clinfo::OpenClErrorString(error.err()) << ") "
-                 << "raised by " << error.what() << "() while driving kernel: '"
-                 << name_ << "'";
-    run.set_outcome(CldriveKernelRun::CL_ERROR);
-    logger.RecordLog(&instance_, kernel_instance_, &run, /*log=*/nullptr);
+bool KernelDriver::SetArgsAndRun(const DynamicParams& dynamic_params,
+                                 const std::vector<long long>* args_values,
+                                 int sweep_index, Logger& logger,
+                                 KernelArgValuesSet* inputs) {
+  labm8::Status args_status =
+      args_values ? args_set_.SetRandom(context_, *args_values, inputs)
+                  : args_set_.SetRandom(context_, dynamic_params, inputs);
+  if (!args_status.ok()) {
+    LOG(WARNING) << "Unsupported params for kernel: '" << name_ << "'";
+    logger.RecordLog(&instance_, kernel_instance_, /*run=*/nullptr,
+                     /*log=*/nullptr);
+    return false;
   }
 
-  return run;
+  if (instance_.tune_lsize()) {
+    TuneLocalSize(dynamic_params, sweep_index, logger, *inputs);
+  } else if (instance_.stream_runs()) {
+    // The run is not kept in the kernel instance once it has been logged, so
+    // memory use does not grow with the number of runs.
+    CldriveKernelRun run;
+    run.set_sweep_index(sweep_index);
+    RunDynamicParams(dynamic_params, logger, *inputs, &run);
+    logger.RecordKernelRun(&instance_, kernel_instance_, &run);
+  } else {
+    // The run is built in place, rather than copied into the kernel instance.
+    auto run = kernel_instance_->add_run();
+    run->set_sweep_index(sweep_index);
+    RunDynamicParams(dynamic_params, logger, *inputs, run);
+    logger.RecordKernelRun(&instance_, kernel_instance_, run);
+  }
+  return true;
 }
 
 namespace {
@@ -109,6 +201,10 @@ gpu::libcecl::OpenClKernelInvocation DynamicParamsToLog(
     const DynamicParams& dynamic_params) {
   gpu::libcecl::OpenClKernelInvocation invocation;
   invocation.set_global_size_x(dynamic_params.global_size_x());
+  invocation.set_global_size_y(std::max<labm8::int64>(
+      dynamic_params.global_size_y(), 1));
+  invocation.set_global_size_z(std::max<labm8::int64>(
+      dynamic_params.global_size_z(), 1));
   invocation.set_local_size_x(dynamic_params.local_size_x());
   invocation.set_local_size_y(dynamic_params.local_size_y());
   invocation.set_local_size_z(dynamic_params.local_size_z());
@@ -119,28 +215,439 @@ gpu::libcecl::OpenClKernelInvocation DynamicParamsToLog(
   return invocation;
 }
 
+// Set the transfer times, sizes and bandwidths of a run's log, in total, by
+// direction, and by argument.
+void SetTransferFields(const ProfilingData& profiling,
+                       gpu::libcecl::OpenClKernelInvocation* log) {
+  log->set_transfer_time_ns(profiling.transfer_nanoseconds);
+  log->set_transferred_bytes(profiling.transferred_bytes);
+  log->set_host_to_device_bytes(profiling.host_to_device_bytes);
+  log->set_host_to_device_time_ns(profiling.host_to_device_nanoseconds);
+  log->set_host_to_device_gbps(
+      GetBandwidthGbps(profiling.host_to_device_bytes,
+                       profiling.host_to_device_nanoseconds));
+  log->set_device_to_host_bytes(profiling.device_to_host_bytes);
+  log->set_device_to_host_time_ns(profiling.device_to_host_nanoseconds);
+  log->set_device_to_host_gbps(
+      GetBandwidthGbps(profiling.device_to_host_bytes,
+                       profiling.device_to_host_nanoseconds));
+
+  for (size_t i = 0; i < profiling.args.size(); ++i) {
+    const ArgTransferData& arg = profiling.args[i];
+    // Zero-copy transfers take time, but transfer no bytes.
+    if (!arg.host_to_device_bytes && !arg.host_to_device_nanoseconds &&
+        !arg.device_to_host_bytes && !arg.device_to_host_nanoseconds) {
+      continue;
+    }
+    gpu::libcecl::OpenClArgTransfer* transfer = log->add_arg_transfer();
+    transfer->set_arg_index(i);
+    transfer->set_host_to_device_bytes(arg.host_to_device_bytes);
+    transfer->set_host_to_device_time_ns(arg.host_to_device_nanoseconds);
+    transfer->set_host_to_device_gbps(GetBandwidthGbps(
+        arg.host_to_device_bytes, arg.host_to_device_nanoseconds));
+    transfer->set_device_to_host_bytes(arg.device_to_host_bytes);
+    transfer->set_device_to_host_time_ns(arg.device_to_host_nanoseconds);
+    transfer->set_device_to_host_gbps(GetBandwidthGbps(
+        arg.device_to_host_bytes, arg.device_to_host_nanoseconds));
+  }
+}
+
 }  // anonymous namespace
 
-labm8::Status KernelDriver::RunDynamicParams(
+void KernelDriver::RunDynamicParams(const DynamicParams& dynamic_params,
+                                    Logger& logger, KernelArgValuesSet& inputs,
+                                    CldriveKernelRun* run) {
+  RunStatistics statistics;
+  try {
+    DoRunDynamicParams(dynamic_params, logger, run, &statistics, inputs);
+  } catch (cl::Error error) {
+    RecordClError(error, run, logger);
+  } catch (WatchdogTimeout timeout) {
+    RecordTimeout(timeout, dynamic_params, inputs, run, statistics, logger);
+  }
+}
+
+void KernelDriver::RecordClError(const cl::Error& error, CldriveKernelRun* run,
+                                 Logger& logger) {
+  LOG(WARNING) << "Error code " << error.err() << " ("
+               << labm8::gpu::clinfo::OpenClErrorString(error.err()) << ") "
+               << "raised by " << error.what() << "() while driving kernel: '"
+               << name_ << "'";
+  run->set_outcome(CldriveKernelRun::CL_ERROR);
+  logger.RecordLog(&instance_, kernel_instance_, run, /*log=*/nullptr);
+}
+
+void KernelDriver::RecordTimeout(const WatchdogTimeout& timeout,
+                                 const DynamicParams& dynamic_params,
+                                 KernelArgValuesSet& inputs,
+                                 CldriveKernelRun* run,
+                                 const RunStatistics& statistics,
+                                 Logger& logger) {
+  LOG(WARNING) << "Time budget exceeded in phase "
+               << CldriveKernelRun::TimeoutPhase_Name(timeout.phase())
+               << " while driving kernel: '" << name_ << "'";
+  // Keep the runs which completed before the budget ran out.
+  run->set_outcome(CldriveKernelRun::TIMEOUT);
+  run->set_timeout_phase(timeout.phase());
+  logger.PrintAndClearBuffer();
+  gpu::libcecl::OpenClKernelInvocation log = DynamicParamsToLog(dynamic_params);
+  log.set_kernel_name(name_);
+  log.set_args_info(args_set_.ToStringWithValue(inputs));
+  logger.RecordLog(&instance_, kernel_instance_, run, &log);
+  SummarizeRun(dynamic_params, inputs, run, statistics, logger);
+
+  // Commands of the abandoned runs may never complete. Later launch configs
+  // are run on a new queue so that they are not stuck behind them, and with
+  // new input buffers, as the abandoned runs may still write to the old ones.
+  queue_ = cl::CommandQueue(context_, device_,
+                            /*properties=*/CL_QUEUE_PROFILING_ENABLE);
+  labm8::Status status = args_set_.ReplaceBuffers(context_, &inputs);
+  CHECK(status.ok()) << status.ToString();
+}
+
+void KernelDriver::TuneLocalSize(const DynamicParams& dynamic_params,
+                                 int sweep_index, Logger& logger,
+                                 KernelArgValuesSet& inputs) {
+  WorkGroupLimits limits;
+  try {
+    limits.max_work_group_size =
+        kernel_.getWorkGroupInfo<CL_KERNEL_WORK_GROUP_SIZE>(device_);
+    limits.preferred_multiple =
+        kernel_.getWorkGroupInfo<CL_KERNEL_PREFERRED_WORK_GROUP_SIZE_MULTIPLE>(
+            device_);
+    const auto max_work_item_sizes =
+        device_.getInfo<CL_DEVICE_MAX_WORK_ITEM_SIZES>();
+    for (size_t i = 0; i < 3; ++i) {
+      limits.max_work_item_sizes[i] =
+          i < max_work_item_sizes.size() ? max_work_item_sizes[i] : 1;
+    }
+  } catch (cl::Error error) {
+    // There are no candidates yet, so the error is recorded in a run of its
+    // own.
+    auto run = kernel_instance_->add_run();
+    run->set_sweep_index(sweep_index);
+    RecordClError(error, run, logger);
+    logger.RecordKernelRun(&instance_, kernel_instance_, run);
+    return;
+  }
+
+  const std::vector<DynamicParams> candidates =
+      LocalSizeCandidates(dynamic_params, limits);
+  if (candidates.empty()) {
+    LOG(WARNING) << "No local sizes to tune for kernel '" << name_
+                 << "' with global size " << dynamic_params.global_size_x();
+    auto run = kernel_instance_->add_run();
+    run->set_sweep_index(sweep_index);
+    run->set_outcome(CldriveKernelRun::INVALID_DYNAMIC_PARAMS);
+    gpu::libcecl::OpenClKernelInvocation log =
+        DynamicParamsToLog(dynamic_params);
+    logger.RecordLog(&instance_, kernel_instance_, run, &log);
+    logger.RecordKernelRun(&instance_, kernel_instance_, run);
+    return;
+  }
+
+  std::vector<CldriveKernelRun*> runs;
+  std::vector<RunStatistics> statistics(candidates.size());
+  for (size_t i = 0; i < candidates.size(); ++i) {
+    runs.push_back(kernel_instance_->add_run());
+    runs.back()->set_sweep_index(sweep_index);
+  }
+
+  const labm8::int64 budget =
+      instance_.tune_lsize_budget() > 0
+          ? instance_.tune_lsize_budget()
+          : static_cast<labm8::int64>(candidates.size()) *
+                std::max(instance_.min_runs_per_kernel(), 1);
+  SuccessiveHalving tuner(candidates.size(), budget);
+
+  // The inputs are shared by every candidate, so unless they are copied
+  // before every run, they are copied once for all of them. The outputs are
+  // checked once, with the first candidate. A failure of either applies to
+  // every candidate.
+  CldriveKernelRun::KernelRunOutcome outcome = CldriveKernelRun::PASS;
+  try {
+    if (instance_.input_residency() != CldriveInstance::PER_RUN) {
+      CopySetupInputs(inputs);
+    }
+    if (instance_.check_outputs()) {
+      outcome = CheckOutputs(candidates[0], inputs);
+    }
+  } catch (cl::Error error) {
+    RecordClError(error, runs[0], logger);
+    outcome = runs[0]->outcome();
+  } catch (WatchdogTimeout timeout) {
+    RecordTimeout(timeout, candidates[0], inputs, runs[0], statistics[0],
+                  logger);
+    outcome = runs[0]->outcome();
+  }
+  if (outcome != CldriveKernelRun::PASS) {
+    LOG(WARNING) << "Rejecting kernel '" << name_ << "' with outcome "
+                 << CldriveKernelRun::KernelRunOutcome_Name(outcome);
+    for (size_t i = 0; i < candidates.size(); ++i) {
+      if (runs[i]->outcome() == CldriveKernelRun::UNKNOWN_ERROR) {
+        runs[i]->set_outcome(outcome);
+        if (runs[0]->has_timeout_phase()) {
+          runs[i]->set_timeout_phase(runs[0]->timeout_phase());
+        }
+        gpu::libcecl::OpenClKernelInvocation log =
+            DynamicParamsToLog(candidates[i]);
+        log.set_kernel_name(name_);
+        log.set_args_info(args_set_.ToStringWithValue(inputs));
+        logger.RecordLog(&instance_, kernel_instance_, runs[i], &log);
+      }
+      logger.RecordKernelRun(&instance_, kernel_instance_, runs[i]);
+    }
+    return;
+  }
+
+  KernelArgValuesSet outputs;
+  while (!tuner.done()) {
+    const int num_runs = tuner.runs_per_candidate();
+    for (size_t i : std::vector<size_t>(tuner.survivors())) {
+      Watchdog::Scope config_scope(watchdog_, CldriveKernelRun::CONFIG,
+                                   instance_.config_timeout_ms());
+      try {
+        if (!statistics[i].count()) {
+          // A warmup run, the first time the local size is timed.
+          RunOnceOrDie(candidates[i], inputs, &outputs);
+        }
+        for (int j = 0; j < num_runs; ++j) {
+          // Logged once the best candidate is known.
+          auto log = RunOnceOrDie(candidates[i], inputs, &outputs);
+          log.set_kernel_name(name_);
+          log.set_args_info(args_set_.ToStringWithValue(inputs));
+          tuner.Add(i, log.kernel_time_ns());
+          AddRunLog(log, runs[i], &statistics[i]);
+        }
+        runs[i]->set_tuning_rounds(runs[i]->tuning_rounds() + 1);
+      } catch (cl::Error error) {
+        RecordClError(error, runs[i], logger);
+        tuner.Fail(i);
+      } catch (WatchdogTimeout timeout) {
+        RecordTimeout(timeout, candidates[i], inputs, runs[i], statistics[i],
+                      logger);
+        tuner.Fail(i);
+        // The inputs have new buffers, which are set up for the remaining
+        // candidates as they were for the first.
+        if (instance_.input_residency() != CldriveInstance::PER_RUN) {
+          CopySetupInputs(inputs);
+        }
+      }
+    }
+    tuner.EndRound();
+  }
+
+  const int best = tuner.best();
+  if (best >= 0) {
+    runs[best]->set_best_local_size(true);
+    LOG(INFO) << "Best local size of kernel '" << name_ << "' for global size "
+              << dynamic_params.global_size_x() << "x"
+              << std::max<labm8::int64>(dynamic_params.global_size_y(), 1)
+              << "x"
+              << std::max<labm8::int64>(dynamic_params.global_size_z(), 1)
+              << ": "
+              << candidates[best].local_size_x() << "x"
+              << candidates[best].local_size_y() << "x"
+              << candidates[best].local_size_z() << " ("
+              << static_cast<labm8::int64>(tuner.MedianTime(best))
+              << " ns median of " << candidates.size() << " candidates)";
+  }
+
+  // The timed runs are logged once the best candidate is known, so that the
+  // log of every run says whether its local size is the best.
+  for (size_t i = 0; i < candidates.size(); ++i) {
+    if (runs[i]->outcome() == CldriveKernelRun::UNKNOWN_ERROR) {
+      runs[i]->set_outcome(CldriveKernelRun::PASS);
+    }
+    for (const auto& log : runs[i]->log()) {
+      logger.RecordLog(&instance_, kernel_instance_, runs[i], &log);
+    }
+    if (runs[i]->outcome() == CldriveKernelRun::PASS) {
+      SummarizeRun(candidates[i], inputs, runs[i], statistics[i], logger);
+    }
+    logger.RecordKernelRun(&instance_, kernel_instance_, runs[i]);
+  }
+}
+
+CldriveKernelRun::KernelRunOutcome KernelDriver::CheckOutputs(
+    const DynamicParams& dynamic_params, KernelArgValuesSet& inputs) {
+  CHECK(hasher_) << "Output checks need a buffer hasher";
+  CHECK(!args_set_.zero_copy()) << "Output checks need copy buffers";
+
+  KernelArgValuesSet alternates;
+  labm8::Status status =
+      args_set_.SetAlternateRandom(context_, inputs, &alternates);
+  if (!status.ok()) {
+    LOG(WARNING) << "Unable to check outputs of kernel '" << name_
+                 << "': " << status.ToString();
+    return CldriveKernelRun::OUTPUTS_NOT_CHECKED;
+  }
+
+  Watchdog::Scope run_scope(watchdog_, CldriveKernelRun::KERNEL,
+                            instance_.run_timeout_ms());
+  auto run_kernel = [&]() {
+    cl::Event event;
+    queue_.enqueueNDRangeKernel(kernel_, /*offset=*/cl::NullRange,
+                                /*global=*/util::GetGlobalRange(dynamic_params),
+                                /*local=*/util::GetLocalRange(dynamic_params),
+                                /*events=*/nullptr, /*event=*/&event);
+    WaitForEvent(queue_, event, watchdog_);
+  };
+
+  // The transfers of the check are not part of the run's profile.
+  ProfilingData profiling;
+  OutputDigests digests;
+
+  try {
+    // Runs A and A' of the inputs.
+    CopyToDevice(inputs, &profiling);
+    inputs.SetAsArgs(&kernel_);
+    HashDeviceBuffers(hasher_, queue_, inputs, &digests.a_inputs);
+    run_kernel();
+    HashDeviceBuffers(hasher_, queue_, inputs, &digests.a_outputs);
+    CopyToDevice(inputs, &profiling);
+    run_kernel();
+    HashDeviceBuffers(hasher_, queue_, inputs, &digests.a_prime_outputs);
+
+    // Run B of the alternate buffers, with the same scalars.
+    for (size_t i = 0; i < alternates.values().size(); ++i) {
+      if (alternates.values()[i]) {
+        alternates.values()[i]->CopyToDevice(queue_, &profiling);
+        alternates.values()[i]->SetAsArg(&kernel_, i);
+      }
+    }
+    HashDeviceBuffers(hasher_, queue_, alternates, &digests.b_inputs);
+    run_kernel();
+    HashDeviceBuffers(hasher_, queue_, alternates, &digests.b_outputs);
+  } catch (WatchdogTimeout) {
+    // An abandoned run may still write to the alternate buffers.
+    alternates.Abandon();
+    throw;
+  }
+
+  inputs.SetAsArgs(&kernel_);
+  if (instance_.input_residency() != CldriveInstance::PER_RUN) {
+    CopyToDevice(inputs, &profiling);
+  }
+  return ClassifyOutputs(digests);
+}
+
+ProfilingData KernelDriver::CopySetupInputs(KernelArgValuesSet& inputs) {
+  ProfilingData profiling;
+  switch (instance_.input_residency()) {
+    case CldriveInstance::PER_RUN:
+      break;
+    case CldriveInstance::PER_CONFIG:
+      inputs.CopyToDevice(queue_, &profiling);
+      break;
+    case CldriveInstance::ONCE:
+      inputs.CopyNonResidentToDevice(queue_, &profiling);
+      break;
+  }
+  return profiling;
+}
+
+void KernelDriver::CopyToDevice(KernelArgValuesSet& inputs,
+                                ProfilingData* profiling) {
+  if (!watchdog_) {
+    inputs.CopyToDevice(queue_, profiling);
+    return;
+  }
+
+  inputs.EnqueueCopyToDevice(queue_, profiling);
+  for (const auto& event : profiling->pending_transfer_events) {
+    WaitForEvent(queue_, event, watchdog_);
+  }
+  profiling->CollectPendingEvents();
+}
+
+void KernelDriver::AddRunLog(const gpu::libcecl::OpenClKernelInvocation& log,
+                             CldriveKernelRun* run,
+                             RunStatistics* statistics) {
+  statistics->Add(log.kernel_time_ns());
+  if (!instance_.summary_only()) {
+    *run->add_log() = log;
+  }
+}
+
+void KernelDriver::SummarizeRun(const DynamicParams& dynamic_params,
+                                KernelArgValuesSet& inputs,
+                                CldriveKernelRun* run,
+                                const RunStatistics& statistics,
+                                Logger& logger) {
+  if (!statistics.count()) {
+    return;
+  }
+  *run->mutable_kernel_time_summary() = statistics.Summary();
+  gpu::libcecl::OpenClKernelInvocation log = DynamicParamsToLog(dynamic_params);
+  log.set_kernel_name(name_);
+  log.set_args_info(args_set_.ToStringWithValue(inputs));
+  logger.RecordRunSummary(&instance_, kernel_instance_, run, &log);
+}
+
+labm8::Status KernelDriver::DoRunDynamicParams(
     const DynamicParams& dynamic_params, Logger& logger,
-    CldriveKernelRun* run, KernelArgValuesSet& inputs) {
+    CldriveKernelRun* run, RunStatistics* statistics,
+    KernelArgValuesSet& inputs) {
   // Create a log message with just the dynamic params so that we can log the
   // global and local sizes on error.
   gpu::libcecl::OpenClKernelInvocation log = DynamicParamsToLog(dynamic_params);
 
+  Watchdog::Scope config_scope(watchdog_, CldriveKernelRun::CONFIG,
+                               instance_.config_timeout_ms());
+
   // Check that the dynamic params are within legal range.
   auto max_work_group_size = device_.getInfo<CL_DEVICE_MAX_WORK_GROUP_SIZE>();
-  if (static_cast<int>(max_work_group_size) < dynamic_params.local_size_x()) {
+  if (static_cast<labm8::int64>(max_work_group_size) <
+      util::GetWorkGroupSize(dynamic_params)) {
     run->set_outcome(CldriveKernelRun::INVALID_DYNAMIC_PARAMS);
     LOG(WARNING) << "Unsupported dynamic params to kernel '" << name_
-                 << "' (local size " << dynamic_params.local_size_x()
+                 << "' (work group size "
+                 << util::GetWorkGroupSize(dynamic_params)
                  << " exceeds maximum device work group size "
                  << max_work_group_size << ")";
     logger.RecordLog(&instance_, kernel_instance_, run, &log);
     return labm8::Status(labm8::error::Code::INVALID_ARGUMENT,
                          "Unsupported dynamic params");
   }
+  if (!util::LocalSizeFitsGlobalSize(dynamic_params)) {
+    run->set_outcome(CldriveKernelRun::INVALID_DYNAMIC_PARAMS);
+    LOG(WARNING) << "Unsupported dynamic params to kernel '" << name_
+                 << "' (local size " << dynamic_params.local_size_x() << "x"
+                 << dynamic_params.local_size_y() << "x"
+                 << dynamic_params.local_size_z()
+                 << " exceeds global size in some dimension)";
+    logger.RecordLog(&instance_, kernel_instance_, run, &log);
+    return labm8::Status(labm8::error::Code::INVALID_ARGUMENT,
+                         "Unsupported dynamic params");
+  }
   
+  // Copy inputs to the device ahead of the runs, unless they are copied
+  // before every run.
+  ProfilingData setup_profiling = CopySetupInputs(inputs);
+  if (instance_.input_residency() != CldriveInstance::PER_RUN) {
+    run->set_setup_transferred_bytes(setup_profiling.transferred_bytes);
+    run->set_setup_transfer_time_ns(setup_profiling.transfer_nanoseconds);
+  }
+  if (watchdog_) {
+    watchdog_->CheckOrThrow();
+  }
+
+  if (instance_.check_outputs()) {
+    const CldriveKernelRun::KernelRunOutcome outcome =
+        CheckOutputs(dynamic_params, inputs);
+    if (outcome != CldriveKernelRun::PASS) {
+      run->set_outcome(outcome);
+      LOG(WARNING) << "Rejecting kernel '" << name_ << "' with outcome "
+                   << CldriveKernelRun::KernelRunOutcome_Name(outcome);
+      log.set_kernel_name(name_);
+      log.set_args_info(args_set_.ToStringWithValue(inputs));
+      logger.RecordLog(&instance_, kernel_instance_, run, &log);
+      return labm8::Status(labm8::error::Code::INVALID_ARGUMENT,
+                           "Kernel outputs rejected");
+    }
+  }
+
   // 2 warmup run
   KernelArgValuesSet output_a;
   inputs.SetAsArgs(&kernel_);
@@ -150,12 +657,22 @@ labm8::Status KernelDriver::RunDynamicParams(
   // from the preliminary runs.
   logger.PrintAndClearBuffer();
 
-  for (int i = 0; i < instance_.min_runs_per_kernel(); ++i) {
-    *run->add_log() =
-        RunOnceOrDie(dynamic_params, inputs, &output_a, run, logger);
+  if (instance_.pipelined()) {
+    RunPipelinedOrDie(dynamic_params, inputs, run, statistics, logger);
+  } else if (instance_.max_runs_per_kernel() >
+             instance_.min_runs_per_kernel()) {
+    RunAdaptiveOrDie(dynamic_params, inputs, &output_a, run, statistics,
+                     logger);
+  } else {
+    for (int i = 0; i < instance_.min_runs_per_kernel(); ++i) {
+      AddRunLog(RunOnceOrDie(dynamic_params, inputs, &output_a, run, logger),
+                run, statistics);
+    }
   }
 
   run->set_outcome(CldriveKernelRun::PASS);
+  SummarizeRun(dynamic_params, inputs, run, *statistics, logger);
+
   return labm8::Status::OK;
 }
 
@@ -163,76 +680,136 @@ gpu::libcecl::OpenClKernelInvocation KernelDriver::RunOnceOrDie(
     const DynamicParams& dynamic_params, KernelArgValuesSet& inputs,
     KernelArgValuesSet* outputs, const CldriveKernelRun* const run,
     Logger& logger, bool flush) {
-  gpu::libcecl::OpenClKernelInvocation log;
-  ProfilingData profiling;
-  cl::Event event;
+  gpu::libcecl::OpenClKernelInvocation log =
+      RunOnceOrDie(dynamic_params, inputs, outputs);
+  log.set_kernel_name(name_);
+  log.set_args_info(args_set_.ToStringWithValue(inputs));
 
-  uint64_t global_size = dynamic_params.global_size_x();
-  uint64_t local_size_x = dynamic_params.local_size_x();
-  uint64_t local_size_y = dynamic_params.local_size_y();
-  uint64_t local_size_z = dynamic_params.local_size_z();
+  logger.RecordLog(&instance_, kernel_instance_, run, &log, flush);
 
-  log.set_global_size_x(global_size);
-  log.set_local_size_x(local_size_x);
-  log.set_local_size_y(local_size_y);
-  log.set_local_size_z(local_size_z);
-  log.set_kernel_name(name_);
+  return log;
+}
+
+void KernelDriver::RunAdaptiveOrDie(const DynamicParams& dynamic_params,
+                                    KernelArgValuesSet& inputs,
+                                    KernelArgValuesSet* outputs,
+                                    CldriveKernelRun* run,
+                                    RunStatistics* statistics,
+                                    Logger& logger) {
+  const auto start_time = absl::Now();
+  const auto time_budget =
+      absl::Milliseconds(instance_.max_time_per_config_ms());
+  std::vector<labm8::int64> kernel_times;
+
+  run->set_stopping_reason(CldriveKernelRun::MAX_RUNS_REACHED);
+  for (int i = 0; i < instance_.max_runs_per_kernel(); ++i) {
+    auto log = RunOnceOrDie(dynamic_params, inputs, outputs, run, logger);
+    kernel_times.push_back(log.kernel_time_ns());
+    AddRunLog(log, run, statistics);
+
+    if (static_cast<int>(kernel_times.size()) <
+        instance_.min_runs_per_kernel()) {
+      continue;
+    }
+
+    if (instance_.target_relative_ci_width() > 0) {
+      auto width_or = RelativeMedianConfidenceIntervalWidth(kernel_times);
+      if (width_or.ok() &&
+          width_or.ValueOrDie() <= instance_.target_relative_ci_width()) {
+        run->set_stopping_reason(CldriveKernelRun::CONFIDENCE_REACHED);
+        return;
+      }
+    }
+
+    if (instance_.max_time_per_config_ms() > 0 &&
+        absl::Now() - start_time >= time_budget) {
+      run->set_stopping_reason(CldriveKernelRun::TIME_BUDGET_EXHAUSTED);
+      return;
+    }
+  }
+}
 
-  inputs.CopyToDevice(queue_, &profiling);
+void KernelDriver::RunPipelinedOrDie(const DynamicParams& dynamic_params,
+                                     KernelArgValuesSet& inputs,
+                                     CldriveKernelRun* run,
+                                     RunStatistics* statistics,
+                                     Logger& logger) {
+  const int num_runs = instance_.min_runs_per_kernel();
+  std::vector<ProfilingData> profiling(num_runs);
+
+  // The argument values do not change between runs, so they are set once.
   inputs.SetAsArgs(&kernel_);
 
-  queue_.enqueueNDRangeKernel(kernel_, /*offset=*/cl::NullRange,
-                              /*global=*/cl::NDRange(global_size),
-                              /*local=*/cl::NDRange(local_size_x, local_size_y, local_size_z),
-                              /*events=*/nullptr, /*event=*/&event);
-  profiling.kernel_nanoseconds += GetElapsedNanoseconds(event);
+  // Enqueue every run without waiting. The queue is in-order, so each run's
+  // transfers complete before its kernel starts.
+  for (int i = 0; i < num_runs; ++i) {
+    if (instance_.input_residency() == CldriveInstance::PER_RUN) {
+      inputs.EnqueueCopyToDevice(queue_, &profiling[i]);
+    }
 
-  // currently no need to copy back the output since we only need kernel execution time
-  // inputs.CopyFromDeviceToNewValueSet(queue_, outputs, &profiling);
-  // Set run proto fields.
-  log.set_kernel_time_ns(profiling.kernel_nanoseconds);
-  log.set_transfer_time_ns(profiling.transfer_nanoseconds);
-  log.set_transferred_bytes(profiling.transferred_bytes);
-  log.set_args_info(args_set_.ToStringWithValue(inputs));
+    cl::Event event;
+    queue_.enqueueNDRangeKernel(
+        kernel_, /*offset=*/cl::NullRange,
+        /*global=*/util::GetGlobalRange(dynamic_params),
+        /*local=*/util::GetLocalRange(dynamic_params),
+        /*events=*/nullptr, /*event=*/&event);
+    profiling[i].pending_kernel_events.push_back(event);
+  }
+  // The queue is in-order, so the last kernel is the last command to
+  // complete.
+  if (watchdog_ && num_runs) {
+    WaitForEvent(queue_, profiling.back().pending_kernel_events.back(),
+                 watchdog_);
+  }
+  queue_.finish();
 
-  logger.RecordLog(&instance_, kernel_instance_, run, &log, flush);
+  const string args_info = args_set_.ToStringWithValue(inputs);
+  for (int i = 0; i < num_runs; ++i) {
+    profiling[i].CollectPendingEvents();
 
-  return log;
+    gpu::libcecl::OpenClKernelInvocation log =
+        DynamicParamsToLog(dynamic_params);
+    log.set_kernel_name(name_);
+    log.set_kernel_time_ns(profiling[i].kernel_nanoseconds);
+    SetTransferFields(profiling[i], &log);
+    log.set_args_info(args_info);
+
+    logger.RecordLog(&instance_, kernel_instance_, run, &log);
+    AddRunLog(log, run, statistics);
+  }
 }
 
 gpu::libcecl::OpenClKernelInvocation KernelDriver::RunOnceOrDie(
     const DynamicParams& dynamic_params, KernelArgValuesSet& inputs,
     KernelArgValuesSet* outputs) {
-  gpu::libcecl::OpenClKernelInvocation log;
+  gpu::libcecl::OpenClKernelInvocation log =
+      DynamicParamsToLog(dynamic_params);
   ProfilingData profiling;
   cl::Event event;
-  
-  size_t global_size = dynamic_params.global_size_x();
-  size_t local_size_x = dynamic_params.local_size_x();
-  size_t local_size_y = dynamic_params.local_size_y();
-  size_t local_size_z = dynamic_params.local_size_z();
-
-  log.set_global_size_x(global_size);
-  log.set_local_size_x(local_size_x);
-  log.set_local_size_y(local_size_y);
-  log.set_local_size_z(local_size_z);
 
-  inputs.CopyToDevice(queue_, &profiling);
+  Watchdog::Scope run_scope(watchdog_, CldriveKernelRun::TRANSFER,
+                            instance_.run_timeout_ms());
+  if (instance_.input_residency() == CldriveInstance::PER_RUN) {
+    CopyToDevice(inputs, &profiling);
+  }
   inputs.SetAsArgs(&kernel_);
 
+  run_scope.set_phase(CldriveKernelRun::KERNEL);
   queue_.enqueueNDRangeKernel(kernel_, /*offset=*/cl::NullRange,
-                              /*global=*/cl::NDRange(global_size),
-                              /*local=*/cl::NDRange(local_size_x, local_size_y, local_size_z),
+                              /*global=*/util::GetGlobalRange(dynamic_params),
+                              /*local=*/util::GetLocalRange(dynamic_params),
                               /*events=*/nullptr, /*event=*/&event);
-
+  WaitForEvent(queue_, event, watchdog_);
   profiling.kernel_nanoseconds += GetElapsedNanoseconds(event);
 
-  // currently no need to copy back the output since we only need kernel execution time
-  // inputs.CopyFromDeviceToNewValueSet(queue_, outputs, &profiling);
+  // Outputs are only copied back if their transfers are to be timed.
+  if (instance_.copy_outputs()) {
+    run_scope.set_phase(CldriveKernelRun::TRANSFER);
+    inputs.CopyFromDeviceToNewValueSet(queue_, outputs, &profiling);
+  }
   // Set run proto fields.
   log.set_kernel_time_ns(profiling.kernel_nanoseconds);
-  log.set_transfer_time_ns(profiling.transfer_nanoseconds);
-  log.set_transferred_bytes(profiling.transferred_bytes);
+  SetTransferFields(profiling, &log);
 
   return log;
 }
@@ -17,25 +17,43 @@
 
 #include "gpu/cldrive/kernel_arg_set.h"
 #include "gpu/cldrive/logger.h"
+#include "gpu/cldrive/output_check.h"
 #include "gpu/cldrive/proto/cldrive.pb.h"
+#include "gpu/cldrive/run_statistics.h"
+#include "gpu/cldrive/watchdog.h"
 #include "labm8/cpp/statusor.h"
 #include "labm8/cpp/string.h"
 #include "third_party/opencl/cl.hpp"
 
+#include <memory>
+
 namespace gpu {
 namespace cldrive {
 
 class KernelDriver {
  public:
+  // If buffer_pool is not nullptr, device buffers are acquired from it, and
+  // returned to it when no longer needed. If watchdog is not nullptr, it
+  // enforces the instance's run_timeout_ms and config_timeout_ms budgets.
+  // The hasher is needed only if the instance's check_outputs is set.
   KernelDriver(const cl::Context& context, const cl::CommandQueue& queue,
                const cl::Kernel& kernel, CldriveInstance* instance,
-               int instance_num);
+               int instance_num, DeviceBufferPool* buffer_pool = nullptr,
+               Watchdog* watchdog = nullptr,
+               DeviceBufferHasher* hasher = nullptr);
 
   void RunOrDie(Logger& logger);
 
-  labm8::StatusOr<CldriveKernelRun> RunDynamicParams(
-      const DynamicParams& dynamic_params, Logger& logger, 
-      KernelArgValuesSet& input);
+  // The queue that commands are enqueued on. After a launch config times
+  // out, the queue may still hold the commands of the abandoned runs, so it
+  // is replaced with a new queue for the same device.
+  const cl::CommandQueue& queue() const { return queue_; }
+
+  // Run the kernel with the given dynamic params, setting the outcome and logs
+  // of run. OpenCL errors are caught, and set the CL_ERROR outcome. Time
+  // budgets which run out set the TIMEOUT outcome.
+  void RunDynamicParams(const DynamicParams& dynamic_params, Logger& logger,
+                        KernelArgValuesSet& inputs, CldriveKernelRun* run);
 
   // Run the kernel with the given dynamic parameters. Any error here will
   // result in the programming terminating. If flush is true, the result is
@@ -45,17 +63,91 @@ class KernelDriver {
       const DynamicParams& dynamic_params, KernelArgValuesSet& inputs,
       KernelArgValuesSet* outputs, const CldriveKernelRun* const run,
       Logger& logger, bool flush = true);
+  // As above, but the result is not logged, and has neither the kernel name
+  // nor the argument values set.
   gpu::libcecl::OpenClKernelInvocation RunOnceOrDie(
-    const DynamicParams& dynamic_params, 
-    KernelArgValuesSet& inputs,
-    KernelArgValuesSet* outputs);
+      const DynamicParams& dynamic_params, KernelArgValuesSet& inputs,
+      KernelArgValuesSet* outputs);
+
+  // Run the kernel between min_runs_per_kernel and max_runs_per_kernel times
+  // with the given dynamic params, stopping early according to the instance's
+  // stopping rules. Each run is logged and added to statistics, and the
+  // reason for stopping is set in run.
+  void RunAdaptiveOrDie(const DynamicParams& dynamic_params,
+                        KernelArgValuesSet& inputs,
+                        KernelArgValuesSet* outputs, CldriveKernelRun* run,
+                        RunStatistics* statistics, Logger& logger);
+
+  // Run the kernel min_runs_per_kernel times with the given dynamic params.
+  // All runs are enqueued before any profiling data is read, so there is a
+  // single synchronization point per launch config. Each run is logged and
+  // added to statistics.
+  void RunPipelinedOrDie(const DynamicParams& dynamic_params,
+                         KernelArgValuesSet& inputs, CldriveKernelRun* run,
+                         RunStatistics* statistics, Logger& logger);
 
  private:
+  // Set the argument values and run the kernel with the given dynamic params.
+  // If args_values is nullptr, argument values are derived from the dynamic
+  // params. The runs have the given sweep_index. Returns false if the argument
+  // values could not be set.
+  bool SetArgsAndRun(const DynamicParams& dynamic_params,
+                     const std::vector<long long>* args_values,
+                     int sweep_index, Logger& logger,
+                     KernelArgValuesSet* inputs);
+
+  // Copy the inputs to the device before a run. If there is a watchdog, the
+  // copies are enqueued without blocking, and WatchdogTimeout is thrown if a
+  // time budget runs out before they complete.
+  void CopyToDevice(KernelArgValuesSet& inputs, ProfilingData* profiling);
+
+  // Copy the inputs to the device ahead of the runs of a launch config,
+  // according to the instance's input_residency. Returns the transfers made.
+  ProfilingData CopySetupInputs(KernelArgValuesSet& inputs);
+
+  // Classify the outputs of the kernel with the given dynamic params, by
+  // comparing device-side digests of its global buffers across two runs of
+  // the inputs and one of alternate inputs. Afterwards, the inputs are set as
+  // the kernel arguments and, unless they are copied before every run, are
+  // on the device. Returns OUTPUTS_NOT_CHECKED if the check cannot be made.
+  CldriveKernelRun::KernelRunOutcome CheckOutputs(
+      const DynamicParams& dynamic_params, KernelArgValuesSet& inputs);
+
+  // Set the CL_ERROR outcome of run, and log it.
+  void RecordClError(const cl::Error& error, CldriveKernelRun* run,
+                     Logger& logger);
+
+  // Set the TIMEOUT outcome of run, log it and the statistics of its
+  // completed runs, and replace the queue.
+  void RecordTimeout(const WatchdogTimeout& timeout,
+                     const DynamicParams& dynamic_params,
+                     KernelArgValuesSet& inputs, CldriveKernelRun* run,
+                     const RunStatistics& statistics, Logger& logger);
+
+  // Time the kernel with candidate local sizes for the global size of
+  // dynamic_params, using successive halving, and add a run per candidate.
+  // The run of the fastest candidate has best_local_size set. The timed runs
+  // are logged once tuning is done. If the outputs are checked and rejected,
+  // no candidate is timed.
+  void TuneLocalSize(const DynamicParams& dynamic_params, int sweep_index,
+                     Logger& logger, KernelArgValuesSet& inputs);
+
+  // Add the log of a completed run of run to statistics and, unless in
+  // summary-only mode, to run.
+  void AddRunLog(const gpu::libcecl::OpenClKernelInvocation& log,
+                 CldriveKernelRun* run, RunStatistics* statistics);
+
+  // Set the kernel time summary of run from statistics, and log it.
+  void SummarizeRun(const DynamicParams& dynamic_params,
+                    KernelArgValuesSet& inputs, CldriveKernelRun* run,
+                    const RunStatistics& statistics, Logger& logger);
+
   // Private helper to public RunDynamicParams() method that doesn't catch
-  // OpenCL exceptions.
-  labm8::Status RunDynamicParams(const DynamicParams& dynamic_params,
-                                 Logger& logger, CldriveKernelRun* run, 
-                                 KernelArgValuesSet& inputs);
+  // OpenCL exceptions or timeouts.
+  labm8::Status DoRunDynamicParams(const DynamicParams& dynamic_params,
+                                   Logger& logger, CldriveKernelRun* run,
+                                   RunStatistics* statistics,
+                                   KernelArgValuesSet& inputs);
 
   cl::Context context_;
   cl::CommandQueue queue_;
@@ -66,6 +158,8 @@ class KernelDriver {
   CldriveKernelInstance* kernel_instance_;
   string name_;
   KernelArgSet args_set_;
+  Watchdog* watchdog_;
+  DeviceBufferHasher* hasher_;
 };
 
 }  // namespace cldrive
@@ -1,4 +1,5 @@
 #include "gpu/cldrive/kernel_arg_set.h"
+#include "gpu/cldrive/program_cache.h"
 
 #include "gpu/clinfo/libclinfo.h"
 
@@ -15,28 +16,8 @@ namespace util {
 labm8::StatusOr<cl::Program> BuildOpenClProgram(
     const std::string& opencl_kernel, const cl::Context& context,
     const string& cl_build_opts) {
-  auto start_time = absl::Now();
-  try {
-    // Assemble the build options. We need -cl-kernel-arg-info so that we can
-    // read the kernel signatures.
-    string all_build_opts = "-cl-kernel-arg-info ";
-    absl::StrAppend(&all_build_opts, cl_build_opts);
-    labm8::TrimRight(all_build_opts);
-
-    cl::Program program(context, opencl_kernel);
-    program.build(context.getInfo<CL_CONTEXT_DEVICES>(),
-                  all_build_opts.c_str());
-    auto end_time = absl::Now();
-    auto duration = (end_time - start_time) / absl::Milliseconds(1);
-    LOG(INFO) << "clBuildProgram() with options '" << all_build_opts
-              << "' completed in " << duration << " ms";
-    return program;
-  } catch (cl::Error e) {
-    LOG(WARNING) << "OpenCL exception: " << e.what() << ", error: " \
-             << labm8::gpu::clinfo::OpenClErrorString(e.err());
-    return labm8::Status(labm8::error::Code::INVALID_ARGUMENT,
-                         "clBuildProgram failed");;
-  }
+  return ::gpu::cldrive::BuildOpenClProgram(opencl_kernel, context,
+                                            cl_build_opts);
 }
 
 string GetKernelInfoOrDie(std::string opencl_src, string build_opts="", cl::Device device=cl::Device()) {
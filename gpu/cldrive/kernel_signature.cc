@@ -0,0 +1,344 @@
+// Copyright (c) 2016-2020 Chris Cummins.
+// This file is part of cldrive.
+//
+// cldrive is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// cldrive is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with cldrive.  If not, see <https://www.gnu.org/licenses/>.
+#include "gpu/cldrive/kernel_signature.h"
+
+#include "gpu/cldrive/kernel_arg_set.h"
+#include "gpu/cldrive/opencl_util.h"
+#include "gpu/cldrive/program_cache.h"
+#include "gpu/clinfo/libclinfo.h"
+
+#include "labm8/cpp/logging.h"
+#include "labm8/cpp/mutex.h"
+#include "labm8/cpp/status.h"
+
+#include "absl/strings/ascii.h"
+
+#include "boost/filesystem.hpp"
+#include "boost/filesystem/fstream.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <future>
+#include <sstream>
+#include <thread>
+
+namespace fs = boost::filesystem;
+
+namespace gpu {
+namespace cldrive {
+
+namespace {
+
+// Work-item functions which take a dimension index.
+const char* const kWorkItemFunctions[] = {
+    "get_global_id",  "get_global_size", "get_global_offset", "get_local_id",
+    "get_local_size", "get_group_id",    "get_num_groups",
+};
+
+bool IsIdentifierChar(char c) { return std::isalnum(c) || c == '_'; }
+
+size_t SkipWhitespace(const string& src, size_t pos) {
+  while (pos < src.size() && std::isspace(src[pos])) {
+    ++pos;
+  }
+  return pos;
+}
+
+// Return the position after the bracket which closes the one at pos, or
+// string::npos if it is not closed.
+size_t SkipBrackets(const string& src, size_t pos, char open, char close) {
+  int depth = 0;
+  for (; pos < src.size(); ++pos) {
+    if (src[pos] == open) {
+      ++depth;
+    } else if (src[pos] == close && !--depth) {
+      return pos + 1;
+    }
+  }
+  return string::npos;
+}
+
+// Return the body of the definition of a function, or an empty string if it
+// is not found. A definition is the name, followed by a parameter list, then
+// optional attributes, then a brace-enclosed body.
+string FindFunctionBody(const string& src, const string& name) {
+  for (size_t pos = src.find(name); pos != string::npos;
+       pos = src.find(name, pos + 1)) {
+    if ((pos && IsIdentifierChar(src[pos - 1])) ||
+        (pos + name.size() < src.size() &&
+         IsIdentifierChar(src[pos + name.size()]))) {
+      continue;
+    }
+    size_t params = SkipWhitespace(src, pos + name.size());
+    if (params >= src.size() || src[params] != '(') {
+      continue;
+    }
+    size_t body = SkipBrackets(src, params, '(', ')');
+    if (body == string::npos) {
+      continue;
+    }
+    // Skip attributes, e.g. __attribute__((reqd_work_group_size(64, 1, 1))).
+    body = SkipWhitespace(src, body);
+    while (body < src.size() && src[body] != '{' && src[body] != ';') {
+      if (src[body] == '(') {
+        body = SkipBrackets(src, body, '(', ')');
+        if (body == string::npos) {
+          break;
+        }
+      } else {
+        ++body;
+      }
+    }
+    if (body >= src.size() || src[body] != '{') {
+      continue;
+    }
+    const size_t end = SkipBrackets(src, body, '{', '}');
+    if (end != string::npos) {
+      return src.substr(body, end - body);
+    }
+  }
+  return "";
+}
+
+// Return the signature of the kernels in a source file.
+ProgramSignatures GetProgramSignatures(const cl::Context& context,
+                                       const cl::Device& device,
+                                       const string& path,
+                                       const string& build_opts) {
+  ProgramSignatures signatures;
+  signatures.set_path(path);
+
+  fs::ifstream file{fs::path(path)};
+  if (!file) {
+    LOG(WARNING) << "Failed to read OpenCL source: '" << path << "'";
+    signatures.set_outcome(ProgramSignatures::READ_FAILURE);
+    return signatures;
+  }
+  std::stringstream buffer;
+  buffer << file.rdbuf();
+  const string opencl_src = buffer.str();
+
+  labm8::StatusOr<cl::Program> program_or =
+      BuildOpenClProgram(opencl_src, context, build_opts);
+  if (!program_or.ok()) {
+    LOG(WARNING) << "OpenCL program compilation failed: '" << path << "'";
+    signatures.set_outcome(ProgramSignatures::PROGRAM_COMPILATION_FAILURE);
+    return signatures;
+  }
+
+  cl::Program program = program_or.ValueOrDie();
+  std::vector<cl::Kernel> kernels;
+  program.createKernels(&kernels);
+  if (kernels.empty()) {
+    signatures.set_outcome(ProgramSignatures::NO_KERNELS_IN_PROGRAM);
+    return signatures;
+  }
+
+  for (auto& kernel : kernels) {
+    *signatures.add_kernel() = GetKernelSignature(&kernel, device, opencl_src);
+  }
+  signatures.set_outcome(ProgramSignatures::PASS);
+  return signatures;
+}
+
+}  // anonymous namespace
+
+labm8::StatusOr<std::vector<string>> ListKernelSources(const string& path) {
+  const fs::path root(path);
+  std::vector<string> paths;
+
+  if (fs::is_directory(root)) {
+    for (fs::recursive_directory_iterator it(root), end; it != end; ++it) {
+      if (fs::is_regular_file(it->path()) && it->path().extension() == ".cl") {
+        paths.push_back(it->path().string());
+      }
+    }
+    std::sort(paths.begin(), paths.end());
+    return paths;
+  }
+
+  if (!fs::is_regular_file(root)) {
+    return labm8::Status(labm8::error::Code::NOT_FOUND,
+                         "Kernel sources not found: '{}'", path);
+  }
+
+  fs::ifstream manifest(root);
+  string line;
+  while (std::getline(manifest, line)) {
+    const string entry(absl::StripAsciiWhitespace(line));
+    if (entry.empty() || entry[0] == '#') {
+      continue;
+    }
+    const fs::path entry_path(entry);
+    paths.push_back(entry_path.is_absolute()
+                        ? entry
+                        : (root.parent_path() / entry_path).string());
+  }
+  return paths;
+}
+
+int DetectNumDimensions(const string& opencl_src, const string& kernel_name) {
+  string body = FindFunctionBody(opencl_src, kernel_name);
+  if (body.empty()) {
+    body = opencl_src;
+  }
+
+  int num_dimensions = 1;
+  for (const char* function : kWorkItemFunctions) {
+    const string name(function);
+    for (size_t pos = body.find(name); pos != string::npos;
+         pos = body.find(name, pos + 1)) {
+      size_t arg = SkipWhitespace(body, pos + name.size());
+      if (arg >= body.size() || body[arg] != '(') {
+        continue;
+      }
+      arg = SkipWhitespace(body, arg + 1);
+      if (arg >= body.size() || body[arg] < '0' || body[arg] > '2') {
+        continue;
+      }
+      const int dimension = body[arg] - '0';
+      if (SkipWhitespace(body, arg + 1) < body.size() &&
+          body[SkipWhitespace(body, arg + 1)] == ')') {
+        num_dimensions = std::max(num_dimensions, dimension + 1);
+      }
+    }
+  }
+  return num_dimensions;
+}
+
+KernelSignature GetKernelSignature(cl::Kernel* kernel, const cl::Device& device,
+                                   const string& opencl_src) {
+  KernelSignature signature;
+  signature.set_name(util::GetOpenClKernelName(*kernel));
+
+  const cl_uint num_args = kernel->getInfo<CL_KERNEL_NUM_ARGS>();
+  for (cl_uint i = 0; i < num_args; ++i) {
+    KernelArgSignature* arg = signature.add_arg();
+    arg->set_name(util::GetKernelArgName(*kernel, i));
+
+    string type_name = util::GetKernelArgTypeName(*kernel, i);
+    arg->set_is_pointer(!type_name.empty() && type_name.back() == '*');
+    if (arg->is_pointer()) {
+      type_name.pop_back();
+    }
+    arg->set_type_name(type_name);
+
+    switch (kernel->getArgInfo<CL_KERNEL_ARG_ADDRESS_QUALIFIER>(i)) {
+      case CL_KERNEL_ARG_ADDRESS_GLOBAL:
+        arg->set_address_qualifier(KernelArgSignature::GLOBAL);
+        break;
+      case CL_KERNEL_ARG_ADDRESS_LOCAL:
+        arg->set_address_qualifier(KernelArgSignature::LOCAL);
+        break;
+      case CL_KERNEL_ARG_ADDRESS_CONSTANT:
+        arg->set_address_qualifier(KernelArgSignature::CONSTANT);
+        break;
+      default:
+        arg->set_address_qualifier(KernelArgSignature::PRIVATE);
+        break;
+    }
+
+    cl_kernel_arg_type_qualifier type_qualifier = 0;
+    kernel->getArgInfo(i, CL_KERNEL_ARG_TYPE_QUALIFIER, &type_qualifier);
+    arg->set_is_const(type_qualifier & CL_KERNEL_ARG_TYPE_CONST);
+    arg->set_is_restrict(type_qualifier & CL_KERNEL_ARG_TYPE_RESTRICT);
+    arg->set_is_volatile(type_qualifier & CL_KERNEL_ARG_TYPE_VOLATILE);
+  }
+
+  KernelArgSet args_set(kernel);
+  signature.set_outcome(args_set.Init());
+  signature.set_num_dimensions(
+      DetectNumDimensions(opencl_src, signature.name()));
+
+  const auto reqd_work_group_size =
+      kernel->getWorkGroupInfo<CL_KERNEL_COMPILE_WORK_GROUP_SIZE>(device);
+  if (reqd_work_group_size[0]) {
+    for (size_t i = 0; i < 3; ++i) {
+      signature.add_reqd_work_group_size(reqd_work_group_size[i]);
+    }
+  }
+  signature.set_attributes(kernel->getInfo<CL_KERNEL_ATTRIBUTES>());
+  signature.set_work_group_size(
+      kernel->getWorkGroupInfo<CL_KERNEL_WORK_GROUP_SIZE>(device));
+  signature.set_preferred_work_group_size_multiple(
+      kernel->getWorkGroupInfo<CL_KERNEL_PREFERRED_WORK_GROUP_SIZE_MULTIPLE>(
+          device));
+  signature.set_local_mem_size_in_bytes(
+      kernel->getWorkGroupInfo<CL_KERNEL_LOCAL_MEM_SIZE>(device));
+  signature.set_private_mem_size_in_bytes(
+      kernel->getWorkGroupInfo<CL_KERNEL_PRIVATE_MEM_SIZE>(device));
+  return signature;
+}
+
+void ExtractKernelSignatures(
+    const ::gpu::clinfo::OpenClDevice& device,
+    const std::vector<string>& paths, const string& build_opts,
+    int num_threads,
+    const std::function<void(const ProgramSignatures&)>& callback) {
+  const cl::Device cl_device =
+      labm8::gpu::clinfo::GetOpenClDeviceOrDie(device);
+  // OpenCL API calls other than clSetKernelArg() are thread safe, so
+  // programs are built concurrently on a single context.
+  const cl::Context context(cl_device);
+
+  // Sources are claimed in order by the worker threads, and their results
+  // passed to the callback in order by this thread.
+  std::vector<std::promise<ProgramSignatures>> results(paths.size());
+  labm8::Mutex mutex;
+  size_t next = 0;
+
+  std::vector<std::thread> threads;
+  for (int i = 0; i < std::max(num_threads, 1); ++i) {
+    threads.emplace_back([&]() {
+      while (true) {
+        size_t j;
+        {
+          labm8::MutexLock lock(&mutex);
+          if (next >= paths.size()) {
+            return;
+          }
+          j = next++;
+        }
+        ProgramSignatures signatures;
+        try {
+          signatures =
+              GetProgramSignatures(context, cl_device, paths[j], build_opts);
+        } catch (cl::Error error) {
+          LOG(WARNING) << "Error code " << error.err() << " ("
+                       << labm8::gpu::clinfo::OpenClErrorString(error.err())
+                       << ") raised by " << error.what() << "(): '"
+                       << paths[j] << "'";
+          signatures.Clear();
+          signatures.set_path(paths[j]);
+          signatures.set_outcome(ProgramSignatures::CL_ERROR);
+        }
+        signatures.set_device_name(device.name());
+        results[j].set_value(std::move(signatures));
+      }
+    });
+  }
+
+  for (auto& result : results) {
+    callback(result.get_future().get());
+  }
+
+  for (auto& thread : threads) {
+    thread.join();
+  }
+}
+
+}  // namespace cldrive
+}  // namespace gpu
@@ -0,0 +1,61 @@
+// Extract the signatures of the kernels of many OpenCL sources.
+//
+// Copyright (c) 2016-2020 Chris Cummins.
+// This file is part of cldrive.
+//
+// cldrive is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// cldrive is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with cldrive.  If not, see <https://www.gnu.org/licenses/>.
+#pragma once
+
+#include "gpu/cldrive/proto/cldrive.pb.h"
+#include "gpu/clinfo/proto/clinfo.pb.h"
+
+#include "labm8/cpp/statusor.h"
+#include "labm8/cpp/string.h"
+#include "third_party/opencl/cl.hpp"
+
+#include <functional>
+#include <vector>
+
+namespace gpu {
+namespace cldrive {
+
+// Return the paths of the OpenCL sources named by path. If path is a
+// directory, these are the '.cl' files beneath it, in sorted order. Else path
+// is a manifest file of one path per line. Blank lines and lines starting with
+// '#' are ignored, and relative paths are relative to the manifest's
+// directory. Returns NOT_FOUND if path does not exist.
+labm8::StatusOr<std::vector<string>> ListKernelSources(const string& path);
+
+// Return the number of dimensions which a kernel indexes: one more than the
+// highest dimension passed as a literal to a work-item function, such as
+// get_global_id(1), in the kernel's body. If the kernel's definition cannot
+// be found in opencl_src, the whole source is searched. Calls made by helper
+// functions of the kernel are not seen. Returns at least one.
+int DetectNumDimensions(const string& opencl_src, const string& kernel_name);
+
+// Return the signature of a kernel compiled for device from opencl_src.
+KernelSignature GetKernelSignature(cl::Kernel* kernel, const cl::Device& device,
+                                   const string& opencl_src);
+
+// Build each of the sources at paths on a single context for device, using
+// num_threads threads, and call callback with the kernel signatures of each
+// source, in the order of paths. Callbacks are made from the calling thread.
+void ExtractKernelSignatures(
+    const ::gpu::clinfo::OpenClDevice& device,
+    const std::vector<string>& paths, const string& build_opts,
+    int num_threads,
+    const std::function<void(const ProgramSignatures&)>& callback);
+
+}  // namespace cldrive
+}  // namespace gpu
@@ -0,0 +1,182 @@
+// Copyright (c) 2016-2020 Chris Cummins.
+// This file is part of cldrive.
+//
+// cldrive is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// cldrive is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with cldrive.  If not, see <https://www.gnu.org/licenses/>.
+#include "gpu/cldrive/kernel_signature.h"
+
+#include "gpu/clinfo/libclinfo.h"
+
+#include "labm8/cpp/logging.h"
+#include "labm8/cpp/test.h"
+
+#include <stdlib.h>
+#include <fstream>
+
+namespace gpu {
+namespace cldrive {
+namespace {
+
+string MakeTemporaryDirectory() {
+  char path[] = "/tmp/kernel_signature_test_XXXXXX";
+  CHECK(mkdtemp(path));
+  return path;
+}
+
+void WriteFile(const string& path, const string& contents) {
+  std::ofstream file(path);
+  file << contents;
+}
+
+TEST(ListKernelSources, DirectoryIsSearchedRecursively) {
+  const string root = MakeTemporaryDirectory();
+  CHECK(!system(("mkdir " + root + "/sub").c_str()));
+  WriteFile(root + "/b.cl", "");
+  WriteFile(root + "/a.cl", "");
+  WriteFile(root + "/sub/c.cl", "");
+  WriteFile(root + "/README", "");
+
+  auto paths_or = ListKernelSources(root);
+  ASSERT_TRUE(paths_or.ok());
+  const auto paths = paths_or.ValueOrDie();
+  ASSERT_EQ(paths.size(), 3);
+  EXPECT_EQ(paths[0], root + "/a.cl");
+  EXPECT_EQ(paths[1], root + "/b.cl");
+  EXPECT_EQ(paths[2], root + "/sub/c.cl");
+}
+
+TEST(ListKernelSources, ManifestPathsAreRelativeToManifest) {
+  const string root = MakeTemporaryDirectory();
+  WriteFile(root + "/manifest.txt", "# Comment\na.cl\n\n  /abs/b.cl  \n");
+
+  auto paths_or = ListKernelSources(root + "/manifest.txt");
+  ASSERT_TRUE(paths_or.ok());
+  const auto paths = paths_or.ValueOrDie();
+  ASSERT_EQ(paths.size(), 2);
+  EXPECT_EQ(paths[0], root + "/a.cl");
+  EXPECT_EQ(paths[1], "/abs/b.cl");
+}
+
+TEST(ListKernelSources, MissingPathIsNotFound) {
+  auto paths_or = ListKernelSources("/not/a/real/path");
+  ASSERT_FALSE(paths_or.ok());
+  EXPECT_EQ(paths_or.status().code(), labm8::error::Code::NOT_FOUND);
+}
+
+TEST(DetectNumDimensions, NoWorkItemFunctions) {
+  EXPECT_EQ(DetectNumDimensions("kernel void A() {}", "A"), 1);
+}
+
+TEST(DetectNumDimensions, HighestDimensionIsUsed) {
+  EXPECT_EQ(DetectNumDimensions("kernel void A(global int* a) {\n"
+                                "  a[get_global_id(0)] = get_local_size( 1 );\n"
+                                "}",
+                                "A"),
+            2);
+  EXPECT_EQ(DetectNumDimensions(
+                "kernel void A(global int* a) { a[0] = get_group_id(2); }",
+                "A"),
+            3);
+}
+
+TEST(DetectNumDimensions, NonLiteralDimensionsAreIgnored) {
+  EXPECT_EQ(DetectNumDimensions(
+                "kernel void A(global int* a, int d) {\n"
+                "  a[get_global_id(d)] = get_global_id(1 + d);\n"
+                "}",
+                "A"),
+            1);
+}
+
+TEST(DetectNumDimensions, OnlyTheNamedKernelIsSearched) {
+  const string src =
+      "kernel void A(global int* a) { a[get_global_id(2)] = 0; }\n"
+      "kernel void AB(global int* a) { a[get_global_id(1)] = 0; }\n"
+      "kernel void B(global int* a) { a[get_global_id(0)] = 0; }\n";
+  EXPECT_EQ(DetectNumDimensions(src, "A"), 3);
+  EXPECT_EQ(DetectNumDimensions(src, "AB"), 2);
+  EXPECT_EQ(DetectNumDimensions(src, "B"), 1);
+}
+
+TEST(DetectNumDimensions, AttributesAreSkipped) {
+  EXPECT_EQ(DetectNumDimensions(
+                "kernel void A(global int* a)\n"
+                "    __attribute__((reqd_work_group_size(8, 8, 1))) {\n"
+                "  a[get_global_id(1)] = 0;\n"
+                "}",
+                "A"),
+            2);
+}
+
+TEST(DetectNumDimensions, UnknownKernelSearchesWholeSource) {
+  EXPECT_EQ(DetectNumDimensions("#define X get_global_id(1)", "A"), 2);
+}
+
+TEST(ExtractKernelSignatures, SignaturesAreInPathOrder) {
+  const string root = MakeTemporaryDirectory();
+  WriteFile(root + "/a.cl",
+            "kernel void A(const global float* restrict a, local int* b,\n"
+            "              const int c)\n"
+            "    __attribute__((reqd_work_group_size(4, 2, 1))) {\n"
+            "  b[0] = a[get_global_id(1)] + c;\n"
+            "}\n");
+  WriteFile(root + "/b.cl", "kernel void B(global int* a) {");
+  WriteFile(root + "/c.cl", "int C() { return 0; }");
+  const std::vector<string> paths = {root + "/a.cl", root + "/b.cl",
+                                     root + "/c.cl", root + "/d.cl"};
+
+  std::vector<ProgramSignatures> results;
+  ExtractKernelSignatures(
+      labm8::gpu::clinfo::GetOpenClDevices().device(0), paths, "",
+      /*num_threads=*/3,
+      [&](const ProgramSignatures& signatures) {
+        results.push_back(signatures);
+      });
+
+  ASSERT_EQ(results.size(), 4);
+  EXPECT_EQ(results[0].path(), paths[0]);
+  EXPECT_EQ(results[0].outcome(), ProgramSignatures::PASS);
+  EXPECT_EQ(results[1].outcome(),
+            ProgramSignatures::PROGRAM_COMPILATION_FAILURE);
+  EXPECT_EQ(results[2].outcome(), ProgramSignatures::NO_KERNELS_IN_PROGRAM);
+  EXPECT_EQ(results[3].outcome(), ProgramSignatures::READ_FAILURE);
+
+  ASSERT_EQ(results[0].kernel_size(), 1);
+  const KernelSignature& kernel = results[0].kernel(0);
+  EXPECT_EQ(kernel.name(), "A");
+  EXPECT_EQ(kernel.outcome(), CldriveKernelInstance::PASS);
+  EXPECT_EQ(kernel.num_dimensions(), 2);
+  ASSERT_EQ(kernel.reqd_work_group_size_size(), 3);
+  EXPECT_EQ(kernel.reqd_work_group_size(0), 4);
+  EXPECT_EQ(kernel.reqd_work_group_size(1), 2);
+  EXPECT_EQ(kernel.reqd_work_group_size(2), 1);
+
+  ASSERT_EQ(kernel.arg_size(), 3);
+  EXPECT_EQ(kernel.arg(0).name(), "a");
+  EXPECT_EQ(kernel.arg(0).type_name(), "float");
+  EXPECT_TRUE(kernel.arg(0).is_pointer());
+  EXPECT_EQ(kernel.arg(0).address_qualifier(), KernelArgSignature::GLOBAL);
+  EXPECT_TRUE(kernel.arg(0).is_const());
+  EXPECT_TRUE(kernel.arg(0).is_restrict());
+  EXPECT_EQ(kernel.arg(1).address_qualifier(), KernelArgSignature::LOCAL);
+  EXPECT_FALSE(kernel.arg(1).is_const());
+  EXPECT_EQ(kernel.arg(2).type_name(), "int");
+  EXPECT_FALSE(kernel.arg(2).is_pointer());
+  EXPECT_EQ(kernel.arg(2).address_qualifier(), KernelArgSignature::PRIVATE);
+}
+
+}  // anonymous namespace
+}  // namespace cldrive
+}  // namespace gpu
+
+TEST_MAIN();
@@ -17,87 +17,73 @@
 
 #include "gpu/cldrive/kernel_arg_value.h"
 #include "gpu/cldrive/kernel_driver.h"
+#include "gpu/cldrive/watchdog.h"
 #include "gpu/clinfo/libclinfo.h"
 
 #include "labm8/cpp/logging.h"
 #include "labm8/cpp/status.h"
 #include "labm8/cpp/statusor.h"
 
-#include "absl/strings/str_cat.h"
-#include "absl/strings/str_format.h"
-#include "absl/strings/strip.h"
-#include "absl/time/clock.h"
-#include "absl/time/time.h"
-
-#define LOG_CL_ERROR(level, error)                                  \
-  LOG(level) << "OpenCL exception: " << error.what() << ", error: " \
-             << labm8::gpu::clinfo::OpenClErrorString(error.err());
+#include <cstdio>
 
 namespace gpu {
 namespace cldrive {
 
-namespace {
-
-// Attempt to build OpenCL program.
-labm8::StatusOr<cl::Program> BuildOpenClProgram(
-    const std::string& opencl_kernel, const cl::Context& context,
-    const string& cl_build_opts) {
-  auto start_time = absl::Now();
-  try {
-    // Assemble the build options. We need -cl-kernel-arg-info so that we can
-    // read the kernel signatures.
-    string all_build_opts = "-cl-kernel-arg-info ";
-    absl::StrAppend(&all_build_opts, cl_build_opts);
-    labm8::TrimRight(all_build_opts);
-
-    cl::Program program(context, opencl_kernel);
-    program.build(context.getInfo<CL_CONTEXT_DEVICES>(),
-                  all_build_opts.c_str());
-    auto end_time = absl::Now();
-    auto duration = (end_time - start_time) / absl::Milliseconds(1);
-    LOG(INFO) << "clBuildProgram() with options '" << all_build_opts
-              << "' completed in " << duration << " ms";
-    
-    return program;
-  } catch (cl::Error e) {
-    LOG_CL_ERROR(WARNING, e);
-    return labm8::Status(labm8::error::Code::INVALID_ARGUMENT,
-                         "clBuildProgram failed");
-  }
-}
-
-}  // namespace
-
 Cldrive::Cldrive(CldriveInstance* instance, int instance_num)
     : instance_(instance),
       instance_num_(instance_num),
-      device_(labm8::gpu::clinfo::GetOpenClDeviceOrDie(instance->device())) {}
+      owned_session_(std::make_unique<CldriveSession>()),
+      session_(owned_session_.get()),
+      device_state_(session_->GetDeviceStateOrDie(instance->device())) {}
 
-void Cldrive::RunOrDie(Logger& logger) {
+Cldrive::Cldrive(CldriveInstance* instance, CldriveSession* session,
+                 int instance_num)
+    : instance_(instance),
+      instance_num_(instance_num),
+      session_(session),
+      device_state_(session_->GetDeviceStateOrDie(instance->device())) {}
+
+labm8::Status Cldrive::Run(Logger& logger) {
   try {
     DoRunOrDie(logger);
   } catch (cl::Error error) {
+    instance_->set_outcome(CldriveInstance::CL_ERROR);
+    return labm8::Status(
+        labm8::error::Code::INTERNAL, "Error code {} ({}) raised by {}()",
+        error.err(), labm8::gpu::clinfo::OpenClErrorString(error.err()),
+        error.what());
+  }
+  return labm8::Status::OK;
+}
+
+void Cldrive::RunOrDie(Logger& logger) {
+  labm8::Status status = Run(logger);
+  if (!status.ok()) {
     LOG(FATAL) << "Unhandled OpenCL exception.\n"
-               << "    Raised by:  " << error.what() << '\n'
-               << "    Error code: " << error.err() << " ("
-               << labm8::gpu::clinfo::OpenClErrorString(error.err()) << ")\n"
+               << "    " << status.error_message() << '\n'
                << "This is a bug! Please report to "
                << "<https://github.com/ChrisCummins/cldrive/issues>.";
   }
 }
 
 void Cldrive::DoRunOrDie(Logger& logger) {
-  cl::Context context(device_);
-  cl::CommandQueue queue(context,
-                         /*devices=*/context.getInfo<CL_CONTEXT_DEVICES>()[0],
-                         /*properties=*/CL_QUEUE_PROFILING_ENABLE);
+  const cl::Context& context = device_state_->context;
+  const cl::CommandQueue& queue = device_state_->queue;
 
   // Compile program or fail.
-  labm8::StatusOr<cl::Program> program_or = BuildOpenClProgram(
-      string(instance_->opencl_src()), context, instance_->build_opts());
+  labm8::StatusOr<cl::Program> program_or = session_->GetProgram(
+      device_state_, instance_->opencl_src(), instance_->build_opts(),
+      instance_->compile_timeout_ms());
   if (!program_or.ok()) {
-    LOG(ERROR) << "OpenCL program compilation failed!";
-    instance_->set_outcome(CldriveInstance::PROGRAM_COMPILATION_FAILURE);
+    if (program_or.status().code() ==
+        labm8::error::Code::DEADLINE_EXCEEDED) {
+      LOG(ERROR) << "OpenCL program compilation exceeded its time budget of "
+                 << instance_->compile_timeout_ms() << " ms!";
+      instance_->set_outcome(CldriveInstance::COMPILE_TIMEOUT);
+    } else {
+      LOG(ERROR) << "OpenCL program compilation failed!";
+      instance_->set_outcome(CldriveInstance::PROGRAM_COMPILATION_FAILURE);
+    }
     logger.RecordLog(instance_, /*kernel_instance=*/nullptr, /*run=*/nullptr,
                      /*log=*/nullptr);
     return;
@@ -114,9 +100,35 @@ void Cldrive::DoRunOrDie(Logger& logger) {
     return;
   }
 
+  // The watchdog flushes the logger as soon as a time budget runs out, so
+  // that the results so far are kept even if a run never returns. It runs on
+  // its own thread, so the kernels are then logged through a thread-safe
+  // logger.
+  ThreadSafeLogger watched_logger(&logger);
+  std::unique_ptr<Watchdog> watchdog;
+  if (instance_->run_timeout_ms() > 0 || instance_->config_timeout_ms() > 0) {
+    watchdog = std::make_unique<Watchdog>(
+        [&watched_logger](CldriveKernelRun::TimeoutPhase phase) {
+          LOG(WARNING) << "Time budget exceeded in phase "
+                       << CldriveKernelRun::TimeoutPhase_Name(phase);
+          watched_logger.Flush();
+          std::fflush(nullptr);
+        });
+  }
+
+  DeviceBufferHasher* hasher = instance_->check_outputs()
+                                   ? session_->GetBufferHasher(device_state_)
+                                   : nullptr;
+
   for (auto& kernel : kernels) {
-    KernelDriver(context, queue, kernel, instance_, instance_num_)
-        .RunOrDie(logger);
+    KernelDriver driver(context, queue, kernel, instance_, instance_num_,
+                        device_state_->buffer_pool.get(), watchdog.get(),
+                        hasher);
+    driver.RunOrDie(watchdog ? watched_logger : logger);
+    // A driver replaces its queue if a launch config times out.
+    if (driver.queue()() != queue()) {
+      device_state_->queue = driver.queue();
+    }
   }
 
   instance_->set_outcome(CldriveInstance::PASS);
@@ -17,6 +17,9 @@
 
 #include "gpu/cldrive/logger.h"
 #include "gpu/cldrive/proto/cldrive.pb.h"
+#include "gpu/cldrive/session.h"
+
+#include "labm8/cpp/status.h"
 
 #include "third_party/opencl/cl.hpp"
 
@@ -27,6 +30,15 @@ class Cldrive {
  public:
   Cldrive(CldriveInstance* instance, int instance_num = 0);
 
+  // Construct a driver which reuses the contexts, queues, and compiled
+  // programs of a session. The session must outlive the driver.
+  Cldrive(CldriveInstance* instance, CldriveSession* session,
+          int instance_num = 0);
+
+  // Run the instance. If an OpenCL error is raised that the driver does not
+  // handle, the instance outcome is CL_ERROR and an error status is returned.
+  labm8::Status Run(Logger& logger);
+
   void RunOrDie(Logger& logger);
 
  private:
@@ -34,7 +46,10 @@ class Cldrive {
 
   CldriveInstance* instance_;
   int instance_num_;
-  cl::Device device_;
+  // Set if the driver was constructed without a session.
+  std::unique_ptr<CldriveSession> owned_session_;
+  CldriveSession* session_;
+  DeviceState* device_state_;
 };
 
 // void ProcessCldriveInstancesOrDie(CldriveInstances* instance);
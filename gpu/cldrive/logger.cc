@@ -16,12 +16,19 @@
 #include "gpu/cldrive/logger.h"
 #include "labm8/cpp/logging.h"
 
+#include "google/protobuf/util/delimited_message_util.h"
+
 namespace gpu {
 namespace cldrive {
 
 Logger::Logger(std::ostream& ostream, const CldriveInstances* const instances)
     : ostream_(ostream), instances_(instances), instance_num_(-1) {}
 
+Logger::Logger(Logger* logger)
+    : ostream_(logger->ostream_),
+      instances_(logger->instances_),
+      instance_num_(-1) {}
+
 /*virtual*/ labm8::Status Logger::StartNewInstance() {
   ++instance_num_;
   return labm8::Status::OK;
@@ -36,16 +43,45 @@ Logger::Logger(std::ostream& ostream, const CldriveInstances* const instances)
   return labm8::Status::OK;
 }
 
-void Logger::PrintAndClearBuffer() {
-  ostream_ << buffer_.str();
-  ClearBuffer();
+/*virtual*/ labm8::Status Logger::RecordRunSummary(
+    const CldriveInstance* const instance,
+    const CldriveKernelInstance* const kernel_instance,
+    const CldriveKernelRun* const run,
+    const gpu::libcecl::OpenClKernelInvocation* const log) {
+  CHECK(instance_num() >= 0);
+  return labm8::Status::OK;
 }
 
+/*virtual*/ labm8::Status Logger::RecordKernelRun(
+    const CldriveInstance* const instance,
+    const CldriveKernelInstance* const kernel_instance,
+    const CldriveKernelRun* const run) {
+  CHECK(instance_num() >= 0);
+  return labm8::Status::OK;
+}
+
+void Logger::PrintAndClearBuffer() { PrintBuffered(TakeBuffer()); }
+
 void Logger::ClearBuffer() {
   buffer_.clear();
   buffer_.str(string());
 }
 
+string Logger::TakeBuffer() {
+  string contents = buffer_.str();
+  ClearBuffer();
+  return contents;
+}
+
+/*virtual*/ void Logger::PrintBuffered(const string& buffered) {
+  ostream_ << buffered;
+}
+
+/*virtual*/ void Logger::Flush() {
+  PrintAndClearBuffer();
+  ostream_.flush();
+}
+
 const CldriveInstances* Logger::instances() { return instances_; }
 
 std::ostream& Logger::ostream(bool flush) {
@@ -73,6 +109,64 @@ ProtocolBufferLogger::ProtocolBufferLogger(
   }
 }
 
+DelimitedProtocolBufferLogger::DelimitedProtocolBufferLogger(
+    std::ostream& ostream, const CldriveInstances* const instances)
+    : Logger(ostream, instances) {}
+
+/*virtual*/ labm8::Status DelimitedProtocolBufferLogger::RecordLog(
+    const CldriveInstance* const instance,
+    const CldriveKernelInstance* const kernel_instance,
+    const CldriveKernelRun* const run,
+    const gpu::libcecl::OpenClKernelInvocation* const log, bool flush) {
+  // Logs without a run are of instances or kernels which could not be run.
+  // Runs are written by RecordKernelRun() once they complete.
+  if (run) {
+    return labm8::Status::OK;
+  }
+  return WriteResult(instance, kernel_instance, /*run=*/nullptr);
+}
+
+/*virtual*/ labm8::Status DelimitedProtocolBufferLogger::RecordKernelRun(
+    const CldriveInstance* const instance,
+    const CldriveKernelInstance* const kernel_instance,
+    const CldriveKernelRun* const run) {
+  return WriteResult(instance, kernel_instance, run);
+}
+
+labm8::Status DelimitedProtocolBufferLogger::WriteResult(
+    const CldriveInstance* const instance,
+    const CldriveKernelInstance* const kernel_instance,
+    const CldriveKernelRun* const run) {
+  CHECK(instance) << "CldriveInstance pointer cannot be null";
+  CldriveResult result;
+  result.set_instance_num(instance_num());
+  *result.mutable_device() = instance->device();
+  result.set_build_opts(instance->build_opts());
+  result.set_instance_outcome(instance->outcome());
+  if (kernel_instance) {
+    CldriveKernelInstance* kernel = result.mutable_kernel();
+    kernel->set_name(kernel_instance->name());
+    kernel->set_outcome(kernel_instance->outcome());
+    kernel->set_work_item_local_mem_size_in_bytes(
+        kernel_instance->work_item_local_mem_size_in_bytes());
+    kernel->set_work_item_private_mem_size_in_bytes(
+        kernel_instance->work_item_private_mem_size_in_bytes());
+    if (run) {
+      *kernel->add_run() = *run;
+    }
+  }
+
+  // Each result is flushed, so that results are not lost if the process is
+  // killed.
+  std::ostream& stream = ostream(/*flush=*/true);
+  if (!google::protobuf::util::SerializeDelimitedToOstream(result, &stream) ||
+      !stream.flush()) {
+    return labm8::Status(labm8::error::Code::UNAVAILABLE,
+                         "Failed to write result");
+  }
+  return labm8::Status::OK;
+}
+
 CsvLogger::CsvLogger(std::ostream& ostream,
                      const CldriveInstances* const instances)
     : Logger(ostream, instances) {
@@ -89,6 +183,100 @@ CsvLogger::CsvLogger(std::ostream& ostream,
   return labm8::Status::OK;
 }
 
+CsvSummaryLogger::CsvSummaryLogger(std::ostream& ostream,
+                                   const CldriveInstances* const instances)
+    : Logger(ostream, instances) {
+  this->ostream(/*flush=*/true) << CsvSummaryLogHeader();
+}
+
+/*virtual*/ labm8::Status CsvSummaryLogger::RecordLog(
+    const CldriveInstance* const instance,
+    const CldriveKernelInstance* const kernel_instance,
+    const CldriveKernelRun* const run,
+    const gpu::libcecl::OpenClKernelInvocation* const log, bool flush) {
+  // The logs of completed runs are summarized by RecordRunSummary(). A
+  // negative transferred_bytes marks the log of a run which failed.
+  if (run && log && log->transferred_bytes() >= 0) {
+    return labm8::Status::OK;
+  }
+  ostream(flush) << CsvSummaryLog::FromProtos(instance_num(), instance,
+                                              kernel_instance, run, log);
+  return labm8::Status::OK;
+}
+
+/*virtual*/ labm8::Status CsvSummaryLogger::RecordRunSummary(
+    const CldriveInstance* const instance,
+    const CldriveKernelInstance* const kernel_instance,
+    const CldriveKernelRun* const run,
+    const gpu::libcecl::OpenClKernelInvocation* const log) {
+  ostream(/*flush=*/true) << CsvSummaryLog::FromProtos(
+      instance_num(), instance, kernel_instance, run, log);
+  return labm8::Status::OK;
+}
+
+ColumnarLogger::ColumnarLogger(std::ostream& ostream,
+                               const CldriveInstances* const instances,
+                               int64_t flush_interval_ms)
+    : Logger(ostream, instances),
+      flush_interval_(flush_interval_ms),
+      last_print_(std::chrono::steady_clock::now()) {}
+
+/*virtual*/ ColumnarLogger::~ColumnarLogger() {
+  ostream(/*flush=*/true) << block_;
+}
+
+/*virtual*/ labm8::Status ColumnarLogger::RecordLog(
+    const CldriveInstance* const instance,
+    const CldriveKernelInstance* const kernel_instance,
+    const CldriveKernelRun* const run,
+    const gpu::libcecl::OpenClKernelInvocation* const log, bool flush) {
+  auto row = ColumnarLogRow::FromProtos(instance_num(), instance,
+                                        kernel_instance, run, log);
+  if (flush) {
+    AddRow(row);
+  } else {
+    // Buffered rows are encoded one at a time, and added to the block when
+    // the buffer is printed.
+    string encoded;
+    row.AppendTo(&encoded);
+    ostream(/*flush=*/false).write(encoded.data(), encoded.size());
+  }
+  return labm8::Status::OK;
+}
+
+/*virtual*/ void ColumnarLogger::PrintBuffered(const string& buffered) {
+  size_t pos = 0;
+  while (pos < buffered.size()) {
+    ColumnarLogRow row(/*instance_id=*/0);
+    CHECK(ColumnarLogRow::ReadFrom(buffered, &pos, &row))
+        << "Truncated columnar log buffer";
+    AddRow(row);
+  }
+}
+
+/*virtual*/ void ColumnarLogger::Flush() {
+  Logger::Flush();
+  if (block_.size()) {
+    PrintBlock();
+  }
+  ostream(/*flush=*/true).flush();
+}
+
+void ColumnarLogger::AddRow(const ColumnarLogRow& row) {
+  block_.AddRow(row);
+  if (block_.size() >= kColumnarLogBlockRows ||
+      std::chrono::steady_clock::now() - last_print_ >= flush_interval_) {
+    PrintBlock();
+    ostream(/*flush=*/true).flush();
+  }
+}
+
+void ColumnarLogger::PrintBlock() {
+  ostream(/*flush=*/true) << block_;
+  block_.Clear();
+  last_print_ = std::chrono::steady_clock::now();
+}
+
 NULLLogger::NULLLogger(std::ostream& ostream,
                      const CldriveInstances* const instances)
     : Logger(ostream, instances) {
@@ -107,5 +295,101 @@ NULLLogger::NULLLogger(std::ostream& ostream,
   return labm8::Status::OK;
 }
 
+ThreadSafeLogger::ThreadSafeLogger(Logger* logger)
+    : Logger(logger), logger_(logger) {}
+
+/*virtual*/ labm8::Status ThreadSafeLogger::StartNewInstance() {
+  labm8::MutexLock lock(&mutex_);
+  return logger_->StartNewInstance();
+}
+
+/*virtual*/ labm8::Status ThreadSafeLogger::RecordLog(
+    const CldriveInstance* const instance,
+    const CldriveKernelInstance* const kernel_instance,
+    const CldriveKernelRun* const run,
+    const gpu::libcecl::OpenClKernelInvocation* const log, bool flush) {
+  labm8::MutexLock lock(&mutex_);
+  if (flush) {
+    return logger_->RecordLog(instance, kernel_instance, run, log, flush);
+  }
+
+  // Format the log into the underlying logger's buffer, then move it to this
+  // thread's buffer.
+  labm8::Status status =
+      logger_->RecordLog(instance, kernel_instance, run, log, flush);
+  buffers_[std::this_thread::get_id()] += logger_->TakeBuffer();
+  return status;
+}
+
+/*virtual*/ labm8::Status ThreadSafeLogger::RecordRunSummary(
+    const CldriveInstance* const instance,
+    const CldriveKernelInstance* const kernel_instance,
+    const CldriveKernelRun* const run,
+    const gpu::libcecl::OpenClKernelInvocation* const log) {
+  labm8::MutexLock lock(&mutex_);
+  return logger_->RecordRunSummary(instance, kernel_instance, run, log);
+}
+
+/*virtual*/ labm8::Status ThreadSafeLogger::RecordKernelRun(
+    const CldriveInstance* const instance,
+    const CldriveKernelInstance* const kernel_instance,
+    const CldriveKernelRun* const run) {
+  labm8::MutexLock lock(&mutex_);
+  return logger_->RecordKernelRun(instance, kernel_instance, run);
+}
+
+/*virtual*/ void ThreadSafeLogger::PrintAndClearBuffer() {
+  labm8::MutexLock lock(&mutex_);
+  auto it = buffers_.find(std::this_thread::get_id());
+  if (it != buffers_.end()) {
+    logger_->PrintBuffered(it->second);
+    buffers_.erase(it);
+  }
+}
+
+/*virtual*/ void ThreadSafeLogger::ClearBuffer() {
+  labm8::MutexLock lock(&mutex_);
+  buffers_.erase(std::this_thread::get_id());
+}
+
+/*virtual*/ void ThreadSafeLogger::Flush() {
+  labm8::MutexLock lock(&mutex_);
+  for (const auto& buffer : buffers_) {
+    logger_->PrintBuffered(buffer.second);
+  }
+  buffers_.clear();
+  logger_->Flush();
+}
+
+void RecordInstance(const CldriveInstance& instance, Logger* logger) {
+  if (instance.outcome() != CldriveInstance::PASS &&
+      instance.outcome() != CldriveInstance::NO_KERNELS_IN_PROGRAM) {
+    logger->RecordLog(&instance, /*kernel_instance=*/nullptr, /*run=*/nullptr,
+                      /*log=*/nullptr);
+    return;
+  }
+
+  for (const auto& kernel : instance.kernel()) {
+    if (kernel.outcome() != CldriveKernelInstance::PASS) {
+      logger->RecordLog(&instance, &kernel, /*run=*/nullptr, /*log=*/nullptr);
+      continue;
+    }
+    for (const auto& run : kernel.run()) {
+      for (const auto& log : run.log()) {
+        logger->RecordLog(&instance, &kernel, &run, &log);
+      }
+      const gpu::libcecl::OpenClKernelInvocation* const first_log =
+          run.log_size() ? &run.log(0) : nullptr;
+      if (run.outcome() != CldriveKernelRun::PASS) {
+        logger->RecordLog(&instance, &kernel, &run, /*log=*/nullptr);
+      }
+      if (run.has_kernel_time_summary() && first_log) {
+        logger->RecordRunSummary(&instance, &kernel, &run, first_log);
+      }
+      logger->RecordKernelRun(&instance, &kernel, &run);
+    }
+  }
+}
+
 }  // namespace cldrive
 }  // namespace gpu
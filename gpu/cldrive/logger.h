@@ -15,13 +15,18 @@
 // along with cldrive.  If not, see <https://www.gnu.org/licenses/>.
 #pragma once
 
+#include "gpu/cldrive/columnar_log.h"
 #include "gpu/cldrive/csv_log.h"
 #include "gpu/cldrive/proto/cldrive.pb.h"
 
+#include "labm8/cpp/mutex.h"
 #include "labm8/cpp/status.h"
 
+#include <chrono>
 #include <iostream>
+#include <map>
 #include <sstream>
+#include <thread>
 
 namespace gpu {
 namespace cldrive {
@@ -43,10 +48,38 @@ class Logger {
       const CldriveKernelRun* const run,
       const gpu::libcecl::OpenClKernelInvocation* const log, bool flush = true);
 
-  void PrintAndClearBuffer();
-  void ClearBuffer();
+  // Record the summary of the runs of a kernel and launch config, once they
+  // have all completed. The log holds the launch config and arguments.
+  virtual labm8::Status RecordRunSummary(
+      const CldriveInstance* const instance,
+      const CldriveKernelInstance* const kernel_instance,
+      const CldriveKernelRun* const run,
+      const gpu::libcecl::OpenClKernelInvocation* const log);
+
+  // Record a run of a kernel with a launch config, once it has completed.
+  virtual labm8::Status RecordKernelRun(
+      const CldriveInstance* const instance,
+      const CldriveKernelInstance* const kernel_instance,
+      const CldriveKernelRun* const run);
+
+  virtual void PrintAndClearBuffer();
+  virtual void ClearBuffer();
+
+  // Remove and return the contents of the buffer.
+  string TakeBuffer();
+
+  // Print the contents of a buffer returned by TakeBuffer().
+  virtual void PrintBuffered(const string& buffered);
+
+  // Print the buffer and any other output which is held back, and flush the
+  // stream, so that the logs recorded so far survive the process being
+  // killed.
+  virtual void Flush();
 
  protected:
+  // Construct a logger which writes to the same stream as another.
+  explicit Logger(Logger* logger);
+
   const CldriveInstances* instances();
   std::ostream& ostream(bool flush);
   int instance_num() const;
@@ -58,7 +91,8 @@ class Logger {
   int instance_num_;
 };
 
-// Logging interface for producing protocol buffers.
+// Logging interface for producing protocol buffers. The instances are written
+// when the logger is destroyed, so Flush() writes nothing.
 class ProtocolBufferLogger : public Logger {
  public:
   ProtocolBufferLogger(std::ostream& ostream,
@@ -71,6 +105,32 @@ class ProtocolBufferLogger : public Logger {
   bool text_format_ = text_format_;
 };
 
+// Logging interface for streaming length-delimited CldriveResult protocol
+// buffers. A result is written for each completed run as soon as it is
+// recorded, and for each kernel or instance which could not be run.
+class DelimitedProtocolBufferLogger : public Logger {
+ public:
+  DelimitedProtocolBufferLogger(std::ostream& ostream,
+                                const CldriveInstances* const instances);
+
+  virtual labm8::Status RecordLog(
+      const CldriveInstance* const instance,
+      const CldriveKernelInstance* const kernel_instance,
+      const CldriveKernelRun* const run,
+      const gpu::libcecl::OpenClKernelInvocation* const log,
+      bool flush) override;
+
+  virtual labm8::Status RecordKernelRun(
+      const CldriveInstance* const instance,
+      const CldriveKernelInstance* const kernel_instance,
+      const CldriveKernelRun* const run) override;
+
+ private:
+  labm8::Status WriteResult(const CldriveInstance* const instance,
+                            const CldriveKernelInstance* const kernel_instance,
+                            const CldriveKernelRun* const run);
+};
+
 class CsvLogger : public Logger {
  public:
   CsvLogger(std::ostream& ostream, const CldriveInstances* const instances);
@@ -83,6 +143,65 @@ class CsvLogger : public Logger {
       bool flush) override;
 };
 
+// A CSV logger which emits one row per kernel and launch config, summarizing
+// the runs, in place of one row per run. Failures are emitted as they occur.
+class CsvSummaryLogger : public Logger {
+ public:
+  CsvSummaryLogger(std::ostream& ostream,
+                   const CldriveInstances* const instances);
+
+  virtual labm8::Status RecordLog(
+      const CldriveInstance* const instance,
+      const CldriveKernelInstance* const kernel_instance,
+      const CldriveKernelRun* const run,
+      const gpu::libcecl::OpenClKernelInvocation* const log,
+      bool flush) override;
+
+  virtual labm8::Status RecordRunSummary(
+      const CldriveInstance* const instance,
+      const CldriveKernelInstance* const kernel_instance,
+      const CldriveKernelRun* const run,
+      const gpu::libcecl::OpenClKernelInvocation* const log) override;
+};
+
+// The longest time that the columnar logger holds rows back, in
+// milliseconds.
+constexpr int64_t kColumnarLogFlushIntervalMs = 1000;
+
+// Logging interface for producing the columnar binary format of
+// columnar_log.h. Rows are printed in blocks of up to kColumnarLogBlockRows.
+// A partial block is printed once flush_interval_ms has passed since the last
+// block was printed, so that a process which is killed loses at most the rows
+// of that interval, and the final block when the logger is destroyed.
+class ColumnarLogger : public Logger {
+ public:
+  ColumnarLogger(std::ostream& ostream,
+                 const CldriveInstances* const instances,
+                 int64_t flush_interval_ms = kColumnarLogFlushIntervalMs);
+
+  virtual ~ColumnarLogger();
+
+  virtual labm8::Status RecordLog(
+      const CldriveInstance* const instance,
+      const CldriveKernelInstance* const kernel_instance,
+      const CldriveKernelRun* const run,
+      const gpu::libcecl::OpenClKernelInvocation* const log,
+      bool flush) override;
+
+  virtual void PrintBuffered(const string& buffered) override;
+
+  // Also prints the rows of the partial block.
+  virtual void Flush() override;
+
+ private:
+  void AddRow(const ColumnarLogRow& row);
+  void PrintBlock();
+
+  ColumnarLogBlock block_;
+  const std::chrono::milliseconds flush_interval_;
+  std::chrono::steady_clock::time_point last_print_;
+};
+
 class NULLLogger : public Logger {
  public:
   NULLLogger(std::ostream& ostream, const CldriveInstances* const instances);
@@ -95,5 +214,53 @@ class NULLLogger : public Logger {
       bool flush) override;
 };
 
+// A logger which may be shared between threads. Logs are passed to an
+// underlying logger while holding a lock. Buffered logs are kept per thread,
+// so a thread's PrintAndClearBuffer() or ClearBuffer() only affects the logs
+// that it recorded.
+class ThreadSafeLogger : public Logger {
+ public:
+  // The underlying logger must outlive this object.
+  explicit ThreadSafeLogger(Logger* logger);
+
+  virtual labm8::Status StartNewInstance() override;
+
+  virtual labm8::Status RecordLog(
+      const CldriveInstance* const instance,
+      const CldriveKernelInstance* const kernel_instance,
+      const CldriveKernelRun* const run,
+      const gpu::libcecl::OpenClKernelInvocation* const log,
+      bool flush) override;
+
+  virtual labm8::Status RecordRunSummary(
+      const CldriveInstance* const instance,
+      const CldriveKernelInstance* const kernel_instance,
+      const CldriveKernelRun* const run,
+      const gpu::libcecl::OpenClKernelInvocation* const log) override;
+
+  virtual labm8::Status RecordKernelRun(
+      const CldriveInstance* const instance,
+      const CldriveKernelInstance* const kernel_instance,
+      const CldriveKernelRun* const run) override;
+
+  virtual void PrintAndClearBuffer() override;
+  virtual void ClearBuffer() override;
+
+  // Print the buffers of every thread, and flush the underlying logger. May
+  // be called from any thread, e.g. the watchdog's.
+  virtual void Flush() override;
+
+ private:
+  Logger* logger_;
+  labm8::Mutex mutex_;
+  std::map<std::thread::id, string> buffers_;
+};
+
+// Log the results of an instance which was run elsewhere, e.g. by a worker
+// process, making the calls that the driver makes while running it. The
+// launch config of a run which failed before any of its runs completed is not
+// known, so it is logged without one.
+void RecordInstance(const CldriveInstance& instance, Logger* logger);
+
 }  // namespace cldrive
 }  // namespace gpu
@@ -0,0 +1,279 @@
+// Copyright (c) 2016-2020 Chris Cummins.
+// This file is part of cldrive.
+//
+// cldrive is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// cldrive is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with cldrive.  If not, see <https://www.gnu.org/licenses/>.
+#include "gpu/cldrive/logger.h"
+
+#include "labm8/cpp/test.h"
+
+#include "google/protobuf/io/zero_copy_stream_impl.h"
+#include "google/protobuf/util/delimited_message_util.h"
+
+#include <algorithm>
+#include <thread>
+#include <vector>
+
+namespace gpu {
+namespace cldrive {
+namespace {
+
+// Return the number of lines in a string.
+int LineCount(const string& str) {
+  return std::count(str.begin(), str.end(), '\n');
+}
+
+TEST(ThreadSafeLogger, BufferedLogsAreKeptPerThread) {
+  std::stringstream stream;
+  CsvLogger csv_logger(stream, /*instances=*/nullptr);
+  csv_logger.StartNewInstance();
+  ThreadSafeLogger logger(&csv_logger);
+  const int header_lines = LineCount(stream.str());
+
+  CldriveInstance instance;
+  gpu::libcecl::OpenClKernelInvocation log;
+
+  // One thread's logs are discarded, the other's are printed.
+  std::thread discard([&]() {
+    logger.RecordLog(&instance, nullptr, nullptr, &log, /*flush=*/false);
+    logger.ClearBuffer();
+  });
+  discard.join();
+  std::thread print([&]() {
+    logger.RecordLog(&instance, nullptr, nullptr, &log, /*flush=*/false);
+    logger.RecordLog(&instance, nullptr, nullptr, &log, /*flush=*/false);
+    logger.PrintAndClearBuffer();
+  });
+  print.join();
+
+  EXPECT_EQ(LineCount(stream.str()) - header_lines, 2);
+}
+
+TEST(ThreadSafeLogger, FlushPrintsTheBuffersOfEveryThread) {
+  std::stringstream stream;
+  CsvLogger csv_logger(stream, /*instances=*/nullptr);
+  csv_logger.StartNewInstance();
+  ThreadSafeLogger logger(&csv_logger);
+  const int header_lines = LineCount(stream.str());
+
+  CldriveInstance instance;
+  gpu::libcecl::OpenClKernelInvocation log;
+  std::thread buffer([&]() {
+    logger.RecordLog(&instance, nullptr, nullptr, &log, /*flush=*/false);
+  });
+  buffer.join();
+  EXPECT_EQ(LineCount(stream.str()) - header_lines, 0);
+
+  // As the watchdog does, from a thread which recorded nothing.
+  logger.Flush();
+  EXPECT_EQ(LineCount(stream.str()) - header_lines, 1);
+}
+
+TEST(ThreadSafeLogger, ConcurrentLogsAreNotInterleaved) {
+  std::stringstream stream;
+  CsvLogger csv_logger(stream, /*instances=*/nullptr);
+  csv_logger.StartNewInstance();
+  ThreadSafeLogger logger(&csv_logger);
+  const int header_lines = LineCount(stream.str());
+
+  std::vector<std::thread> threads;
+  for (int i = 0; i < 4; ++i) {
+    threads.emplace_back([&logger]() {
+      CldriveInstance instance;
+      instance.mutable_device()->set_name("device");
+      gpu::libcecl::OpenClKernelInvocation log;
+      for (int j = 0; j < 100; ++j) {
+        logger.RecordLog(&instance, nullptr, nullptr, &log, /*flush=*/j % 2);
+        if (j % 10 == 9) {
+          logger.PrintAndClearBuffer();
+        }
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+
+  EXPECT_EQ(LineCount(stream.str()) - header_lines, 400);
+}
+
+TEST(ColumnarLogger, FlushPrintsThePartialBlock) {
+  std::stringstream stream;
+  ColumnarLogger logger(stream, /*instances=*/nullptr);
+  logger.StartNewInstance();
+
+  CldriveInstance instance;
+  logger.RecordLog(&instance, nullptr, nullptr, nullptr, /*flush=*/true);
+  EXPECT_TRUE(stream.str().empty());
+
+  logger.Flush();
+  EXPECT_FALSE(stream.str().empty());
+}
+
+TEST(ColumnarLogger, PartialBlockIsPrintedAfterTheFlushInterval) {
+  std::stringstream stream;
+  ColumnarLogger logger(stream, /*instances=*/nullptr,
+                        /*flush_interval_ms=*/0);
+  logger.StartNewInstance();
+
+  CldriveInstance instance;
+  logger.RecordLog(&instance, nullptr, nullptr, nullptr, /*flush=*/true);
+  const size_t size = stream.str().size();
+  EXPECT_GT(size, 0);
+
+  // Buffered rows are added to a block when the buffer is printed.
+  logger.RecordLog(&instance, nullptr, nullptr, nullptr, /*flush=*/false);
+  EXPECT_EQ(stream.str().size(), size);
+  logger.PrintAndClearBuffer();
+  EXPECT_GT(stream.str().size(), size);
+}
+
+TEST(CsvSummaryLogger, OnlySummariesAndFailuresArePrinted) {
+  std::stringstream stream;
+  CsvSummaryLogger logger(stream, /*instances=*/nullptr);
+  logger.StartNewInstance();
+  const int header_lines = LineCount(stream.str());
+
+  CldriveInstance instance;
+  CldriveKernelInstance kernel_instance;
+  CldriveKernelRun run;
+  gpu::libcecl::OpenClKernelInvocation log;
+  log.set_transferred_bytes(0);
+
+  // The log of a completed run is not printed.
+  logger.RecordLog(&instance, &kernel_instance, &run, &log, /*flush=*/true);
+  EXPECT_EQ(LineCount(stream.str()) - header_lines, 0);
+
+  // A failed run is printed.
+  log.set_transferred_bytes(-1);
+  logger.RecordLog(&instance, &kernel_instance, &run, &log, /*flush=*/true);
+  EXPECT_EQ(LineCount(stream.str()) - header_lines, 1);
+
+  run.set_outcome(CldriveKernelRun::PASS);
+  run.mutable_kernel_time_summary()->set_num_runs(10);
+  run.mutable_kernel_time_summary()->set_p50(1000);
+  logger.RecordRunSummary(&instance, &kernel_instance, &run, &log);
+  EXPECT_EQ(LineCount(stream.str()) - header_lines, 2);
+  EXPECT_NE(stream.str().find(",PASS,FIXED_RUN_COUNT,10,"), string::npos);
+}
+
+TEST(DelimitedProtocolBufferLogger, RunsAndFailuresAreStreamed) {
+  std::stringstream stream;
+  DelimitedProtocolBufferLogger logger(stream, /*instances=*/nullptr);
+  logger.StartNewInstance();
+  logger.StartNewInstance();
+
+  CldriveInstance instance;
+  instance.mutable_device()->set_name("device");
+  CldriveKernelInstance kernel_instance;
+  kernel_instance.set_name("kernel");
+  CldriveKernelRun run;
+  run.set_outcome(CldriveKernelRun::PASS);
+  gpu::libcecl::OpenClKernelInvocation log;
+  log.set_kernel_name("kernel");
+  log.set_global_size_x(1024);
+  log.set_local_size_x(64);
+  log.set_local_size_y(1);
+  log.set_local_size_z(1);
+  log.set_transferred_bytes(0);
+  log.set_transfer_time_ns(0);
+  log.set_kernel_time_ns(1000);
+  log.set_args_info("");
+  *run.add_log() = log;
+
+  // The logs of a run are not streamed, only the completed run.
+  logger.RecordLog(&instance, &kernel_instance, &run, &log, /*flush=*/true);
+  EXPECT_TRUE(stream.str().empty());
+  logger.RecordKernelRun(&instance, &kernel_instance, &run);
+  logger.RecordLog(&instance, /*kernel_instance=*/nullptr, /*run=*/nullptr,
+                   /*log=*/nullptr, /*flush=*/true);
+
+  google::protobuf::io::IstreamInputStream input(&stream);
+  CldriveResult result;
+  ASSERT_TRUE(google::protobuf::util::ParseDelimitedFromZeroCopyStream(
+      &result, &input, /*clean_eof=*/nullptr));
+  EXPECT_EQ(result.instance_num(), 1);
+  EXPECT_EQ(result.device().name(), "device");
+  EXPECT_EQ(result.kernel().name(), "kernel");
+  ASSERT_EQ(result.kernel().run_size(), 1);
+  EXPECT_EQ(result.kernel().run(0).log(0).kernel_time_ns(), 1000);
+
+  CldriveResult failure;
+  ASSERT_TRUE(google::protobuf::util::ParseDelimitedFromZeroCopyStream(
+      &failure, &input, /*clean_eof=*/nullptr));
+  EXPECT_EQ(failure.instance_num(), 1);
+  EXPECT_FALSE(failure.has_kernel());
+
+  EXPECT_FALSE(google::protobuf::util::ParseDelimitedFromZeroCopyStream(
+      &failure, &input, /*clean_eof=*/nullptr));
+}
+
+TEST(RecordInstance, EveryLogAndFailureIsRecorded) {
+  std::stringstream stream;
+  CsvLogger logger(stream, /*instances=*/nullptr);
+  logger.StartNewInstance();
+  const int header_lines = LineCount(stream.str());
+
+  CldriveInstance instance;
+  instance.set_outcome(CldriveInstance::PASS);
+  CldriveKernelInstance* unsupported = instance.add_kernel();
+  unsupported->set_outcome(CldriveKernelInstance::UNSUPPORTED_ARGUMENTS);
+  CldriveKernelInstance* kernel = instance.add_kernel();
+  kernel->set_outcome(CldriveKernelInstance::PASS);
+  CldriveKernelRun* run = kernel->add_run();
+  run->set_outcome(CldriveKernelRun::PASS);
+  run->add_log()->set_transferred_bytes(0);
+  run->add_log()->set_transferred_bytes(0);
+  kernel->add_run()->set_outcome(CldriveKernelRun::CL_ERROR);
+
+  RecordInstance(instance, &logger);
+  EXPECT_EQ(LineCount(stream.str()) - header_lines, 4);
+  EXPECT_NE(stream.str().find(",UNSUPPORTED_ARGUMENTS,"), string::npos);
+  EXPECT_NE(stream.str().find(",CL_ERROR,"), string::npos);
+}
+
+TEST(RecordInstance, CrashedInstanceIsRecorded) {
+  std::stringstream stream;
+  CsvLogger logger(stream, /*instances=*/nullptr);
+  logger.StartNewInstance();
+  const int header_lines = LineCount(stream.str());
+
+  CldriveInstance instance;
+  instance.set_outcome(CldriveInstance::CRASH);
+  instance.set_crash_signal(11);
+
+  RecordInstance(instance, &logger);
+  EXPECT_EQ(LineCount(stream.str()) - header_lines, 1);
+  EXPECT_NE(stream.str().find(",CRASH,"), string::npos);
+}
+
+TEST(CsvLogger, RowsHaveTheSweepIndexOfTheirRun) {
+  std::stringstream stream;
+  CsvLogger logger(stream, /*instances=*/nullptr);
+  logger.StartNewInstance();
+
+  CldriveInstance instance;
+  CldriveKernelInstance kernel_instance;
+  CldriveKernelRun run;
+  run.set_sweep_index(7);
+  gpu::libcecl::OpenClKernelInvocation log;
+  log.set_args_info("a");
+  logger.RecordLog(&instance, &kernel_instance, &run, &log, /*flush=*/true);
+  EXPECT_NE(stream.str().find(",7,\"a\""), string::npos);
+}
+
+}  // anonymous namespace
+}  // namespace cldrive
+}  // namespace gpu
+
+TEST_MAIN();
@@ -0,0 +1,171 @@
+// Copyright (c) 2016-2020 Chris Cummins.
+// This file is part of cldrive.
+//
+// cldrive is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// cldrive is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with cldrive.  If not, see <https://www.gnu.org/licenses/>.
+#include "gpu/cldrive/lsize_tuner.h"
+
+#include "gpu/cldrive/run_statistics.h"
+
+#include "labm8/cpp/logging.h"
+
+#include <algorithm>
+#include <tuple>
+
+namespace gpu {
+namespace cldrive {
+
+namespace {
+
+// Return the local sizes to try in one dimension.
+std::vector<size_t> DimensionCandidates(size_t global_size,
+                                        size_t max_local_size,
+                                        size_t preferred_multiple) {
+  std::vector<size_t> sizes;
+  const size_t limit = std::min(global_size, max_local_size);
+  for (size_t size = 1; size <= limit; ++size) {
+    const bool power_of_two = !(size & (size - 1));
+    const bool preferred = preferred_multiple && !(size % preferred_multiple);
+    if ((power_of_two || preferred) && !(global_size % size)) {
+      sizes.push_back(size);
+    }
+  }
+  return sizes;
+}
+
+}  // anonymous namespace
+
+std::vector<DynamicParams> LocalSizeCandidates(
+    const DynamicParams& dynamic_params, const WorkGroupLimits& limits) {
+  const size_t global_sizes[] = {
+      static_cast<size_t>(std::max<labm8::int64>(
+          dynamic_params.global_size_x(), 1)),
+      static_cast<size_t>(std::max<labm8::int64>(
+          dynamic_params.global_size_y(), 1)),
+      static_cast<size_t>(std::max<labm8::int64>(
+          dynamic_params.global_size_z(), 1))};
+
+  std::vector<size_t> sizes[3];
+  for (int i = 0; i < 3; ++i) {
+    sizes[i] = DimensionCandidates(
+        global_sizes[i],
+        std::min(limits.max_work_item_sizes[i], limits.max_work_group_size),
+        limits.preferred_multiple);
+  }
+
+  std::vector<std::tuple<size_t, size_t, size_t, size_t>> shapes;
+  bool any_preferred = false;
+  for (size_t x : sizes[0]) {
+    for (size_t y : sizes[1]) {
+      for (size_t z : sizes[2]) {
+        const size_t work_group_size = x * y * z;
+        if (work_group_size > limits.max_work_group_size) {
+          continue;
+        }
+        any_preferred |= limits.preferred_multiple &&
+                         !(work_group_size % limits.preferred_multiple);
+        shapes.emplace_back(work_group_size, x, y, z);
+      }
+    }
+  }
+  std::sort(shapes.begin(), shapes.end());
+
+  std::vector<DynamicParams> candidates;
+  for (const auto& shape : shapes) {
+    if (any_preferred && std::get<0>(shape) % limits.preferred_multiple) {
+      continue;
+    }
+    DynamicParams candidate = dynamic_params;
+    candidate.set_local_size_x(std::get<1>(shape));
+    candidate.set_local_size_y(std::get<2>(shape));
+    candidate.set_local_size_z(std::get<3>(shape));
+    candidates.push_back(candidate);
+  }
+  return candidates;
+}
+
+SuccessiveHalving::SuccessiveHalving(size_t num_candidates,
+                                     labm8::int64 budget)
+    : budget_(budget),
+      num_rounds_(0),
+      round_(0),
+      times_(num_candidates),
+      failed_(num_candidates, false) {
+  CHECK(num_candidates > 0) << "No candidates";
+  CHECK(budget > 0) << "Budget must be positive";
+  while ((size_t(1) << num_rounds_) < num_candidates) {
+    ++num_rounds_;
+  }
+  num_rounds_ = std::max(num_rounds_, 1);
+  for (size_t i = 0; i < num_candidates; ++i) {
+    survivors_.push_back(i);
+  }
+}
+
+bool SuccessiveHalving::done() const {
+  return round_ > 0 && survivors_.size() <= 1;
+}
+
+int SuccessiveHalving::runs_per_candidate() const {
+  if (survivors_.empty()) {
+    return 0;
+  }
+  const labm8::int64 runs =
+      budget_ / (static_cast<labm8::int64>(survivors_.size()) * num_rounds_);
+  return static_cast<int>(std::max<labm8::int64>(runs, 1));
+}
+
+void SuccessiveHalving::Add(size_t candidate, labm8::int64 time) {
+  times_[candidate].push_back(time);
+}
+
+void SuccessiveHalving::Fail(size_t candidate) { failed_[candidate] = true; }
+
+void SuccessiveHalving::EndRound() {
+  std::vector<std::pair<double, size_t>> ranked;
+  for (size_t candidate : survivors_) {
+    if (!failed_[candidate] && !times_[candidate].empty()) {
+      ranked.emplace_back(MedianTime(candidate), candidate);
+    }
+  }
+  std::sort(ranked.begin(), ranked.end());
+  // Keep the faster half, rounding up.
+  ranked.resize((ranked.size() + 1) / 2);
+
+  survivors_.clear();
+  for (const auto& candidate : ranked) {
+    survivors_.push_back(candidate.second);
+  }
+  std::sort(survivors_.begin(), survivors_.end());
+  ++round_;
+}
+
+double SuccessiveHalving::MedianTime(size_t candidate) const {
+  return Median(times_[candidate]);
+}
+
+int SuccessiveHalving::best() const {
+  int best = -1;
+  for (size_t candidate : survivors_) {
+    if (failed_[candidate] || times_[candidate].empty()) {
+      continue;
+    }
+    if (best < 0 || MedianTime(candidate) < MedianTime(best)) {
+      best = static_cast<int>(candidate);
+    }
+  }
+  return best;
+}
+
+}  // namespace cldrive
+}  // namespace gpu
@@ -0,0 +1,110 @@
+// Search for the fastest local (work group) size of a kernel.
+//
+// Copyright (c) 2016-2020 Chris Cummins.
+// This file is part of cldrive.
+//
+// cldrive is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// cldrive is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with cldrive.  If not, see <https://www.gnu.org/licenses/>.
+#pragma once
+
+#include "gpu/cldrive/proto/cldrive.pb.h"
+
+#include "labm8/cpp/port.h"
+
+#include <cstddef>
+#include <vector>
+
+namespace gpu {
+namespace cldrive {
+
+// The work group limits of a kernel on a device.
+struct WorkGroupLimits {
+  // CL_KERNEL_WORK_GROUP_SIZE.
+  size_t max_work_group_size;
+  // CL_KERNEL_PREFERRED_WORK_GROUP_SIZE_MULTIPLE.
+  size_t preferred_multiple;
+  // CL_DEVICE_MAX_WORK_ITEM_SIZES.
+  size_t max_work_item_sizes[3];
+};
+
+// Return the local sizes to try for the global size of dynamic_params, as
+// copies of dynamic_params. In each dimension, a local size is a power of two
+// or a multiple of the preferred multiple which divides the global size, and
+// is within the maximum work item size. The product of the local sizes is at
+// most the maximum work group size. If any candidate's work group size is a
+// multiple of the preferred multiple, those which are not are dropped.
+// Global sizes of zero are treated as one. Candidates are ordered by work
+// group size, then by local_size_x, local_size_y, and local_size_z.
+std::vector<DynamicParams> LocalSizeCandidates(
+    const DynamicParams& dynamic_params, const WorkGroupLimits& limits);
+
+// Successive halving over a list of candidates. In each round, every
+// surviving candidate is timed runs_per_candidate() times, and then the half
+// with the highest median time is eliminated. The budget is the total number
+// of timed runs, split evenly between the ceil(log2(num_candidates)) rounds.
+//
+// Usage:
+//    SuccessiveHalving tuner(candidates.size(), budget);
+//    while (!tuner.done()) {
+//      for (size_t i : tuner.survivors()) {
+//        for (int j = 0; j < tuner.runs_per_candidate(); ++j) {
+//          tuner.Add(i, Time(candidates[i]));
+//        }
+//      }
+//      tuner.EndRound();
+//    }
+//    int best = tuner.best();
+class SuccessiveHalving {
+ public:
+  // There must be at least one candidate, and a positive budget.
+  SuccessiveHalving(size_t num_candidates, labm8::int64 budget);
+
+  // True once a single candidate survives, or every candidate has failed.
+  // There is always at least one round.
+  bool done() const;
+
+  // The candidates which have not been eliminated, in increasing order.
+  const std::vector<size_t>& survivors() const { return survivors_; }
+
+  // The number of times to run each survivor in the current round.
+  int runs_per_candidate() const;
+
+  // Record a time of a candidate.
+  void Add(size_t candidate, labm8::int64 time);
+
+  // Mark a candidate as failed. It is eliminated at the end of the round.
+  void Fail(size_t candidate);
+
+  // Eliminate the failed survivors, and the slower half of the rest.
+  void EndRound();
+
+  // The median time of a candidate. The candidate must have a time.
+  double MedianTime(size_t candidate) const;
+
+  // The surviving candidate with the lowest median time, or -1 if every
+  // candidate failed.
+  int best() const;
+
+  int round() const { return round_; }
+
+ private:
+  labm8::int64 budget_;
+  int num_rounds_;
+  int round_;
+  std::vector<size_t> survivors_;
+  std::vector<std::vector<labm8::int64>> times_;
+  std::vector<bool> failed_;
+};
+
+}  // namespace cldrive
+}  // namespace gpu
@@ -0,0 +1,158 @@
+// Copyright (c) 2016-2020 Chris Cummins.
+// This file is part of cldrive.
+//
+// cldrive is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// cldrive is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with cldrive.  If not, see <https://www.gnu.org/licenses/>.
+#include "gpu/cldrive/lsize_tuner.h"
+
+#include "labm8/cpp/test.h"
+
+namespace gpu {
+namespace cldrive {
+namespace {
+
+WorkGroupLimits MakeLimits(size_t max_work_group_size,
+                           size_t preferred_multiple) {
+  WorkGroupLimits limits;
+  limits.max_work_group_size = max_work_group_size;
+  limits.preferred_multiple = preferred_multiple;
+  limits.max_work_item_sizes[0] = 1024;
+  limits.max_work_item_sizes[1] = 1024;
+  limits.max_work_item_sizes[2] = 64;
+  return limits;
+}
+
+DynamicParams MakeGlobalSize(int64_t x, int64_t y = 0, int64_t z = 0) {
+  DynamicParams dynamic_params;
+  dynamic_params.set_global_size_x(x);
+  dynamic_params.set_global_size_y(y);
+  dynamic_params.set_global_size_z(z);
+  return dynamic_params;
+}
+
+TEST(LocalSizeCandidates, OneDimensionalPowersOfTwo) {
+  auto candidates =
+      LocalSizeCandidates(MakeGlobalSize(1024), MakeLimits(256, 1));
+  ASSERT_EQ(candidates.size(), 9);
+  for (size_t i = 0; i < candidates.size(); ++i) {
+    EXPECT_EQ(candidates[i].global_size_x(), 1024);
+    EXPECT_EQ(candidates[i].local_size_x(), 1 << i);
+    EXPECT_EQ(candidates[i].local_size_y(), 1);
+    EXPECT_EQ(candidates[i].local_size_z(), 1);
+  }
+}
+
+TEST(LocalSizeCandidates, LocalSizesDivideGlobalSize) {
+  auto candidates =
+      LocalSizeCandidates(MakeGlobalSize(96), MakeLimits(256, 48));
+  ASSERT_EQ(candidates.size(), 2);
+  EXPECT_EQ(candidates[0].local_size_x(), 48);
+  EXPECT_EQ(candidates[1].local_size_x(), 96);
+}
+
+TEST(LocalSizeCandidates, OnlyPreferredMultiplesWhenAvailable) {
+  auto candidates =
+      LocalSizeCandidates(MakeGlobalSize(1024), MakeLimits(256, 32));
+  ASSERT_EQ(candidates.size(), 4);
+  EXPECT_EQ(candidates[0].local_size_x(), 32);
+  EXPECT_EQ(candidates[3].local_size_x(), 256);
+}
+
+TEST(LocalSizeCandidates, SmallGlobalSizeKeepsNonPreferred) {
+  auto candidates =
+      LocalSizeCandidates(MakeGlobalSize(8), MakeLimits(256, 32));
+  ASSERT_EQ(candidates.size(), 4);
+  EXPECT_EQ(candidates.back().local_size_x(), 8);
+}
+
+TEST(LocalSizeCandidates, TwoDimensionalShapes) {
+  auto candidates =
+      LocalSizeCandidates(MakeGlobalSize(64, 64), MakeLimits(64, 64));
+  // Every power of two split of 64 work items between x and y.
+  ASSERT_EQ(candidates.size(), 7);
+  for (const auto& candidate : candidates) {
+    EXPECT_EQ(candidate.local_size_x() * candidate.local_size_y(), 64);
+    EXPECT_EQ(candidate.local_size_z(), 1);
+    EXPECT_EQ(candidate.global_size_y(), 64);
+  }
+}
+
+TEST(LocalSizeCandidates, MaxWorkItemSizesAreRespected) {
+  auto candidates =
+      LocalSizeCandidates(MakeGlobalSize(1, 1, 1024), MakeLimits(1024, 1));
+  EXPECT_EQ(candidates.back().local_size_z(), 64);
+}
+
+TEST(SuccessiveHalving, FastestCandidateWins) {
+  SuccessiveHalving tuner(/*num_candidates=*/5, /*budget=*/60);
+  int rounds = 0;
+  while (!tuner.done()) {
+    for (size_t i : tuner.survivors()) {
+      for (int j = 0; j < tuner.runs_per_candidate(); ++j) {
+        // Candidate 3 is the fastest.
+        tuner.Add(i, i == 3 ? 10 : 100 + i);
+      }
+    }
+    tuner.EndRound();
+    ++rounds;
+  }
+  EXPECT_EQ(rounds, 3);
+  EXPECT_EQ(tuner.best(), 3);
+  ASSERT_EQ(tuner.survivors().size(), 1);
+}
+
+TEST(SuccessiveHalving, RunsPerCandidateGrowAsCandidatesAreEliminated) {
+  SuccessiveHalving tuner(/*num_candidates=*/4, /*budget=*/16);
+  EXPECT_EQ(tuner.runs_per_candidate(), 2);
+  for (size_t i : tuner.survivors()) {
+    tuner.Add(i, i);
+  }
+  tuner.EndRound();
+  EXPECT_EQ(tuner.survivors().size(), 2);
+  EXPECT_EQ(tuner.runs_per_candidate(), 4);
+}
+
+TEST(SuccessiveHalving, SingleCandidateHasOneRound) {
+  SuccessiveHalving tuner(/*num_candidates=*/1, /*budget=*/5);
+  EXPECT_FALSE(tuner.done());
+  EXPECT_EQ(tuner.runs_per_candidate(), 5);
+  tuner.Add(0, 1);
+  tuner.EndRound();
+  EXPECT_TRUE(tuner.done());
+  EXPECT_EQ(tuner.best(), 0);
+}
+
+TEST(SuccessiveHalving, FailedCandidatesAreEliminated) {
+  SuccessiveHalving tuner(/*num_candidates=*/2, /*budget=*/2);
+  tuner.Add(0, 1);
+  tuner.Fail(0);
+  tuner.Add(1, 100);
+  tuner.EndRound();
+  EXPECT_TRUE(tuner.done());
+  EXPECT_EQ(tuner.best(), 1);
+}
+
+TEST(SuccessiveHalving, AllCandidatesFailed) {
+  SuccessiveHalving tuner(/*num_candidates=*/2, /*budget=*/2);
+  tuner.Fail(0);
+  tuner.Fail(1);
+  tuner.EndRound();
+  EXPECT_TRUE(tuner.done());
+  EXPECT_EQ(tuner.best(), -1);
+}
+
+}  // anonymous namespace
+}  // namespace cldrive
+}  // namespace gpu
+
+TEST_MAIN();
@@ -17,6 +17,7 @@
 
 #include "gpu/cldrive/global_memory_arg_value.h"
 #include "gpu/cldrive/local_memory_arg_value.h"
+#include "gpu/cldrive/random_fill.h"
 #include "gpu/cldrive/scalar_kernel_arg_value.h"
 
 namespace gpu {
@@ -28,13 +29,17 @@ namespace {
 template <typename T>
 std::unique_ptr<GlobalMemoryArgValueWithBuffer<T>> CreateGlobalMemoryArgValue(
     const cl::Context& context, size_t size, const int& value,
-    bool rand_values) {
+    bool rand_values, DeviceBufferPool* pool, uint64_t seed, bool zero_copy) {
   auto arg_value = std::make_unique<GlobalMemoryArgValueWithBuffer<T>>(
-      context, size, /*value=*/opencl_type::MakeScalar<T>(value));
+      pool, zero_copy, context, size,
+      /*value=*/opencl_type::MakeScalar<T>(value));
   if (rand_values) {
-    for (size_t i = 0; i < size; ++i) {
-      arg_value->vector()[i] = opencl_type::MakeScalar<T>(rand());
-    }
+    T* data = arg_value->vector().data();
+    ParallelFor(size, [data, seed](size_t begin, size_t end) {
+      for (size_t i = begin; i < end; ++i) {
+        data[i] = opencl_type::MakeScalar<T>(CounterRandom(seed, i));
+      }
+    });
   }
   return arg_value;
 }
@@ -49,278 +54,279 @@ std::unique_ptr<KernelArgValue> CreateScalarArgValue(const int& value) {
 
 std::unique_ptr<KernelArgValue> CreateGlobalMemoryArgValue(
     const OpenClType& type, const cl::Context& context, size_t size,
-    const int& value, bool rand_values) {
+    const int& value, bool rand_values, DeviceBufferPool* pool,
+    uint64_t seed, bool zero_copy) {
   DCHECK(size) << "Cannot create array with 0 elements";
   switch (type) {
     case OpenClType::BOOL: {
       // Use cl_bool here because std::vector<bool> has a funny bitmask
       // specialization in some STL implementations.
-      return CreateGlobalMemoryArgValue<cl_bool>(context, size, value,
-                                                 rand_values);
+      return CreateGlobalMemoryArgValue<cl_bool>(
+          context, size, value, rand_values, pool, seed, zero_copy);
     }
     case OpenClType::CHAR: {
-      return CreateGlobalMemoryArgValue<cl_char>(context, size, value,
-                                                 rand_values);
+      return CreateGlobalMemoryArgValue<cl_char>(
+          context, size, value, rand_values, pool, seed, zero_copy);
     }
     case OpenClType::UCHAR: {
-      return CreateGlobalMemoryArgValue<cl_uchar>(context, size, value,
-                                                  rand_values);
+      return CreateGlobalMemoryArgValue<cl_uchar>(
+          context, size, value, rand_values, pool, seed, zero_copy);
     }
     case OpenClType::SHORT: {
-      return CreateGlobalMemoryArgValue<cl_short>(context, size, value,
-                                                  rand_values);
+      return CreateGlobalMemoryArgValue<cl_short>(
+          context, size, value, rand_values, pool, seed, zero_copy);
     }
     case OpenClType::USHORT: {
-      return CreateGlobalMemoryArgValue<cl_ushort>(context, size, value,
-                                                   rand_values);
+      return CreateGlobalMemoryArgValue<cl_ushort>(
+          context, size, value, rand_values, pool, seed, zero_copy);
     }
     case OpenClType::INT: {
-      return CreateGlobalMemoryArgValue<cl_int>(context, size, value,
-                                                rand_values);
+      return CreateGlobalMemoryArgValue<cl_int>(
+          context, size, value, rand_values, pool, seed, zero_copy);
     }
     case OpenClType::UINT: {
-      return CreateGlobalMemoryArgValue<cl_uint>(context, size, value,
-                                                 rand_values);
+      return CreateGlobalMemoryArgValue<cl_uint>(
+          context, size, value, rand_values, pool, seed, zero_copy);
     }
     case OpenClType::LONG: {
-      return CreateGlobalMemoryArgValue<cl_long>(context, size, value,
-                                                 rand_values);
+      return CreateGlobalMemoryArgValue<cl_long>(
+          context, size, value, rand_values, pool, seed, zero_copy);
     }
     case OpenClType::ULONG: {
-      return CreateGlobalMemoryArgValue<cl_ulong>(context, size, value,
-                                                  rand_values);
+      return CreateGlobalMemoryArgValue<cl_ulong>(
+          context, size, value, rand_values, pool, seed, zero_copy);
     }
     case OpenClType::FLOAT: {
-      return CreateGlobalMemoryArgValue<cl_float>(context, size, value,
-                                                  rand_values);
+      return CreateGlobalMemoryArgValue<cl_float>(
+          context, size, value, rand_values, pool, seed, zero_copy);
     }
     case OpenClType::DOUBLE: {
-      return CreateGlobalMemoryArgValue<cl_double>(context, size, value,
-                                                   rand_values);
+      return CreateGlobalMemoryArgValue<cl_double>(
+          context, size, value, rand_values, pool, seed, zero_copy);
     }
     case OpenClType::HALF: {
-      return CreateGlobalMemoryArgValue<cl_half>(context, size, value,
-                                                 rand_values);
+      return CreateGlobalMemoryArgValue<cl_half>(
+          context, size, value, rand_values, pool, seed, zero_copy);
     }
     case OpenClType::CHAR2: {
-      return CreateGlobalMemoryArgValue<cl_char2>(context, size, value,
-                                                  rand_values);
+      return CreateGlobalMemoryArgValue<cl_char2>(
+          context, size, value, rand_values, pool, seed, zero_copy);
     }
     case OpenClType::CHAR3: {
-      return CreateGlobalMemoryArgValue<cl_char3>(context, size, value,
-                                                  rand_values);
+      return CreateGlobalMemoryArgValue<cl_char3>(
+          context, size, value, rand_values, pool, seed, zero_copy);
     }
     case OpenClType::CHAR4: {
-      return CreateGlobalMemoryArgValue<cl_char4>(context, size, value,
-                                                  rand_values);
+      return CreateGlobalMemoryArgValue<cl_char4>(
+          context, size, value, rand_values, pool, seed, zero_copy);
     }
     case OpenClType::CHAR8: {
-      return CreateGlobalMemoryArgValue<cl_char8>(context, size, value,
-                                                  rand_values);
+      return CreateGlobalMemoryArgValue<cl_char8>(
+          context, size, value, rand_values, pool, seed, zero_copy);
     }
     case OpenClType::CHAR16: {
-      return CreateGlobalMemoryArgValue<cl_char16>(context, size, value,
-                                                   rand_values);
+      return CreateGlobalMemoryArgValue<cl_char16>(
+          context, size, value, rand_values, pool, seed, zero_copy);
     }
     case OpenClType::UCHAR2: {
-      return CreateGlobalMemoryArgValue<cl_uchar2>(context, size, value,
-                                                   rand_values);
+      return CreateGlobalMemoryArgValue<cl_uchar2>(
+          context, size, value, rand_values, pool, seed, zero_copy);
     }
     case OpenClType::UCHAR3: {
-      return CreateGlobalMemoryArgValue<cl_uchar3>(context, size, value,
-                                                   rand_values);
+      return CreateGlobalMemoryArgValue<cl_uchar3>(
+          context, size, value, rand_values, pool, seed, zero_copy);
     }
     case OpenClType::UCHAR4: {
-      return CreateGlobalMemoryArgValue<cl_uchar4>(context, size, value,
-                                                   rand_values);
+      return CreateGlobalMemoryArgValue<cl_uchar4>(
+          context, size, value, rand_values, pool, seed, zero_copy);
     }
     case OpenClType::UCHAR8: {
-      return CreateGlobalMemoryArgValue<cl_uchar8>(context, size, value,
-                                                   rand_values);
+      return CreateGlobalMemoryArgValue<cl_uchar8>(
+          context, size, value, rand_values, pool, seed, zero_copy);
     }
     case OpenClType::UCHAR16: {
-      return CreateGlobalMemoryArgValue<cl_uchar16>(context, size, value,
-                                                    rand_values);
+      return CreateGlobalMemoryArgValue<cl_uchar16>(
+          context, size, value, rand_values, pool, seed, zero_copy);
     }
     case OpenClType::SHORT2: {
-      return CreateGlobalMemoryArgValue<cl_short2>(context, size, value,
-                                                   rand_values);
+      return CreateGlobalMemoryArgValue<cl_short2>(
+          context, size, value, rand_values, pool, seed, zero_copy);
     }
     case OpenClType::SHORT3: {
-      return CreateGlobalMemoryArgValue<cl_short3>(context, size, value,
-                                                   rand_values);
+      return CreateGlobalMemoryArgValue<cl_short3>(
+          context, size, value, rand_values, pool, seed, zero_copy);
     }
     case OpenClType::SHORT4: {
-      return CreateGlobalMemoryArgValue<cl_short4>(context, size, value,
-                                                   rand_values);
+      return CreateGlobalMemoryArgValue<cl_short4>(
+          context, size, value, rand_values, pool, seed, zero_copy);
     }
     case OpenClType::SHORT8: {
-      return CreateGlobalMemoryArgValue<cl_short8>(context, size, value,
-                                                   rand_values);
+      return CreateGlobalMemoryArgValue<cl_short8>(
+          context, size, value, rand_values, pool, seed, zero_copy);
     }
     case OpenClType::SHORT16: {
-      return CreateGlobalMemoryArgValue<cl_short16>(context, size, value,
-                                                    rand_values);
+      return CreateGlobalMemoryArgValue<cl_short16>(
+          context, size, value, rand_values, pool, seed, zero_copy);
     }
     case OpenClType::USHORT2: {
-      return CreateGlobalMemoryArgValue<cl_ushort2>(context, size, value,
-                                                    rand_values);
+      return CreateGlobalMemoryArgValue<cl_ushort2>(
+          context, size, value, rand_values, pool, seed, zero_copy);
     }
     case OpenClType::USHORT3: {
-      return CreateGlobalMemoryArgValue<cl_ushort3>(context, size, value,
-                                                    rand_values);
+      return CreateGlobalMemoryArgValue<cl_ushort3>(
+          context, size, value, rand_values, pool, seed, zero_copy);
     }
     case OpenClType::USHORT4: {
-      return CreateGlobalMemoryArgValue<cl_ushort4>(context, size, value,
-                                                    rand_values);
+      return CreateGlobalMemoryArgValue<cl_ushort4>(
+          context, size, value, rand_values, pool, seed, zero_copy);
     }
     case OpenClType::USHORT8: {
-      return CreateGlobalMemoryArgValue<cl_ushort8>(context, size, value,
-                                                    rand_values);
+      return CreateGlobalMemoryArgValue<cl_ushort8>(
+          context, size, value, rand_values, pool, seed, zero_copy);
     }
     case OpenClType::USHORT16: {
-      return CreateGlobalMemoryArgValue<cl_ushort16>(context, size, value,
-                                                     rand_values);
+      return CreateGlobalMemoryArgValue<cl_ushort16>(
+          context, size, value, rand_values, pool, seed, zero_copy);
     }
     case OpenClType::INT2: {
-      return CreateGlobalMemoryArgValue<cl_int2>(context, size, value,
-                                                 rand_values);
+      return CreateGlobalMemoryArgValue<cl_int2>(
+          context, size, value, rand_values, pool, seed, zero_copy);
     }
     case OpenClType::INT3: {
-      return CreateGlobalMemoryArgValue<cl_int3>(context, size, value,
-                                                 rand_values);
+      return CreateGlobalMemoryArgValue<cl_int3>(
+          context, size, value, rand_values, pool, seed, zero_copy);
     }
     case OpenClType::INT4: {
-      return CreateGlobalMemoryArgValue<cl_int4>(context, size, value,
-                                                 rand_values);
+      return CreateGlobalMemoryArgValue<cl_int4>(
+          context, size, value, rand_values, pool, seed, zero_copy);
     }
     case OpenClType::INT8: {
-      return CreateGlobalMemoryArgValue<cl_int8>(context, size, value,
-                                                 rand_values);
+      return CreateGlobalMemoryArgValue<cl_int8>(
+          context, size, value, rand_values, pool, seed, zero_copy);
     }
     case OpenClType::INT16: {
-      return CreateGlobalMemoryArgValue<cl_int16>(context, size, value,
-                                                  rand_values);
+      return CreateGlobalMemoryArgValue<cl_int16>(
+          context, size, value, rand_values, pool, seed, zero_copy);
     }
     case OpenClType::UINT2: {
-      return CreateGlobalMemoryArgValue<cl_uint2>(context, size, value,
-                                                  rand_values);
+      return CreateGlobalMemoryArgValue<cl_uint2>(
+          context, size, value, rand_values, pool, seed, zero_copy);
     }
     case OpenClType::UINT3: {
-      return CreateGlobalMemoryArgValue<cl_uint3>(context, size, value,
-                                                  rand_values);
+      return CreateGlobalMemoryArgValue<cl_uint3>(
+          context, size, value, rand_values, pool, seed, zero_copy);
     }
     case OpenClType::UINT4: {
-      return CreateGlobalMemoryArgValue<cl_uint4>(context, size, value,
-                                                  rand_values);
+      return CreateGlobalMemoryArgValue<cl_uint4>(
+          context, size, value, rand_values, pool, seed, zero_copy);
     }
     case OpenClType::UINT8: {
-      return CreateGlobalMemoryArgValue<cl_uint8>(context, size, value,
-                                                  rand_values);
+      return CreateGlobalMemoryArgValue<cl_uint8>(
+          context, size, value, rand_values, pool, seed, zero_copy);
     }
     case OpenClType::UINT16: {
-      return CreateGlobalMemoryArgValue<cl_uint16>(context, size, value,
-                                                   rand_values);
+      return CreateGlobalMemoryArgValue<cl_uint16>(
+          context, size, value, rand_values, pool, seed, zero_copy);
     }
     case OpenClType::LONG2: {
-      return CreateGlobalMemoryArgValue<cl_long2>(context, size, value,
-                                                  rand_values);
+      return CreateGlobalMemoryArgValue<cl_long2>(
+          context, size, value, rand_values, pool, seed, zero_copy);
     }
     case OpenClType::LONG3: {
-      return CreateGlobalMemoryArgValue<cl_long3>(context, size, value,
-                                                  rand_values);
+      return CreateGlobalMemoryArgValue<cl_long3>(
+          context, size, value, rand_values, pool, seed, zero_copy);
     }
     case OpenClType::LONG4: {
-      return CreateGlobalMemoryArgValue<cl_long4>(context, size, value,
-                                                  rand_values);
+      return CreateGlobalMemoryArgValue<cl_long4>(
+          context, size, value, rand_values, pool, seed, zero_copy);
     }
     case OpenClType::LONG8: {
-      return CreateGlobalMemoryArgValue<cl_long8>(context, size, value,
-                                                  rand_values);
+      return CreateGlobalMemoryArgValue<cl_long8>(
+          context, size, value, rand_values, pool, seed, zero_copy);
     }
     case OpenClType::LONG16: {
-      return CreateGlobalMemoryArgValue<cl_long16>(context, size, value,
-                                                   rand_values);
+      return CreateGlobalMemoryArgValue<cl_long16>(
+          context, size, value, rand_values, pool, seed, zero_copy);
     }
     case OpenClType::ULONG2: {
-      return CreateGlobalMemoryArgValue<cl_ulong2>(context, size, value,
-                                                   rand_values);
+      return CreateGlobalMemoryArgValue<cl_ulong2>(
+          context, size, value, rand_values, pool, seed, zero_copy);
     }
     case OpenClType::ULONG3: {
-      return CreateGlobalMemoryArgValue<cl_ulong3>(context, size, value,
-                                                   rand_values);
+      return CreateGlobalMemoryArgValue<cl_ulong3>(
+          context, size, value, rand_values, pool, seed, zero_copy);
     }
     case OpenClType::ULONG4: {
-      return CreateGlobalMemoryArgValue<cl_ulong4>(context, size, value,
-                                                   rand_values);
+      return CreateGlobalMemoryArgValue<cl_ulong4>(
+          context, size, value, rand_values, pool, seed, zero_copy);
     }
     case OpenClType::ULONG8: {
-      return CreateGlobalMemoryArgValue<cl_ulong8>(context, size, value,
-                                                   rand_values);
+      return CreateGlobalMemoryArgValue<cl_ulong8>(
+          context, size, value, rand_values, pool, seed, zero_copy);
     }
     case OpenClType::ULONG16: {
-      return CreateGlobalMemoryArgValue<cl_ulong16>(context, size, value,
-                                                    rand_values);
+      return CreateGlobalMemoryArgValue<cl_ulong16>(
+          context, size, value, rand_values, pool, seed, zero_copy);
     }
     case OpenClType::FLOAT2: {
-      return CreateGlobalMemoryArgValue<cl_float2>(context, size, value,
-                                                   rand_values);
+      return CreateGlobalMemoryArgValue<cl_float2>(
+          context, size, value, rand_values, pool, seed, zero_copy);
     }
     case OpenClType::FLOAT3: {
-      return CreateGlobalMemoryArgValue<cl_float3>(context, size, value,
-                                                   rand_values);
+      return CreateGlobalMemoryArgValue<cl_float3>(
+          context, size, value, rand_values, pool, seed, zero_copy);
     }
     case OpenClType::FLOAT4: {
-      return CreateGlobalMemoryArgValue<cl_float4>(context, size, value,
-                                                   rand_values);
+      return CreateGlobalMemoryArgValue<cl_float4>(
+          context, size, value, rand_values, pool, seed, zero_copy);
     }
     case OpenClType::FLOAT8: {
-      return CreateGlobalMemoryArgValue<cl_float8>(context, size, value,
-                                                   rand_values);
+      return CreateGlobalMemoryArgValue<cl_float8>(
+          context, size, value, rand_values, pool, seed, zero_copy);
     }
     case OpenClType::FLOAT16: {
-      return CreateGlobalMemoryArgValue<cl_float16>(context, size, value,
-                                                    rand_values);
+      return CreateGlobalMemoryArgValue<cl_float16>(
+          context, size, value, rand_values, pool, seed, zero_copy);
     }
     case OpenClType::DOUBLE2: {
-      return CreateGlobalMemoryArgValue<cl_double2>(context, size, value,
-                                                    rand_values);
+      return CreateGlobalMemoryArgValue<cl_double2>(
+          context, size, value, rand_values, pool, seed, zero_copy);
     }
     case OpenClType::DOUBLE3: {
-      return CreateGlobalMemoryArgValue<cl_double3>(context, size, value,
-                                                    rand_values);
+      return CreateGlobalMemoryArgValue<cl_double3>(
+          context, size, value, rand_values, pool, seed, zero_copy);
     }
     case OpenClType::DOUBLE4: {
-      return CreateGlobalMemoryArgValue<cl_double4>(context, size, value,
-                                                    rand_values);
+      return CreateGlobalMemoryArgValue<cl_double4>(
+          context, size, value, rand_values, pool, seed, zero_copy);
     }
     case OpenClType::DOUBLE8: {
-      return CreateGlobalMemoryArgValue<cl_double8>(context, size, value,
-                                                    rand_values);
+      return CreateGlobalMemoryArgValue<cl_double8>(
+          context, size, value, rand_values, pool, seed, zero_copy);
     }
     case OpenClType::DOUBLE16: {
-      return CreateGlobalMemoryArgValue<cl_double16>(context, size, value,
-                                                     rand_values);
+      return CreateGlobalMemoryArgValue<cl_double16>(
+          context, size, value, rand_values, pool, seed, zero_copy);
     }
     case OpenClType::HALF2: {
-      return CreateGlobalMemoryArgValue<cl_half2>(context, size, value,
-                                                  rand_values);
+      return CreateGlobalMemoryArgValue<cl_half2>(
+          context, size, value, rand_values, pool, seed, zero_copy);
     }
     case OpenClType::HALF3: {
-      return CreateGlobalMemoryArgValue<cl_half3>(context, size, value,
-                                                  rand_values);
+      return CreateGlobalMemoryArgValue<cl_half3>(
+          context, size, value, rand_values, pool, seed, zero_copy);
     }
     case OpenClType::HALF4: {
-      return CreateGlobalMemoryArgValue<cl_half4>(context, size, value,
-                                                  rand_values);
+      return CreateGlobalMemoryArgValue<cl_half4>(
+          context, size, value, rand_values, pool, seed, zero_copy);
     }
     case OpenClType::HALF8: {
-      return CreateGlobalMemoryArgValue<cl_half8>(context, size, value,
-                                                  rand_values);
+      return CreateGlobalMemoryArgValue<cl_half8>(
+          context, size, value, rand_values, pool, seed, zero_copy);
     }
     case OpenClType::HALF16: {
-      return CreateGlobalMemoryArgValue<cl_half16>(context, size, value,
-                                                   rand_values);
+      return CreateGlobalMemoryArgValue<cl_half16>(
+          context, size, value, rand_values, pool, seed, zero_copy);
     }
     case OpenClType::DEFAULT_UNKNOWN: {
       // This condition should never occur as KernelArg::Init() will return an
@@ -19,20 +19,28 @@
 
 #pragma once
 
+#include "gpu/cldrive/device_buffer_pool.h"
 #include "gpu/cldrive/kernel_arg_value.h"
 #include "gpu/cldrive/opencl_type.h"
 
 #include "third_party/opencl/cl.hpp"
 
+#include <cstdint>
 #include <cstdlib>
 
 namespace gpu {
 namespace cldrive {
 namespace util {
 
+// Create an array value. If pool is not nullptr, the device buffer is
+// acquired from it. If rand_values is true, elements are filled with the
+// random stream for seed (see random_fill.h) in place of value. If zero_copy
+// is true, the device buffer uses the host memory of the value (see
+// GlobalMemoryArgValueWithBuffer).
 std::unique_ptr<KernelArgValue> CreateGlobalMemoryArgValue(
     const OpenClType& type, const cl::Context& context, size_t size,
-    const int& value, bool rand_values);
+    const int& value, bool rand_values, DeviceBufferPool* pool = nullptr,
+    uint64_t seed = 0, bool zero_copy = false);
 
 std::unique_ptr<KernelArgValue> CreateLocalMemoryArgValue(
     const OpenClType& type, size_t size);
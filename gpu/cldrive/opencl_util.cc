@@ -15,6 +15,9 @@
 // along with cldrive.  If not, see <https://www.gnu.org/licenses/>.
 #include "gpu/cldrive/opencl_util.h"
 
+#include <algorithm>
+#include <array>
+#include <cstring>
 
 namespace gpu {
 namespace cldrive {
@@ -29,8 +32,19 @@ void CopyHostToDevice(const cl::CommandQueue& queue, void* host_pointer,
       /*ptr=*/host_pointer, /*events=*/nullptr, /*event=*/&event);
 
   // Set profiling data.
-  profiling->transfer_nanoseconds += GetElapsedNanoseconds(event);
-  profiling->transferred_bytes += buffer_size;
+  profiling->AddHostToDevice(GetElapsedNanoseconds(event), buffer_size);
+}
+
+void EnqueueCopyHostToDevice(const cl::CommandQueue& queue, void* host_pointer,
+                             const cl::Buffer& buffer, size_t buffer_size,
+                             ProfilingData* profiling) {
+  cl::Event event;
+  queue.enqueueWriteBuffer(
+      buffer, /*blocking=*/false, /*offset=*/0, /*size=*/buffer_size,
+      /*ptr=*/host_pointer, /*events=*/nullptr, /*event=*/&event);
+
+  // Profiling data is set once the event has completed.
+  profiling->AddPendingHostToDevice(event, buffer_size);
 }
 
 void CopyDeviceToHost(const cl::CommandQueue& queue, const cl::Buffer& buffer,
@@ -42,8 +56,52 @@ void CopyDeviceToHost(const cl::CommandQueue& queue, const cl::Buffer& buffer,
       /*ptr=*/host_pointer, /*events=*/nullptr, /*event=*/&event);
 
   // Set profiling data.
-  profiling->transfer_nanoseconds += GetElapsedNanoseconds(event);
-  profiling->transferred_bytes += buffer_size;
+  profiling->AddDeviceToHost(GetElapsedNanoseconds(event), buffer_size);
+}
+
+void MapHostToDevice(const cl::CommandQueue& queue, const cl::Buffer& buffer,
+                     size_t buffer_size, ProfilingData* profiling) {
+  // The map and unmap publish the host memory to the device. The host values
+  // must be kept, so the region is not invalidated.
+  void* mapped = queue.enqueueMapBuffer(
+      buffer, /*blocking=*/true, /*flags=*/CL_MAP_WRITE,
+      /*offset=*/0, /*size=*/buffer_size);
+  cl::Event event;
+  queue.enqueueUnmapMemObject(buffer, mapped, /*events=*/nullptr,
+                              /*event=*/&event);
+
+  // Set profiling data. Nothing is copied, so no bytes are transferred.
+  profiling->AddHostToDevice(GetElapsedNanoseconds(event), /*bytes=*/0);
+}
+
+void EnqueueMapHostToDevice(const cl::CommandQueue& queue,
+                            const cl::Buffer& buffer, size_t buffer_size,
+                            ProfilingData* profiling) {
+  void* mapped = queue.enqueueMapBuffer(
+      buffer, /*blocking=*/false, /*flags=*/CL_MAP_WRITE,
+      /*offset=*/0, /*size=*/buffer_size);
+  cl::Event event;
+  queue.enqueueUnmapMemObject(buffer, mapped, /*events=*/nullptr,
+                              /*event=*/&event);
+
+  // Profiling data is set once the event has completed. Nothing is copied, so
+  // no bytes are transferred.
+  profiling->AddPendingHostToDevice(event, /*bytes=*/0);
+}
+
+void MapDeviceToHost(const cl::CommandQueue& queue, const cl::Buffer& buffer,
+                     void* host_pointer, size_t buffer_size,
+                     ProfilingData* profiling) {
+  cl::Event event;
+  void* mapped = queue.enqueueMapBuffer(
+      buffer, /*blocking=*/true, /*flags=*/CL_MAP_READ, /*offset=*/0,
+      /*size=*/buffer_size, /*events=*/nullptr, /*event=*/&event);
+  std::memcpy(host_pointer, mapped, buffer_size);
+  queue.enqueueUnmapMemObject(buffer, mapped);
+
+  // Set profiling data. The device did not copy, so no bytes are
+  // transferred.
+  profiling->AddDeviceToHost(GetElapsedNanoseconds(event), /*bytes=*/0);
 }
 
 string GetOpenClKernelName(const cl::Kernel& kernel) {
@@ -117,6 +175,83 @@ string GetKernelArgName(const cl::Kernel& kernel, size_t arg_index) {
   return name;
 }
 
+namespace {
+
+// Return the sizes of a launch config in each dimension, with zero treated as
+// one.
+std::array<size_t, 3> GetSizes(labm8::int64 x, labm8::int64 y,
+                               labm8::int64 z) {
+  return {static_cast<size_t>(std::max<labm8::int64>(x, 1)),
+          static_cast<size_t>(std::max<labm8::int64>(y, 1)),
+          static_cast<size_t>(std::max<labm8::int64>(z, 1))};
+}
+
+cl::NDRange GetRange(int num_dimensions, const std::array<size_t, 3>& sizes) {
+  switch (num_dimensions) {
+    case 1:
+      return cl::NDRange(sizes[0]);
+    case 2:
+      return cl::NDRange(sizes[0], sizes[1]);
+    default:
+      return cl::NDRange(sizes[0], sizes[1], sizes[2]);
+  }
+}
+
+}  // anonymous namespace
+
+int GetNumDimensions(const DynamicParams& dynamic_params) {
+  if (dynamic_params.global_size_z() > 1) {
+    return 3;
+  }
+  if (dynamic_params.global_size_y() > 1) {
+    return 2;
+  }
+  return 1;
+}
+
+cl::NDRange GetGlobalRange(const DynamicParams& dynamic_params) {
+  return GetRange(GetNumDimensions(dynamic_params),
+                  GetSizes(dynamic_params.global_size_x(),
+                           dynamic_params.global_size_y(),
+                           dynamic_params.global_size_z()));
+}
+
+cl::NDRange GetLocalRange(const DynamicParams& dynamic_params) {
+  return GetRange(GetNumDimensions(dynamic_params),
+                  GetSizes(dynamic_params.local_size_x(),
+                           dynamic_params.local_size_y(),
+                           dynamic_params.local_size_z()));
+}
+
+labm8::int64 GetNumWorkItems(const DynamicParams& dynamic_params) {
+  const auto sizes = GetSizes(dynamic_params.global_size_x(),
+                              dynamic_params.global_size_y(),
+                              dynamic_params.global_size_z());
+  return sizes[0] * sizes[1] * sizes[2];
+}
+
+labm8::int64 GetWorkGroupSize(const DynamicParams& dynamic_params) {
+  const auto sizes = GetSizes(dynamic_params.local_size_x(),
+                              dynamic_params.local_size_y(),
+                              dynamic_params.local_size_z());
+  return sizes[0] * sizes[1] * sizes[2];
+}
+
+bool LocalSizeFitsGlobalSize(const DynamicParams& dynamic_params) {
+  const auto global = GetSizes(dynamic_params.global_size_x(),
+                               dynamic_params.global_size_y(),
+                               dynamic_params.global_size_z());
+  const auto local = GetSizes(dynamic_params.local_size_x(),
+                              dynamic_params.local_size_y(),
+                              dynamic_params.local_size_z());
+  for (size_t i = 0; i < 3; ++i) {
+    if (local[i] > global[i]) {
+      return false;
+    }
+  }
+  return true;
+}
+
 }  // namespace util
 }  // namespace cldrive
 }  // namespace gpu
@@ -16,7 +16,9 @@
 #pragma once
 
 #include "gpu/cldrive/profiling_data.h"
+#include "gpu/cldrive/proto/cldrive.pb.h"
 #include "labm8/cpp/logging.h"
+#include "labm8/cpp/port.h"
 #include "third_party/opencl/cl.hpp"
 
 namespace gpu {
@@ -29,12 +31,39 @@ void CopyHostToDevice(const cl::CommandQueue &queue, void *host_pointer,
                       const cl::Buffer &buffer, size_t buffer_size,
                       ProfilingData *profiling);
 
+// Non-blocking host to device copy operation between iterators and a buffer.
+// The host memory must not be modified or freed until the copy completes. The
+// copy event is appended to profiling->pending_transfer_events.
+void EnqueueCopyHostToDevice(const cl::CommandQueue &queue, void *host_pointer,
+                             const cl::Buffer &buffer, size_t buffer_size,
+                             ProfilingData *profiling);
+
 // Blocking host to device copy operation between iterators and a buffer.
 // Returns the elapsed nanoseconds.
 void CopyDeviceToHost(const cl::CommandQueue &queue, const cl::Buffer &buffer,
                       void *host_pointer, size_t buffer_size,
                       ProfilingData *profiling);
 
+// Make the host memory of a CL_MEM_USE_HOST_PTR buffer visible to the device
+// by mapping and unmapping it. Devices which share memory with the host need
+// not copy. Blocks until the buffer is unmapped. The time of the unmap is
+// recorded as a host to device transfer of zero bytes.
+void MapHostToDevice(const cl::CommandQueue &queue, const cl::Buffer &buffer,
+                     size_t buffer_size, ProfilingData *profiling);
+
+// Non-blocking version of MapHostToDevice(). The unmap event is appended to
+// profiling->pending_transfer_events.
+void EnqueueMapHostToDevice(const cl::CommandQueue &queue,
+                            const cl::Buffer &buffer, size_t buffer_size,
+                            ProfilingData *profiling);
+
+// Blocking read of a buffer by mapping it, copying the mapped memory to
+// host_pointer, and unmapping it. The time of the map is recorded as a device
+// to host transfer of zero bytes.
+void MapDeviceToHost(const cl::CommandQueue &queue, const cl::Buffer &buffer,
+                     void *host_pointer, size_t buffer_size,
+                     ProfilingData *profiling);
+
 // Get the name of a kernel.
 string GetOpenClKernelName(const cl::Kernel &kernel);
 
@@ -44,6 +73,27 @@ string GetKernelArgName(const cl::Kernel& kernel, size_t arg_index);
 // Get the type name of a kernel argument.
 string GetKernelArgTypeName(const cl::Kernel &kernel, size_t arg_index);
 
+// Get the number of dimensions of a launch config: the highest dimension
+// whose global size is greater than one, and at least one.
+int GetNumDimensions(const DynamicParams &dynamic_params);
+
+// Get the global or local range of a launch config, with GetNumDimensions()
+// dimensions. Sizes of zero are treated as one.
+cl::NDRange GetGlobalRange(const DynamicParams &dynamic_params);
+cl::NDRange GetLocalRange(const DynamicParams &dynamic_params);
+
+// Get the total number of work items of a launch config.
+labm8::int64 GetNumWorkItems(const DynamicParams &dynamic_params);
+
+// Get the number of work items in a work group of a launch config.
+labm8::int64 GetWorkGroupSize(const DynamicParams &dynamic_params);
+
+// Return whether the local size of a launch config is no greater than its
+// global size in every dimension, including dimensions which the NDRange
+// does not have, whose local sizes would otherwise be silently dropped.
+// Sizes of zero are treated as one.
+bool LocalSizeFitsGlobalSize(const DynamicParams &dynamic_params);
+
 }  // namespace util
 }  // namespace cldrive
 }  // namespace gpu
@@ -57,6 +57,74 @@ TEST(GetKernelArgTypeName, SecondArg) {
   EXPECT_EQ(GetKernelArgTypeName(kernel, 1), "float8*");
 }
 
+TEST(EnqueueCopyHostToDevice, EventIsCollectedAfterFinish) {
+  auto kernel = CreateClKernel("kernel void A(global int *a) {}");
+  cl::Context context = kernel.getInfo<CL_KERNEL_CONTEXT>();
+  cl::CommandQueue queue(context, context.getInfo<CL_CONTEXT_DEVICES>()[0],
+                         CL_QUEUE_PROFILING_ENABLE);
+  std::vector<int> host(16, 1);
+  cl::Buffer buffer(context, CL_MEM_READ_WRITE, sizeof(int) * host.size());
+
+  ProfilingData profiling;
+  EnqueueCopyHostToDevice(queue, host.data(), buffer,
+                          sizeof(int) * host.size(), &profiling);
+  EXPECT_EQ(profiling.pending_transfer_events.size(), 1);
+  EXPECT_EQ(profiling.transferred_bytes, sizeof(int) * host.size());
+  EXPECT_EQ(profiling.transfer_nanoseconds, 0);
+
+  queue.finish();
+  profiling.CollectPendingEvents();
+  EXPECT_TRUE(profiling.pending_transfer_events.empty());
+  EXPECT_GE(profiling.transfer_nanoseconds, 0);
+}
+
+DynamicParams MakeDynamicParams(int64_t gx, int64_t gy, int64_t gz,
+                                int64_t lx, int64_t ly, int64_t lz) {
+  DynamicParams dynamic_params;
+  dynamic_params.set_global_size_x(gx);
+  dynamic_params.set_global_size_y(gy);
+  dynamic_params.set_global_size_z(gz);
+  dynamic_params.set_local_size_x(lx);
+  dynamic_params.set_local_size_y(ly);
+  dynamic_params.set_local_size_z(lz);
+  return dynamic_params;
+}
+
+TEST(GetNumDimensions, UnsetSizesAreOneDimensional) {
+  DynamicParams dynamic_params;
+  dynamic_params.set_global_size_x(1024);
+  EXPECT_EQ(GetNumDimensions(dynamic_params), 1);
+  EXPECT_EQ(GetNumWorkItems(dynamic_params), 1024);
+}
+
+TEST(GetNumDimensions, HighestDimensionGreaterThanOne) {
+  EXPECT_EQ(GetNumDimensions(MakeDynamicParams(64, 32, 1, 8, 8, 1)), 2);
+  EXPECT_EQ(GetNumDimensions(MakeDynamicParams(64, 1, 4, 8, 1, 1)), 3);
+}
+
+TEST(GetGlobalRange, TwoDimensional) {
+  const auto dynamic_params = MakeDynamicParams(64, 32, 1, 8, 4, 0);
+  const cl::NDRange global = GetGlobalRange(dynamic_params);
+  const cl::NDRange local = GetLocalRange(dynamic_params);
+  ASSERT_EQ(global.dimensions(), 2);
+  ASSERT_EQ(local.dimensions(), 2);
+  EXPECT_EQ(global[0], 64);
+  EXPECT_EQ(global[1], 32);
+  EXPECT_EQ(local[0], 8);
+  EXPECT_EQ(local[1], 4);
+  EXPECT_EQ(GetNumWorkItems(dynamic_params), 64 * 32);
+  EXPECT_EQ(GetWorkGroupSize(dynamic_params), 8 * 4);
+}
+
+TEST(LocalSizeFitsGlobalSize, EveryDimensionIsChecked) {
+  EXPECT_TRUE(LocalSizeFitsGlobalSize(MakeDynamicParams(64, 32, 1, 8, 4, 0)));
+  EXPECT_TRUE(LocalSizeFitsGlobalSize(MakeDynamicParams(64, 1, 1, 64, 1, 1)));
+  EXPECT_FALSE(LocalSizeFitsGlobalSize(MakeDynamicParams(64, 1, 1, 128, 1, 1)));
+  // The y and z local sizes of a 1D NDRange would be dropped.
+  EXPECT_FALSE(LocalSizeFitsGlobalSize(MakeDynamicParams(64, 1, 1, 8, 2, 1)));
+  EXPECT_FALSE(LocalSizeFitsGlobalSize(MakeDynamicParams(64, 0, 0, 8, 1, 4)));
+}
+
 }  // anonymous namespace
 }  // namespace util
 }  // namespace cldrive
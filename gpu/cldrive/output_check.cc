@@ -0,0 +1,165 @@
+// Copyright (c) 2016-2020 Chris Cummins.
+// This file is part of cldrive.
+//
+// cldrive is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// cldrive is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with cldrive.  If not, see <https://www.gnu.org/licenses/>.
+#include "gpu/cldrive/output_check.h"
+
+#include "gpu/cldrive/program_cache.h"
+
+#include "labm8/cpp/logging.h"
+
+#include <limits>
+
+namespace gpu {
+namespace cldrive {
+
+namespace {
+
+// The number of work items of the hash kernel, and so of partial sums which
+// are copied back to the host.
+const size_t kNumHashWorkItems = 1024;
+
+// The hash kernel. Each work item sums the mixed words at a stride of the
+// global size. This must compute the same lane sums as HashBytes().
+const char* kHashKernelSrc = R"(
+inline uint fmix32(uint h) {
+  h ^= h >> 16;
+  h *= 0x85ebca6bu;
+  h ^= h >> 13;
+  h *= 0xc2b2ae35u;
+  h ^= h >> 16;
+  return h;
+}
+
+kernel void cldrive_hash_buffer(global const uchar* data, uint num_bytes,
+                                global uint2* partials) {
+  const uint num_words = (num_bytes + 3) / 4;
+  uint2 sum = (uint2)(0, 0);
+  for (uint i = get_global_id(0); i < num_words; i += get_global_size(0)) {
+    uint word = 0;
+    if (4 * i + 4 <= num_bytes) {
+      const uchar4 bytes = vload4(i, data);
+      word = bytes.x | (bytes.y << 8) | (bytes.z << 16) | (bytes.w << 24);
+    } else {
+      for (uint j = 0; 4 * i + j < num_bytes; ++j) {
+        word |= (uint)data[4 * i + j] << (8 * j);
+      }
+    }
+    sum.x += fmix32(word ^ fmix32(2 * i));
+    sum.y += fmix32(word ^ fmix32(2 * i + 1));
+  }
+  partials[get_global_id(0)] = sum;
+}
+)";
+
+// The MurmurHash3 32-bit finalizer.
+uint32_t Fmix32(uint32_t h) {
+  h ^= h >> 16;
+  h *= 0x85ebca6bu;
+  h ^= h >> 13;
+  h *= 0xc2b2ae35u;
+  h ^= h >> 16;
+  return h;
+}
+
+uint64_t LanesToDigest(uint32_t a, uint32_t b, size_t size) {
+  return ((static_cast<uint64_t>(a) << 32) | b) ^
+         (static_cast<uint64_t>(size) * 0x9e3779b97f4a7c15ull);
+}
+
+}  // anonymous namespace
+
+uint64_t HashBytes(const void* data, size_t size) {
+  const unsigned char* bytes = static_cast<const unsigned char*>(data);
+  uint32_t a = 0;
+  uint32_t b = 0;
+  for (size_t i = 0; 4 * i < size; ++i) {
+    uint32_t word = 0;
+    for (size_t j = 0; j < 4 && 4 * i + j < size; ++j) {
+      word |= static_cast<uint32_t>(bytes[4 * i + j]) << (8 * j);
+    }
+    a += Fmix32(word ^ Fmix32(static_cast<uint32_t>(2 * i)));
+    b += Fmix32(word ^ Fmix32(static_cast<uint32_t>(2 * i + 1)));
+  }
+  return LanesToDigest(a, b, size);
+}
+
+DeviceBufferHasher::DeviceBufferHasher(const cl::Context& context)
+    : context_(context),
+      partials_(context, /*flags=*/CL_MEM_WRITE_ONLY,
+                /*size=*/kNumHashWorkItems * sizeof(cl_uint2)) {
+  labm8::StatusOr<cl::Program> program_or =
+      BuildOpenClProgram(kHashKernelSrc, context_, /*cl_build_opts=*/"");
+  if (!program_or.ok()) {
+    LOG(FATAL) << "Failed to build the buffer hash kernel: "
+               << program_or.status().ToString();
+  }
+  kernel_ = cl::Kernel(program_or.ValueOrDie(), "cldrive_hash_buffer");
+}
+
+uint64_t DeviceBufferHasher::Hash(const cl::CommandQueue& queue,
+                                  const cl::Buffer& buffer, size_t size) {
+  CHECK(size <= std::numeric_limits<cl_uint>::max())
+      << "Buffer too large to hash: " << size << " bytes";
+  if (!size) {
+    return LanesToDigest(0, 0, 0);
+  }
+
+  kernel_.setArg(0, buffer);
+  kernel_.setArg(1, static_cast<cl_uint>(size));
+  kernel_.setArg(2, partials_);
+  queue.enqueueNDRangeKernel(kernel_, /*offset=*/cl::NullRange,
+                             /*global=*/cl::NDRange(kNumHashWorkItems),
+                             /*local=*/cl::NullRange);
+
+  std::vector<cl_uint2> partials(kNumHashWorkItems);
+  queue.enqueueReadBuffer(partials_, /*blocking=*/CL_TRUE, /*offset=*/0,
+                          /*size=*/partials.size() * sizeof(cl_uint2),
+                          /*ptr=*/partials.data());
+
+  // Addition is commutative, so the sum does not depend on which work item
+  // hashed which word.
+  uint32_t a = 0;
+  uint32_t b = 0;
+  for (const auto& partial : partials) {
+    a += partial.s[0];
+    b += partial.s[1];
+  }
+  return LanesToDigest(a, b, size);
+}
+
+CldriveKernelRun::KernelRunOutcome ClassifyOutputs(
+    const OutputDigests& digests) {
+  if (digests.a_outputs == digests.a_inputs) {
+    return CldriveKernelRun::NO_OUTPUT;
+  }
+  if (digests.a_prime_outputs != digests.a_outputs) {
+    return CldriveKernelRun::NONDETERMINISTIC;
+  }
+  if (digests.b_inputs == digests.a_inputs) {
+    return CldriveKernelRun::PASS;
+  }
+  // Buffers which the kernel only reads differ between runs A and B by
+  // construction, so only the buffers written by run A are compared.
+  for (size_t i = 0; i < digests.a_outputs.size(); ++i) {
+    if (digests.a_outputs[i] != digests.a_inputs[i] &&
+        digests.b_outputs[i] != digests.a_outputs[i]) {
+      return CldriveKernelRun::PASS;
+    }
+  }
+  return CldriveKernelRun::INPUT_INSENSITIVE;
+}
+
+}  // namespace cldrive
+}  // namespace gpu
@@ -0,0 +1,79 @@
+// Classify kernel outputs by hashing device buffers on the device.
+//
+// Copyright (c) 2016-2020 Chris Cummins.
+// This file is part of cldrive.
+//
+// cldrive is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// cldrive is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with cldrive.  If not, see <https://www.gnu.org/licenses/>.
+#pragma once
+
+#include "gpu/cldrive/proto/cldrive.pb.h"
+
+#include "labm8/cpp/macros.h"
+#include "third_party/opencl/cl.hpp"
+
+#include <cstdint>
+#include <vector>
+
+namespace gpu {
+namespace cldrive {
+
+// Return the 64-bit digest of a byte array. The array is hashed as 32-bit
+// little endian words, with a zero-padded last word. Each word is mixed with
+// its index into two 32-bit lanes, which are summed, so the digest does not
+// depend on how the words are split between work items.
+uint64_t HashBytes(const void* data, size_t size);
+
+// Computes HashBytes() of device buffers with a kernel on the device. Only
+// the per-work-item lane sums are copied back to the host, rather than the
+// buffer.
+class DeviceBufferHasher {
+ public:
+  // Build the hash kernel for the devices of the context. The kernel is built
+  // in, so failing to build it is fatal.
+  explicit DeviceBufferHasher(const cl::Context& context);
+
+  // Return the digest of the first size bytes of a buffer, which must be less
+  // than 4 GiB. The hash is enqueued after the commands already on the queue,
+  // and this blocks until it completes.
+  uint64_t Hash(const cl::CommandQueue& queue, const cl::Buffer& buffer,
+                size_t size);
+
+ private:
+  cl::Context context_;
+  cl::Kernel kernel_;
+  cl::Buffer partials_;
+
+  DISALLOW_EVIL_CONSTRUCTORS(DeviceBufferHasher);
+};
+
+// The digests of the global buffers of a kernel's arguments, in argument
+// order, at each point of an output check. Runs A and A' are of the same
+// inputs, and run B is of different inputs.
+struct OutputDigests {
+  std::vector<uint64_t> a_inputs;
+  std::vector<uint64_t> a_outputs;
+  std::vector<uint64_t> a_prime_outputs;
+  std::vector<uint64_t> b_inputs;
+  std::vector<uint64_t> b_outputs;
+};
+
+// Classify a kernel from the digests of an output check. Returns NO_OUTPUT if
+// run A left its buffers unchanged, NONDETERMINISTIC if runs A and A' differ,
+// INPUT_INSENSITIVE if run B of different inputs left the same values as run
+// A in every buffer that run A wrote, else PASS.
+CldriveKernelRun::KernelRunOutcome ClassifyOutputs(
+    const OutputDigests& digests);
+
+}  // namespace cldrive
+}  // namespace gpu
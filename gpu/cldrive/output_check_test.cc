@@ -0,0 +1,120 @@
+// Copyright (c) 2016-2020 Chris Cummins.
+// This file is part of cldrive.
+//
+// cldrive is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// cldrive is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with cldrive.  If not, see <https://www.gnu.org/licenses/>.
+#include "gpu/cldrive/output_check.h"
+
+#include "labm8/cpp/test.h"
+
+#include <vector>
+
+namespace gpu {
+namespace cldrive {
+namespace {
+
+TEST(HashBytes, SameBytesSameDigest) {
+  std::vector<int> a(1000, 7);
+  std::vector<int> b(1000, 7);
+  EXPECT_EQ(HashBytes(a.data(), a.size() * sizeof(int)),
+            HashBytes(b.data(), b.size() * sizeof(int)));
+}
+
+TEST(HashBytes, ChangedByteChangesDigest) {
+  std::vector<char> a(1001, 0);
+  const uint64_t digest = HashBytes(a.data(), a.size());
+  for (size_t i : {size_t(0), size_t(3), size_t(500), size_t(1000)}) {
+    a[i] = 1;
+    EXPECT_NE(HashBytes(a.data(), a.size()), digest);
+    a[i] = 0;
+  }
+}
+
+TEST(HashBytes, SwappedWordsChangeDigest) {
+  const int a[] = {1, 2, 3, 4};
+  const int b[] = {2, 1, 3, 4};
+  EXPECT_NE(HashBytes(a, sizeof(a)), HashBytes(b, sizeof(b)));
+}
+
+TEST(HashBytes, TrailingZerosChangeDigest) {
+  const char a[] = {1, 2, 3, 0};
+  EXPECT_NE(HashBytes(a, 3), HashBytes(a, 4));
+  EXPECT_NE(HashBytes(a, 0), HashBytes(a + 3, 1));
+}
+
+TEST(ClassifyOutputs, Pass) {
+  OutputDigests digests;
+  digests.a_inputs = {1, 2};
+  digests.a_outputs = {1, 3};
+  digests.a_prime_outputs = {1, 3};
+  digests.b_inputs = {4, 5};
+  digests.b_outputs = {4, 6};
+  EXPECT_EQ(ClassifyOutputs(digests), CldriveKernelRun::PASS);
+}
+
+TEST(ClassifyOutputs, NoOutput) {
+  OutputDigests digests;
+  digests.a_inputs = {1, 2};
+  digests.a_outputs = {1, 2};
+  digests.a_prime_outputs = {1, 2};
+  digests.b_inputs = {4, 5};
+  digests.b_outputs = {4, 5};
+  EXPECT_EQ(ClassifyOutputs(digests), CldriveKernelRun::NO_OUTPUT);
+}
+
+TEST(ClassifyOutputs, Nondeterministic) {
+  OutputDigests digests;
+  digests.a_inputs = {1, 2};
+  digests.a_outputs = {1, 3};
+  digests.a_prime_outputs = {1, 4};
+  digests.b_inputs = {4, 5};
+  digests.b_outputs = {4, 6};
+  EXPECT_EQ(ClassifyOutputs(digests), CldriveKernelRun::NONDETERMINISTIC);
+}
+
+TEST(ClassifyOutputs, InputInsensitive) {
+  // The first buffer is only read, so it differs between runs A and B, but
+  // the written second buffer does not.
+  OutputDigests digests;
+  digests.a_inputs = {1, 2};
+  digests.a_outputs = {1, 3};
+  digests.a_prime_outputs = {1, 3};
+  digests.b_inputs = {4, 5};
+  digests.b_outputs = {4, 3};
+  EXPECT_EQ(ClassifyOutputs(digests), CldriveKernelRun::INPUT_INSENSITIVE);
+}
+
+TEST(DeviceBufferHasher, MatchesHashBytes) {
+  cl::Context context = cl::Context::getDefault();
+  cl::CommandQueue queue(context);
+  DeviceBufferHasher hasher(context);
+
+  // Sizes which are smaller than, and not a multiple of, the number of words
+  // hashed by the work items.
+  for (size_t size : {size_t(1), size_t(6), size_t(4096), size_t(100003)}) {
+    std::vector<unsigned char> data(size);
+    for (size_t i = 0; i < size; ++i) {
+      data[i] = static_cast<unsigned char>(i * 31 + 7);
+    }
+    cl::Buffer buffer(context, CL_MEM_READ_WRITE, size);
+    queue.enqueueWriteBuffer(buffer, /*blocking=*/CL_TRUE, /*offset=*/0, size,
+                             data.data());
+    EXPECT_EQ(hasher.Hash(queue, buffer, size), HashBytes(data.data(), size));
+  }
+}
+
+}  // anonymous namespace
+}  // namespace cldrive
+}  // namespace gpu
+
+TEST_MAIN();
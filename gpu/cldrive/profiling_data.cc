@@ -25,5 +25,69 @@ labm8::int64 GetElapsedNanoseconds(const cl::Event& event) {
   return static_cast<labm8::int64>(end - start);
 }
 
+double GetBandwidthGbps(labm8::int64 bytes, labm8::int64 nanoseconds) {
+  // One byte per nanosecond is one GB/s.
+  return nanoseconds > 0 ? static_cast<double>(bytes) / nanoseconds : 0;
+}
+
+void ProfilingData::AddHostToDevice(labm8::int64 nanoseconds,
+                                    labm8::int64 bytes) {
+  transfer_nanoseconds += nanoseconds;
+  transferred_bytes += bytes;
+  host_to_device_nanoseconds += nanoseconds;
+  host_to_device_bytes += bytes;
+  ArgTransferData* arg = ArgTransfers(current_arg);
+  if (arg) {
+    arg->host_to_device_nanoseconds += nanoseconds;
+    arg->host_to_device_bytes += bytes;
+  }
+}
+
+void ProfilingData::AddDeviceToHost(labm8::int64 nanoseconds,
+                                    labm8::int64 bytes) {
+  transfer_nanoseconds += nanoseconds;
+  transferred_bytes += bytes;
+  device_to_host_nanoseconds += nanoseconds;
+  device_to_host_bytes += bytes;
+  ArgTransferData* arg = ArgTransfers(current_arg);
+  if (arg) {
+    arg->device_to_host_nanoseconds += nanoseconds;
+    arg->device_to_host_bytes += bytes;
+  }
+}
+
+void ProfilingData::AddPendingHostToDevice(const cl::Event& event,
+                                           labm8::int64 bytes) {
+  AddHostToDevice(/*nanoseconds=*/0, bytes);
+  pending_transfer_events.push_back(event);
+  pending_transfer_args.push_back(current_arg);
+}
+
+void ProfilingData::CollectPendingEvents() {
+  for (const auto& event : pending_kernel_events) {
+    kernel_nanoseconds += GetElapsedNanoseconds(event);
+  }
+  const int current = current_arg;
+  for (size_t i = 0; i < pending_transfer_events.size(); ++i) {
+    current_arg = pending_transfer_args[i];
+    AddHostToDevice(GetElapsedNanoseconds(pending_transfer_events[i]),
+                    /*bytes=*/0);
+  }
+  current_arg = current;
+  pending_kernel_events.clear();
+  pending_transfer_events.clear();
+  pending_transfer_args.clear();
+}
+
+ArgTransferData* ProfilingData::ArgTransfers(int arg_index) {
+  if (arg_index < 0) {
+    return nullptr;
+  }
+  if (static_cast<size_t>(arg_index) >= args.size()) {
+    args.resize(arg_index + 1);
+  }
+  return &args[arg_index];
+}
+
 }  // namespace cldrive
 }  // namespace gpu
@@ -19,18 +19,76 @@
 
 #include "third_party/opencl/cl.hpp"
 
+#include <vector>
+
 namespace gpu {
 namespace cldrive {
 
 labm8::int64 GetElapsedNanoseconds(const cl::Event& event);
 
+// The transfers of one kernel argument's values.
+struct ArgTransferData {
+  labm8::int64 host_to_device_nanoseconds = 0;
+  labm8::int64 host_to_device_bytes = 0;
+  labm8::int64 device_to_host_nanoseconds = 0;
+  labm8::int64 device_to_host_bytes = 0;
+};
+
+// Return the bandwidth of a transfer in GB/s, or zero if it took no time.
+double GetBandwidthGbps(labm8::int64 bytes, labm8::int64 nanoseconds);
+
 class ProfilingData {
  public:
   ProfilingData()
-      : kernel_nanoseconds(0), transfer_nanoseconds(0), transferred_bytes(0) {}
+      : kernel_nanoseconds(0),
+        transfer_nanoseconds(0),
+        transferred_bytes(0),
+        host_to_device_nanoseconds(0),
+        host_to_device_bytes(0),
+        device_to_host_nanoseconds(0),
+        device_to_host_bytes(0),
+        current_arg(-1) {}
   labm8::int64 kernel_nanoseconds;
+  // The totals of transfers in both directions.
   labm8::int64 transfer_nanoseconds;
   labm8::int64 transferred_bytes;
+  // The totals of transfers in each direction.
+  labm8::int64 host_to_device_nanoseconds;
+  labm8::int64 host_to_device_bytes;
+  labm8::int64 device_to_host_nanoseconds;
+  labm8::int64 device_to_host_bytes;
+
+  // The transfers of each argument, indexed by argument. Transfers made while
+  // current_arg is negative are counted only in the totals.
+  std::vector<ArgTransferData> args;
+  // The index of the argument whose values are being transferred, set by
+  // KernelArgValuesSet.
+  int current_arg;
+
+  // Add a completed transfer to the totals and to current_arg.
+  void AddHostToDevice(labm8::int64 nanoseconds, labm8::int64 bytes);
+  void AddDeviceToHost(labm8::int64 nanoseconds, labm8::int64 bytes);
+
+  // Add the bytes of an enqueued host to device transfer, and append its
+  // event to pending_transfer_events. Its elapsed time is added once it is
+  // collected.
+  void AddPendingHostToDevice(const cl::Event& event, labm8::int64 bytes);
+
+  // Events of commands which were enqueued without waiting for them to
+  // complete. Their elapsed times are added to the totals above by
+  // CollectPendingEvents(). Pending transfers are host to device copies.
+  std::vector<cl::Event> pending_kernel_events;
+  std::vector<cl::Event> pending_transfer_events;
+  // The current_arg of each of pending_transfer_events.
+  std::vector<int> pending_transfer_args;
+
+  // Wait for the pending events and add their elapsed times to the totals.
+  void CollectPendingEvents();
+
+ private:
+  // Return the transfers of an argument, growing args as needed, or nullptr
+  // if arg_index is negative.
+  ArgTransferData* ArgTransfers(int arg_index);
 };
 
 }  // namespace cldrive
@@ -21,7 +21,47 @@ namespace gpu {
 namespace cldrive {
 namespace {
 
-TEST(TODO, TODO) { EXPECT_EQ(1, 1); }
+TEST(ProfilingData, TransfersAreSplitByDirection) {
+  ProfilingData profiling;
+  profiling.AddHostToDevice(/*nanoseconds=*/100, /*bytes=*/1000);
+  profiling.AddDeviceToHost(/*nanoseconds=*/50, /*bytes=*/200);
+  profiling.AddHostToDevice(/*nanoseconds=*/20, /*bytes=*/24);
+
+  EXPECT_EQ(profiling.transfer_nanoseconds, 170);
+  EXPECT_EQ(profiling.transferred_bytes, 1224);
+  EXPECT_EQ(profiling.host_to_device_nanoseconds, 120);
+  EXPECT_EQ(profiling.host_to_device_bytes, 1024);
+  EXPECT_EQ(profiling.device_to_host_nanoseconds, 50);
+  EXPECT_EQ(profiling.device_to_host_bytes, 200);
+  // No argument was set.
+  EXPECT_TRUE(profiling.args.empty());
+}
+
+TEST(ProfilingData, TransfersAreSplitByArgument) {
+  ProfilingData profiling;
+  profiling.current_arg = 2;
+  profiling.AddHostToDevice(/*nanoseconds=*/100, /*bytes=*/1000);
+  profiling.AddDeviceToHost(/*nanoseconds=*/50, /*bytes=*/200);
+  profiling.current_arg = 0;
+  profiling.AddHostToDevice(/*nanoseconds=*/10, /*bytes=*/8);
+
+  ASSERT_EQ(profiling.args.size(), 3);
+  EXPECT_EQ(profiling.args[0].host_to_device_nanoseconds, 10);
+  EXPECT_EQ(profiling.args[0].host_to_device_bytes, 8);
+  EXPECT_EQ(profiling.args[0].device_to_host_bytes, 0);
+  EXPECT_EQ(profiling.args[1].host_to_device_bytes, 0);
+  EXPECT_EQ(profiling.args[2].host_to_device_nanoseconds, 100);
+  EXPECT_EQ(profiling.args[2].host_to_device_bytes, 1000);
+  EXPECT_EQ(profiling.args[2].device_to_host_nanoseconds, 50);
+  EXPECT_EQ(profiling.args[2].device_to_host_bytes, 200);
+  EXPECT_EQ(profiling.transferred_bytes, 1208);
+}
+
+TEST(GetBandwidthGbps, BytesPerNanosecond) {
+  EXPECT_DOUBLE_EQ(GetBandwidthGbps(/*bytes=*/1000, /*nanoseconds=*/100), 10);
+  EXPECT_DOUBLE_EQ(GetBandwidthGbps(/*bytes=*/1, /*nanoseconds=*/4), 0.25);
+  EXPECT_DOUBLE_EQ(GetBandwidthGbps(/*bytes=*/1000, /*nanoseconds=*/0), 0);
+}
 
 }  // anonymous namespace
 }  // namespace cldrive
@@ -0,0 +1,255 @@
+// Copyright (c) 2016-2020 Chris Cummins.
+// This file is part of cldrive.
+//
+// cldrive is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// cldrive is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with cldrive.  If not, see <https://www.gnu.org/licenses/>.
+#include "gpu/cldrive/program_cache.h"
+
+#include "gpu/cldrive/proto/cldrive.pb.h"
+#include "gpu/clinfo/libclinfo.h"
+
+#include "labm8/cpp/logging.h"
+#include "labm8/cpp/status.h"
+
+#include "absl/strings/str_format.h"
+#include "absl/strings/str_join.h"
+#include "absl/strings/str_split.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
+
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cstdio>
+#include <fstream>
+#include <memory>
+
+#define LOG_CL_ERROR(level, error)                                  \
+  LOG(level) << "OpenCL exception: " << error.what() << ", error: " \
+             << labm8::gpu::clinfo::OpenClErrorString(error.err());
+
+namespace gpu {
+namespace cldrive {
+
+namespace {
+
+std::unique_ptr<ProgramBinaryCache> global_cache;
+
+// Return the binary of a program built for a single device.
+labm8::StatusOr<string> GetProgramBinary(const cl::Program& program) {
+  size_t binary_size = 0;
+  cl_int err = clGetProgramInfo(program(), CL_PROGRAM_BINARY_SIZES,
+                                sizeof(binary_size), &binary_size, nullptr);
+  if (err != CL_SUCCESS || !binary_size) {
+    return labm8::Status(labm8::error::Code::UNAVAILABLE,
+                         "Program binary not available");
+  }
+
+  string binary(binary_size, '\0');
+  unsigned char* binary_ptr = reinterpret_cast<unsigned char*>(&binary[0]);
+  err = clGetProgramInfo(program(), CL_PROGRAM_BINARIES, sizeof(binary_ptr),
+                         &binary_ptr, nullptr);
+  if (err != CL_SUCCESS) {
+    return labm8::Status(labm8::error::Code::UNAVAILABLE,
+                         "Program binary not available");
+  }
+  return binary;
+}
+
+}  // anonymous namespace
+
+ProgramBinaryCache::ProgramBinaryCache(const string& cache_dir)
+    : cache_dir_(cache_dir) {}
+
+string ProgramBinaryCache::EntryPath(const string& opencl_src,
+                                     const cl::Device& device,
+                                     const string& build_opts) const {
+  string key = absl::StrFormat(
+      "%016x|%s|%s|%s", Fnv1a64(opencl_src), build_opts,
+      device.getInfo<CL_DEVICE_NAME>(), device.getInfo<CL_DRIVER_VERSION>());
+  return absl::StrFormat("%s/%016x.pb", cache_dir_, Fnv1a64(key));
+}
+
+labm8::StatusOr<cl::Program> ProgramBinaryCache::Load(
+    const string& opencl_src, const cl::Context& context,
+    const string& build_opts) {
+  auto start_time = absl::Now();
+  auto Miss = [this]() {
+    labm8::MutexLock lock(&mutex_);
+    ++misses_;
+    return labm8::Status(labm8::error::Code::NOT_FOUND, "Cache miss");
+  };
+
+  auto devices = context.getInfo<CL_CONTEXT_DEVICES>();
+  if (devices.size() != 1) {
+    return Miss();
+  }
+  const cl::Device& device = devices[0];
+
+  std::ifstream file(EntryPath(opencl_src, device, build_opts),
+                     std::ios::binary);
+  OpenClProgramBinary entry;
+  if (!file.is_open() || !entry.ParseFromIstream(&file)) {
+    return Miss();
+  }
+
+  // Guard against collisions in the entry path hash.
+  if (entry.opencl_src_hash() != Fnv1a64(opencl_src) ||
+      entry.opencl_src() != opencl_src || entry.build_opts() != build_opts ||
+      entry.device_name() != device.getInfo<CL_DEVICE_NAME>() ||
+      entry.driver_version() != device.getInfo<CL_DRIVER_VERSION>()) {
+    return Miss();
+  }
+
+  try {
+    cl::Program::Binaries binaries = {
+        {entry.binary().data(), entry.binary().size()}};
+    cl::Program program(context, devices, binaries);
+    program.build(devices, build_opts.c_str());
+
+    auto load_ms = (absl::Now() - start_time) / absl::Milliseconds(1);
+    int64_t saved_ms =
+        std::max(entry.build_time_ms() - static_cast<int64_t>(load_ms),
+                 static_cast<int64_t>(0));
+    LOG(INFO) << "Loaded cached program binary in " << load_ms << " ms (saved "
+              << saved_ms << " ms)";
+
+    labm8::MutexLock lock(&mutex_);
+    ++hits_;
+    saved_ms_ += saved_ms;
+    return program;
+  } catch (cl::Error e) {
+    // The driver may reject a binary, e.g. after an upgrade which did not
+    // change the reported version. Fall back to building from source.
+    LOG_CL_ERROR(WARNING, e);
+    return Miss();
+  }
+}
+
+void ProgramBinaryCache::Store(const cl::Program& program,
+                               const string& opencl_src,
+                               const cl::Context& context,
+                               const string& build_opts,
+                               int64_t build_time_ms) {
+  auto devices = context.getInfo<CL_CONTEXT_DEVICES>();
+  if (devices.size() != 1) {
+    return;
+  }
+  const cl::Device& device = devices[0];
+
+  auto binary_or = GetProgramBinary(program);
+  if (!binary_or.ok()) {
+    LOG(WARNING) << binary_or.status().ToString();
+    return;
+  }
+
+  OpenClProgramBinary entry;
+  entry.set_opencl_src_hash(Fnv1a64(opencl_src));
+  entry.set_opencl_src(opencl_src);
+  entry.set_build_opts(build_opts);
+  entry.set_device_name(device.getInfo<CL_DEVICE_NAME>());
+  entry.set_driver_version(device.getInfo<CL_DRIVER_VERSION>());
+  entry.set_build_time_ms(build_time_ms);
+  entry.set_binary(binary_or.ValueOrDie());
+
+  // Write to a temporary file and rename so that concurrent readers never
+  // see a partially written entry.
+  const string path = EntryPath(opencl_src, device, build_opts);
+  const string tmp_path = absl::StrFormat("%s.%d.tmp", path, getpid());
+  {
+    std::ofstream file(tmp_path, std::ios::binary);
+    if (!file.is_open() || !entry.SerializeToOstream(&file)) {
+      LOG(WARNING) << "Failed to write program binary cache entry " << path;
+      std::remove(tmp_path.c_str());
+      return;
+    }
+  }
+  if (std::rename(tmp_path.c_str(), path.c_str())) {
+    LOG(WARNING) << "Failed to write program binary cache entry " << path;
+    std::remove(tmp_path.c_str());
+  }
+}
+
+string ProgramBinaryCache::StatsString() const {
+  labm8::MutexLock lock(&mutex_);
+  return absl::StrFormat(
+      "Program binary cache: %d hits, %d misses, %d ms saved", hits_, misses_,
+      saved_ms_);
+}
+
+void EnableProgramBinaryCache(const string& cache_dir) {
+  if (mkdir(cache_dir.c_str(), 0755) && errno != EEXIST) {
+    LOG(FATAL) << "Failed to create program binary cache directory "
+               << cache_dir;
+  }
+  global_cache = std::make_unique<ProgramBinaryCache>(cache_dir);
+}
+
+ProgramBinaryCache* GetProgramBinaryCache() { return global_cache.get(); }
+
+string NormalizeBuildOpts(const string& cl_build_opts) {
+  std::vector<string> opts = {"-cl-kernel-arg-info"};
+  for (const auto& opt :
+       absl::StrSplit(cl_build_opts, ' ', absl::SkipWhitespace())) {
+    opts.push_back(string(opt));
+  }
+  return absl::StrJoin(opts, " ");
+}
+
+uint64_t Fnv1a64(const string& str) {
+  uint64_t hash = 14695981039346656037ull;
+  for (unsigned char c : str) {
+    hash ^= c;
+    hash *= 1099511628211ull;
+  }
+  return hash;
+}
+
+labm8::StatusOr<cl::Program> BuildOpenClProgram(const string& opencl_kernel,
+                                                const cl::Context& context,
+                                                const string& cl_build_opts) {
+  // Assemble the build options. We need -cl-kernel-arg-info so that we can
+  // read the kernel signatures.
+  const string all_build_opts = NormalizeBuildOpts(cl_build_opts);
+
+  ProgramBinaryCache* cache = GetProgramBinaryCache();
+  if (cache) {
+    auto program_or = cache->Load(opencl_kernel, context, all_build_opts);
+    if (program_or.ok()) {
+      return program_or;
+    }
+  }
+
+  auto start_time = absl::Now();
+  try {
+    cl::Program program(context, opencl_kernel);
+    program.build(context.getInfo<CL_CONTEXT_DEVICES>(),
+                  all_build_opts.c_str());
+    auto end_time = absl::Now();
+    auto duration = (end_time - start_time) / absl::Milliseconds(1);
+    LOG(INFO) << "clBuildProgram() with options '" << all_build_opts
+              << "' completed in " << duration << " ms";
+
+    if (cache) {
+      cache->Store(program, opencl_kernel, context, all_build_opts, duration);
+    }
+    return program;
+  } catch (cl::Error e) {
+    LOG_CL_ERROR(WARNING, e);
+    return labm8::Status(labm8::error::Code::INVALID_ARGUMENT,
+                         "clBuildProgram failed");
+  }
+}
+
+}  // namespace cldrive
+}  // namespace gpu
@@ -0,0 +1,103 @@
+// An on-disk cache of compiled OpenCL program binaries.
+//
+// Copyright (c) 2016-2020 Chris Cummins.
+// This file is part of cldrive.
+//
+// cldrive is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// cldrive is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with cldrive.  If not, see <https://www.gnu.org/licenses/>.
+#pragma once
+
+#include "labm8/cpp/macros.h"
+#include "labm8/cpp/mutex.h"
+#include "labm8/cpp/statusor.h"
+#include "labm8/cpp/string.h"
+
+#include "third_party/opencl/cl.hpp"
+
+#include <cstdint>
+
+namespace gpu {
+namespace cldrive {
+
+// A cache of CL_PROGRAM_BINARIES values, stored as one file per program in a
+// directory. Entries are keyed by the hash of the OpenCL source, the
+// normalized build options, and the name and driver version of the device.
+// Entries also hold their source, which is compared on load, so a hash
+// collision is a cache miss. Only programs built for a single device are
+// cached.
+//
+// Lookups are thread safe, and concurrent processes may share a directory:
+// entries are written to a temporary file and renamed into place.
+class ProgramBinaryCache {
+ public:
+  explicit ProgramBinaryCache(const string& cache_dir);
+
+  // Load and build a program from a cached binary. Returns NOT_FOUND on a
+  // cache miss, or if the cached binary is rejected by the driver.
+  labm8::StatusOr<cl::Program> Load(const string& opencl_src,
+                                    const cl::Context& context,
+                                    const string& build_opts);
+
+  // Store the binary of a program that was built from source in
+  // build_time_ms milliseconds.
+  void Store(const cl::Program& program, const string& opencl_src,
+             const cl::Context& context, const string& build_opts,
+             int64_t build_time_ms);
+
+  size_t hits() const { return hits_; }
+  size_t misses() const { return misses_; }
+  // The sum of build-from-source times for cache hits, less the time taken
+  // to load them.
+  int64_t saved_ms() const { return saved_ms_; }
+
+  // Return a one-line summary of cache hits, misses, and time saved.
+  string StatsString() const;
+
+ private:
+  string EntryPath(const string& opencl_src, const cl::Device& device,
+                   const string& build_opts) const;
+
+  const string cache_dir_;
+  mutable labm8::Mutex mutex_;
+  size_t hits_ = 0;
+  size_t misses_ = 0;
+  int64_t saved_ms_ = 0;
+
+  DISALLOW_EVIL_CONSTRUCTORS(ProgramBinaryCache);
+};
+
+// Enable the process-wide program binary cache, rooted at the given
+// directory. The directory is created if it does not exist.
+void EnableProgramBinaryCache(const string& cache_dir);
+
+// Return the process-wide program binary cache, or nullptr if it has not been
+// enabled.
+ProgramBinaryCache* GetProgramBinaryCache();
+
+// Return the options passed to clBuildProgram() for the given user options:
+// '-cl-kernel-arg-info' is prepended and whitespace is normalized.
+string NormalizeBuildOpts(const string& cl_build_opts);
+
+// Return the 64-bit FNV-1a hash of a string.
+uint64_t Fnv1a64(const string& str);
+
+// Compile an OpenCL program for all devices in the context. The option
+// '-cl-kernel-arg-info' is always added to the build options. If the program
+// binary cache is enabled, the program is built from a cached binary when
+// possible.
+labm8::StatusOr<cl::Program> BuildOpenClProgram(const string& opencl_kernel,
+                                                const cl::Context& context,
+                                                const string& cl_build_opts);
+
+}  // namespace cldrive
+}  // namespace gpu
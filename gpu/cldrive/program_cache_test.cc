@@ -0,0 +1,102 @@
+// Copyright (c) 2016-2020 Chris Cummins.
+// This file is part of cldrive.
+//
+// cldrive is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// cldrive is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with cldrive.  If not, see <https://www.gnu.org/licenses/>.
+#include "gpu/cldrive/program_cache.h"
+
+#include "gpu/clinfo/libclinfo.h"
+
+#include "labm8/cpp/logging.h"
+#include "labm8/cpp/test.h"
+
+#include <stdlib.h>
+
+namespace gpu {
+namespace cldrive {
+namespace {
+
+string MakeTemporaryDirectory() {
+  char path[] = "/tmp/program_cache_test_XXXXXX";
+  CHECK(mkdtemp(path));
+  return path;
+}
+
+cl::Context MakeTestContext() {
+  return cl::Context(labm8::gpu::clinfo::GetOpenClDeviceOrDie(
+      labm8::gpu::clinfo::GetOpenClDevices().device(0)));
+}
+
+TEST(NormalizeBuildOpts, EmptyOpts) {
+  EXPECT_EQ(NormalizeBuildOpts(""), "-cl-kernel-arg-info");
+}
+
+TEST(NormalizeBuildOpts, WhitespaceIsCollapsed) {
+  EXPECT_EQ(NormalizeBuildOpts("  -DFOO   -DBAR "),
+            "-cl-kernel-arg-info -DFOO -DBAR");
+}
+
+TEST(Fnv1a64, KnownValues) {
+  EXPECT_EQ(Fnv1a64(""), 0xcbf29ce484222325ull);
+  EXPECT_EQ(Fnv1a64("a"), 0xaf63dc4c8601ec8cull);
+}
+
+TEST(ProgramBinaryCache, EmptyCacheMisses) {
+  ProgramBinaryCache cache(MakeTemporaryDirectory());
+  cl::Context context = MakeTestContext();
+
+  EXPECT_FALSE(cache.Load("kernel void A(global int* a) {}", context,
+                          "-cl-kernel-arg-info")
+                   .ok());
+  EXPECT_EQ(cache.hits(), 0);
+  EXPECT_EQ(cache.misses(), 1);
+}
+
+TEST(ProgramBinaryCache, StoredProgramIsLoaded) {
+  ProgramBinaryCache cache(MakeTemporaryDirectory());
+  cl::Context context = MakeTestContext();
+  const string src = "kernel void A(global int* a) { a[0] = 1; }";
+  const string opts = "-cl-kernel-arg-info";
+
+  cl::Program program(context, src);
+  program.build(context.getInfo<CL_CONTEXT_DEVICES>(), opts.c_str());
+  cache.Store(program, src, context, opts, /*build_time_ms=*/100);
+
+  auto loaded_or = cache.Load(src, context, opts);
+  ASSERT_TRUE(loaded_or.ok());
+  EXPECT_EQ(cache.hits(), 1);
+
+  cl::Program loaded = loaded_or.ValueOrDie();
+  std::vector<cl::Kernel> kernels;
+  loaded.createKernels(&kernels);
+  ASSERT_EQ(kernels.size(), 1);
+  EXPECT_EQ(kernels[0].getInfo<CL_KERNEL_FUNCTION_NAME>(), "A");
+}
+
+TEST(ProgramBinaryCache, DifferentBuildOptsMiss) {
+  ProgramBinaryCache cache(MakeTemporaryDirectory());
+  cl::Context context = MakeTestContext();
+  const string src = "kernel void A(global int* a) { a[0] = 1; }";
+
+  cl::Program program(context, src);
+  program.build(context.getInfo<CL_CONTEXT_DEVICES>(), "-cl-kernel-arg-info");
+  cache.Store(program, src, context, "-cl-kernel-arg-info", 100);
+
+  EXPECT_FALSE(cache.Load(src, context, "-cl-kernel-arg-info -DFOO").ok());
+}
+
+}  // anonymous namespace
+}  // namespace cldrive
+}  // namespace gpu
+
+TEST_MAIN();
@@ -0,0 +1,56 @@
+// Copyright (c) 2016-2020 Chris Cummins.
+// This file is part of cldrive.
+//
+// cldrive is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// cldrive is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with cldrive.  If not, see <https://www.gnu.org/licenses/>.
+#include "gpu/cldrive/random_fill.h"
+
+#include <algorithm>
+#include <thread>
+#include <vector>
+
+namespace gpu {
+namespace cldrive {
+namespace util {
+
+void ParallelFor(size_t size, const std::function<void(size_t, size_t)>& fn,
+                 size_t min_elements_per_thread, int num_threads) {
+  if (num_threads <= 0) {
+    num_threads = std::max(std::thread::hardware_concurrency(), 1u);
+  }
+  const size_t max_threads =
+      std::max(size / std::max(min_elements_per_thread, size_t(1)), size_t(1));
+  const size_t thread_count =
+      std::min(static_cast<size_t>(num_threads), max_threads);
+
+  if (thread_count == 1) {
+    fn(0, size);
+    return;
+  }
+
+  const size_t chunk_size = (size + thread_count - 1) / thread_count;
+  std::vector<std::thread> threads;
+  threads.reserve(thread_count - 1);
+  // The calling thread takes the first chunk.
+  for (size_t begin = chunk_size; begin < size; begin += chunk_size) {
+    threads.emplace_back(fn, begin, std::min(begin + chunk_size, size));
+  }
+  fn(0, std::min(chunk_size, size));
+  for (auto& thread : threads) {
+    thread.join();
+  }
+}
+
+}  // namespace util
+}  // namespace cldrive
+}  // namespace gpu
@@ -0,0 +1,62 @@
+// Seeded, counter-based random values for kernel inputs.
+//
+// Copyright (c) 2016-2020 Chris Cummins.
+// This file is part of cldrive.
+//
+// cldrive is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// cldrive is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with cldrive.  If not, see <https://www.gnu.org/licenses/>.
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+
+namespace gpu {
+namespace cldrive {
+namespace util {
+
+// Buffers with fewer elements than this are filled on the calling thread.
+constexpr size_t kMinElementsPerFillThread = 1 << 16;
+
+// The SplitMix64 finalizer: a bijective mixing function on 64-bit values.
+inline uint64_t Mix64(uint64_t z) {
+  z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+  z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+  return z ^ (z >> 31);
+}
+
+// Return the seed of an independent stream of values, e.g. one per kernel
+// argument, derived from a global seed.
+inline uint64_t StreamSeed(uint64_t seed, uint64_t stream) {
+  return Mix64(seed ^ Mix64(stream + 0x9e3779b97f4a7c15ull));
+}
+
+// Return the counter'th value of the stream with the given seed. The value
+// depends only on the seed and counter, so elements may be generated in any
+// order and on any thread. Values are in the range [0, 2^31), the same as
+// rand() with glibc.
+inline int CounterRandom(uint64_t seed, uint64_t counter) {
+  return static_cast<int>(
+      Mix64(seed + (counter + 1) * 0x9e3779b97f4a7c15ull) >> 33);
+}
+
+// Call fn(begin, end) over disjoint ranges which cover [0, size), using up to
+// num_threads threads. If num_threads is zero, the number of hardware threads
+// is used. Each thread is given at least min_elements_per_thread elements.
+void ParallelFor(size_t size, const std::function<void(size_t, size_t)>& fn,
+                 size_t min_elements_per_thread = kMinElementsPerFillThread,
+                 int num_threads = 0);
+
+}  // namespace util
+}  // namespace cldrive
+}  // namespace gpu
@@ -0,0 +1,99 @@
+// Copyright (c) 2016-2020 Chris Cummins.
+// This file is part of cldrive.
+//
+// cldrive is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// cldrive is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with cldrive.  If not, see <https://www.gnu.org/licenses/>.
+#include "gpu/cldrive/random_fill.h"
+
+#include "labm8/cpp/test.h"
+
+#include <vector>
+
+namespace gpu {
+namespace cldrive {
+namespace util {
+namespace {
+
+std::vector<int> Fill(size_t size, uint64_t seed, int num_threads) {
+  std::vector<int> values(size);
+  ParallelFor(
+      size,
+      [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+          values[i] = CounterRandom(seed, i);
+        }
+      },
+      /*min_elements_per_thread=*/16, num_threads);
+  return values;
+}
+
+TEST(RandomFill, SameSeedProducesSameValues) {
+  EXPECT_EQ(Fill(1000, /*seed=*/7, /*num_threads=*/1),
+            Fill(1000, /*seed=*/7, /*num_threads=*/1));
+}
+
+TEST(RandomFill, DifferentSeedsProduceDifferentValues) {
+  EXPECT_NE(Fill(1000, /*seed=*/7, /*num_threads=*/1),
+            Fill(1000, /*seed=*/8, /*num_threads=*/1));
+}
+
+TEST(RandomFill, ValuesAreIndependentOfThreadCount) {
+  const auto expected = Fill(1001, /*seed=*/3, /*num_threads=*/1);
+  EXPECT_EQ(Fill(1001, /*seed=*/3, /*num_threads=*/2), expected);
+  EXPECT_EQ(Fill(1001, /*seed=*/3, /*num_threads=*/7), expected);
+  EXPECT_EQ(Fill(1001, /*seed=*/3, /*num_threads=*/0), expected);
+}
+
+TEST(RandomFill, ValuesAreNonNegative) {
+  for (int value : Fill(10000, /*seed=*/0, /*num_threads=*/1)) {
+    EXPECT_GE(value, 0);
+  }
+}
+
+TEST(RandomFill, StreamsAreIndependent) {
+  EXPECT_NE(StreamSeed(/*seed=*/0, /*stream=*/0),
+            StreamSeed(/*seed=*/0, /*stream=*/1));
+  EXPECT_NE(StreamSeed(/*seed=*/0, /*stream=*/1),
+            StreamSeed(/*seed=*/1, /*stream=*/0));
+}
+
+TEST(RandomFill, ParallelForCoversEveryElementOnce) {
+  std::vector<int> counts(12345, 0);
+  ParallelFor(
+      counts.size(),
+      [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+          ++counts[i];
+        }
+      },
+      /*min_elements_per_thread=*/100, /*num_threads=*/8);
+  for (int count : counts) {
+    EXPECT_EQ(count, 1);
+  }
+}
+
+TEST(RandomFill, ParallelForEmptyRange) {
+  int calls = 0;
+  ParallelFor(0, [&](size_t begin, size_t end) {
+    EXPECT_EQ(begin, end);
+    ++calls;
+  });
+  EXPECT_EQ(calls, 1);
+}
+
+}  // anonymous namespace
+}  // namespace util
+}  // namespace cldrive
+}  // namespace gpu
+
+TEST_MAIN();
@@ -0,0 +1,231 @@
+// Copyright (c) 2016-2020 Chris Cummins.
+// This file is part of cldrive.
+//
+// cldrive is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// cldrive is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with cldrive.  If not, see <https://www.gnu.org/licenses/>.
+#include "gpu/cldrive/run_statistics.h"
+
+#include "labm8/cpp/logging.h"
+#include "labm8/cpp/status.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace gpu {
+namespace cldrive {
+
+namespace {
+
+// The two-sided 95% quantile of the standard normal distribution.
+constexpr double kZ95 = 1.959964;
+
+// The ratio of the standard deviation to the MAD of a normal distribution.
+constexpr double kMadScale = 1.4826;
+
+// Samples more than this many scaled MADs from the median are outliers.
+constexpr double kOutlierThreshold = 3;
+
+}  // anonymous namespace
+
+double Median(std::vector<labm8::int64> samples) {
+  CHECK(!samples.empty());
+  const size_t n = samples.size();
+  std::sort(samples.begin(), samples.end());
+  if (n % 2) {
+    return samples[n / 2];
+  }
+  return (samples[n / 2 - 1] + samples[n / 2]) / 2.0;
+}
+
+labm8::StatusOr<std::pair<labm8::int64, labm8::int64>> MedianConfidenceInterval(
+    std::vector<labm8::int64> samples) {
+  // The number of samples below the median is Binomial(n, 0.5). Using its
+  // normal approximation, the interval is bounded by the order statistics of
+  // rank n/2 -/+ z*sqrt(n)/2 (one-based).
+  const double n = samples.size();
+  const double half_width = kZ95 * std::sqrt(n) / 2;
+  const long lower_rank = static_cast<long>(std::floor(n / 2 - half_width));
+  const long upper_rank =
+      static_cast<long>(std::ceil(n / 2 + 1 + half_width));
+  if (lower_rank < 1 || upper_rank > static_cast<long>(samples.size())) {
+    return labm8::Status(labm8::error::Code::FAILED_PRECONDITION,
+                         "Too few samples for a confidence interval: {}",
+                         samples.size());
+  }
+
+  std::sort(samples.begin(), samples.end());
+  return std::make_pair(samples[lower_rank - 1], samples[upper_rank - 1]);
+}
+
+labm8::StatusOr<double> RelativeMedianConfidenceIntervalWidth(
+    const std::vector<labm8::int64>& samples) {
+  auto interval_or = MedianConfidenceInterval(samples);
+  if (!interval_or.ok()) {
+    return interval_or.status();
+  }
+  const double median = Median(samples);
+  if (median == 0) {
+    return labm8::Status(labm8::error::Code::FAILED_PRECONDITION,
+                         "Median is zero");
+  }
+  const auto& interval = interval_or.ValueOrDie();
+  return (interval.second - interval.first) / median;
+}
+
+StreamingQuantile::StreamingQuantile(double p)
+    : p_(p),
+      count_(0),
+      positions_{0, 1, 2, 3, 4},
+      desired_{0, 2 * p, 4 * p, 2 + 2 * p, 4},
+      increments_{0, p / 2, p, (1 + p) / 2, 1} {
+  CHECK(p > 0 && p < 1) << "Quantile out of range: " << p;
+}
+
+void StreamingQuantile::Add(double value) {
+  // The first five samples initialize the markers.
+  if (count_ < 5) {
+    heights_[count_++] = value;
+    if (count_ == 5) {
+      std::sort(heights_, heights_ + 5);
+    }
+    return;
+  }
+  ++count_;
+
+  // Find the cell k containing the sample, extending the extremes if needed.
+  int k;
+  if (value < heights_[0]) {
+    heights_[0] = value;
+    k = 0;
+  } else if (value >= heights_[4]) {
+    heights_[4] = value;
+    k = 3;
+  } else {
+    k = 0;
+    while (value >= heights_[k + 1]) {
+      ++k;
+    }
+  }
+
+  for (int i = k + 1; i < 5; ++i) {
+    ++positions_[i];
+  }
+  for (int i = 0; i < 5; ++i) {
+    desired_[i] += increments_[i];
+  }
+
+  // Move the middle markers towards their desired positions.
+  for (int i = 1; i < 4; ++i) {
+    const double offset = desired_[i] - positions_[i];
+    if ((offset >= 1 && positions_[i + 1] - positions_[i] > 1) ||
+        (offset <= -1 && positions_[i - 1] - positions_[i] < -1)) {
+      const int d = offset > 0 ? 1 : -1;
+      const double height = Parabolic(i, d);
+      if (heights_[i - 1] < height && height < heights_[i + 1]) {
+        heights_[i] = height;
+      } else {
+        heights_[i] = Linear(i, d);
+      }
+      positions_[i] += d;
+    }
+  }
+}
+
+double StreamingQuantile::Parabolic(int i, double d) const {
+  return heights_[i] +
+         d / (positions_[i + 1] - positions_[i - 1]) *
+             ((positions_[i] - positions_[i - 1] + d) *
+                  (heights_[i + 1] - heights_[i]) /
+                  (positions_[i + 1] - positions_[i]) +
+              (positions_[i + 1] - positions_[i] - d) *
+                  (heights_[i] - heights_[i - 1]) /
+                  (positions_[i] - positions_[i - 1]));
+}
+
+double StreamingQuantile::Linear(int i, int d) const {
+  return heights_[i] + d * (heights_[i + d] - heights_[i]) /
+                           (positions_[i + d] - positions_[i]);
+}
+
+double StreamingQuantile::Value() const {
+  CHECK(count_ > 0);
+  if (count_ >= 5) {
+    return heights_[2];
+  }
+
+  // Interpolate between the sorted samples.
+  double sorted[5];
+  std::copy(heights_, heights_ + count_, sorted);
+  std::sort(sorted, sorted + count_);
+  const double rank = p_ * (count_ - 1);
+  const int lower = static_cast<int>(std::floor(rank));
+  const int upper = static_cast<int>(std::ceil(rank));
+  return sorted[lower] + (rank - lower) * (sorted[upper] - sorted[lower]);
+}
+
+RunStatistics::RunStatistics()
+    : count_(0),
+      min_(std::numeric_limits<labm8::int64>::max()),
+      max_(std::numeric_limits<labm8::int64>::min()),
+      mean_(0),
+      m2_(0),
+      p25_(0.25),
+      p50_(0.5),
+      p75_(0.75),
+      p99_(0.99),
+      mad_(0.5),
+      num_outliers_(0) {}
+
+void RunStatistics::Add(labm8::int64 value) {
+  if (count_ >= 5) {
+    const double scaled_mad = kMadScale * mad_.Value();
+    if (scaled_mad > 0 &&
+        std::abs(value - p50_.Value()) > kOutlierThreshold * scaled_mad) {
+      ++num_outliers_;
+    }
+  }
+
+  ++count_;
+  min_ = std::min(min_, value);
+  max_ = std::max(max_, value);
+  const double delta = value - mean_;
+  mean_ += delta / count_;
+  m2_ += delta * (value - mean_);
+
+  p25_.Add(value);
+  p50_.Add(value);
+  p75_.Add(value);
+  p99_.Add(value);
+  mad_.Add(std::abs(value - p50_.Value()));
+}
+
+KernelTimeSummary RunStatistics::Summary() const {
+  CHECK(count_ > 0);
+  KernelTimeSummary summary;
+  summary.set_num_runs(count_);
+  summary.set_min(min_);
+  summary.set_max(max_);
+  summary.set_mean(mean_);
+  summary.set_stddev(count_ > 1 ? std::sqrt(m2_ / (count_ - 1)) : 0);
+  summary.set_p25(p25_.Value());
+  summary.set_p50(p50_.Value());
+  summary.set_p75(p75_.Value());
+  summary.set_p99(p99_.Value());
+  summary.set_mad(mad_.Value());
+  summary.set_num_outliers(num_outliers_);
+  return summary;
+}
+
+}  // namespace cldrive
+}  // namespace gpu
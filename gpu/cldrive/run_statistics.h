@@ -0,0 +1,111 @@
+// Statistics over the timings of repeated kernel runs.
+//
+// Copyright (c) 2016-2020 Chris Cummins.
+// This file is part of cldrive.
+//
+// cldrive is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// cldrive is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with cldrive.  If not, see <https://www.gnu.org/licenses/>.
+#pragma once
+
+#include "gpu/cldrive/proto/cldrive.pb.h"
+
+#include "labm8/cpp/port.h"
+#include "labm8/cpp/statusor.h"
+
+#include <utility>
+#include <vector>
+
+namespace gpu {
+namespace cldrive {
+
+// Return the median of a list of samples. The list must not be empty.
+double Median(std::vector<labm8::int64> samples);
+
+// Return a distribution-free 95% confidence interval of the median, as the
+// pair of order statistics which bracket it. Returns FAILED_PRECONDITION if
+// there are too few samples (fewer than 8) for the interval to exist.
+labm8::StatusOr<std::pair<labm8::int64, labm8::int64>> MedianConfidenceInterval(
+    std::vector<labm8::int64> samples);
+
+// Return the width of the 95% confidence interval of the median, relative to
+// the median. Returns FAILED_PRECONDITION if there are too few samples, or if
+// the median is zero.
+labm8::StatusOr<double> RelativeMedianConfidenceIntervalWidth(
+    const std::vector<labm8::int64>& samples);
+
+// A streaming estimate of a single quantile, using the P-square algorithm of
+// Jain and Chlamtac (1985). Memory use is constant in the number of samples.
+// The estimate is exact for fewer than five samples.
+class StreamingQuantile {
+ public:
+  // Construct an estimator for the p-quantile, where 0 < p < 1.
+  explicit StreamingQuantile(double p);
+
+  void Add(double value);
+
+  // Return the estimated quantile. There must be at least one sample.
+  double Value() const;
+
+  labm8::int64 count() const { return count_; }
+
+ private:
+  // Return the parabolic prediction for marker i moved by d (+1 or -1).
+  double Parabolic(int i, double d) const;
+  // Return the linear prediction for marker i moved by d (+1 or -1).
+  double Linear(int i, int d) const;
+
+  double p_;
+  labm8::int64 count_;
+  // Marker heights, actual positions, desired positions, and desired
+  // position increments.
+  double heights_[5];
+  double positions_[5];
+  double desired_[5];
+  double increments_[5];
+};
+
+// Streaming summary statistics of kernel times. The count, minimum, maximum,
+// mean, and standard deviation are exact. Quantiles are StreamingQuantile
+// estimates. The median absolute deviation (MAD) is estimated as the
+// streaming median of each sample's distance from the median estimate at the
+// time it was added. Likewise, a sample is counted as an outlier if it is
+// more than 3 scaled MADs (1.4826 * MAD) from the median estimate when it is
+// added. Outliers are not counted among the first five samples.
+class RunStatistics {
+ public:
+  RunStatistics();
+
+  void Add(labm8::int64 value);
+
+  labm8::int64 count() const { return count_; }
+
+  // Return the summary. There must be at least one sample.
+  KernelTimeSummary Summary() const;
+
+ private:
+  labm8::int64 count_;
+  labm8::int64 min_;
+  labm8::int64 max_;
+  // Welford's running mean and sum of squared differences from the mean.
+  double mean_;
+  double m2_;
+  StreamingQuantile p25_;
+  StreamingQuantile p50_;
+  StreamingQuantile p75_;
+  StreamingQuantile p99_;
+  StreamingQuantile mad_;
+  labm8::int64 num_outliers_;
+};
+
+}  // namespace cldrive
+}  // namespace gpu
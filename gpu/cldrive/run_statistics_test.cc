@@ -0,0 +1,131 @@
+// Copyright (c) 2016-2020 Chris Cummins.
+// This file is part of cldrive.
+//
+// cldrive is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// cldrive is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with cldrive.  If not, see <https://www.gnu.org/licenses/>.
+#include "gpu/cldrive/run_statistics.h"
+
+#include "labm8/cpp/test.h"
+
+#include <cmath>
+
+namespace gpu {
+namespace cldrive {
+namespace {
+
+TEST(Median, OddNumberOfSamples) { EXPECT_EQ(Median({5, 1, 3}), 3); }
+
+TEST(Median, EvenNumberOfSamples) { EXPECT_EQ(Median({4, 1, 3, 2}), 2.5); }
+
+TEST(MedianConfidenceInterval, TooFewSamples) {
+  EXPECT_FALSE(MedianConfidenceInterval({1, 2, 3, 4, 5, 6, 7}).ok());
+}
+
+TEST(MedianConfidenceInterval, SmallestSampleUsesExtremes) {
+  auto interval_or = MedianConfidenceInterval({8, 1, 7, 2, 6, 3, 5, 4});
+  ASSERT_TRUE(interval_or.ok());
+  EXPECT_EQ(interval_or.ValueOrDie().first, 1);
+  EXPECT_EQ(interval_or.ValueOrDie().second, 8);
+}
+
+TEST(MedianConfidenceInterval, IntervalBracketsMedian) {
+  std::vector<labm8::int64> samples;
+  for (int i = 1; i <= 100; ++i) {
+    samples.push_back(i);
+  }
+  auto interval_or = MedianConfidenceInterval(samples);
+  ASSERT_TRUE(interval_or.ok());
+  EXPECT_EQ(interval_or.ValueOrDie().first, 40);
+  EXPECT_EQ(interval_or.ValueOrDie().second, 61);
+}
+
+TEST(RelativeMedianConfidenceIntervalWidth, ConstantSamples) {
+  std::vector<labm8::int64> samples(20, 1000);
+  auto width_or = RelativeMedianConfidenceIntervalWidth(samples);
+  ASSERT_TRUE(width_or.ok());
+  EXPECT_EQ(width_or.ValueOrDie(), 0);
+}
+
+TEST(RelativeMedianConfidenceIntervalWidth, ZeroMedian) {
+  std::vector<labm8::int64> samples(20, 0);
+  EXPECT_FALSE(RelativeMedianConfidenceIntervalWidth(samples).ok());
+}
+
+TEST(StreamingQuantile, ExactForFewSamples) {
+  StreamingQuantile median(0.5);
+  median.Add(3);
+  EXPECT_EQ(median.Value(), 3);
+  median.Add(1);
+  EXPECT_EQ(median.Value(), 2);
+  median.Add(2);
+  EXPECT_EQ(median.Value(), 2);
+}
+
+TEST(StreamingQuantile, ConvergesOnUniformSamples) {
+  StreamingQuantile p25(0.25);
+  StreamingQuantile p50(0.5);
+  StreamingQuantile p99(0.99);
+  // Add the values 0..9999 in a scrambled order.
+  for (int i = 0; i < 10000; ++i) {
+    const double value = (i * 7919) % 10000;
+    p25.Add(value);
+    p50.Add(value);
+    p99.Add(value);
+  }
+  EXPECT_NEAR(p25.Value(), 2500, 100);
+  EXPECT_NEAR(p50.Value(), 5000, 100);
+  EXPECT_NEAR(p99.Value(), 9900, 100);
+}
+
+TEST(RunStatistics, ExactMoments) {
+  RunStatistics statistics;
+  for (labm8::int64 value : {2, 4, 4, 4, 5, 5, 7, 9}) {
+    statistics.Add(value);
+  }
+  const KernelTimeSummary summary = statistics.Summary();
+  EXPECT_EQ(summary.num_runs(), 8);
+  EXPECT_EQ(summary.min(), 2);
+  EXPECT_EQ(summary.max(), 9);
+  EXPECT_EQ(summary.mean(), 5);
+  EXPECT_NEAR(summary.stddev(), std::sqrt(32.0 / 7), 1e-9);
+}
+
+TEST(RunStatistics, SingleSample) {
+  RunStatistics statistics;
+  statistics.Add(100);
+  const KernelTimeSummary summary = statistics.Summary();
+  EXPECT_EQ(summary.num_runs(), 1);
+  EXPECT_EQ(summary.stddev(), 0);
+  EXPECT_EQ(summary.p50(), 100);
+  EXPECT_EQ(summary.mad(), 0);
+}
+
+TEST(RunStatistics, CountsOutliers) {
+  RunStatistics statistics;
+  for (int i = 0; i < 100; ++i) {
+    statistics.Add(1000 + (i % 10));
+  }
+  const labm8::int64 num_outliers = statistics.Summary().num_outliers();
+  statistics.Add(100000);
+  statistics.Add(1);
+  const KernelTimeSummary summary = statistics.Summary();
+  EXPECT_EQ(summary.num_outliers(), num_outliers + 2);
+  EXPECT_NEAR(summary.p50(), 1004.5, 2);
+  EXPECT_NEAR(summary.mad(), 2.5, 1);
+}
+
+}  // anonymous namespace
+}  // namespace cldrive
+}  // namespace gpu
+
+TEST_MAIN();
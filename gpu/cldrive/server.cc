@@ -0,0 +1,135 @@
+// Copyright (c) 2016-2020 Chris Cummins.
+// This file is part of cldrive.
+//
+// cldrive is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// cldrive is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with cldrive.  If not, see <https://www.gnu.org/licenses/>.
+#include "gpu/cldrive/server.h"
+
+#include "gpu/cldrive/libcldrive.h"
+#include "gpu/cldrive/logger.h"
+#include "gpu/cldrive/proto/cldrive.pb.h"
+
+#include "labm8/cpp/logging.h"
+
+#include "google/protobuf/io/zero_copy_stream_impl.h"
+#include "google/protobuf/util/delimited_message_util.h"
+
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <cstring>
+#include <sstream>
+
+namespace gpu {
+namespace cldrive {
+
+labm8::Status ServeFileDescriptors(int input_fd, int output_fd,
+                                   CldriveSession* session) {
+  google::protobuf::io::FileInputStream input(input_fd);
+  google::protobuf::io::FileOutputStream output(output_fd);
+
+  // Results are returned in the response protos, so the logger is only
+  // needed to satisfy the driver interface.
+  std::stringstream null_stream;
+  NULLLogger logger(null_stream, /*instances=*/nullptr);
+
+  for (int request_num = 0;; ++request_num) {
+    CldriveInstance instance;
+    bool clean_eof = false;
+    if (!google::protobuf::util::ParseDelimitedFromZeroCopyStream(
+            &instance, &input, &clean_eof)) {
+      if (clean_eof) {
+        return labm8::Status::OK;
+      }
+      return labm8::Status(labm8::error::Code::INVALID_ARGUMENT,
+                           "Failed to parse request {}", request_num);
+    }
+
+    // Clear any output fields set by the client.
+    instance.clear_outcome();
+    instance.clear_kernel();
+
+    logger.StartNewInstance();
+    // An OpenCL error fails only its own request, whose response then has
+    // the CL_ERROR outcome.
+    labm8::Status status =
+        Cldrive(&instance, session, request_num).Run(logger);
+    if (!status.ok()) {
+      LOG(ERROR) << "Request " << request_num << " failed: "
+                 << status.ToString();
+    }
+
+    if (!google::protobuf::util::SerializeDelimitedToZeroCopyStream(
+            instance, &output) ||
+        !output.Flush()) {
+      return labm8::Status(labm8::error::Code::UNAVAILABLE,
+                           "Failed to write response {}", request_num);
+    }
+    LOG(INFO) << "Served request " << request_num << " ("
+              << session->program_cache_hits() << " program cache hits, "
+              << session->program_cache_misses() << " misses)";
+  }
+}
+
+labm8::Status ServeUnixSocket(const string& path, CldriveSession* session) {
+  int server_fd = socket(AF_UNIX, SOCK_STREAM, 0);
+  if (server_fd < 0) {
+    return labm8::Status(labm8::error::Code::UNAVAILABLE,
+                         "socket() failed: {}", strerror(errno));
+  }
+
+  sockaddr_un address;
+  memset(&address, 0, sizeof(address));
+  address.sun_family = AF_UNIX;
+  if (path.size() >= sizeof(address.sun_path)) {
+    close(server_fd);
+    return labm8::Status(labm8::error::Code::INVALID_ARGUMENT,
+                         "Socket path too long: '{}'", path);
+  }
+  strncpy(address.sun_path, path.c_str(), sizeof(address.sun_path) - 1);
+
+  // Remove a stale socket left behind by a previous server.
+  unlink(path.c_str());
+  if (bind(server_fd, reinterpret_cast<sockaddr*>(&address),
+           sizeof(address)) < 0 ||
+      listen(server_fd, /*backlog=*/16) < 0) {
+    close(server_fd);
+    return labm8::Status(labm8::error::Code::UNAVAILABLE,
+                         "Failed to listen on '{}': {}", path,
+                         strerror(errno));
+  }
+  LOG(INFO) << "Listening on " << path;
+
+  while (true) {
+    int client_fd = accept(server_fd, nullptr, nullptr);
+    if (client_fd < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      close(server_fd);
+      return labm8::Status(labm8::error::Code::UNAVAILABLE,
+                           "accept() failed: {}", strerror(errno));
+    }
+
+    labm8::Status status =
+        ServeFileDescriptors(client_fd, client_fd, session);
+    if (!status.ok()) {
+      LOG(WARNING) << "Dropping connection: " << status.ToString();
+    }
+    close(client_fd);
+  }
+}
+
+}  // namespace cldrive
+}  // namespace gpu
@@ -0,0 +1,45 @@
+// A long-lived server which drives CldriveInstance requests.
+//
+// Requests and responses are framed as varint32 length-prefixed serialized
+// protos (the format of Java's writeDelimitedTo() and Python's
+// _VarintBytes(len(msg)) + msg). Each request is a CldriveInstance, and the
+// response is the same CldriveInstance with its output fields populated.
+//
+// Copyright (c) 2016-2020 Chris Cummins.
+// This file is part of cldrive.
+//
+// cldrive is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// cldrive is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with cldrive.  If not, see <https://www.gnu.org/licenses/>.
+#pragma once
+
+#include "gpu/cldrive/session.h"
+
+#include "labm8/cpp/status.h"
+#include "labm8/cpp/string.h"
+
+namespace gpu {
+namespace cldrive {
+
+// Read requests from the input file descriptor and write responses to the
+// output file descriptor until the input is closed. All requests share the
+// given session.
+labm8::Status ServeFileDescriptors(int input_fd, int output_fd,
+                                   CldriveSession* session);
+
+// Listen on a Unix domain socket at the given path and serve connections
+// one at a time. Connections share a single session. This function only
+// returns on error.
+labm8::Status ServeUnixSocket(const string& path, CldriveSession* session);
+
+}  // namespace cldrive
+}  // namespace gpu
@@ -0,0 +1,65 @@
+// Copyright (c) 2016-2020 Chris Cummins.
+// This file is part of cldrive.
+//
+// cldrive is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// cldrive is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with cldrive.  If not, see <https://www.gnu.org/licenses/>.
+#include "gpu/cldrive/server.h"
+
+#include "labm8/cpp/test.h"
+
+#include <unistd.h>
+
+namespace gpu {
+namespace cldrive {
+namespace {
+
+TEST(ServeFileDescriptors, EmptyInputIsOk) {
+  int input[2];
+  int output[2];
+  ASSERT_EQ(pipe(input), 0);
+  ASSERT_EQ(pipe(output), 0);
+  close(input[1]);
+
+  CldriveSession session;
+  EXPECT_TRUE(ServeFileDescriptors(input[0], output[1], &session).ok());
+
+  close(input[0]);
+  close(output[0]);
+  close(output[1]);
+}
+
+TEST(ServeFileDescriptors, TruncatedRequestIsError) {
+  int input[2];
+  int output[2];
+  ASSERT_EQ(pipe(input), 0);
+  ASSERT_EQ(pipe(output), 0);
+
+  // A length prefix of 100 bytes, followed by only 3.
+  const char truncated[] = {100, 'a', 'b', 'c'};
+  ASSERT_EQ(write(input[1], truncated, sizeof(truncated)),
+            static_cast<ssize_t>(sizeof(truncated)));
+  close(input[1]);
+
+  CldriveSession session;
+  EXPECT_FALSE(ServeFileDescriptors(input[0], output[1], &session).ok());
+
+  close(input[0]);
+  close(output[0]);
+  close(output[1]);
+}
+
+}  // anonymous namespace
+}  // namespace cldrive
+}  // namespace gpu
+
+TEST_MAIN();
@@ -0,0 +1,194 @@
+// Copyright (c) 2016-2020 Chris Cummins.
+// This file is part of cldrive.
+//
+// cldrive is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// cldrive is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with cldrive.  If not, see <https://www.gnu.org/licenses/>.
+#include "gpu/cldrive/session.h"
+
+#include "gpu/cldrive/program_cache.h"
+#include "gpu/clinfo/libclinfo.h"
+
+#include "labm8/cpp/logging.h"
+#include "labm8/cpp/status.h"
+
+#include <algorithm>
+#include <chrono>
+#include <thread>
+
+namespace gpu {
+namespace cldrive {
+
+CldriveSession::~CldriveSession() {
+  // A build which has not finished may never finish, e.g. one abandoned by a
+  // compile timeout, so it is detached rather than waited for. Its thread
+  // owns copies of the context, source and promise, so it does not use the
+  // session.
+  for (auto& build : builds_) {
+    if (build.second.wait_for(std::chrono::seconds(0)) ==
+        std::future_status::ready) {
+      build.first.join();
+    } else {
+      build.first.detach();
+    }
+  }
+}
+
+CldriveSession::BuildFuture CldriveSession::StartBuild(
+    const cl::Context& context, const string& opencl_src,
+    const string& build_opts) {
+  // The thread shares ownership of the promise, and captures the context and
+  // sources by value, so that it may outlive the session.
+  auto promise =
+      std::make_shared<std::promise<labm8::StatusOr<cl::Program>>>();
+  auto future = promise->get_future().share();
+  std::thread thread([=]() {
+    promise->set_value(BuildOpenClProgram(opencl_src, context, build_opts));
+  });
+
+  labm8::MutexLock lock(&mutex_);
+  JoinFinishedBuilds();
+  builds_.emplace_back(std::move(thread), future);
+  return future;
+}
+
+void CldriveSession::JoinFinishedBuilds() {
+  // A thread whose result is ready returns right after setting it, so
+  // joining it does not wait for a build.
+  auto finished = std::partition(
+      builds_.begin(), builds_.end(),
+      [](const std::pair<std::thread, BuildFuture>& build) {
+        return build.second.wait_for(std::chrono::seconds(0)) !=
+               std::future_status::ready;
+      });
+  for (auto it = finished; it != builds_.end(); ++it) {
+    it->first.join();
+  }
+  builds_.erase(finished, builds_.end());
+}
+
+DeviceState* CldriveSession::GetDeviceStateOrDie(
+    const ::gpu::clinfo::OpenClDevice& device) {
+  labm8::MutexLock lock(&mutex_);
+
+  auto it = devices_.find(device.name());
+  if (it != devices_.end()) {
+    return it->second.get();
+  }
+
+  auto state = std::make_unique<DeviceState>();
+  state->name = device.name();
+  state->device = labm8::gpu::clinfo::GetOpenClDeviceOrDie(device);
+  state->context = cl::Context(state->device);
+  state->queue = cl::CommandQueue(state->context, state->device,
+                                  /*properties=*/CL_QUEUE_PROFILING_ENABLE);
+  state->buffer_pool = std::make_unique<DeviceBufferPool>(state->context);
+
+  DeviceState* ptr = state.get();
+  devices_[device.name()] = std::move(state);
+  return ptr;
+}
+
+DeviceBufferHasher* CldriveSession::GetBufferHasher(
+    DeviceState* device_state) {
+  labm8::MutexLock lock(&mutex_);
+  if (!device_state->buffer_hasher) {
+    device_state->buffer_hasher =
+        std::make_unique<DeviceBufferHasher>(device_state->context);
+  }
+  return device_state->buffer_hasher.get();
+}
+
+labm8::StatusOr<cl::Program> CldriveSession::GetProgram(
+    DeviceState* device_state, const string& opencl_src,
+    const string& build_opts, labm8::int64 timeout_ms) {
+  ProgramKey key{device_state->name, build_opts, opencl_src};
+  BuildFuture prefetch;
+
+  {
+    labm8::MutexLock lock(&mutex_);
+    auto it = programs_.find(key);
+    if (it != programs_.end()) {
+      ++program_cache_hits_;
+      return it->second;
+    }
+    ++program_cache_misses_;
+
+    auto prefetch_it = prefetches_.find(key);
+    if (prefetch_it != prefetches_.end()) {
+      prefetch = prefetch_it->second;
+      prefetches_.erase(prefetch_it);
+    }
+  }
+
+  // A build with a time budget is run in the background, so that it can be
+  // abandoned.
+  if (timeout_ms > 0) {
+    if (!prefetch.valid()) {
+      prefetch = StartBuild(device_state->context, opencl_src, build_opts);
+    }
+    if (prefetch.wait_for(std::chrono::milliseconds(timeout_ms)) !=
+        std::future_status::ready) {
+      // Keep the build, so that a later request for the program does not
+      // start another.
+      labm8::MutexLock lock(&mutex_);
+      if (prefetches_.size() < kMaxPrefetchedPrograms) {
+        prefetches_.emplace(key, prefetch);
+      }
+      return labm8::Status(labm8::error::Code::DEADLINE_EXCEEDED,
+                           "Program build exceeded {} ms", timeout_ms);
+    }
+  }
+
+  // Build outside of the lock so that programs for different devices (or
+  // different sources) may be compiled concurrently.
+  auto program_or =
+      prefetch.valid()
+          ? prefetch.get()
+          : BuildOpenClProgram(opencl_src, device_state->context, build_opts);
+  if (!program_or.ok()) {
+    return program_or;
+  }
+
+  labm8::MutexLock lock(&mutex_);
+  if (programs_.find(key) == programs_.end()) {
+    if (programs_.size() >= kMaxCachedPrograms) {
+      programs_.erase(program_order_.front());
+      program_order_.pop_front();
+    }
+    programs_[key] = program_or.ValueOrDie();
+    program_order_.push_back(key);
+  }
+  return program_or;
+}
+
+void CldriveSession::PrefetchProgram(DeviceState* device_state,
+                                     const string& opencl_src,
+                                     const string& build_opts) {
+  ProgramKey key{device_state->name, build_opts, opencl_src};
+
+  {
+    labm8::MutexLock lock(&mutex_);
+    if (programs_.find(key) != programs_.end() ||
+        prefetches_.find(key) != prefetches_.end() ||
+        prefetches_.size() >= kMaxPrefetchedPrograms) {
+      return;
+    }
+  }
+  auto build = StartBuild(device_state->context, opencl_src, build_opts);
+
+  labm8::MutexLock lock(&mutex_);
+  prefetches_.emplace(key, build);
+}
+
+}  // namespace cldrive
+}  // namespace gpu
@@ -0,0 +1,137 @@
+// A session holds the OpenCL state that can outlive a single CldriveInstance.
+//
+// Copyright (c) 2016-2020 Chris Cummins.
+// This file is part of cldrive.
+//
+// cldrive is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// cldrive is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with cldrive.  If not, see <https://www.gnu.org/licenses/>.
+#pragma once
+
+#include "gpu/cldrive/device_buffer_pool.h"
+#include "gpu/cldrive/output_check.h"
+#include "gpu/clinfo/proto/clinfo.pb.h"
+
+#include "labm8/cpp/macros.h"
+#include "labm8/cpp/mutex.h"
+#include "labm8/cpp/port.h"
+#include "labm8/cpp/statusor.h"
+#include "labm8/cpp/string.h"
+
+#include "third_party/opencl/cl.hpp"
+
+#include <deque>
+#include <future>
+#include <map>
+#include <memory>
+#include <thread>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+namespace gpu {
+namespace cldrive {
+
+// The OpenCL objects needed to drive kernels on a single device.
+struct DeviceState {
+  // The fully qualified device name, as reported by --clinfo.
+  string name;
+  cl::Device device;
+  cl::Context context;
+  cl::CommandQueue queue;
+  // Device buffers for argument values, shared by all kernels on the device.
+  std::unique_ptr<DeviceBufferPool> buffer_pool;
+  // Hashes buffers for output checks, shared by all kernels on the device.
+  // Created by the first call to CldriveSession::GetBufferHasher().
+  std::unique_ptr<DeviceBufferHasher> buffer_hasher;
+};
+
+// A session owns one context and profiling-enabled command queue per device,
+// and a table of compiled programs. Sharing a session between instances
+// avoids re-creating the context and re-compiling the program for every
+// instance, which dominates the runtime of short kernels.
+//
+// Lookups are thread safe. The returned DeviceState is owned by the session
+// and lives as long as it.
+class CldriveSession {
+ public:
+  // The maximum number of compiled programs that are retained. When the table
+  // is full, the oldest program is evicted.
+  static constexpr size_t kMaxCachedPrograms = 256;
+
+  // The maximum number of builds which are kept for a later GetProgram()
+  // without having been claimed by one. Further prefetches are ignored.
+  static constexpr size_t kMaxPrefetchedPrograms = 64;
+
+  CldriveSession() = default;
+
+  // Joins the threads of finished builds. Builds which are still running,
+  // including those abandoned by a timeout, are detached and left to finish
+  // in the background, so that a hung compile does not hang the destructor.
+  ~CldriveSession();
+
+  // Return the state for a device, creating it on first use.
+  DeviceState* GetDeviceStateOrDie(const ::gpu::clinfo::OpenClDevice& device);
+
+  // Return the buffer hasher of a device, building its kernel on first use.
+  DeviceBufferHasher* GetBufferHasher(DeviceState* device_state);
+
+  // Return a program built for the device, compiling it on first use. Failed
+  // builds are not cached. If the program is being prefetched, wait for that
+  // build rather than starting another. If timeout_ms is greater than zero,
+  // returns DEADLINE_EXCEEDED if the build takes longer than that. The build
+  // then continues in the background, and may be claimed by a later call.
+  labm8::StatusOr<cl::Program> GetProgram(DeviceState* device_state,
+                                          const string& opencl_src,
+                                          const string& build_opts,
+                                          labm8::int64 timeout_ms = 0);
+
+  // Start building a program on a background thread, so that a later
+  // GetProgram() for it does not wait for the whole build. Does nothing if the
+  // program is already built or being built.
+  void PrefetchProgram(DeviceState* device_state, const string& opencl_src,
+                       const string& build_opts);
+
+  size_t program_cache_hits() const { return program_cache_hits_; }
+  size_t program_cache_misses() const { return program_cache_misses_; }
+
+ private:
+  // Programs are keyed by device name, build options, and source.
+  using ProgramKey = std::tuple<string, string, string>;
+  using BuildFuture = std::shared_future<labm8::StatusOr<cl::Program>>;
+
+  // Build a program on a background thread, which is joined once the build
+  // has finished, or detached by the destructor.
+  BuildFuture StartBuild(const cl::Context& context, const string& opencl_src,
+                         const string& build_opts);
+
+  // Join the threads of the builds which have finished. Must be called with
+  // mutex_ held.
+  void JoinFinishedBuilds();
+
+  labm8::Mutex mutex_;
+  std::map<string, std::unique_ptr<DeviceState>> devices_;
+  std::map<ProgramKey, cl::Program> programs_;
+  std::deque<ProgramKey> program_order_;
+  // Builds started by PrefetchProgram() which have not been claimed by
+  // GetProgram().
+  std::map<ProgramKey, BuildFuture> prefetches_;
+  // The threads of builds started by StartBuild(), and their results.
+  std::vector<std::pair<std::thread, BuildFuture>> builds_;
+  size_t program_cache_hits_ = 0;
+  size_t program_cache_misses_ = 0;
+
+  DISALLOW_EVIL_CONSTRUCTORS(CldriveSession);
+};
+
+}  // namespace cldrive
+}  // namespace gpu
@@ -0,0 +1,128 @@
+// Copyright (c) 2016-2020 Chris Cummins.
+// This file is part of cldrive.
+//
+// cldrive is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// cldrive is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with cldrive.  If not, see <https://www.gnu.org/licenses/>.
+#include "gpu/cldrive/session.h"
+
+#include "gpu/clinfo/libclinfo.h"
+
+#include "labm8/cpp/test.h"
+
+#include <string>
+
+namespace gpu {
+namespace cldrive {
+namespace {
+
+::gpu::clinfo::OpenClDevice GetTestDevice() {
+  return labm8::gpu::clinfo::GetOpenClDevices().device(0);
+}
+
+TEST(CldriveSession, DeviceStateIsReused) {
+  CldriveSession session;
+  DeviceState* a = session.GetDeviceStateOrDie(GetTestDevice());
+  DeviceState* b = session.GetDeviceStateOrDie(GetTestDevice());
+  EXPECT_EQ(a, b);
+}
+
+TEST(CldriveSession, BufferHasherIsReused) {
+  CldriveSession session;
+  DeviceState* state = session.GetDeviceStateOrDie(GetTestDevice());
+  DeviceBufferHasher* a = session.GetBufferHasher(state);
+  DeviceBufferHasher* b = session.GetBufferHasher(state);
+  EXPECT_NE(a, nullptr);
+  EXPECT_EQ(a, b);
+}
+
+TEST(CldriveSession, ProgramIsCompiledOnce) {
+  CldriveSession session;
+  DeviceState* state = session.GetDeviceStateOrDie(GetTestDevice());
+  const string src = "kernel void A(global int* a) {}";
+
+  ASSERT_TRUE(session.GetProgram(state, src, "").ok());
+  ASSERT_TRUE(session.GetProgram(state, src, "").ok());
+  EXPECT_EQ(session.program_cache_misses(), 1);
+  EXPECT_EQ(session.program_cache_hits(), 1);
+}
+
+TEST(CldriveSession, DifferentBuildOptsAreCompiledSeparately) {
+  CldriveSession session;
+  DeviceState* state = session.GetDeviceStateOrDie(GetTestDevice());
+  const string src = "kernel void A(global int* a) {}";
+
+  ASSERT_TRUE(session.GetProgram(state, src, "").ok());
+  ASSERT_TRUE(session.GetProgram(state, src, "-DFOO").ok());
+  EXPECT_EQ(session.program_cache_misses(), 2);
+}
+
+TEST(CldriveSession, FailedBuildIsNotCached) {
+  CldriveSession session;
+  DeviceState* state = session.GetDeviceStateOrDie(GetTestDevice());
+  const string src = "kernel void A(global int* a) { syntax error }";
+
+  EXPECT_FALSE(session.GetProgram(state, src, "").ok());
+  EXPECT_FALSE(session.GetProgram(state, src, "").ok());
+  EXPECT_EQ(session.program_cache_hits(), 0);
+}
+
+TEST(CldriveSession, PrefetchedProgramIsNotRebuilt) {
+  CldriveSession session;
+  DeviceState* state = session.GetDeviceStateOrDie(GetTestDevice());
+  const string src = "kernel void A(global int* a) {}";
+
+  session.PrefetchProgram(state, src, "");
+  session.PrefetchProgram(state, src, "");
+  ASSERT_TRUE(session.GetProgram(state, src, "").ok());
+  ASSERT_TRUE(session.GetProgram(state, src, "").ok());
+  EXPECT_EQ(session.program_cache_misses(), 1);
+  EXPECT_EQ(session.program_cache_hits(), 1);
+}
+
+TEST(CldriveSession, FailedPrefetchIsReturned) {
+  CldriveSession session;
+  DeviceState* state = session.GetDeviceStateOrDie(GetTestDevice());
+  const string src = "kernel void A(global int* a) { syntax error }";
+
+  session.PrefetchProgram(state, src, "");
+  EXPECT_FALSE(session.GetProgram(state, src, "").ok());
+}
+
+TEST(CldriveSession, ProgramBuiltWithinTimeoutIsCached) {
+  CldriveSession session;
+  DeviceState* state = session.GetDeviceStateOrDie(GetTestDevice());
+  const string src = "kernel void A(global int* a) {}";
+
+  ASSERT_TRUE(session.GetProgram(state, src, "", /*timeout_ms=*/60000).ok());
+  ASSERT_TRUE(session.GetProgram(state, src, "", /*timeout_ms=*/60000).ok());
+  EXPECT_EQ(session.program_cache_misses(), 1);
+  EXPECT_EQ(session.program_cache_hits(), 1);
+}
+
+TEST(CldriveSession, UnclaimedPrefetchesDoNotBlockDestruction) {
+  CldriveSession session;
+  DeviceState* state = session.GetDeviceStateOrDie(GetTestDevice());
+
+  // More than kMaxPrefetchedPrograms, so some of the prefetches are ignored.
+  for (size_t i = 0; i <= CldriveSession::kMaxPrefetchedPrograms; ++i) {
+    session.PrefetchProgram(
+        state, "kernel void A" + std::to_string(i) + "(global int* a) {}",
+        "");
+  }
+}
+
+}  // anonymous namespace
+}  // namespace cldrive
+}  // namespace gpu
+
+TEST_MAIN();
@@ -0,0 +1,96 @@
+// Copyright (c) 2016-2020 Chris Cummins.
+// This file is part of cldrive.
+//
+// cldrive is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// cldrive is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with cldrive.  If not, see <https://www.gnu.org/licenses/>.
+#include "gpu/cldrive/sweep.h"
+
+#include "labm8/cpp/status.h"
+
+#include "absl/strings/match.h"
+#include "google/protobuf/text_format.h"
+#include "google/protobuf/util/json_util.h"
+
+#include <algorithm>
+
+namespace gpu {
+namespace cldrive {
+
+labm8::StatusOr<CldriveSweep> ParseSweep(const string& path,
+                                         const string& contents) {
+  CldriveSweep sweep;
+
+  bool parsed;
+  if (absl::EndsWith(path, ".json")) {
+    parsed = google::protobuf::util::JsonStringToMessage(contents, &sweep).ok();
+  } else if (absl::EndsWith(path, ".pb")) {
+    parsed = sweep.ParseFromString(contents);
+  } else {
+    parsed = google::protobuf::TextFormat::ParseFromString(contents, &sweep);
+  }
+  if (!parsed) {
+    return labm8::Status(labm8::error::Code::INVALID_ARGUMENT,
+                         "Failed to parse sweep file '{}'", path);
+  }
+
+  for (auto& kernel : *sweep.mutable_kernel()) {
+    for (auto& dynamic_params : *kernel.mutable_dynamic_params()) {
+      if (dynamic_params.global_size_x() < 1 ||
+          dynamic_params.local_size_x() < 1) {
+        return labm8::Status(labm8::error::Code::INVALID_ARGUMENT,
+                             "Sweep for kernel '{}' has dynamic params "
+                             "without global_size_x and local_size_x",
+                             kernel.name());
+      }
+      // Unset local sizes in the second and third dimension default to 1,
+      // matching the --lsize_y and --lsize_z flags.
+      if (!dynamic_params.has_local_size_y()) {
+        dynamic_params.set_local_size_y(1);
+      }
+      if (!dynamic_params.has_local_size_z()) {
+        dynamic_params.set_local_size_z(1);
+      }
+      // The local size of a dimension which the NDRange does not have would
+      // be dropped.
+      if (dynamic_params.local_size_y() >
+              std::max<int64_t>(dynamic_params.global_size_y(), 1) ||
+          dynamic_params.local_size_z() >
+              std::max<int64_t>(dynamic_params.global_size_z(), 1)) {
+        return labm8::Status(labm8::error::Code::INVALID_ARGUMENT,
+                             "Sweep for kernel '{}' has a local size greater "
+                             "than its global size in the second or third "
+                             "dimension",
+                             kernel.name());
+      }
+    }
+  }
+
+  return sweep;
+}
+
+const CldriveKernelSweep* FindKernelSweep(const CldriveInstance& instance,
+                                          const string& kernel_name) {
+  const CldriveKernelSweep* unnamed_sweep = nullptr;
+  for (const auto& sweep : instance.sweep()) {
+    if (sweep.name() == kernel_name) {
+      return &sweep;
+    }
+    if (sweep.name().empty() && !unnamed_sweep) {
+      unnamed_sweep = &sweep;
+    }
+  }
+  return unnamed_sweep;
+}
+
+}  // namespace cldrive
+}  // namespace gpu
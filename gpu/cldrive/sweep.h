@@ -0,0 +1,41 @@
+// Sweeps describe the launch configs and argument values to run kernels with.
+//
+// Copyright (c) 2016-2020 Chris Cummins.
+// This file is part of cldrive.
+//
+// cldrive is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// cldrive is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with cldrive.  If not, see <https://www.gnu.org/licenses/>.
+#pragma once
+
+#include "gpu/cldrive/proto/cldrive.pb.h"
+
+#include "labm8/cpp/statusor.h"
+#include "labm8/cpp/string.h"
+
+namespace gpu {
+namespace cldrive {
+
+// Parse the contents of a sweep file. The format is determined by the file
+// extension: '.json' files are parsed as JSON, '.pb' files as binary protos,
+// and anything else as text format protos.
+labm8::StatusOr<CldriveSweep> ParseSweep(const string& path,
+                                         const string& contents);
+
+// Return the sweep for the named kernel, or nullptr if the instance has no
+// sweep that applies to it. A sweep with a matching name is preferred over an
+// unnamed sweep.
+const CldriveKernelSweep* FindKernelSweep(const CldriveInstance& instance,
+                                          const string& kernel_name);
+
+}  // namespace cldrive
+}  // namespace gpu
@@ -0,0 +1,114 @@
+// Copyright (c) 2016-2020 Chris Cummins.
+// This file is part of cldrive.
+//
+// cldrive is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// cldrive is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with cldrive.  If not, see <https://www.gnu.org/licenses/>.
+#include "gpu/cldrive/sweep.h"
+
+#include "labm8/cpp/test.h"
+
+namespace gpu {
+namespace cldrive {
+namespace {
+
+TEST(ParseSweep, TextFormat) {
+  auto sweep_or = ParseSweep("sweep.pbtxt", R"(
+kernel {
+  name: "A"
+  dynamic_params { global_size_x: 1024 local_size_x: 128 }
+  dynamic_params { global_size_x: 2048 local_size_x: 256 }
+  args_values { value: 1024 value: 5 }
+}
+)");
+  ASSERT_TRUE(sweep_or.ok());
+  const CldriveSweep& sweep = sweep_or.ValueOrDie();
+  ASSERT_EQ(sweep.kernel_size(), 1);
+  EXPECT_EQ(sweep.kernel(0).name(), "A");
+  EXPECT_EQ(sweep.kernel(0).dynamic_params_size(), 2);
+  EXPECT_EQ(sweep.kernel(0).args_values(0).value_size(), 2);
+}
+
+TEST(ParseSweep, Json) {
+  auto sweep_or = ParseSweep("sweep.json", R"({
+  "kernel": [{
+    "name": "A",
+    "dynamic_params": [{"global_size_x": 1024, "local_size_x": 128}],
+    "args_values": [{"value": [1024, 5]}, {"value": [512, 6]}]
+  }]
+})");
+  ASSERT_TRUE(sweep_or.ok());
+  const CldriveSweep& sweep = sweep_or.ValueOrDie();
+  ASSERT_EQ(sweep.kernel_size(), 1);
+  EXPECT_EQ(sweep.kernel(0).dynamic_params(0).global_size_x(), 1024);
+  EXPECT_EQ(sweep.kernel(0).args_values_size(), 2);
+}
+
+TEST(ParseSweep, UnsetLocalSizesDefaultToOne) {
+  auto sweep_or = ParseSweep(
+      "sweep.pbtxt",
+      "kernel { dynamic_params { global_size_x: 64 local_size_x: 8 } }");
+  ASSERT_TRUE(sweep_or.ok());
+  const DynamicParams& dynamic_params =
+      sweep_or.ValueOrDie().kernel(0).dynamic_params(0);
+  EXPECT_EQ(dynamic_params.local_size_y(), 1);
+  EXPECT_EQ(dynamic_params.local_size_z(), 1);
+}
+
+TEST(ParseSweep, InvalidContents) {
+  EXPECT_FALSE(ParseSweep("sweep.pbtxt", "not a proto").ok());
+  EXPECT_FALSE(ParseSweep("sweep.json", "{").ok());
+}
+
+TEST(ParseSweep, MissingGlobalSize) {
+  EXPECT_FALSE(
+      ParseSweep("sweep.pbtxt", "kernel { dynamic_params { local_size_x: 8 } }")
+          .ok());
+}
+
+TEST(ParseSweep, LocalSizeOfAnUnusedDimension) {
+  EXPECT_FALSE(ParseSweep("sweep.pbtxt",
+                          "kernel { dynamic_params { global_size_x: 64 "
+                          "local_size_x: 8 local_size_y: 2 } }")
+                   .ok());
+  EXPECT_TRUE(ParseSweep("sweep.pbtxt",
+                         "kernel { dynamic_params { global_size_x: 64 "
+                         "global_size_y: 4 local_size_x: 8 local_size_y: 2 } }")
+                  .ok());
+}
+
+TEST(FindKernelSweep, NoSweeps) {
+  CldriveInstance instance;
+  EXPECT_EQ(FindKernelSweep(instance, "A"), nullptr);
+}
+
+TEST(FindKernelSweep, NamedSweepIsPreferred) {
+  CldriveInstance instance;
+  instance.add_sweep();
+  instance.add_sweep()->set_name("A");
+
+  EXPECT_EQ(FindKernelSweep(instance, "A"), &instance.sweep(1));
+  EXPECT_EQ(FindKernelSweep(instance, "B"), &instance.sweep(0));
+}
+
+TEST(FindKernelSweep, NoMatchingSweep) {
+  CldriveInstance instance;
+  instance.add_sweep()->set_name("A");
+
+  EXPECT_EQ(FindKernelSweep(instance, "B"), nullptr);
+}
+
+}  // anonymous namespace
+}  // namespace cldrive
+}  // namespace gpu
+
+TEST_MAIN();
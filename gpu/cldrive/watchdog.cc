@@ -0,0 +1,116 @@
+// Copyright (c) 2016-2020 Chris Cummins.
+// This file is part of cldrive.
+//
+// cldrive is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// cldrive is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with cldrive.  If not, see <https://www.gnu.org/licenses/>.
+#include "gpu/cldrive/watchdog.h"
+
+namespace gpu {
+namespace cldrive {
+
+Watchdog::Scope::Scope(Watchdog* watchdog,
+                       CldriveKernelRun::TimeoutPhase phase,
+                       labm8::int64 budget_ms)
+    : watchdog_(budget_ms > 0 ? watchdog : nullptr) {
+  if (!watchdog_) {
+    return;
+  }
+  std::unique_lock<std::mutex> lock(watchdog_->mutex_);
+  deadline_ = watchdog_->deadlines_.insert(
+      watchdog_->deadlines_.end(),
+      {Clock::now() + std::chrono::milliseconds(budget_ms), phase,
+       /*notified=*/false});
+  watchdog_->armed_.notify_one();
+}
+
+Watchdog::Scope::~Scope() {
+  if (!watchdog_) {
+    return;
+  }
+  std::unique_lock<std::mutex> lock(watchdog_->mutex_);
+  watchdog_->deadlines_.erase(deadline_);
+}
+
+void Watchdog::Scope::set_phase(CldriveKernelRun::TimeoutPhase phase) {
+  if (!watchdog_) {
+    return;
+  }
+  std::unique_lock<std::mutex> lock(watchdog_->mutex_);
+  deadline_->phase = phase;
+}
+
+Watchdog::Watchdog(
+    std::function<void(CldriveKernelRun::TimeoutPhase)> on_expiry)
+    : on_expiry_(on_expiry), stop_(false), thread_([this]() { Run(); }) {}
+
+Watchdog::~Watchdog() {
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+    stop_ = true;
+  }
+  armed_.notify_one();
+  thread_.join();
+}
+
+CldriveKernelRun::TimeoutPhase Watchdog::ExpiredPhase() const {
+  const auto now = Clock::now();
+  std::unique_lock<std::mutex> lock(mutex_);
+  const Scope::Deadline* expired = nullptr;
+  for (const auto& deadline : deadlines_) {
+    if (deadline.time <= now && (!expired || deadline.time < expired->time)) {
+      expired = &deadline;
+    }
+  }
+  return expired ? expired->phase : CldriveKernelRun::NO_TIMEOUT;
+}
+
+void Watchdog::CheckOrThrow() const {
+  const auto phase = ExpiredPhase();
+  if (phase != CldriveKernelRun::NO_TIMEOUT) {
+    throw WatchdogTimeout(phase);
+  }
+}
+
+void Watchdog::Run() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  while (!stop_) {
+    // Find the earliest deadline which has not yet been notified.
+    Scope::Deadline* next = nullptr;
+    for (auto& deadline : deadlines_) {
+      if (!deadline.notified && (!next || deadline.time < next->time)) {
+        next = &deadline;
+      }
+    }
+
+    if (!next) {
+      armed_.wait(lock);
+      continue;
+    }
+    if (Clock::now() < next->time) {
+      // Woken by a change to the deadlines, or by the deadline passing.
+      armed_.wait_until(lock, next->time);
+      continue;
+    }
+
+    next->notified = true;
+    const auto phase = next->phase;
+    lock.unlock();
+    if (on_expiry_) {
+      on_expiry_(phase);
+    }
+    lock.lock();
+  }
+}
+
+}  // namespace cldrive
+}  // namespace gpu
@@ -0,0 +1,121 @@
+// A watchdog for the time budgets of kernel runs.
+//
+// Copyright (c) 2016-2020 Chris Cummins.
+// This file is part of cldrive.
+//
+// cldrive is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// cldrive is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with cldrive.  If not, see <https://www.gnu.org/licenses/>.
+#pragma once
+
+#include "gpu/cldrive/proto/cldrive.pb.h"
+
+#include "labm8/cpp/macros.h"
+#include "labm8/cpp/port.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <list>
+#include <mutex>
+#include <thread>
+
+namespace gpu {
+namespace cldrive {
+
+// Thrown by Watchdog::CheckOrThrow() once a time budget has run out.
+class WatchdogTimeout : public std::exception {
+ public:
+  explicit WatchdogTimeout(CldriveKernelRun::TimeoutPhase phase)
+      : phase_(phase) {}
+
+  CldriveKernelRun::TimeoutPhase phase() const { return phase_; }
+
+  const char* what() const noexcept override {
+    return "Time budget exceeded";
+  }
+
+ private:
+  CldriveKernelRun::TimeoutPhase phase_;
+};
+
+// A watchdog tracks the deadlines of nested time budgets. The driving thread
+// arms a budget with a Scope, and polls for expiry with CheckOrThrow() or
+// ExpiredPhase() where it would otherwise block. A background thread calls
+// the on_expiry callback as soon as a deadline passes, so that results may be
+// flushed even if the driving thread is stuck in a call which cannot be
+// interrupted.
+//
+// Usage:
+//    Watchdog watchdog([](CldriveKernelRun::TimeoutPhase phase) { ... });
+//    Watchdog::Scope scope(&watchdog, CldriveKernelRun::KERNEL, 1000);
+//    while (!done) {
+//      watchdog.CheckOrThrow();
+//    }
+class Watchdog {
+ public:
+  using Clock = std::chrono::steady_clock;
+
+  // A budget which is armed for the lifetime of the scope. A scope with a
+  // null watchdog, or a budget of zero, does nothing.
+  class Scope {
+   public:
+    Scope(Watchdog* watchdog, CldriveKernelRun::TimeoutPhase phase,
+          labm8::int64 budget_ms);
+    ~Scope();
+
+    // Change the phase reported if the budget runs out, e.g. as a run moves
+    // from transferring inputs to running the kernel.
+    void set_phase(CldriveKernelRun::TimeoutPhase phase);
+
+   private:
+    friend class Watchdog;
+
+    struct Deadline {
+      Clock::time_point time;
+      CldriveKernelRun::TimeoutPhase phase;
+      bool notified;
+    };
+
+    Watchdog* watchdog_;
+    std::list<Deadline>::iterator deadline_;
+
+    DISALLOW_EVIL_CONSTRUCTORS(Scope);
+  };
+
+  explicit Watchdog(
+      std::function<void(CldriveKernelRun::TimeoutPhase)> on_expiry);
+  ~Watchdog();
+
+  // Return the phase of the earliest armed deadline which has passed, or
+  // NO_TIMEOUT.
+  CldriveKernelRun::TimeoutPhase ExpiredPhase() const;
+
+  // Throw WatchdogTimeout if an armed deadline has passed.
+  void CheckOrThrow() const;
+
+ private:
+  void Run();
+
+  mutable std::mutex mutex_;
+  std::condition_variable armed_;
+  std::list<Scope::Deadline> deadlines_;
+  std::function<void(CldriveKernelRun::TimeoutPhase)> on_expiry_;
+  bool stop_;
+  std::thread thread_;
+
+  DISALLOW_EVIL_CONSTRUCTORS(Watchdog);
+};
+
+}  // namespace cldrive
+}  // namespace gpu
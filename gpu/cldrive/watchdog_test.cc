@@ -0,0 +1,101 @@
+// Copyright (c) 2016-2020 Chris Cummins.
+// This file is part of cldrive.
+//
+// cldrive is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// cldrive is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with cldrive.  If not, see <https://www.gnu.org/licenses/>.
+#include "gpu/cldrive/watchdog.h"
+
+#include "labm8/cpp/test.h"
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+namespace gpu {
+namespace cldrive {
+namespace {
+
+void SleepMs(int ms) {
+  std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+}
+
+TEST(Watchdog, NoScopesHaveNotExpired) {
+  Watchdog watchdog(nullptr);
+  EXPECT_EQ(watchdog.ExpiredPhase(), CldriveKernelRun::NO_TIMEOUT);
+  watchdog.CheckOrThrow();
+}
+
+TEST(Watchdog, ZeroBudgetIsUnlimited) {
+  Watchdog watchdog(nullptr);
+  Watchdog::Scope scope(&watchdog, CldriveKernelRun::KERNEL, 0);
+  SleepMs(5);
+  EXPECT_EQ(watchdog.ExpiredPhase(), CldriveKernelRun::NO_TIMEOUT);
+}
+
+TEST(Watchdog, NullWatchdogScopeDoesNothing) {
+  Watchdog::Scope scope(nullptr, CldriveKernelRun::KERNEL, 1);
+  scope.set_phase(CldriveKernelRun::TRANSFER);
+}
+
+TEST(Watchdog, ExpiredScopeThrowsItsPhase) {
+  Watchdog watchdog(nullptr);
+  Watchdog::Scope scope(&watchdog, CldriveKernelRun::TRANSFER, 1);
+  scope.set_phase(CldriveKernelRun::KERNEL);
+  SleepMs(5);
+  EXPECT_EQ(watchdog.ExpiredPhase(), CldriveKernelRun::KERNEL);
+  try {
+    watchdog.CheckOrThrow();
+    FAIL() << "Expected WatchdogTimeout";
+  } catch (WatchdogTimeout timeout) {
+    EXPECT_EQ(timeout.phase(), CldriveKernelRun::KERNEL);
+  }
+}
+
+TEST(Watchdog, EarliestExpiredDeadlineIsReported) {
+  Watchdog watchdog(nullptr);
+  Watchdog::Scope config(&watchdog, CldriveKernelRun::CONFIG, 1);
+  Watchdog::Scope run(&watchdog, CldriveKernelRun::KERNEL, 3);
+  SleepMs(10);
+  EXPECT_EQ(watchdog.ExpiredPhase(), CldriveKernelRun::CONFIG);
+}
+
+TEST(Watchdog, ClosedScopeIsDisarmed) {
+  std::atomic<int> calls(0);
+  Watchdog watchdog([&calls](CldriveKernelRun::TimeoutPhase) { ++calls; });
+  { Watchdog::Scope scope(&watchdog, CldriveKernelRun::KERNEL, 20); }
+  SleepMs(40);
+  EXPECT_EQ(watchdog.ExpiredPhase(), CldriveKernelRun::NO_TIMEOUT);
+  EXPECT_EQ(calls, 0);
+}
+
+TEST(Watchdog, OnExpiryIsCalledOnceWithoutPolling) {
+  std::atomic<int> calls(0);
+  std::atomic<int> phase(CldriveKernelRun::NO_TIMEOUT);
+  Watchdog watchdog([&](CldriveKernelRun::TimeoutPhase expired) {
+    phase = expired;
+    ++calls;
+  });
+  Watchdog::Scope scope(&watchdog, CldriveKernelRun::TRANSFER, 1);
+  for (int i = 0; i < 1000 && !calls; ++i) {
+    SleepMs(1);
+  }
+  SleepMs(5);
+  EXPECT_EQ(calls, 1);
+  EXPECT_EQ(phase, CldriveKernelRun::TRANSFER);
+}
+
+}  // anonymous namespace
+}  // namespace cldrive
+}  // namespace gpu
+
+TEST_MAIN();
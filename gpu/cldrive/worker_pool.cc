@@ -0,0 +1,303 @@
+// Copyright (c) 2016-2020 Chris Cummins.
+// This file is part of cldrive.
+//
+// cldrive is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// cldrive is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with cldrive.  If not, see <https://www.gnu.org/licenses/>.
+#include "gpu/cldrive/worker_pool.h"
+
+#include "labm8/cpp/logging.h"
+
+#include "google/protobuf/io/coded_stream.h"
+#include "google/protobuf/io/zero_copy_stream_impl.h"
+#include "google/protobuf/util/delimited_message_util.h"
+
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+
+namespace gpu {
+namespace cldrive {
+
+namespace {
+
+// Create a pipe whose ends are closed in child processes on exec(), so that
+// each worker only inherits the ends which are its stdin and stdout.
+void PipeOrDie(int fds[2]) {
+  CHECK(pipe(fds) == 0) << "pipe() failed: " << strerror(errno);
+  for (int i = 0; i < 2; ++i) {
+    CHECK(fcntl(fds[i], F_SETFD, FD_CLOEXEC) == 0)
+        << "fcntl() failed: " << strerror(errno);
+  }
+}
+
+// If buffer starts with a whole length-delimited message, remove it from
+// buffer, store its serialized bytes in message, and return true.
+bool TakeDelimitedMessage(string* buffer, string* message) {
+  google::protobuf::io::CodedInputStream input(
+      reinterpret_cast<const uint8_t*>(buffer->data()), buffer->size());
+  uint32_t size;
+  if (!input.ReadVarint32(&size)) {
+    return false;
+  }
+  const size_t header_size = input.CurrentPosition();
+  if (buffer->size() - header_size < size) {
+    return false;
+  }
+  message->assign(*buffer, header_size, size);
+  buffer->erase(0, header_size + size);
+  return true;
+}
+
+}  // anonymous namespace
+
+WorkerPool::WorkerPool(const std::vector<string>& command, int num_workers,
+                       labm8::int64 timeout_ms)
+    : command_(command),
+      timeout_ms_(timeout_ms),
+      workers_(num_workers),
+      next_id_(0),
+      next_result_id_(0),
+      num_crashes_(0),
+      num_timeouts_(0) {
+  CHECK(!command_.empty()) << "Worker command cannot be empty";
+  CHECK(num_workers > 0) << "A worker pool needs at least one worker";
+  // A worker which dies closes its stdin, and writing to it must fail rather
+  // than kill the supervisor.
+  signal(SIGPIPE, SIG_IGN);
+  for (auto& worker : workers_) {
+    StartWorker(&worker);
+  }
+}
+
+WorkerPool::~WorkerPool() {
+  for (auto& worker : workers_) {
+    // Idle workers exit once their input is closed. Busy workers are killed
+    // rather than waited for, since their results would be discarded.
+    StopWorker(&worker, /*kill_process=*/worker.task_id >= 0);
+  }
+}
+
+void WorkerPool::Submit(const CldriveInstance& instance) {
+  queue_.emplace_back(next_id_++, instance);
+  Dispatch();
+}
+
+CldriveInstance WorkerPool::NextResult() {
+  CHECK(pending()) << "No pending instances";
+  while (true) {
+    auto it = results_.find(next_result_id_);
+    if (it != results_.end()) {
+      CldriveInstance result = std::move(it->second);
+      results_.erase(it);
+      ++next_result_id_;
+      return result;
+    }
+    Dispatch();
+    WaitForWorkers();
+  }
+}
+
+void WorkerPool::StartWorker(Worker* worker) {
+  int input[2];
+  int output[2];
+  PipeOrDie(input);
+  PipeOrDie(output);
+
+  // Build the arguments before forking, so that the child does not allocate.
+  std::vector<char*> argv;
+  for (const auto& arg : command_) {
+    argv.push_back(const_cast<char*>(arg.c_str()));
+  }
+  argv.push_back(nullptr);
+
+  pid_t pid = fork();
+  CHECK(pid >= 0) << "fork() failed: " << strerror(errno);
+  if (!pid) {
+    // dup2() clears the close-on-exec flag of the new descriptors.
+    if (dup2(input[0], STDIN_FILENO) < 0 ||
+        dup2(output[1], STDOUT_FILENO) < 0) {
+      _exit(127);
+    }
+    execvp(argv[0], argv.data());
+    _exit(127);
+  }
+
+  close(input[0]);
+  close(output[1]);
+  worker->pid = pid;
+  worker->input_fd = input[1];
+  worker->output_fd = output[0];
+  // Output is read only as far as is available, so that a partial result
+  // does not block the supervisor.
+  CHECK(fcntl(worker->output_fd, F_SETFL, O_NONBLOCK) == 0)
+      << "fcntl() failed: " << strerror(errno);
+  worker->output_buffer.clear();
+  worker->task_id = -1;
+}
+
+void WorkerPool::Dispatch() {
+  for (auto& worker : workers_) {
+    if (queue_.empty()) {
+      return;
+    }
+    if (worker.task_id >= 0) {
+      continue;
+    }
+
+    worker.task_id = queue_.front().first;
+    worker.task = std::move(queue_.front().second);
+    worker.task_start = Clock::now();
+    queue_.pop_front();
+
+    google::protobuf::io::FileOutputStream input(worker.input_fd);
+    if (!google::protobuf::util::SerializeDelimitedToZeroCopyStream(
+            worker.task, &input) ||
+        !input.Flush()) {
+      ReplaceWorker(&worker, CldriveInstance::CRASH);
+    }
+  }
+}
+
+void WorkerPool::WaitForWorkers() {
+  std::vector<pollfd> fds;
+  std::vector<Worker*> busy;
+  int timeout = -1;
+  const auto now = Clock::now();
+  for (auto& worker : workers_) {
+    if (worker.task_id < 0) {
+      continue;
+    }
+    fds.push_back({worker.output_fd, POLLIN, 0});
+    busy.push_back(&worker);
+    if (timeout_ms_ > 0) {
+      const auto elapsed =
+          std::chrono::duration_cast<std::chrono::milliseconds>(
+              now - worker.task_start)
+              .count();
+      const int remaining =
+          static_cast<int>(std::max<labm8::int64>(0, timeout_ms_ - elapsed));
+      timeout = timeout < 0 ? remaining : std::min(timeout, remaining);
+    }
+  }
+  CHECK(!fds.empty()) << "No busy workers to wait for";
+
+  if (poll(fds.data(), fds.size(), timeout) < 0) {
+    CHECK(errno == EINTR) << "poll() failed: " << strerror(errno);
+    return;
+  }
+
+  for (size_t i = 0; i < fds.size(); ++i) {
+    Worker* worker = busy[i];
+    // The worker has written some output, or closed its output by dying.
+    if (fds[i].revents && ReadWorkerOutput(worker)) {
+      continue;
+    }
+    if (worker->task_id >= 0 && timeout_ms_ > 0 &&
+        Clock::now() - worker->task_start >=
+            std::chrono::milliseconds(timeout_ms_)) {
+      LOG(WARNING) << "Killing worker " << worker->pid << " which exceeded "
+                   << timeout_ms_ << " ms";
+      ReplaceWorker(worker, CldriveInstance::WORKER_TIMEOUT);
+    }
+  }
+}
+
+bool WorkerPool::ReadWorkerOutput(Worker* worker) {
+  char buffer[4096];
+  bool closed = false;
+  while (true) {
+    const ssize_t n = read(worker->output_fd, buffer, sizeof(buffer));
+    if (n > 0) {
+      worker->output_buffer.append(buffer, n);
+    } else if (n < 0 && errno == EINTR) {
+      continue;
+    } else {
+      // Either all of the available output has been read, or the output is
+      // closed, or cannot be read.
+      closed = !(n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK));
+      break;
+    }
+  }
+
+  string message;
+  if (!TakeDelimitedMessage(&worker->output_buffer, &message)) {
+    if (closed) {
+      // The worker has died before writing its whole result.
+      ReplaceWorker(worker, CldriveInstance::CRASH);
+      return true;
+    }
+    return false;
+  }
+  CldriveInstance result;
+  if (!result.ParseFromString(message)) {
+    LOG(WARNING) << "Worker " << worker->pid << " wrote a malformed result";
+    ReplaceWorker(worker, CldriveInstance::CRASH);
+    return true;
+  }
+  results_[worker->task_id] = std::move(result);
+  worker->task_id = -1;
+  return true;
+}
+
+void WorkerPool::ReplaceWorker(Worker* worker,
+                               CldriveInstance::InstanceOutcome outcome) {
+  const pid_t pid = worker->pid;
+  // The worker is killed in case it closed its output without exiting. This
+  // does not change the exit status of a worker which has already died.
+  int status = StopWorker(worker, /*kill_process=*/true);
+  const int signal_number = WIFSIGNALED(status) ? WTERMSIG(status) : 0;
+  if (signal_number) {
+    LOG(WARNING) << "Worker " << pid << " was killed by signal "
+                 << signal_number << " (" << strsignal(signal_number)
+                 << ") while running instance " << worker->task_id
+                 << ". Replacing it";
+  } else {
+    LOG(WARNING) << "Worker " << pid << " exited with status "
+                 << WEXITSTATUS(status) << " while running instance "
+                 << worker->task_id << ". Replacing it";
+  }
+
+  CldriveInstance result = std::move(worker->task);
+  result.clear_kernel();
+  result.set_outcome(outcome);
+  if (outcome == CldriveInstance::CRASH) {
+    result.set_crash_signal(signal_number);
+    ++num_crashes_;
+  } else {
+    ++num_timeouts_;
+  }
+  results_[worker->task_id] = std::move(result);
+
+  StartWorker(worker);
+}
+
+int WorkerPool::StopWorker(Worker* worker, bool kill_process) {
+  close(worker->input_fd);
+  close(worker->output_fd);
+  if (kill_process) {
+    kill(worker->pid, SIGKILL);
+  }
+  int status = 0;
+  while (waitpid(worker->pid, &status, 0) < 0 && errno == EINTR) {
+  }
+  return status;
+}
+
+}  // namespace cldrive
+}  // namespace gpu
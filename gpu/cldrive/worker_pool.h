@@ -0,0 +1,139 @@
+// A pool of worker processes which run instances.
+//
+// Copyright (c) 2016-2020 Chris Cummins.
+// This file is part of cldrive.
+//
+// cldrive is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// cldrive is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with cldrive.  If not, see <https://www.gnu.org/licenses/>.
+#pragma once
+
+#include "gpu/cldrive/proto/cldrive.pb.h"
+
+#include "labm8/cpp/macros.h"
+#include "labm8/cpp/port.h"
+#include "labm8/cpp/string.h"
+
+#include <sys/types.h>
+
+#include <chrono>
+#include <deque>
+#include <map>
+#include <memory>
+#include <vector>
+
+namespace gpu {
+namespace cldrive {
+
+// A pool of worker processes which run instances, so that a kernel which
+// crashes or hangs takes down only its worker rather than the whole sweep.
+// A worker is a long-lived process which reads length-delimited
+// CldriveInstance protos from stdin and writes each back with its results, as
+// "cldrive --serve" does (see server.h). Device enumeration, context creation,
+// and program builds are then paid once per worker rather than once per
+// instance. A worker which dies is replaced.
+//
+// Usage:
+//    WorkerPool pool({argv[0], "--serve"}, /*num_workers=*/4);
+//    pool.Submit(instance);
+//    CldriveInstance result = pool.NextResult();
+class WorkerPool {
+ public:
+  // Start num_workers processes running the given command. If timeout_ms is
+  // greater than zero, a worker which takes longer than that to run an
+  // instance is killed.
+  WorkerPool(const std::vector<string>& command, int num_workers,
+             labm8::int64 timeout_ms = 0);
+
+  // Close the inputs of the workers, and wait for them to exit.
+  ~WorkerPool();
+
+  // Queue an instance to be run by the next idle worker.
+  void Submit(const CldriveInstance& instance);
+
+  // Wait for the result of the oldest instance which has not yet been
+  // returned. Results are returned in the order that instances were
+  // submitted. If the worker running an instance dies, the result is the
+  // instance with the CRASH outcome, and the signal which killed the worker
+  // in crash_signal. If the worker is killed for exceeding the time budget,
+  // the result is the instance with the WORKER_TIMEOUT outcome. There must be
+  // a pending instance.
+  CldriveInstance NextResult();
+
+  // The number of submitted instances which have not yet been returned.
+  size_t pending() const { return next_id_ - next_result_id_; }
+
+  // The number of workers which have died and been replaced.
+  size_t num_crashes() const { return num_crashes_; }
+
+  // The number of workers which have been killed for exceeding the time
+  // budget and replaced.
+  size_t num_timeouts() const { return num_timeouts_; }
+
+ private:
+  using Clock = std::chrono::steady_clock;
+
+  struct Worker {
+    pid_t pid;
+    int input_fd;
+    int output_fd;
+    // Output which has been read, but does not yet make a whole result.
+    string output_buffer;
+    // The instance being run, and its position in the submission order, or
+    // -1 if the worker is idle.
+    int64_t task_id;
+    CldriveInstance task;
+    Clock::time_point task_start;
+  };
+
+  // Start the process for a worker.
+  void StartWorker(Worker* worker);
+
+  // Send queued instances to idle workers.
+  void Dispatch();
+
+  // Wait for output from the busy workers, or for the time budget of one to
+  // run out, and store the result of each worker which has finished, died,
+  // or been killed. Output is read without blocking, so a worker which
+  // writes part of a result and then hangs is still killed on time.
+  void WaitForWorkers();
+
+  // Read the available output of a worker which poll() reported as ready.
+  // Stores the result and returns true if the worker has finished. Returns
+  // false if the result is not yet complete. If the worker closed its output
+  // or wrote a malformed result, it is replaced.
+  bool ReadWorkerOutput(Worker* worker);
+
+  // Reap a worker which has died or been killed, store the result of its
+  // instance with the given outcome, and replace it. A CRASH result has the
+  // signal which killed the worker.
+  void ReplaceWorker(Worker* worker, CldriveInstance::InstanceOutcome outcome);
+
+  // Close a worker's pipes, and wait for its process to exit, killing it
+  // first if kill_process is true. Returns the wait status of the process.
+  int StopWorker(Worker* worker, bool kill_process);
+
+  std::vector<string> command_;
+  labm8::int64 timeout_ms_;
+  std::vector<Worker> workers_;
+  std::deque<std::pair<int64_t, CldriveInstance>> queue_;
+  std::map<int64_t, CldriveInstance> results_;
+  int64_t next_id_;
+  int64_t next_result_id_;
+  size_t num_crashes_;
+  size_t num_timeouts_;
+
+  DISALLOW_EVIL_CONSTRUCTORS(WorkerPool);
+};
+
+}  // namespace cldrive
+}  // namespace gpu
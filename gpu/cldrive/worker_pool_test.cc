@@ -0,0 +1,96 @@
+// Copyright (c) 2016-2020 Chris Cummins.
+// This file is part of cldrive.
+//
+// cldrive is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// cldrive is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with cldrive.  If not, see <https://www.gnu.org/licenses/>.
+#include "gpu/cldrive/worker_pool.h"
+
+#include "labm8/cpp/test.h"
+
+#include <signal.h>
+
+namespace gpu {
+namespace cldrive {
+namespace {
+
+CldriveInstance MakeInstance(const string& src) {
+  CldriveInstance instance;
+  instance.set_opencl_src(src);
+  return instance;
+}
+
+// cat(1) echoes each request back as its response, so it stands in for a
+// worker which runs instances without changing them.
+TEST(WorkerPool, ResultsAreReturnedInOrder) {
+  WorkerPool pool({"cat"}, /*num_workers=*/3);
+  for (int i = 0; i < 10; ++i) {
+    pool.Submit(MakeInstance(std::to_string(i)));
+  }
+  EXPECT_EQ(pool.pending(), 10);
+  for (int i = 0; i < 10; ++i) {
+    EXPECT_EQ(pool.NextResult().opencl_src(), std::to_string(i));
+  }
+  EXPECT_EQ(pool.pending(), 0);
+  EXPECT_EQ(pool.num_crashes(), 0);
+}
+
+TEST(WorkerPool, CrashingWorkerIsReplaced) {
+  WorkerPool pool({"sh", "-c", "kill -SEGV $$"}, /*num_workers=*/2);
+  pool.Submit(MakeInstance("a"));
+  pool.Submit(MakeInstance("b"));
+  pool.Submit(MakeInstance("c"));
+  for (const string src : {"a", "b", "c"}) {
+    CldriveInstance result = pool.NextResult();
+    EXPECT_EQ(result.opencl_src(), src);
+    EXPECT_EQ(result.outcome(), CldriveInstance::CRASH);
+    EXPECT_EQ(result.crash_signal(), SIGSEGV);
+  }
+  EXPECT_EQ(pool.num_crashes(), 3);
+}
+
+TEST(WorkerPool, HungWorkerIsKilled) {
+  // The worker blocks until its input is closed, which is only once the pool
+  // is destroyed.
+  WorkerPool pool({"sh", "-c", "cat >/dev/null"}, /*num_workers=*/1,
+                  /*timeout_ms=*/50);
+  pool.Submit(MakeInstance("a"));
+  CldriveInstance result = pool.NextResult();
+  EXPECT_EQ(result.outcome(), CldriveInstance::WORKER_TIMEOUT);
+  EXPECT_FALSE(result.has_crash_signal());
+  EXPECT_EQ(pool.num_timeouts(), 1);
+  EXPECT_EQ(pool.num_crashes(), 0);
+}
+
+TEST(WorkerPool, WorkerWhichWritesPartOfAResultIsKilled) {
+  // The worker writes the length of a 10 byte result and one byte of it, and
+  // then blocks.
+  WorkerPool pool({"sh", "-c", "printf '\\012a'; cat >/dev/null"},
+                  /*num_workers=*/1, /*timeout_ms=*/50);
+  pool.Submit(MakeInstance("a"));
+  CldriveInstance result = pool.NextResult();
+  EXPECT_EQ(result.outcome(), CldriveInstance::WORKER_TIMEOUT);
+}
+
+TEST(WorkerPool, WorkerWhichExitsHasNoSignal) {
+  WorkerPool pool({"true"}, /*num_workers=*/1);
+  pool.Submit(MakeInstance("a"));
+  CldriveInstance result = pool.NextResult();
+  EXPECT_EQ(result.outcome(), CldriveInstance::CRASH);
+  EXPECT_EQ(result.crash_signal(), 0);
+}
+
+}  // anonymous namespace
+}  // namespace cldrive
+}  // namespace gpu
+
+TEST_MAIN();
@@ -0,0 +1,305 @@
+// Copyright (c) 2016-2020 Chris Cummins.
+// This file is part of clmem.
+//
+// clmem is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// clmem is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with clmem.  If not, see <https://www.gnu.org/licenses/>.
+#include "gpu/clmem/bounds_inference.h"
+
+#include "labm8/cpp/logging.h"
+#include "labm8/cpp/status.h"
+
+#include "absl/strings/ascii.h"
+#include "absl/strings/numbers.h"
+#include "absl/strings/str_split.h"
+
+#include <json/json.h>
+#include <cmath>
+
+namespace gpu {
+namespace clmem {
+
+namespace {
+
+// Solve the n x n system a * x = b in place by Gaussian elimination with
+// partial pivoting. Returns false if the system is singular.
+bool Solve(std::vector<std::vector<double>>* a, std::vector<double>* b) {
+  const size_t n = b->size();
+  for (size_t col = 0; col < n; ++col) {
+    size_t pivot = col;
+    for (size_t row = col + 1; row < n; ++row) {
+      if (std::fabs((*a)[row][col]) > std::fabs((*a)[pivot][col])) {
+        pivot = row;
+      }
+    }
+    if (std::fabs((*a)[pivot][col]) < 1e-9) {
+      return false;
+    }
+    std::swap((*a)[col], (*a)[pivot]);
+    std::swap((*b)[col], (*b)[pivot]);
+    for (size_t row = 0; row < n; ++row) {
+      if (row == col) {
+        continue;
+      }
+      const double factor = (*a)[row][col] / (*a)[col][col];
+      for (size_t k = col; k < n; ++k) {
+        (*a)[row][k] -= factor * (*a)[col][k];
+      }
+      (*b)[row] -= factor * (*b)[col];
+    }
+  }
+  for (size_t i = 0; i < n; ++i) {
+    (*b)[i] /= (*a)[i][i];
+  }
+  return true;
+}
+
+// Fit values to the given columns of [global_size, local_size, 1] by the
+// normal equations. Returns false if the columns are not independent.
+bool FitColumns(const std::vector<DynamicParams>& launches,
+                const std::vector<double>& values,
+                const std::vector<int>& columns, std::array<double, 3>* coef) {
+  const size_t n = columns.size();
+  std::vector<std::vector<double>> ata(n, std::vector<double>(n, 0));
+  std::vector<double> atb(n, 0);
+  for (size_t i = 0; i < launches.size(); ++i) {
+    const double x[] = {static_cast<double>(launches[i].global_size_x()),
+                        static_cast<double>(launches[i].local_size_x()), 1};
+    for (size_t r = 0; r < n; ++r) {
+      for (size_t c = 0; c < n; ++c) {
+        ata[r][c] += x[columns[r]] * x[columns[c]];
+      }
+      atb[r] += x[columns[r]] * values[i];
+    }
+  }
+  if (!Solve(&ata, &atb)) {
+    return false;
+  }
+  coef->fill(0);
+  for (size_t i = 0; i < n; ++i) {
+    // Drop floating point noise, so that exact fits have exact coefficients.
+    (*coef)[columns[i]] = std::round(atb[i] * 1e6) / 1e6;
+  }
+  return true;
+}
+
+ArgBoundModel MakeModel(int arg_id, const string& name, double global_size,
+                        double local_size, double constant) {
+  ArgBoundModel model;
+  model.arg_id = arg_id;
+  model.name = name;
+  model.coef = {{global_size, local_size, constant}};
+  return model;
+}
+
+// Return the models of a scalar setting, or an error if it is not valid.
+labm8::StatusOr<std::vector<ArgBoundModel>> TryScalarSetting(
+    const std::vector<BoundsArg>& args, const BoundsInferenceOptions& options,
+    const BoundsProbe& probe, const std::vector<size_t>& setting) {
+  // The largest index of each pointer argument at each probe, or -1 if it is
+  // not accessed.
+  std::vector<std::vector<double>> max_indices(
+      args.size(), std::vector<double>(options.probes.size(), -1));
+  std::vector<bool> accessed(args.size(), false);
+
+  for (size_t p = 0; p < options.probes.size(); ++p) {
+    const DynamicParams& launch = options.probes[p];
+    std::vector<int> scalar_values;
+    for (size_t candidate : setting) {
+      const ScalarCandidate& scalar = options.scalar_candidates[candidate];
+      scalar_values.push_back(scalar.is_global_size ? launch.global_size_x()
+                                                    : scalar.value);
+    }
+
+    auto bounds_or = probe(launch, scalar_values);
+    if (!bounds_or.ok()) {
+      return bounds_or.status();
+    }
+    for (const auto& it : bounds_or.ValueOrDie()) {
+      const int arg_id = it.first;
+      const AccessBounds& bounds = it.second;
+      if (arg_id < 0 || arg_id >= static_cast<int>(args.size()) ||
+          !args[arg_id].is_pointer) {
+        continue;
+      }
+      const int buffer_size = args[arg_id].is_global
+                                  ? options.probe_global_buffer_size
+                                  : options.probe_local_buffer_size;
+      if (bounds.min_index() < 0 || bounds.max_index() >= buffer_size) {
+        return labm8::Status(labm8::error::Code::OUT_OF_RANGE,
+                             "Argument {} accessed out of bounds",
+                             args[arg_id].name);
+      }
+      max_indices[arg_id][p] = bounds.max_index();
+      accessed[arg_id] = true;
+    }
+  }
+
+  std::vector<ArgBoundModel> models;
+  size_t scalar = 0;
+  for (size_t i = 0; i < args.size(); ++i) {
+    if (!args[i].is_pointer) {
+      const ScalarCandidate& candidate =
+          options.scalar_candidates[setting[scalar++]];
+      models.push_back(candidate.is_global_size
+                           ? MakeModel(i, args[i].name, 1, 0, -1)
+                           : MakeModel(i, args[i].name, 0, 0,
+                                       candidate.value - 1));
+      continue;
+    }
+    if (!accessed[i]) {
+      models.push_back(MakeModel(i, args[i].name, 1, 0, -1));
+      continue;
+    }
+
+    ArgBoundModel model;
+    model.arg_id = i;
+    model.name = args[i].name;
+    model.coef = FitBoundModel(options.probes, max_indices[i]);
+    const labm8::int64 bound = EvaluateBoundModel(model, options.target);
+    const labm8::int64 min_bound =
+        args[i].is_global ? options.target.global_size_x() : 1;
+    const labm8::int64 max_bound = args[i].is_global
+                                       ? options.max_bound
+                                       : options.probe_local_buffer_size;
+    if (bound < min_bound || bound > max_bound) {
+      return labm8::Status(labm8::error::Code::OUT_OF_RANGE,
+                           "Bound {} of argument {} is out of range", bound,
+                           args[i].name);
+    }
+    models.push_back(model);
+  }
+  return models;
+}
+
+}  // anonymous namespace
+
+labm8::StatusOr<std::vector<ScalarCandidate>> ParseScalarCandidates(
+    const string& str) {
+  std::vector<ScalarCandidate> candidates;
+  for (absl::string_view token : absl::StrSplit(str, ',', absl::SkipEmpty())) {
+    token = absl::StripAsciiWhitespace(token);
+    ScalarCandidate candidate = {/*is_global_size=*/token == "gsize",
+                                 /*value=*/0};
+    if (!candidate.is_global_size &&
+        !absl::SimpleAtoi(token, &candidate.value)) {
+      return labm8::Status(labm8::error::Code::INVALID_ARGUMENT,
+                           "Invalid scalar candidate: '{}'", string(token));
+    }
+    candidates.push_back(candidate);
+  }
+  if (candidates.empty()) {
+    return labm8::Status(labm8::error::Code::INVALID_ARGUMENT,
+                         "No scalar candidates");
+  }
+  return candidates;
+}
+
+labm8::StatusOr<std::vector<DynamicParams>> ParseBoundsProbes(
+    const string& str) {
+  std::vector<DynamicParams> probes;
+  for (absl::string_view token : absl::StrSplit(str, ',', absl::SkipEmpty())) {
+    std::vector<absl::string_view> sizes = absl::StrSplit(token, ':');
+    int global_size, local_size;
+    if (sizes.size() != 2 ||
+        !absl::SimpleAtoi(sizes[0], &global_size) ||
+        !absl::SimpleAtoi(sizes[1], &local_size) || global_size <= 0 ||
+        local_size <= 0 || global_size % local_size) {
+      return labm8::Status(labm8::error::Code::INVALID_ARGUMENT,
+                           "Invalid probe: '{}'", string(token));
+    }
+    DynamicParams probe;
+    probe.set_global_size_x(global_size);
+    probe.set_local_size_x(local_size);
+    probe.set_local_size_y(1);
+    probe.set_local_size_z(1);
+    probes.push_back(probe);
+  }
+  if (probes.empty()) {
+    return labm8::Status(labm8::error::Code::INVALID_ARGUMENT, "No probes");
+  }
+  return probes;
+}
+
+labm8::int64 EvaluateBoundModel(const ArgBoundModel& model,
+                                const DynamicParams& launch) {
+  return std::llround(model.coef[0] * launch.global_size_x() +
+                      model.coef[1] * launch.local_size_x() + model.coef[2]) +
+         1;
+}
+
+std::array<double, 3> FitBoundModel(const std::vector<DynamicParams>& launches,
+                                    const std::vector<double>& values) {
+  CHECK(launches.size() == values.size());
+  CHECK(!launches.empty());
+  std::array<double, 3> coef;
+  if (FitColumns(launches, values, {0, 1, 2}, &coef) ||
+      FitColumns(launches, values, {0, 2}, &coef) ||
+      FitColumns(launches, values, {1, 2}, &coef)) {
+    return coef;
+  }
+  CHECK(FitColumns(launches, values, {2}, &coef));
+  return coef;
+}
+
+labm8::StatusOr<std::vector<ArgBoundModel>> InferBoundsModel(
+    const std::vector<BoundsArg>& args, const BoundsInferenceOptions& options,
+    const BoundsProbe& probe) {
+  CHECK(!options.scalar_candidates.empty());
+  CHECK(!options.probes.empty());
+
+  size_t num_scalars = 0;
+  for (const auto& arg : args) {
+    num_scalars += !arg.is_pointer;
+  }
+
+  // Enumerate scalar settings as an odometer over candidate indices, with the
+  // last scalar varying fastest.
+  std::vector<size_t> setting(num_scalars, 0);
+  labm8::Status last_error(labm8::error::Code::NOT_FOUND, "No settings tried");
+  for (int i = 0; i < options.max_settings; ++i) {
+    auto models_or = TryScalarSetting(args, options, probe, setting);
+    if (models_or.ok()) {
+      return models_or;
+    }
+    last_error = models_or.status();
+
+    size_t digit = num_scalars;
+    while (digit > 0 &&
+           ++setting[digit - 1] == options.scalar_candidates.size()) {
+      setting[--digit] = 0;
+    }
+    if (!digit) {
+      break;  // Every setting has been tried.
+    }
+  }
+  return labm8::Status(labm8::error::Code::NOT_FOUND,
+                       "No valid scalar setting found. Last error: {}",
+                       last_error.error_message().ToString());
+}
+
+string BoundsModelToJson(const std::vector<ArgBoundModel>& models) {
+  Json::Value root(Json::objectValue);
+  for (const auto& model : models) {
+    Json::Value& arg = root[model.name];
+    arg["arg_id"] = model.arg_id;
+    for (double coef : model.coef) {
+      arg["coef"].append(coef);
+    }
+  }
+  Json::StreamWriterBuilder builder;
+  builder["indentation"] = "";
+  return Json::writeString(builder, root);
+}
+
+}  // namespace clmem
+}  // namespace gpu
@@ -0,0 +1,120 @@
+// Infer models of the array bounds of a kernel's arguments.
+//
+// Copyright (c) 2016-2020 Chris Cummins.
+// This file is part of clmem.
+//
+// clmem is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// clmem is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with clmem.  If not, see <https://www.gnu.org/licenses/>.
+#pragma once
+
+#include "gpu/clmem/proto/clmem.pb.h"
+
+#include "labm8/cpp/port.h"
+#include "labm8/cpp/statusor.h"
+#include "labm8/cpp/string.h"
+
+#include <array>
+#include <functional>
+#include <map>
+#include <vector>
+
+namespace gpu {
+namespace clmem {
+
+// An argument of the kernel whose bounds are inferred.
+struct BoundsArg {
+  string name;
+  bool is_pointer;
+  // True for global and constant pointers, false for local pointers.
+  bool is_global;
+};
+
+// A candidate value of a scalar argument: either a constant, or the global
+// size of the launch.
+struct ScalarCandidate {
+  bool is_global_size;
+  int value;
+};
+
+// A linear model of an argument at a launch. For a pointer, this is the
+// number of elements which are accessed. For a scalar, it is the value. The
+// model is:
+//     round(coef[0] * global_size + coef[1] * local_size + coef[2]) + 1
+// which is the format read by clcheck's mem_analysis::getMemAnalysisInfo().
+struct ArgBoundModel {
+  int arg_id;
+  string name;
+  std::array<double, 3> coef;
+};
+
+struct BoundsInferenceOptions {
+  // The values tried for each scalar argument. Settings are tried in
+  // lexicographic order of candidate indices.
+  std::vector<ScalarCandidate> scalar_candidates;
+  // The launches which are run for each scalar setting. The model is fit to
+  // the largest index accessed at each.
+  std::vector<DynamicParams> probes;
+  // The maximum number of scalar settings to try.
+  int max_settings;
+  // The launch at which the models must give valid bounds: at least the
+  // global size for global pointers, and no more than max_bound.
+  DynamicParams target;
+  labm8::int64 max_bound;
+  // The number of elements of the buffers of pointer arguments during
+  // probes. Larger indices are out of bounds.
+  int probe_global_buffer_size;
+  int probe_local_buffer_size;
+};
+
+// Run the kernel at a launch with the given values of its scalar arguments,
+// in argument order. Returns the access bounds of each arg_id which was
+// accessed.
+using BoundsProbe = std::function<labm8::StatusOr<std::map<int, AccessBounds>>(
+    const DynamicParams& launch, const std::vector<int>& scalar_values)>;
+
+// Parse a comma separated list of scalar candidates, e.g. "1,4,gsize".
+labm8::StatusOr<std::vector<ScalarCandidate>> ParseScalarCandidates(
+    const string& str);
+
+// Parse a comma separated list of <global_size>:<local_size> launches, e.g.
+// "192:32,512:64".
+labm8::StatusOr<std::vector<DynamicParams>> ParseBoundsProbes(
+    const string& str);
+
+// Return the value of a model at a launch.
+labm8::int64 EvaluateBoundModel(const ArgBoundModel& model,
+                                const DynamicParams& launch);
+
+// Return the least squares fit of
+//     values[i] = coef[0] * global_size + coef[1] * local_size + coef[2]
+// over launches. If the local sizes (or global sizes) do not vary
+// independently, their coefficient is zero.
+std::array<double, 3> FitBoundModel(const std::vector<DynamicParams>& launches,
+                                    const std::vector<double>& values);
+
+// Search scalar settings for one at which the bounds of every pointer argument
+// are valid, and return a model of every argument. A pointer which is never
+// accessed is modelled as the global size. A setting is rejected if a probe
+// fails or accesses an index outside of its buffers. Returns NOT_FOUND if no
+// setting is valid.
+labm8::StatusOr<std::vector<ArgBoundModel>> InferBoundsModel(
+    const std::vector<BoundsArg>& args, const BoundsInferenceOptions& options,
+    const BoundsProbe& probe);
+
+// Serialize models to the JSON format read by clcheck's --mem_analysis_dir:
+// an object of {"arg_id": <int>, "coef": [<double>, <double>, <double>]},
+// keyed by argument name.
+string BoundsModelToJson(const std::vector<ArgBoundModel>& models);
+
+}  // namespace clmem
+}  // namespace gpu
@@ -0,0 +1,236 @@
+// Copyright (c) 2016-2020 Chris Cummins.
+// This file is part of clmem.
+//
+// clmem is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// clmem is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with clmem.  If not, see <https://www.gnu.org/licenses/>.
+#include "gpu/clmem/bounds_inference.h"
+
+#include "labm8/cpp/test.h"
+
+namespace gpu {
+namespace clmem {
+namespace {
+
+DynamicParams MakeLaunch(int global_size, int local_size) {
+  DynamicParams launch;
+  launch.set_global_size_x(global_size);
+  launch.set_local_size_x(local_size);
+  return launch;
+}
+
+AccessBounds MakeBounds(int arg_id, int min_index, int max_index) {
+  AccessBounds bounds;
+  bounds.set_arg_id(arg_id);
+  bounds.set_min_index(min_index);
+  bounds.set_max_index(max_index);
+  return bounds;
+}
+
+BoundsInferenceOptions MakeOptions() {
+  BoundsInferenceOptions options;
+  options.scalar_candidates =
+      ParseScalarCandidates("1,4,gsize").ValueOrDie();
+  options.probes = ParseBoundsProbes("192:32,512:32,512:64").ValueOrDie();
+  options.max_settings = 100;
+  options.target = MakeLaunch(1024, 128);
+  options.max_bound = 9999999;
+  options.probe_global_buffer_size = 100000;
+  options.probe_local_buffer_size = 512;
+  return options;
+}
+
+TEST(ParseScalarCandidates, ConstantsAndGlobalSize) {
+  auto candidates_or = ParseScalarCandidates("1, 16,gsize");
+  ASSERT_TRUE(candidates_or.ok());
+  const auto& candidates = candidates_or.ValueOrDie();
+  ASSERT_EQ(candidates.size(), 3);
+  EXPECT_FALSE(candidates[0].is_global_size);
+  EXPECT_EQ(candidates[0].value, 1);
+  EXPECT_FALSE(candidates[1].is_global_size);
+  EXPECT_EQ(candidates[1].value, 16);
+  EXPECT_TRUE(candidates[2].is_global_size);
+}
+
+TEST(ParseScalarCandidates, InvalidCandidate) {
+  EXPECT_FALSE(ParseScalarCandidates("1,lsize").ok());
+  EXPECT_FALSE(ParseScalarCandidates("").ok());
+}
+
+TEST(ParseBoundsProbes, GlobalAndLocalSizes) {
+  auto probes_or = ParseBoundsProbes("192:32,512:64");
+  ASSERT_TRUE(probes_or.ok());
+  const auto& probes = probes_or.ValueOrDie();
+  ASSERT_EQ(probes.size(), 2);
+  EXPECT_EQ(probes[0].global_size_x(), 192);
+  EXPECT_EQ(probes[0].local_size_x(), 32);
+  EXPECT_EQ(probes[1].global_size_x(), 512);
+  EXPECT_EQ(probes[1].local_size_x(), 64);
+}
+
+TEST(ParseBoundsProbes, InvalidProbe) {
+  EXPECT_FALSE(ParseBoundsProbes("192").ok());
+  EXPECT_FALSE(ParseBoundsProbes("192:0").ok());
+  // The global size must be a multiple of the local size.
+  EXPECT_FALSE(ParseBoundsProbes("100:32").ok());
+}
+
+TEST(EvaluateBoundModel, LinearModel) {
+  ArgBoundModel model = {0, "a", {{2, 1, 3}}};
+  EXPECT_EQ(EvaluateBoundModel(model, MakeLaunch(100, 10)), 214);
+}
+
+TEST(FitBoundModel, ExactFit) {
+  const auto coef = FitBoundModel(
+      {MakeLaunch(192, 32), MakeLaunch(512, 32), MakeLaunch(512, 64)},
+      {2 * 192 + 32 - 1, 2 * 512 + 32 - 1, 2 * 512 + 64 - 1});
+  EXPECT_DOUBLE_EQ(coef[0], 2);
+  EXPECT_DOUBLE_EQ(coef[1], 1);
+  EXPECT_DOUBLE_EQ(coef[2], -1);
+}
+
+TEST(FitBoundModel, ConstantLocalSize) {
+  // The local size does not vary, so it has no coefficient.
+  const auto coef =
+      FitBoundModel({MakeLaunch(192, 32), MakeLaunch(512, 32)}, {191, 511});
+  EXPECT_DOUBLE_EQ(coef[0], 1);
+  EXPECT_DOUBLE_EQ(coef[1], 0);
+  EXPECT_DOUBLE_EQ(coef[2], -1);
+}
+
+TEST(FitBoundModel, SingleLaunch) {
+  const auto coef = FitBoundModel({MakeLaunch(192, 32)}, {7});
+  EXPECT_DOUBLE_EQ(coef[0], 0);
+  EXPECT_DOUBLE_EQ(coef[1], 0);
+  EXPECT_DOUBLE_EQ(coef[2], 7);
+}
+
+TEST(InferBoundsModel, GlobalSizeScalar) {
+  // A kernel "k(global int* a, int n)" which reads a[0 .. n - 1], and which
+  // faults for n = 1 and n = 4 because it reads a[get_global_id(0) * 4].
+  const std::vector<BoundsArg> args = {{"a", true, true}, {"n", false, false}};
+  int num_probes = 0;
+  auto models_or = InferBoundsModel(
+      args, MakeOptions(),
+      [&](const DynamicParams& launch, const std::vector<int>& scalars)
+          -> labm8::StatusOr<std::map<int, AccessBounds>> {
+        ++num_probes;
+        EXPECT_EQ(scalars.size(), 1);
+        if (scalars[0] != launch.global_size_x()) {
+          return std::map<int, AccessBounds>{
+              {0, MakeBounds(0, 0, 4 * launch.global_size_x() + 200000)}};
+        }
+        return std::map<int, AccessBounds>{
+            {0, MakeBounds(0, 0, scalars[0] - 1)}};
+      });
+  ASSERT_TRUE(models_or.ok());
+  const auto& models = models_or.ValueOrDie();
+  ASSERT_EQ(models.size(), 2);
+  EXPECT_EQ(models[0].name, "a");
+  EXPECT_EQ(EvaluateBoundModel(models[0], MakeLaunch(1024, 128)), 1024);
+  EXPECT_EQ(models[1].name, "n");
+  EXPECT_EQ(EvaluateBoundModel(models[1], MakeLaunch(1024, 128)), 1024);
+  // The first probe of the rejected settings fails, then all three probes of
+  // the accepted setting are run.
+  EXPECT_EQ(num_probes, 5);
+}
+
+TEST(InferBoundsModel, ConstantScalar) {
+  // A kernel which reads a[get_global_id(0) * n], valid for n = 1.
+  const std::vector<BoundsArg> args = {{"n", false, false}, {"a", true, true}};
+  auto models_or = InferBoundsModel(
+      args, MakeOptions(),
+      [](const DynamicParams& launch, const std::vector<int>& scalars)
+          -> labm8::StatusOr<std::map<int, AccessBounds>> {
+        return std::map<int, AccessBounds>{
+            {1, MakeBounds(1, 0, (launch.global_size_x() - 1) * scalars[0])}};
+      });
+  ASSERT_TRUE(models_or.ok());
+  const auto& models = models_or.ValueOrDie();
+  ASSERT_EQ(models.size(), 2);
+  EXPECT_EQ(EvaluateBoundModel(models[0], MakeLaunch(1024, 128)), 1);
+  EXPECT_EQ(EvaluateBoundModel(models[1], MakeLaunch(1024, 128)), 1024);
+}
+
+TEST(InferBoundsModel, UnaccessedPointer) {
+  const std::vector<BoundsArg> args = {{"a", true, true}};
+  auto models_or = InferBoundsModel(
+      args, MakeOptions(),
+      [](const DynamicParams& /*launch*/, const std::vector<int>& /*scalars*/)
+          -> labm8::StatusOr<std::map<int, AccessBounds>> {
+        return std::map<int, AccessBounds>{};
+      });
+  ASSERT_TRUE(models_or.ok());
+  EXPECT_EQ(EvaluateBoundModel(models_or.ValueOrDie()[0], MakeLaunch(64, 8)),
+            64);
+}
+
+TEST(InferBoundsModel, LocalPointer) {
+  // A kernel which reads local memory a[get_local_id(0)].
+  const std::vector<BoundsArg> args = {{"a", true, false}};
+  auto models_or = InferBoundsModel(
+      args, MakeOptions(),
+      [](const DynamicParams& launch, const std::vector<int>& /*scalars*/)
+          -> labm8::StatusOr<std::map<int, AccessBounds>> {
+        return std::map<int, AccessBounds>{
+            {0, MakeBounds(0, 0, launch.local_size_x() - 1)}};
+      });
+  ASSERT_TRUE(models_or.ok());
+  EXPECT_EQ(
+      EvaluateBoundModel(models_or.ValueOrDie()[0], MakeLaunch(1024, 128)),
+      128);
+}
+
+TEST(InferBoundsModel, NoValidSetting) {
+  const std::vector<BoundsArg> args = {{"a", true, true}, {"n", false, false}};
+  int num_probes = 0;
+  auto models_or = InferBoundsModel(
+      args, MakeOptions(),
+      [&](const DynamicParams& /*launch*/, const std::vector<int>& /*scalars*/)
+          -> labm8::StatusOr<std::map<int, AccessBounds>> {
+        ++num_probes;
+        return labm8::Status(labm8::error::Code::INTERNAL, "fault");
+      });
+  ASSERT_FALSE(models_or.ok());
+  EXPECT_EQ(models_or.status().error_code(), labm8::error::Code::NOT_FOUND);
+  // Each of the three settings is tried once.
+  EXPECT_EQ(num_probes, 3);
+}
+
+TEST(InferBoundsModel, MaxSettings) {
+  const std::vector<BoundsArg> args = {{"m", false, false},
+                                       {"n", false, false}};
+  BoundsInferenceOptions options = MakeOptions();
+  options.max_settings = 4;
+  int num_probes = 0;
+  auto models_or = InferBoundsModel(
+      args, options,
+      [&](const DynamicParams& /*launch*/, const std::vector<int>& /*scalars*/)
+          -> labm8::StatusOr<std::map<int, AccessBounds>> {
+        ++num_probes;
+        return labm8::Status(labm8::error::Code::INTERNAL, "fault");
+      });
+  ASSERT_FALSE(models_or.ok());
+  EXPECT_EQ(num_probes, 4);
+}
+
+TEST(BoundsModelToJson, KeyedByName) {
+  EXPECT_EQ(BoundsModelToJson({{0, "a", {{1, 0, -1}}}, {1, "n", {{0, 0, 3}}}}),
+            "{\"a\":{\"arg_id\":0,\"coef\":[1.0,0.0,-1.0]},"
+            "\"n\":{\"arg_id\":1,\"coef\":[0.0,0.0,3.0]}}");
+}
+
+}  // anonymous namespace
+}  // namespace clmem
+}  // namespace gpu
+
+TEST_MAIN();
@@ -3,6 +3,8 @@
 // Usage summary:
 //   clmem --srcs=<opencl_sources> --envs=<opencl_devices>
 //       --gsize=<gsize> --lsize=<lsize> --output_format=(txt|pb|pbtxt)
+//   clmem --srcs=<opencl_sources> --envs=<opencl_device> --infer_bounds
+//       [--infer_bounds_dir=<dir>]
 //
 // Run with `--help` argument to see full usage options.
 //
@@ -23,8 +25,10 @@
 // along with clmem.  If not, see <https://www.gnu.org/licenses/>.
 #include "gpu/clmem/libclmem.h"
 
+#include "gpu/clmem/bounds_inference.h"
 #include "gpu/clmem/logger.h"
 #include "gpu/clmem/proto/clmem.pb.h"
+#include "gpu/cldrive/program_cache.h"
 #include "gpu/clinfo/libclinfo.h"
 
 #include "labm8/cpp/app.h"
@@ -115,11 +119,14 @@ static bool ValidateEnvs(const char* flagname, const string& value) {
 DEFINE_validator(envs, &ValidateEnvs);
 
 DEFINE_string(output_format, "null",
-              "The output format. One of: {pb,pbtxt,null}.");
+              "The output format. One of: {bounds,pb,pbtxt,null}. 'bounds' "
+              "prints a CSV of the access bounds of each run, and requires "
+              "--hook_mode=atomic.");
 static bool ValidateOutputFormat(const char* flagname, const string& value) {
-  if (value.compare("pb") && value.compare("pbtxt") && value.compare("null")) {
+  if (value.compare("bounds") && value.compare("pb") &&
+      value.compare("pbtxt") && value.compare("null")) {
     LOG(FATAL) << "Illegal value for --" << flagname << ". Must be one of: "
-               << "{pb,pbtxt,null}";
+               << "{bounds,pb,pbtxt,null}";
   }
   return true;
 }
@@ -138,7 +145,73 @@ DEFINE_string(args_values, "",
               "argument. Must be the same length as the number of arguments");
 
 DEFINE_string(cl_build_opt, "", "Build options passed to clBuildProgram().");
+DEFINE_string(cl_program_cache_dir, "",
+              "If set, cache compiled program binaries in this directory and "
+              "reuse them for later builds of the same source, build options, "
+              "and device.");
 DEFINE_int32(num_runs, 30, "The number of runs per kernel.");
+DEFINE_string(hook_mode, "printf",
+              "How the hook(arg_id, index) function of instrumented kernels "
+              "reports memory accesses. One of: {printf,atomic}. With "
+              "'printf', hook() is run as written. With 'atomic', hook() is "
+              "rewritten to record the minimum and maximum index of each "
+              "arg_id in a small device buffer, which is read back after each "
+              "run.");
+static bool ValidateHookMode(const char* flagname, const string& value) {
+  if (value.compare("printf") && value.compare("atomic")) {
+    LOG(FATAL) << "Illegal value for --" << flagname << ". Must be one of: "
+               << "{printf,atomic}";
+  }
+  return true;
+}
+DEFINE_validator(hook_mode, &ValidateHookMode);
+
+DEFINE_bool(infer_bounds, false,
+            "Infer a model of the array bound of each argument of the first "
+            "kernel of each source, in place of driving the kernels. Sources "
+            "must define hook(), as for --hook_mode=atomic. For each setting "
+            "of the scalar arguments, the kernel is run at each of "
+            "--infer_bounds_probes, and a model of the largest index of each "
+            "pointer argument is fit over the global and local sizes. The "
+            "models of the first setting which gives valid bounds at --gsize "
+            "and --lsize_x are written in the format read by clcheck's "
+            "--mem_analysis_dir.");
+DEFINE_string(infer_bounds_dir, "",
+              "If set, write the models of --infer_bounds to "
+              "<dir>/<source_stem>.json. Else, print one JSON object per "
+              "source to stdout.");
+DEFINE_string(infer_bounds_scalars, "1,4,gsize,16,32,256",
+              "A comma separated list of the values tried for each scalar "
+              "argument with --infer_bounds. 'gsize' is the global size of "
+              "the probe.");
+static bool ValidateInferBoundsScalars(const char* flagname,
+                                       const string& value) {
+  auto candidates_or = gpu::clmem::ParseScalarCandidates(value);
+  if (!candidates_or.ok()) {
+    LOG(FATAL) << "Illegal value for --" << flagname << ": "
+               << candidates_or.status().ToString();
+  }
+  return true;
+}
+DEFINE_validator(infer_bounds_scalars, &ValidateInferBoundsScalars);
+DEFINE_string(infer_bounds_probes, "192:32,512:32,512:64,1024:128",
+              "A comma separated list of <gsize>:<lsize> launches which are "
+              "run for each scalar setting with --infer_bounds. The global "
+              "and local sizes must each take at least two values for both "
+              "to be fit.");
+static bool ValidateInferBoundsProbes(const char* flagname,
+                                      const string& value) {
+  auto probes_or = gpu::clmem::ParseBoundsProbes(value);
+  if (!probes_or.ok()) {
+    LOG(FATAL) << "Illegal value for --" << flagname << ": "
+               << probes_or.status().ToString();
+  }
+  return true;
+}
+DEFINE_validator(infer_bounds_probes, &ValidateInferBoundsProbes);
+DEFINE_int32(infer_bounds_max_settings, 216,
+             "The maximum number of scalar settings tried for each source "
+             "with --infer_bounds.");
 DEFINE_bool(clinfo, false, "List the available devices and exit.");
 
 // End flag definitions ------------------------------------
@@ -148,7 +221,9 @@ namespace clmem {
 
 std::unique_ptr<Logger> MakeLoggerFromFlags(
     std::ostream& ostream, const ClmemInstances* const instances) {
-  if (!FLAGS_output_format.compare("pb")) {
+  if (!FLAGS_output_format.compare("bounds")) {
+    return std::make_unique<AccessBoundsLogger>(std::cout, instances);
+  } else if (!FLAGS_output_format.compare("pb")) {
     return std::make_unique<ProtocolBufferLogger>(std::cout, instances,
                                                   /*text_format=*/false);
   } else if (!FLAGS_output_format.compare("pbtxt")) {
@@ -189,6 +264,64 @@ std::vector<::gpu::clinfo::OpenClDevice> GetDevicesFromCommaSeparatedString(
   return devices;
 }
 
+// The number of elements of the buffers of pointer arguments during
+// --infer_bounds probes. A probe which accesses beyond them rejects its scalar
+// setting.
+const int kInferBoundsGlobalBufferSize = 1000000;
+const int kInferBoundsLocalBufferSize = 512;
+// The largest bound which --infer_bounds accepts for a global pointer.
+const labm8::int64 kInferBoundsMaxBound = 9999999;
+
+// Infer the array bounds of each of --srcs on a device, and write them to
+// --infer_bounds_dir or stdout.
+void InferBoundsOrDie(const ::gpu::clinfo::OpenClDevice& device) {
+  gpu::clmem::BoundsInferenceOptions options;
+  options.scalar_candidates =
+      gpu::clmem::ParseScalarCandidates(FLAGS_infer_bounds_scalars)
+          .ValueOrDie();
+  options.probes =
+      gpu::clmem::ParseBoundsProbes(FLAGS_infer_bounds_probes).ValueOrDie();
+  options.max_settings = FLAGS_infer_bounds_max_settings;
+  options.target.set_global_size_x(FLAGS_gsize);
+  options.target.set_local_size_x(FLAGS_lsize_x);
+  options.max_bound = kInferBoundsMaxBound;
+  options.probe_global_buffer_size = kInferBoundsGlobalBufferSize;
+  options.probe_local_buffer_size = kInferBoundsLocalBufferSize;
+
+  if (!FLAGS_infer_bounds_dir.empty()) {
+    boost::filesystem::create_directories(FLAGS_infer_bounds_dir);
+  }
+
+  int instance_num = 0;
+  for (auto path : SplitCommaSeparated(FLAGS_srcs)) {
+    gpu::clmem::ClmemInstance instance;
+    *instance.mutable_device() = device;
+    instance.set_build_opts(FLAGS_cl_build_opt);
+    instance.set_opencl_src(ReadFileOrDie(path));
+
+    auto models_or =
+        gpu::clmem::Clmem(&instance, instance_num++).InferBounds(options);
+    if (!models_or.ok()) {
+      LOG(WARNING) << "Failed to infer bounds of '" << path
+                   << "': " << models_or.status().ToString();
+      continue;
+    }
+
+    const string json = gpu::clmem::BoundsModelToJson(models_or.ValueOrDie());
+    if (FLAGS_infer_bounds_dir.empty()) {
+      std::cout << json << std::endl;
+    } else {
+      const boost::filesystem::path out_path =
+          boost::filesystem::path(FLAGS_infer_bounds_dir) /
+          (boost::filesystem::path(path).stem().string() + ".json");
+      boost::filesystem::ofstream ostream(out_path);
+      CHECK(ostream.is_open()) << "Failed to open: '" << out_path.string()
+                               << "'";
+      ostream << json << std::endl;
+    }
+  }
+}
+
 }  // namespace
 
 int main(int argc, char** argv) {
@@ -204,6 +337,10 @@ int main(int argc, char** argv) {
     return 0;
   }
 
+  if (!FLAGS_cl_program_cache_dir.empty()) {
+    gpu::cldrive::EnableProgramBinaryCache(FLAGS_cl_program_cache_dir);
+  }
+
   // Check that required flags are set. We can't check this in the flag
   // validator functions as they are only required if the early-exit flags
   // above are not set.
@@ -213,6 +350,16 @@ int main(int argc, char** argv) {
 
   auto devices = GetDevicesFromCommaSeparatedString(FLAGS_envs);
 
+  if (FLAGS_infer_bounds) {
+    CHECK(!devices.empty()) << "No OpenCL devices";
+    if (devices.size() > 1) {
+      LOG(WARNING) << "--infer_bounds uses only the first of "
+                   << devices.size() << " devices: " << devices[0].name();
+    }
+    InferBoundsOrDie(devices[0]);
+    return 0;
+  }
+
   // Create instances proto.
   gpu::clmem::ClmemInstances instances;
   gpu::clmem::ClmemInstance* instance = instances.add_instance();
@@ -228,6 +375,11 @@ int main(int argc, char** argv) {
   dp->set_local_size_y(FLAGS_lsize_y);
   dp->set_local_size_z(FLAGS_lsize_z);
   instance->set_min_runs_per_kernel(FLAGS_num_runs);
+  if (!FLAGS_hook_mode.compare("atomic")) {
+    instance->set_hook_mode(gpu::clmem::ClmemInstance::ATOMIC_BOUNDS);
+  } else if (!FLAGS_output_format.compare("bounds")) {
+    LOG(FATAL) << "--output_format=bounds requires --hook_mode=atomic";
+  }
 
   // Parse logger flag.
   std::unique_ptr<gpu::clmem::Logger> logger =
@@ -257,5 +409,9 @@ int main(int argc, char** argv) {
     ++instance_num;
   }
 
+  if (gpu::cldrive::GetProgramBinaryCache()) {
+    LOG(INFO) << gpu::cldrive::GetProgramBinaryCache()->StatsString();
+  }
+
   return 0;
 }
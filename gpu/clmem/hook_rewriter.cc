@@ -0,0 +1,411 @@
+// Copyright (c) 2016-2020 Chris Cummins.
+// This file is part of clmem.
+//
+// clmem is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// clmem is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with clmem.  If not, see <https://www.gnu.org/licenses/>.
+#include "gpu/clmem/hook_rewriter.h"
+
+#include "labm8/cpp/status.h"
+
+#include "absl/strings/ascii.h"
+#include "absl/strings/str_cat.h"
+
+#include <algorithm>
+#include <cctype>
+#include <map>
+#include <set>
+#include <vector>
+
+namespace gpu {
+namespace clmem {
+
+const char* const kHookFunctionName = "hook";
+const char* const kAccessBoundsArgName = "__clmem_bounds";
+
+namespace {
+
+// A function definition or declaration at file scope.
+struct Function {
+  string name;
+  bool is_kernel;
+  // The positions of the '(' and ')' of the parameter list.
+  size_t params_begin;
+  size_t params_end;
+  // The positions of the '{' and one past the '}' of the body. Both are
+  // string::npos for a declaration.
+  size_t body_begin;
+  size_t body_end;
+};
+
+// A call to a function of the source.
+struct Call {
+  string callee;
+  // The position of the '(' of the argument list.
+  size_t args_begin;
+};
+
+// A replacement of src[begin, end) by text.
+struct Edit {
+  size_t begin;
+  size_t end;
+  string text;
+};
+
+bool IsIdentifierStart(char c) { return std::isalpha(c) || c == '_'; }
+
+bool IsIdentifierChar(char c) { return std::isalnum(c) || c == '_'; }
+
+size_t SkipWhitespace(const string& code, size_t pos) {
+  while (pos < code.size() && std::isspace(code[pos])) {
+    ++pos;
+  }
+  return pos;
+}
+
+size_t SkipIdentifier(const string& code, size_t pos) {
+  while (pos < code.size() && IsIdentifierChar(code[pos])) {
+    ++pos;
+  }
+  return pos;
+}
+
+// Return the position after the bracket which closes the one at pos, or
+// string::npos if it is not closed.
+size_t SkipBrackets(const string& code, size_t pos, char open, char close) {
+  int depth = 0;
+  for (; pos < code.size(); ++pos) {
+    if (code[pos] == open) {
+      ++depth;
+    } else if (code[pos] == close && !--depth) {
+      return pos + 1;
+    }
+  }
+  return string::npos;
+}
+
+// Return the position of the first token after any __attribute__((...))
+// specifiers at pos, or string::npos if one is not closed.
+size_t SkipAttributes(const string& code, size_t pos) {
+  pos = SkipWhitespace(code, pos);
+  while (pos < code.size() && IsIdentifierStart(code[pos])) {
+    const size_t end = SkipIdentifier(code, pos);
+    const string name = code.substr(pos, end - pos);
+    if (name != "__attribute__" && name != "__attribute") {
+      break;
+    }
+    pos = SkipWhitespace(code, end);
+    if (pos >= code.size() || code[pos] != '(') {
+      break;
+    }
+    pos = SkipBrackets(code, pos, '(', ')');
+    if (pos == string::npos) {
+      return pos;
+    }
+    pos = SkipWhitespace(code, pos);
+  }
+  return pos;
+}
+
+// Return a copy of src with comments, string and character literals, and
+// preprocessor directives replaced by spaces. Newlines are kept, so positions
+// in the copy are positions in src.
+string MaskNonCode(const string& src) {
+  string code(src);
+  bool line_start = true;
+  size_t i = 0;
+  while (i < src.size()) {
+    const char c = src[i];
+    const char next = i + 1 < src.size() ? src[i + 1] : '\0';
+    size_t end;
+    if (c == '/' && next == '/') {
+      end = std::min(src.find('\n', i), src.size());
+    } else if (c == '/' && next == '*') {
+      end = src.find("*/", i + 2);
+      end = end == string::npos ? src.size() : end + 2;
+    } else if (c == '"' || c == '\'') {
+      for (end = i + 1; end < src.size() && src[end] != c; ++end) {
+        if (src[end] == '\\') {
+          ++end;
+        }
+      }
+      end = std::min(end + 1, src.size());
+    } else if (c == '#' && line_start) {
+      for (end = i; end < src.size(); ++end) {
+        if (src[end] == '\n' && src[end - 1] != '\\') {
+          break;
+        }
+      }
+    } else {
+      line_start = c == '\n' || (line_start && std::isspace(c));
+      ++i;
+      continue;
+    }
+    for (; i < end; ++i) {
+      if (code[i] != '\n') {
+        code[i] = ' ';
+      }
+    }
+  }
+  return code;
+}
+
+// Return true if a declaration has the kernel qualifier.
+bool HasKernelQualifier(const string& code, size_t begin, size_t end) {
+  for (size_t i = begin; i < end;) {
+    if (!IsIdentifierStart(code[i])) {
+      ++i;
+      continue;
+    }
+    const size_t token_end = SkipIdentifier(code, i);
+    const string token = code.substr(i, token_end - i);
+    if (token == "kernel" || token == "__kernel") {
+      return true;
+    }
+    i = token_end;
+  }
+  return false;
+}
+
+// Return the functions defined or declared at file scope.
+std::vector<Function> FindFunctions(const string& code) {
+  std::vector<Function> functions;
+  // The start of the current file scope declaration.
+  size_t declaration_begin = 0;
+  size_t i = 0;
+  while (i < code.size()) {
+    const char c = code[i];
+    if (c == ';') {
+      declaration_begin = ++i;
+      continue;
+    }
+    if (c == '{' || c == '(') {
+      // Not a function, e.g. a struct definition.
+      i = SkipBrackets(code, i, c, c == '{' ? '}' : ')');
+      if (i == string::npos) {
+        break;
+      }
+      continue;
+    }
+    if (!IsIdentifierStart(c) || (i && IsIdentifierChar(code[i - 1]))) {
+      ++i;
+      continue;
+    }
+
+    const size_t name_end = SkipIdentifier(code, i);
+    const size_t params_begin = SkipWhitespace(code, name_end);
+    if (params_begin >= code.size() || code[params_begin] != '(') {
+      i = name_end;
+      continue;
+    }
+    const size_t params_end = SkipBrackets(code, params_begin, '(', ')');
+    if (params_end == string::npos) {
+      break;
+    }
+    const size_t next = SkipAttributes(code, params_end);
+    if (next >= code.size() || (code[next] != '{' && code[next] != ';')) {
+      i = params_end;
+      continue;
+    }
+
+    Function function;
+    function.name = code.substr(i, name_end - i);
+    function.is_kernel = HasKernelQualifier(code, declaration_begin, i);
+    function.params_begin = params_begin;
+    function.params_end = params_end - 1;
+    function.body_begin = string::npos;
+    function.body_end = string::npos;
+    if (code[next] == '{') {
+      function.body_begin = next;
+      function.body_end = SkipBrackets(code, next, '{', '}');
+      if (function.body_end == string::npos) {
+        break;
+      }
+      i = function.body_end;
+    } else {
+      i = next + 1;
+    }
+    functions.push_back(function);
+    declaration_begin = i;
+  }
+  return functions;
+}
+
+// Return the calls to any of the named functions in a function body.
+std::vector<Call> FindCalls(const string& code, const Function& function,
+                            const std::set<string>& names) {
+  std::vector<Call> calls;
+  size_t i = function.body_begin;
+  while (i < function.body_end) {
+    if (!IsIdentifierStart(code[i]) || IsIdentifierChar(code[i - 1])) {
+      ++i;
+      continue;
+    }
+    const size_t name_end = SkipIdentifier(code, i);
+    const string name = code.substr(i, name_end - i);
+    const size_t args_begin = SkipWhitespace(code, name_end);
+    if (args_begin < code.size() && code[args_begin] == '(' &&
+        names.count(name)) {
+      calls.push_back({name, args_begin});
+    }
+    i = name_end;
+  }
+  return calls;
+}
+
+// Return the arg_id of a hook() call if it is a literal, else -1.
+int GetLiteralArgId(const string& code, const Call& call) {
+  const size_t begin = SkipWhitespace(code, call.args_begin + 1);
+  size_t end = begin;
+  while (end < code.size() && std::isdigit(code[end])) {
+    ++end;
+  }
+  if (end == begin || end - begin > 6) {
+    return -1;
+  }
+  const size_t comma = SkipWhitespace(code, end);
+  if (comma >= code.size() || code[comma] != ',') {
+    return -1;
+  }
+  return std::stoi(code.substr(begin, end - begin));
+}
+
+// Return true if a parameter list declares no parameters.
+bool HasNoParams(const string& code, const Function& function) {
+  const string params(absl::StripAsciiWhitespace(code.substr(
+      function.params_begin + 1,
+      function.params_end - function.params_begin - 1)));
+  return params.empty() || params == "void";
+}
+
+}  // anonymous namespace
+
+labm8::StatusOr<AccessBoundsProgram> RewriteHooksToAccessBounds(
+    const string& opencl_src) {
+  const string code = MaskNonCode(opencl_src);
+  const std::vector<Function> functions = FindFunctions(code);
+  const string hook(kHookFunctionName);
+  const string bounds(kAccessBoundsArgName);
+  const string bounds_param = absl::StrCat("global int* ", bounds);
+
+  std::set<string> names;
+  bool has_hook = false;
+  for (const auto& function : functions) {
+    names.insert(function.name);
+    has_hook |= function.name == hook && function.body_begin != string::npos;
+  }
+  if (!has_hook) {
+    return labm8::Status(labm8::error::Code::NOT_FOUND,
+                         "No definition of {}() in OpenCL source", hook);
+  }
+
+  // Find the calls made by each function body, and the largest arg_id.
+  AccessBoundsProgram program;
+  program.num_arg_ids = 1;
+  std::map<const Function*, std::vector<Call>> calls;
+  for (const auto& function : functions) {
+    if (function.body_begin == string::npos) {
+      continue;
+    }
+    calls[&function] = FindCalls(code, function, names);
+    for (const auto& call : calls[&function]) {
+      if (call.callee == hook) {
+        program.num_arg_ids = std::max(program.num_arg_ids,
+                                       GetLiteralArgId(code, call) + 1);
+      }
+    }
+  }
+
+  // The functions which call hook(), directly or indirectly, need the
+  // buffer.
+  std::set<string> needs_bounds = {hook};
+  for (bool changed = true; changed;) {
+    changed = false;
+    for (const auto& it : calls) {
+      if (it.first->is_kernel || needs_bounds.count(it.first->name)) {
+        continue;
+      }
+      for (const auto& call : it.second) {
+        if (needs_bounds.count(call.callee)) {
+          needs_bounds.insert(it.first->name);
+          changed = true;
+          break;
+        }
+      }
+    }
+  }
+
+  std::vector<Edit> edits;
+  for (const auto& function : functions) {
+    const bool is_definition = function.body_begin != string::npos;
+    if (function.name == hook) {
+      string replacement = absl::StrCat("(", bounds_param,
+                                        ", int __clmem_arg_id, "
+                                        "int __clmem_index)");
+      if (is_definition) {
+        absl::StrAppend(
+            &replacement, " {\n  if (__clmem_arg_id >= 0 && __clmem_arg_id < ",
+            program.num_arg_ids, ") {\n    atomic_min(&", bounds,
+            "[2 * __clmem_arg_id], __clmem_index);\n    atomic_max(&", bounds,
+            "[2 * __clmem_arg_id + 1], __clmem_index);\n  }\n"
+            "  return __clmem_index;\n}");
+      }
+      edits.push_back({function.params_begin,
+                       is_definition ? function.body_end
+                                     : function.params_end + 1,
+                       replacement});
+      continue;
+    }
+
+    const bool gets_bounds =
+        function.is_kernel || needs_bounds.count(function.name);
+    if (gets_bounds) {
+      if (HasNoParams(code, function)) {
+        edits.push_back(
+            {function.params_begin + 1, function.params_end, bounds_param});
+      } else if (function.is_kernel) {
+        // The buffer is the last kernel argument, so that the indices of
+        // the other arguments are unchanged.
+        edits.push_back({function.params_end, function.params_end,
+                         absl::StrCat(", ", bounds_param)});
+      } else {
+        edits.push_back({function.params_begin + 1, function.params_begin + 1,
+                         absl::StrCat(bounds_param, ", ")});
+      }
+    }
+
+    if (!is_definition || !gets_bounds) {
+      continue;
+    }
+    for (const auto& call : calls[&function]) {
+      if (!needs_bounds.count(call.callee)) {
+        continue;
+      }
+      const size_t arg = SkipWhitespace(code, call.args_begin + 1);
+      const bool no_args = arg < code.size() && code[arg] == ')';
+      edits.push_back({call.args_begin + 1, call.args_begin + 1,
+                       no_args ? bounds : absl::StrCat(bounds, ", ")});
+    }
+  }
+
+  // Apply the edits from last to first, so that positions stay valid.
+  std::sort(edits.begin(), edits.end(),
+            [](const Edit& a, const Edit& b) { return a.begin > b.begin; });
+  program.opencl_src = opencl_src;
+  for (const auto& edit : edits) {
+    program.opencl_src.replace(edit.begin, edit.end - edit.begin, edit.text);
+  }
+  return program;
+}
+
+}  // namespace clmem
+}  // namespace gpu
@@ -0,0 +1,59 @@
+// Rewrite memory access hooks to record access bounds on the device.
+//
+// Copyright (c) 2016-2020 Chris Cummins.
+// This file is part of clmem.
+//
+// clmem is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// clmem is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with clmem.  If not, see <https://www.gnu.org/licenses/>.
+#pragma once
+
+#include "labm8/cpp/statusor.h"
+#include "labm8/cpp/string.h"
+
+namespace gpu {
+namespace clmem {
+
+// The name of the function which instrumented kernels call on every memory
+// access, as hook(arg_id, index). It returns index.
+extern const char* const kHookFunctionName;
+
+// The name of the kernel argument added by RewriteHooksToAccessBounds().
+extern const char* const kAccessBoundsArgName;
+
+struct AccessBoundsProgram {
+  // The rewritten OpenCL source.
+  string opencl_src;
+  // The number of argument ids which are recorded. The access bounds buffer
+  // holds a (min, max) pair of ints for each.
+  int num_arg_ids;
+};
+
+// Rewrite an OpenCL source so that hook(arg_id, index) records the minimum
+// and maximum index of each arg_id with atomic_min() and atomic_max() into a
+// buffer, rather than printing them.
+//
+// Every kernel gets an extra, last, argument: a global int pointer to the
+// buffer. The buffer is passed down to hook() by adding it as the first
+// parameter of every function which calls hook(), directly or indirectly. The
+// buffer has num_arg_ids (min, max) pairs, where num_arg_ids is one more
+// than the largest literal arg_id passed to hook(). Calls with other arg_ids
+// are ignored.
+//
+// Comments, string literals, and preprocessor directives are not rewritten,
+// so hook() calls in macro definitions are not supported. Returns NOT_FOUND
+// if the source has no definition of hook().
+labm8::StatusOr<AccessBoundsProgram> RewriteHooksToAccessBounds(
+    const string& opencl_src);
+
+}  // namespace clmem
+}  // namespace gpu
@@ -0,0 +1,170 @@
+// Copyright (c) 2016-2020 Chris Cummins.
+// This file is part of clmem.
+//
+// clmem is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// clmem is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with clmem.  If not, see <https://www.gnu.org/licenses/>.
+#include "gpu/clmem/hook_rewriter.h"
+
+#include "labm8/cpp/logging.h"
+#include "labm8/cpp/test.h"
+
+namespace gpu {
+namespace clmem {
+namespace {
+
+const char* kHookDefinition =
+    "int hook(int argId, int id) {\n"
+    "  printf(\"%d,%d\\n\", argId, id);\n"
+    "  return id;\n"
+    "}\n";
+
+const char* kRewrittenHook =
+    "int hook(global int* __clmem_bounds, int __clmem_arg_id, "
+    "int __clmem_index) {\n"
+    "  if (__clmem_arg_id >= 0 && __clmem_arg_id < 2) {\n"
+    "    atomic_min(&__clmem_bounds[2 * __clmem_arg_id], __clmem_index);\n"
+    "    atomic_max(&__clmem_bounds[2 * __clmem_arg_id + 1], "
+    "__clmem_index);\n"
+    "  }\n"
+    "  return __clmem_index;\n"
+    "}\n";
+
+string RewriteOrDie(const string& src) {
+  auto program_or = RewriteHooksToAccessBounds(src);
+  CHECK(program_or.ok()) << program_or.status().ToString();
+  return program_or.ValueOrDie().opencl_src;
+}
+
+TEST(RewriteHooksToAccessBounds, NoHookIsNotFound) {
+  auto program_or = RewriteHooksToAccessBounds("kernel void A() {}");
+  ASSERT_FALSE(program_or.ok());
+  EXPECT_EQ(program_or.status().code(), labm8::error::Code::NOT_FOUND);
+}
+
+TEST(RewriteHooksToAccessBounds, HookIsCalledFromKernel) {
+  auto program_or = RewriteHooksToAccessBounds(
+      string(kHookDefinition) +
+      "kernel void A(global int* a, global int* b) {\n"
+      "  a[hook(0, get_global_id(0))] = b[hook(1, 0)];\n"
+      "}\n");
+  ASSERT_TRUE(program_or.ok());
+  EXPECT_EQ(program_or.ValueOrDie().num_arg_ids, 2);
+  EXPECT_EQ(program_or.ValueOrDie().opencl_src,
+            string(kRewrittenHook) +
+                "kernel void A(global int* a, global int* b, "
+                "global int* __clmem_bounds) {\n"
+                "  a[hook(__clmem_bounds, 0, get_global_id(0))] = "
+                "b[hook(__clmem_bounds, 1, 0)];\n"
+                "}\n");
+}
+
+TEST(RewriteHooksToAccessBounds, BoundsArePassedThroughHelpers) {
+  EXPECT_EQ(RewriteOrDie(string(kHookDefinition) +
+                         "int B(global int* in, int n) {\n"
+                         "  return in[hook(1, n)];\n"
+                         "}\n"
+                         "int C(global int* in) { return B(in, 0); }\n"
+                         "int D(int n) { return n + 1; }\n"
+                         "kernel void A(global int* in, global int* out) {\n"
+                         "  out[D(0)] = C(in);\n"
+                         "}\n"),
+            string(kRewrittenHook) +
+                "int B(global int* __clmem_bounds, global int* in, int n) {\n"
+                "  return in[hook(__clmem_bounds, 1, n)];\n"
+                "}\n"
+                "int C(global int* __clmem_bounds, global int* in) { "
+                "return B(__clmem_bounds, in, 0); }\n"
+                "int D(int n) { return n + 1; }\n"
+                "kernel void A(global int* in, global int* out, "
+                "global int* __clmem_bounds) {\n"
+                "  out[D(0)] = C(__clmem_bounds, in);\n"
+                "}\n");
+}
+
+TEST(RewriteHooksToAccessBounds, EmptyParameterLists) {
+  const string src = RewriteOrDie(
+      "int hook(int a, int i) { return i; }\n"
+      "int B(void) { return hook(0, 0); }\n"
+      "kernel void A() { B(); }\n");
+  EXPECT_NE(src.find("int B(global int* __clmem_bounds) {"), string::npos);
+  EXPECT_NE(src.find("B(__clmem_bounds);"), string::npos);
+  EXPECT_NE(src.find("kernel void A(global int* __clmem_bounds) {"),
+            string::npos);
+}
+
+TEST(RewriteHooksToAccessBounds, DeclarationsAreRewritten) {
+  const string src = RewriteOrDie(
+      "int hook(int, int);\n"
+      "int B(int n);\n"
+      "kernel void A(global int* a) { a[B(0)] = 0; }\n"
+      "int B(int n) { return hook(0, n); }\n" +
+      string(kHookDefinition));
+  EXPECT_NE(src.find("int hook(global int* __clmem_bounds, int __clmem_arg_id,"
+                     " int __clmem_index);\n"),
+            string::npos);
+  EXPECT_NE(src.find("int B(global int* __clmem_bounds, int n);"),
+            string::npos);
+  EXPECT_NE(src.find("a[B(__clmem_bounds, 0)]"), string::npos);
+}
+
+TEST(RewriteHooksToAccessBounds, KernelAttributesAndQualifiers) {
+  const string src = RewriteOrDie(
+      string(kHookDefinition) +
+      "__kernel __attribute__((reqd_work_group_size(64, 1, 1)))\n"
+      "void A(__global int* a) __attribute__((vec_type_hint(int))) {\n"
+      "  a[hook(0, 0)] = 0;\n"
+      "}\n");
+  EXPECT_NE(src.find("void A(__global int* a, global int* __clmem_bounds)"),
+            string::npos);
+  EXPECT_NE(src.find("a[hook(__clmem_bounds, 0, 0)]"), string::npos);
+}
+
+TEST(RewriteHooksToAccessBounds, CommentsStringsAndMacrosAreIgnored) {
+  const string src = RewriteOrDie(
+      "#define HOOK(x) hook(0, x)\n"
+      "// int hook(int a, int b) { return b; }\n" +
+      string(kHookDefinition) +
+      "kernel void A(global int* a) {\n"
+      "  /* hook(3, 0) */ a[hook(0, 0)] = 0;\n"
+      "}\n");
+  EXPECT_NE(src.find("#define HOOK(x) hook(0, x)\n"), string::npos);
+  EXPECT_NE(src.find("// int hook(int a, int b) { return b; }\n"),
+            string::npos);
+  EXPECT_NE(src.find("/* hook(3, 0) */"), string::npos);
+  EXPECT_EQ(src.find("printf"), string::npos);
+}
+
+TEST(RewriteHooksToAccessBounds, NumArgIdsIsLargestLiteralPlusOne) {
+  auto program_or = RewriteHooksToAccessBounds(
+      string(kHookDefinition) +
+      "kernel void A(global int* a, int n) {\n"
+      "  a[hook(4, 0)] = a[hook(n, 1)];\n"
+      "}\n");
+  ASSERT_TRUE(program_or.ok());
+  EXPECT_EQ(program_or.ValueOrDie().num_arg_ids, 5);
+}
+
+TEST(RewriteHooksToAccessBounds, StructsAreSkipped) {
+  const string src = RewriteOrDie(
+      "typedef struct { int x; } S;\n" + string(kHookDefinition) +
+      "kernel void A(global S* s) { s[hook(0, 0)].x = 0; }\n");
+  EXPECT_NE(src.find("typedef struct { int x; } S;\n"), string::npos);
+  EXPECT_NE(src.find("kernel void A(global S* s, global int* __clmem_bounds)"),
+            string::npos);
+}
+
+}  // anonymous namespace
+}  // namespace clmem
+}  // namespace gpu
+
+TEST_MAIN();
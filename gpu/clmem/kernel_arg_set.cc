@@ -23,10 +23,13 @@
 namespace gpu {
 namespace clmem {
 
-KernelArgSet::KernelArgSet(cl::Kernel* kernel) : kernel_(kernel) {}
+KernelArgSet::KernelArgSet(cl::Kernel* kernel, size_t num_hidden_args)
+    : kernel_(kernel), num_hidden_args_(num_hidden_args) {}
 
 ClmemKernelInstance::KernelInstanceOutcome KernelArgSet::Init() {
   size_t num_args = kernel_->getInfo<CL_KERNEL_NUM_ARGS>();
+  CHECK(num_args >= num_hidden_args_);
+  num_args -= num_hidden_args_;
   if (!num_args) {
     LOG(WARNING) << "Kernel '" << util::GetOpenClKernelName(*kernel_)
                  << "' has no arguments";
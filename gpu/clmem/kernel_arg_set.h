@@ -26,7 +26,9 @@ namespace clmem {
 
 class KernelArgSet {
  public:
-  KernelArgSet(cl::Kernel* kernel);
+  // The last num_hidden_args arguments of the kernel are set by the caller,
+  // and are not part of the set.
+  KernelArgSet(cl::Kernel* kernel, size_t num_hidden_args = 0);
 
   ClmemKernelInstance::KernelInstanceOutcome LogErrorOutcome(
       const ClmemKernelInstance::KernelInstanceOutcome& outcome);
@@ -48,6 +50,7 @@ class KernelArgSet {
 
  private:
   cl::Kernel* kernel_;
+  size_t num_hidden_args_;
   std::vector<KernelArg> args_;
 };
 
@@ -23,6 +23,9 @@
 #include "labm8/cpp/logging.h"
 #include "labm8/cpp/status_macros.h"
 
+#include <limits>
+#include <map>
+
 #define MAX_ARRAY_SIZE 1000000
 
 namespace gpu {
@@ -31,16 +34,18 @@ namespace clmem {
 KernelDriver::KernelDriver(const cl::Context& context,
                            const cl::CommandQueue& queue,
                            const cl::Kernel& kernel, ClmemInstance* instance,
-                           int instance_num)
+                           int instance_num, int num_access_bound_ids)
     : context_(context),
       queue_(queue),
       device_(context.getInfo<CL_CONTEXT_DEVICES>()[0]),
       kernel_(kernel),
       instance_(*instance),
       instance_num_(instance_num),
+      num_access_bound_ids_(num_access_bound_ids),
       kernel_instance_(instance->add_kernel()),
       name_(util::GetOpenClKernelName(kernel)),
-      args_set_(&kernel_) {}
+      args_set_(&kernel_,
+                /*num_hidden_args=*/num_access_bound_ids ? 1 : 0) {}
 
 void KernelDriver::RunOrDie(Logger& logger) {
   kernel_instance_->set_name(name_);
@@ -165,8 +170,8 @@ labm8::Status KernelDriver::RunDynamicParams(
 
 gpu::libcecl::OpenClKernelInvocation KernelDriver::RunOnceOrDie(
     const DynamicParams& dynamic_params, KernelArgValuesSet& inputs,
-    KernelArgValuesSet* outputs, const ClmemKernelRun* const run,
-    Logger& logger, bool flush) {
+    KernelArgValuesSet* outputs, ClmemKernelRun* run, Logger& logger,
+    bool flush) {
   gpu::libcecl::OpenClKernelInvocation log;
   ProfilingData profiling;
   cl::Event event;
@@ -184,6 +189,10 @@ gpu::libcecl::OpenClKernelInvocation KernelDriver::RunOnceOrDie(
 
   inputs.CopyToDevice(queue_, &profiling);
   inputs.SetAsArgs(&kernel_);
+  cl::Buffer access_bounds;
+  if (num_access_bound_ids_) {
+    access_bounds = SetAccessBoundsArg();
+  }
 
   queue_.enqueueNDRangeKernel(kernel_, /*offset=*/cl::NullRange,
                               /*global=*/cl::NDRange(global_size),
@@ -192,6 +201,9 @@ gpu::libcecl::OpenClKernelInvocation KernelDriver::RunOnceOrDie(
   profiling.kernel_nanoseconds += GetElapsedNanoseconds(event);
 
   inputs.CopyFromDeviceToNewValueSet(queue_, outputs, &profiling);
+  if (num_access_bound_ids_) {
+    ReadAccessBounds(access_bounds, run);
+  }
 
   // Set run proto fields.
   log.set_kernel_time_ns(profiling.kernel_nanoseconds);
@@ -203,5 +215,113 @@ gpu::libcecl::OpenClKernelInvocation KernelDriver::RunOnceOrDie(
   return log;
 }
 
+labm8::StatusOr<std::vector<ArgBoundModel>> KernelDriver::InferBounds(
+    const BoundsInferenceOptions& options) {
+  CHECK(num_access_bound_ids_) << "Kernel has no access bounds argument";
+  kernel_instance_->set_name(name_);
+  kernel_instance_->set_outcome(args_set_.Init());
+  if (kernel_instance_->outcome() != ClmemKernelInstance::PASS) {
+    return labm8::Status(labm8::error::Code::INVALID_ARGUMENT,
+                         "Unsupported arguments to kernel '{}'", name_);
+  }
+
+  const std::vector<KernelArg> args = args_set_.args();
+  std::vector<BoundsArg> bounds_args;
+  std::vector<long long> args_values;
+  for (size_t i = 0; i < args.size(); ++i) {
+    bounds_args.push_back({util::GetKernelArgName(kernel_, i),
+                           args[i].IsPointer(), !args[i].IsLocal()});
+    if (!args[i].IsPointer()) {
+      args_values.push_back(0);  // Overwritten by each probe.
+    } else if (args[i].IsLocal()) {
+      args_values.push_back(options.probe_local_buffer_size);
+    } else {
+      args_values.push_back(options.probe_global_buffer_size);
+    }
+  }
+  KernelArgValuesSet inputs;
+  RETURN_IF_ERROR(args_set_.SetRandom(context_, args_values, &inputs));
+
+  auto max_work_group_size = device_.getInfo<CL_DEVICE_MAX_WORK_GROUP_SIZE>();
+  BoundsProbe probe = [&](const DynamicParams& launch,
+                          const std::vector<int>& scalar_values)
+      -> labm8::StatusOr<std::map<int, AccessBounds>> {
+    if (static_cast<int>(max_work_group_size) < launch.local_size_x()) {
+      return labm8::Status(labm8::error::Code::INVALID_ARGUMENT,
+                           "Local size {} exceeds maximum work group size {}",
+                           launch.local_size_x(), max_work_group_size);
+    }
+
+    ClmemKernelRun run;
+    try {
+      ProfilingData profiling;
+      inputs.CopyToDevice(queue_, &profiling);
+      inputs.SetAsArgs(&kernel_);
+      size_t scalar = 0;
+      for (size_t i = 0; i < args.size(); ++i) {
+        if (!args[i].IsPointer()) {
+          args[i]
+              .TryToCreateConstValue(context_, /*size=*/1,
+                                     /*value=*/scalar_values[scalar++])
+              ->SetAsArg(&kernel_, i);
+        }
+      }
+      cl::Buffer access_bounds = SetAccessBoundsArg();
+
+      queue_.enqueueNDRangeKernel(
+          kernel_, /*offset=*/cl::NullRange,
+          /*global=*/cl::NDRange(launch.global_size_x()),
+          /*local=*/cl::NDRange(launch.local_size_x()));
+      ReadAccessBounds(access_bounds, &run);
+    } catch (cl::Error error) {
+      return labm8::Status(labm8::error::Code::INTERNAL,
+                           "Error code {} ({}) raised by {}()", error.err(),
+                           labm8::gpu::clinfo::OpenClErrorString(error.err()),
+                           error.what());
+    }
+
+    std::map<int, AccessBounds> bounds;
+    for (const auto& access_bounds : run.access_bounds()) {
+      bounds[access_bounds.arg_id()] = access_bounds;
+    }
+    return bounds;
+  };
+
+  return InferBoundsModel(bounds_args, options, probe);
+}
+
+cl::Buffer KernelDriver::SetAccessBoundsArg() {
+  // A (min, max) pair per arg_id, initialized to an empty range.
+  std::vector<cl_int> bounds(2 * num_access_bound_ids_);
+  for (int i = 0; i < num_access_bound_ids_; ++i) {
+    bounds[2 * i] = std::numeric_limits<cl_int>::max();
+    bounds[2 * i + 1] = std::numeric_limits<cl_int>::min();
+  }
+  cl::Buffer buffer(context_, CL_MEM_READ_WRITE,
+                    bounds.size() * sizeof(cl_int));
+  queue_.enqueueWriteBuffer(buffer, /*blocking=*/true, /*offset=*/0,
+                            bounds.size() * sizeof(cl_int), bounds.data());
+  kernel_.setArg(kernel_.getInfo<CL_KERNEL_NUM_ARGS>() - 1, buffer);
+  return buffer;
+}
+
+void KernelDriver::ReadAccessBounds(const cl::Buffer& buffer,
+                                    ClmemKernelRun* run) {
+  std::vector<cl_int> bounds(2 * num_access_bound_ids_);
+  queue_.enqueueReadBuffer(buffer, /*blocking=*/true, /*offset=*/0,
+                           bounds.size() * sizeof(cl_int), bounds.data());
+  run->clear_access_bounds();
+  for (int i = 0; i < num_access_bound_ids_; ++i) {
+    // An arg_id which was never accessed keeps its empty range.
+    if (bounds[2 * i] > bounds[2 * i + 1]) {
+      continue;
+    }
+    AccessBounds* access_bounds = run->add_access_bounds();
+    access_bounds->set_arg_id(i);
+    access_bounds->set_min_index(bounds[2 * i]);
+    access_bounds->set_max_index(bounds[2 * i + 1]);
+  }
+}
+
 }  // namespace clmem
 }  // namespace gpu
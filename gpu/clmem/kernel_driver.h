@@ -15,6 +15,7 @@
 // along with clmem.  If not, see <https://www.gnu.org/licenses/>.
 #pragma once
 
+#include "gpu/clmem/bounds_inference.h"
 #include "gpu/clmem/kernel_arg_set.h"
 #include "gpu/clmem/logger.h"
 #include "gpu/clmem/proto/clmem.pb.h"
@@ -27,9 +28,12 @@ namespace clmem {
 
 class KernelDriver {
  public:
+  // If num_access_bound_ids is not zero, the kernel has been rewritten by
+  // RewriteHooksToAccessBounds(), and its last argument is the access bounds
+  // buffer for that many arg_ids.
   KernelDriver(const cl::Context& context, const cl::CommandQueue& queue,
                const cl::Kernel& kernel, ClmemInstance* instance,
-               int instance_num);
+               int instance_num, int num_access_bound_ids = 0);
 
   void RunOrDie(Logger& logger);
 
@@ -42,8 +46,16 @@ class KernelDriver {
   // later call to logger.FlushLogs().
   gpu::libcecl::OpenClKernelInvocation RunOnceOrDie(
       const DynamicParams& dynamic_params, KernelArgValuesSet& inputs,
-      KernelArgValuesSet* outputs, const ClmemKernelRun* const run,
-      Logger& logger, bool flush = true);
+      KernelArgValuesSet* outputs, ClmemKernelRun* run, Logger& logger,
+      bool flush = true);
+
+  // Infer models of the array bounds of the kernel's arguments by probing it
+  // with InferBoundsModel(). The kernel must have been rewritten by
+  // RewriteHooksToAccessBounds(), with hook() arg_ids being argument indices.
+  // Buffers are allocated once, at the probe buffer sizes, and their
+  // contents are copied to the device before each probe.
+  labm8::StatusOr<std::vector<ArgBoundModel>> InferBounds(
+      const BoundsInferenceOptions& options);
 
  private:
   // Private helper to public RunDynamicParams() method that doesn't catch
@@ -52,12 +64,19 @@ class KernelDriver {
                                  Logger& logger, ClmemKernelRun* run, 
                                  KernelArgValuesSet &inputs);
 
+  // Create the access bounds buffer and set it as the last kernel argument.
+  cl::Buffer SetAccessBoundsArg();
+
+  // Read the access bounds buffer into the run.
+  void ReadAccessBounds(const cl::Buffer& buffer, ClmemKernelRun* run);
+
   cl::Context context_;
   cl::CommandQueue queue_;
   cl::Device device_;
   cl::Kernel kernel_;
   const ClmemInstance& instance_;
   int instance_num_;
+  int num_access_bound_ids_;
   ClmemKernelInstance* kernel_instance_;
   string name_;
   KernelArgSet args_set_;
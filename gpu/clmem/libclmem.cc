@@ -15,8 +15,10 @@
 // along with clmem.  If not, see <https://www.gnu.org/licenses/>.
 #include "gpu/clmem/libclmem.h"
 
+#include "gpu/clmem/hook_rewriter.h"
 #include "gpu/clmem/kernel_arg_value.h"
 #include "gpu/clmem/kernel_driver.h"
+#include "gpu/cldrive/program_cache.h"
 #include "gpu/clinfo/libclinfo.h"
 
 #include "labm8/cpp/logging.h"
@@ -36,37 +38,6 @@
 namespace gpu {
 namespace clmem {
 
-namespace {
-
-// Attempt to build OpenCL program.
-labm8::StatusOr<cl::Program> BuildOpenClProgram(
-    const std::string& opencl_kernel, const cl::Context& context,
-    const string& cl_build_opts) {
-  auto start_time = absl::Now();
-  try {
-    // Assemble the build options. We need -cl-kernel-arg-info so that we can
-    // read the kernel signatures.
-    string all_build_opts = "-cl-kernel-arg-info ";
-    absl::StrAppend(&all_build_opts, cl_build_opts);
-    labm8::TrimRight(all_build_opts);
-
-    cl::Program program(context, opencl_kernel);
-    program.build(context.getInfo<CL_CONTEXT_DEVICES>(),
-                  all_build_opts.c_str());
-    auto end_time = absl::Now();
-    auto duration = (end_time - start_time) / absl::Milliseconds(1);
-    LOG(INFO) << "clBuildProgram() with options '" << all_build_opts
-              << "' completed in " << duration << " ms";
-    return program;
-  } catch (cl::Error e) {
-    LOG_CL_ERROR(WARNING, e);
-    return labm8::Status(labm8::error::Code::INVALID_ARGUMENT,
-                         "clBuildProgram failed");
-  }
-}
-
-}  // namespace
-
 Clmem::Clmem(ClmemInstance* instance, int instance_num)
     : instance_(instance),
       instance_num_(instance_num),
@@ -85,15 +56,82 @@ void Clmem::RunOrDie(Logger& logger) {
   }
 }
 
+labm8::StatusOr<std::vector<ArgBoundModel>> Clmem::InferBounds(
+    const BoundsInferenceOptions& options) {
+  try {
+    return DoInferBounds(options);
+  } catch (cl::Error error) {
+    return labm8::Status(labm8::error::Code::INTERNAL,
+                         "Error code {} ({}) raised by {}()", error.err(),
+                         labm8::gpu::clinfo::OpenClErrorString(error.err()),
+                         error.what());
+  }
+}
+
+labm8::StatusOr<std::vector<ArgBoundModel>> Clmem::DoInferBounds(
+    const BoundsInferenceOptions& options) {
+  cl::Context context(device_);
+  cl::CommandQueue queue(context,
+                         /*devices=*/context.getInfo<CL_CONTEXT_DEVICES>()[0],
+                         /*properties=*/CL_QUEUE_PROFILING_ENABLE);
+
+  auto rewrite_or = RewriteHooksToAccessBounds(instance_->opencl_src());
+  if (!rewrite_or.ok()) {
+    instance_->set_outcome(ClmemInstance::HOOK_REWRITE_FAILURE);
+    return rewrite_or.status();
+  }
+
+  labm8::StatusOr<cl::Program> program_or =
+      ::gpu::cldrive::BuildOpenClProgram(rewrite_or.ValueOrDie().opencl_src,
+                                         context, instance_->build_opts());
+  if (!program_or.ok()) {
+    instance_->set_outcome(ClmemInstance::PROGRAM_COMPILATION_FAILURE);
+    return program_or.status();
+  }
+  cl::Program program = program_or.ValueOrDie();
+
+  std::vector<cl::Kernel> kernels;
+  program.createKernels(&kernels);
+  if (!kernels.size()) {
+    instance_->set_outcome(ClmemInstance::NO_KERNELS_IN_PROGRAM);
+    return labm8::Status(labm8::error::Code::NOT_FOUND,
+                         "OpenCL program contains no kernels");
+  }
+
+  auto models_or = KernelDriver(context, queue, kernels[0], instance_,
+                                instance_num_,
+                                rewrite_or.ValueOrDie().num_arg_ids)
+                       .InferBounds(options);
+  instance_->set_outcome(ClmemInstance::PASS);
+  return models_or;
+}
+
 void Clmem::DoRunOrDie(Logger& logger) {
   cl::Context context(device_);
   cl::CommandQueue queue(context,
                          /*devices=*/context.getInfo<CL_CONTEXT_DEVICES>()[0],
                          /*properties=*/CL_QUEUE_PROFILING_ENABLE);
 
+  // With ATOMIC_BOUNDS, drive the rewritten source in place of the original.
+  string opencl_src = instance_->opencl_src();
+  int num_access_bound_ids = 0;
+  if (instance_->hook_mode() == ClmemInstance::ATOMIC_BOUNDS) {
+    auto rewrite_or = RewriteHooksToAccessBounds(opencl_src);
+    if (!rewrite_or.ok()) {
+      LOG(ERROR) << rewrite_or.status().ToString();
+      instance_->set_outcome(ClmemInstance::HOOK_REWRITE_FAILURE);
+      logger.RecordLog(instance_, /*kernel_instance=*/nullptr, /*run=*/nullptr,
+                       /*log=*/nullptr);
+      return;
+    }
+    opencl_src = rewrite_or.ValueOrDie().opencl_src;
+    num_access_bound_ids = rewrite_or.ValueOrDie().num_arg_ids;
+  }
+
   // Compile program or fail.
-  labm8::StatusOr<cl::Program> program_or = BuildOpenClProgram(
-      string(instance_->opencl_src()), context, instance_->build_opts());
+  labm8::StatusOr<cl::Program> program_or =
+      ::gpu::cldrive::BuildOpenClProgram(opencl_src, context,
+                                         instance_->build_opts());
   if (!program_or.ok()) {
     LOG(ERROR) << "OpenCL program compilation failed!";
     instance_->set_outcome(ClmemInstance::PROGRAM_COMPILATION_FAILURE);
@@ -116,7 +154,8 @@ void Clmem::DoRunOrDie(Logger& logger) {
     // auto dp = instance_->add_dynamic_params();
     // dp->set_global_size_x(FLAGS_gsize);
     // dp->set_local_size_x(FLAGS_lsize);
-    KernelDriver(context, queue, kernel, instance_, instance_num_)
+    KernelDriver(context, queue, kernel, instance_, instance_num_,
+                 num_access_bound_ids)
         .RunOrDie(logger);
   }
 
@@ -15,11 +15,15 @@
 // along with clmem.  If not, see <https://www.gnu.org/licenses/>.
 #pragma once
 
+#include "gpu/clmem/bounds_inference.h"
 #include "gpu/clmem/logger.h"
 #include "gpu/clmem/proto/clmem.pb.h"
 
+#include "labm8/cpp/statusor.h"
 #include "third_party/opencl/cl.hpp"
 
+#include <vector>
+
 namespace gpu {
 namespace clmem {
 
@@ -29,9 +33,18 @@ class Clmem {
 
   void RunOrDie(Logger& logger);
 
+  // Infer models of the array bounds of the arguments of the first kernel of
+  // the instance's source, which must define hook(). The source is rewritten
+  // and compiled once, and every probe of the search runs in this process.
+  labm8::StatusOr<std::vector<ArgBoundModel>> InferBounds(
+      const BoundsInferenceOptions& options);
+
  private:
   void DoRunOrDie(Logger& logger);
 
+  labm8::StatusOr<std::vector<ArgBoundModel>> DoInferBounds(
+      const BoundsInferenceOptions& options);
+
   ClmemInstance* instance_;
   int instance_num_;
   cl::Device device_;
@@ -90,5 +90,29 @@ NULLLogger::NULLLogger(std::ostream& ostream,
   return labm8::Status::OK;
 }
 
+AccessBoundsLogger::AccessBoundsLogger(std::ostream& ostream,
+                                       const ClmemInstances* const instances)
+    : Logger(ostream, instances) {
+  this->ostream(/*flush=*/true) << "instance,kernel,global_size,local_size,"
+                                << "arg_id,min_index,max_index\n";
+}
+
+/*virtual*/ labm8::Status AccessBoundsLogger::RecordLog(
+    const ClmemInstance* const instance,
+    const ClmemKernelInstance* const kernel_instance,
+    const ClmemKernelRun* const run,
+    const gpu::libcecl::OpenClKernelInvocation* const log, bool flush) {
+  if (!run || !log) {
+    return labm8::Status::OK;
+  }
+  for (const auto& bounds : run->access_bounds()) {
+    ostream(flush) << instance_num() << ',' << log->kernel_name() << ','
+                   << log->global_size_x() << ',' << log->local_size_x() << ','
+                   << bounds.arg_id() << ',' << bounds.min_index() << ','
+                   << bounds.max_index() << '\n';
+  }
+  return labm8::Status::OK;
+}
+
 }  // namespace clmem
 }  // namespace gpu
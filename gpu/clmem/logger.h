@@ -82,6 +82,20 @@ class NULLLogger : public Logger {
       bool flush) override;
 };
 
+// Logging interface for producing a CSV of the access bounds of each run, with
+// columns: instance,kernel,global_size,local_size,arg_id,min_index,max_index.
+class AccessBoundsLogger : public Logger {
+ public:
+  AccessBoundsLogger(std::ostream& ostream,
+                     const ClmemInstances* const instances);
+
+  virtual labm8::Status RecordLog(
+      const ClmemInstance* const instance,
+      const ClmemKernelInstance* const kernel_instance,
+      const ClmemKernelRun* const run,
+      const gpu::libcecl::OpenClKernelInvocation* const log,
+      bool flush) override;
+};
 
 }  // namespace clmem
 }  // namespace gpu
@@ -49,21 +49,37 @@ def run_config(kernel_configs_filename):
             for j in range(len(kernel_configs)):
                 kernel_configs[j][i] += 1
     
-    for i, kernel_config in enumerate(kernel_configs):
-        file_id = f"{kernel_id}_{gsize}_{lsize}_{i}"         
-        if file_id in BACKUPED_LIST:
-            continue
-        
-        run_instance = KernelRunInstance(kernel_code=kernel_code,
-                                            gsize=gsize,
-                                            lsize=lsize,
-                                            args_values=kernel_config)
-        result_df, stderr = run_instance.run_n_times(10)
-        if result_df is None:
+    pending = [
+        (i, kernel_config) for i, kernel_config in enumerate(kernel_configs)
+        if f"{kernel_id}_{gsize}_{lsize}_{i}" not in BACKUPED_LIST
+    ]
+    if not pending:
+        return
+
+    # Run all configs in one cldrive process, compiling the kernel once.
+    run_instance = KernelRunInstance(kernel_code=kernel_code,
+                                        gsize=gsize,
+                                        lsize=lsize)
+    result_df, stderr = run_instance.run_sweep(
+        [kernel_config for _, kernel_config in pending], 10)
+
+    # The rows of each config have its position in the sweep. Configs which
+    # were not run, e.g. because cldrive crashed part way, have no rows.
+    groups = {}
+    if result_df is not None and "sweep_index" in result_df:
+        groups = {
+            int(j): group.drop(columns="sweep_index")
+            for j, group in result_df.dropna(subset=["sweep_index"])
+                                     .groupby("sweep_index", sort=False)
+        }
+
+    for j, (i, _) in enumerate(pending):
+        file_id = f"{kernel_id}_{gsize}_{lsize}_{i}"
+        if j in groups:
+            groups[j].to_csv(os.path.join(SUCCESS_DIR, f"{file_id}.csv"), index=None)
+        else:
             with open(os.path.join(FAIL_DIR, f"{file_id}.txt"), "w") as f:
                 f.write(stderr)
-        else:
-            result_df.to_csv(os.path.join(SUCCESS_DIR, f"{file_id}.csv"), index=None)
 
 if __name__ == "__main__":
     if not os.path.exists(KERNEL_DIR):
@@ -29,6 +29,9 @@ NUM_PROCESS = 16 # number of processes to run in parallel
 MAX_ARG_TRY = 216 # maximum number of argument settings to try, to avoid exponential explosion of argument settings
 NUM_ARG_SELECTION = 4 # number of argument settings to select
 verbose_cldrive = False # whether to print CLDrive stdout
+USE_ATOMIC_BOUNDS = True # track access bounds on the device with clmem, rather than parsing printf output
+USE_CLMEM_INFER_BOUNDS = True # infer the argument values with `clmem --infer_bounds` in one process, rather than the KernelMemoryAnalyzer search loop
+INFER_BOUNDS_TIMEOUT = 600 # timeout for the whole inference of one kernel and launch config
 device_num_sm = 80 # number of SMs of the current GPU, used to generate launch configs
 
 random.seed(2610)
@@ -163,6 +166,15 @@ class KernelMemoryAnalyzer:
                 else:
                     args_values.append(int(KernelMemoryAnalyzer.TEST_LOCAL_ARRAY_BOUND))
         kernel_instance = KernelRunInstance(self.kernel_code, gsize, lsize, args_values)
+        if USE_ATOMIC_BOUNDS:
+            # clmem rewrites hook() to track the bounds on the device, so only
+            # one (min, max) pair per argument is read back.
+            df, stderr = kernel_instance.run_mem_bounds()
+            if df.empty:
+                raise Exception(f"Run kernel with args_values={args_values} failed with error:\n{stderr}")
+            max_dict = {self.id2name[r.arg_id]: r.max_index for r in df.itertuples()}
+            min_dict = {self.id2name[r.arg_id]: r.min_index for r in df.itertuples()}
+            return max_dict, min_dict, launch_config
         stdout, stderr = kernel_instance.run_mem_access()
         if len(stdout) == 0:
             raise Exception(f"Run kernel with args_values={args_values} failed with error:\n{stderr}")
@@ -208,9 +220,19 @@ def get_kernel_args_values(args):
     logger.info(f"Analyzing {org_kernel_path}")
     
     try:
-        analyzer = KernelMemoryAnalyzer(hook_inserted_kernel_path)
-        
-        run_settings = analyzer.get_run_settings(gsize, lsize)
+        if USE_CLMEM_INFER_BOUNDS:
+            # clmem tries the same scalar candidates and compiles the kernel
+            # once, but writes only the first valid setting.
+            with open(hook_inserted_kernel_path, "r", encoding="utf-8") as f:
+                kernel_code = f.read()
+            kernel_instance = KernelRunInstance(kernel_code, gsize, lsize, timeout=INFER_BOUNDS_TIMEOUT)
+            args_values, stderr = kernel_instance.infer_args_values()
+            if args_values is None:
+                logger.error(f"ERROR: (`{org_kernel_path}`) clmem --infer_bounds found no valid setting:\n{stderr}")
+            run_settings = [args_values] if args_values is not None else []
+        else:
+            analyzer = KernelMemoryAnalyzer(hook_inserted_kernel_path)
+            run_settings = analyzer.get_run_settings(gsize, lsize)
         save_dir = SUCCESS_DIR if len(run_settings) > 0 else FAIL_DIR
         with open(os.path.join(save_dir, os.path.splitext(kernel)[0] + f"_{gsize}_{lsize}.json"), "w", encoding="utf-8") as f:
             json.dump(run_settings, f)
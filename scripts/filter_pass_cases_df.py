@@ -50,10 +50,30 @@ def calculate_stats(row):
     return row
 
 
-# Apply the function to each row and add the resulting columns to the DataFrame
-print("Calculating statistics for each kernel instance...")
-pass_instances = pass_instances.apply(calculate_stats, axis=1)
-pass_instances = pass_instances.dropna()
+# CSVs from `cldrive --summary_only` already hold the statistics of each
+# kernel instance, computed by cldrive. Its percentiles are P-square streaming
+# estimates rather than exact percentiles, and its std is the sample standard
+# deviation, which is converted to the population standard deviation computed
+# above.
+summary_columns = {
+    "kernel_time_ns_max": "max_time",
+    "kernel_time_ns_min": "min_time",
+    "kernel_time_ns_mean": "mean_time",
+    "kernel_time_ns_std": "std",
+    "kernel_time_ns_p25": "percentile_25",
+    "kernel_time_ns_p50": "percentile_50",
+    "kernel_time_ns_p75": "percentile_75",
+    "kernel_time_ns_p99": "percentile_99",
+}
+if "kernel_time_ns_p50" in pass_instances.columns:
+    pass_instances = pass_instances.rename(columns=summary_columns)
+    num_runs = pass_instances["num_runs"]
+    pass_instances["std"] *= np.sqrt((num_runs - 1) / num_runs)
+else:
+    # Apply the function to each row and add the resulting columns to the DataFrame
+    print("Calculating statistics for each kernel instance...")
+    pass_instances = pass_instances.apply(calculate_stats, axis=1)
+    pass_instances = pass_instances.dropna()
 pass_instances["norm_std"] = pass_instances["std"] / pass_instances["mean_time"]
 
 # Print the resulting DataFrame with calculated statistics
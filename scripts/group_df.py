@@ -46,11 +46,12 @@ for filename in tqdm(list(os.listdir(result_path))):
         except Exception as e:
             print(f'kernel {file_path} failed to read csv!')
             raise e
-        # group by device,kernel,global_size,local_size_x,args_info
+        # group by device,kernel,launch config,args_info
         aggr = {}
         aggr['kernel_time_ns'] = 'mean'
         aggr['outcome'] = lambda x: x.iloc[0]
-        df = df.groupby(['device','kernel','global_size','local_size_x','args_info'])\
+        df = df.groupby(['device','kernel','global_size','global_size_y','global_size_z',
+                         'local_size_x','local_size_y','local_size_z','args_info'])\
                 .agg(aggr).reset_index()
                 
         kernel_id = extract_info_from_filename(filename)[0]